@@ -26,9 +26,12 @@
 
 #include "config.h"
 
+#if HAVE_MTDEV
 #include <mtdev-plumbing.h>
+#endif
 
 #include "evdev-fallback.h"
+#include "libinput-plugin-mt-protocol-a.h"
 #include "util-input-event.h"
 
 static void
@@ -1095,24 +1098,11 @@ fallback_handle_state(struct fallback_dispatch *dispatch,
 }
 
 static void
-fallback_interface_process(struct evdev_dispatch *evdev_dispatch,
-			   struct evdev_device *device,
-			   struct evdev_event *event,
-			   uint64_t time)
+fallback_process_event(struct fallback_dispatch *dispatch,
+		       struct evdev_device *device,
+		       struct evdev_event *event,
+		       uint64_t time)
 {
-	struct fallback_dispatch *dispatch = fallback_dispatch(evdev_dispatch);
-	static bool warned = false;
-
-	if (dispatch->arbitration.in_arbitration) {
-		if (!warned) {
-			evdev_log_debug(device, "dropping events due to touch arbitration\n");
-			warned = true;
-		}
-		return;
-	}
-
-	warned = false;
-
 	uint16_t type = evdev_event_type(event);
 	switch (type) {
 	case EV_REL:
@@ -1133,6 +1123,58 @@ fallback_interface_process(struct evdev_dispatch *evdev_dispatch,
 	}
 }
 
+static bool
+fallback_drop_for_arbitration(struct fallback_dispatch *dispatch,
+			      struct evdev_device *device)
+{
+	static bool warned = false;
+
+	if (dispatch->arbitration.in_arbitration) {
+		if (!warned) {
+			evdev_log_debug(device, "dropping events due to touch arbitration\n");
+			warned = true;
+		}
+		return true;
+	}
+
+	warned = false;
+	return false;
+}
+
+static void
+fallback_interface_process(struct evdev_dispatch *evdev_dispatch,
+			   struct evdev_device *device,
+			   struct evdev_event *event,
+			   uint64_t time)
+{
+	struct fallback_dispatch *dispatch = fallback_dispatch(evdev_dispatch);
+
+	if (fallback_drop_for_arbitration(dispatch, device))
+		return;
+
+	fallback_process_event(dispatch, device, event, time);
+}
+
+static void
+fallback_interface_process_frame(struct evdev_dispatch *evdev_dispatch,
+				 struct evdev_device *device,
+				 struct evdev_frame *frame)
+{
+	struct fallback_dispatch *dispatch = fallback_dispatch(evdev_dispatch);
+
+	/* Arbitration is toggled by other devices, so it cannot change
+	 * in the middle of one of our frames */
+	if (fallback_drop_for_arbitration(dispatch, device))
+		return;
+
+	uint64_t time = evdev_frame_get_time(frame);
+	size_t nevents;
+	struct evdev_event *events = evdev_frame_get_events(frame, &nevents);
+
+	for (size_t i = 0; i < nevents; i++)
+		fallback_process_event(dispatch, device, &events[i], time);
+}
+
 static void
 cancel_touches(struct fallback_dispatch *dispatch,
 	       struct evdev_device *device,
@@ -1550,6 +1592,7 @@ fallback_interface_device_removed(struct evdev_device *device,
 
 static struct evdev_dispatch_interface fallback_interface = {
 	.process = fallback_interface_process,
+	.process_frame = fallback_interface_process_frame,
 	.suspend = fallback_interface_suspend,
 	.remove = fallback_interface_remove,
 	.destroy = fallback_interface_destroy,
@@ -1663,16 +1706,18 @@ fallback_dispatch_init_slots(struct fallback_dispatch *dispatch,
 
 	/* We only handle the slotted Protocol B in libinput.
 	   Devices with ABS_MT_POSITION_* but not ABS_MT_SLOT
-	   require mtdev for conversion. */
-	if (evdev_need_mtdev(device)) {
-		device->mtdev = mtdev_new_open(device->fd);
-		if (!device->mtdev)
-			return -1;
-
-		/* pick 10 slots as default for type A
-		   devices. */
-		num_slots = 10;
-		active_slot = device->mtdev->caps.slot.value;
+	   are converted by mtdev or the mt-protocol-a plugin,
+	   see evdev_need_mtdev(). */
+	if (evdev_is_mt_protocol_a(device)) {
+#if HAVE_MTDEV
+		if (evdev_need_mtdev(device)) {
+			device->mtdev = mtdev_new_open(device->fd);
+			if (!device->mtdev)
+				return -1;
+		}
+#endif
+		num_slots = MT_PROTOCOL_A_NUM_SLOTS;
+		active_slot = 0;
 	} else {
 		num_slots = libevdev_get_num_slots(device->evdev);
 		active_slot = libevdev_get_current_slot(evdev);
@@ -1683,7 +1728,7 @@ fallback_dispatch_init_slots(struct fallback_dispatch *dispatch,
 	for (slot = 0; slot < num_slots; ++slot) {
 		slots[slot].seat_slot = -1;
 
-		if (evdev_need_mtdev(device))
+		if (evdev_is_mt_protocol_a(device))
 			continue;
 
 		slots[slot].point.x = libevdev_get_slot_value(evdev,
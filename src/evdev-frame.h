@@ -27,6 +27,7 @@
 #include "config.h"
 
 #include "util-mem.h"
+#include "util-macros.h"
 #include "util-input-event.h"
 #include "util-newtype.h"
 
@@ -252,6 +253,62 @@ evdev_usage_is_key(evdev_usage_t usage)
 	return false;
 }
 
+/**
+ * A usage mask is a coarse bitmask of usages where each bit covers
+ * one or more usages: EV_KEY in blocks of 32 codes, EV_ABS in blocks
+ * of 4 codes, each EV_REL code individually and other types with one
+ * bit per type. Where two usage masks do not intersect, none of the
+ * usages in one are in the other, the reverse is not true.
+ */
+#define EVDEV_USAGE_MASK_ALL UINT64_MAX
+
+static inline unsigned int
+evdev_usage_mask_bit(evdev_usage_t usage)
+{
+	uint16_t code = evdev_usage_code(usage);
+
+	switch (evdev_usage_type(usage)) {
+	case EV_SYN:
+		return 0;
+	case EV_KEY:
+		return 1 + min(code / 32, 23); /* 1 - 24 */
+	case EV_REL:
+		return 25 + min(code, 15); /* 25 - 40 */
+	case EV_ABS:
+		return 41 + min(code / 4, 15); /* 41 - 56 */
+	case EV_MSC:
+		return 57;
+	case EV_SW:
+		return 58;
+	case EV_LED:
+		return 59;
+	default:
+		return 60;
+	}
+}
+
+static inline uint64_t
+evdev_usage_mask(evdev_usage_t usage)
+{
+	return 1ULL << evdev_usage_mask_bit(usage);
+}
+
+/**
+ * Returns the usage mask for all usages from first to last, inclusive.
+ */
+static inline uint64_t
+evdev_usage_mask_range(evdev_usage_t first, evdev_usage_t last)
+{
+	uint64_t mask = 0;
+
+	for (evdev_usage_t u = first;
+	     evdev_usage_as_uint32_t(u) <= evdev_usage_as_uint32_t(last);
+	     u = evdev_usage_next(u))
+		mask |= evdev_usage_mask(u);
+
+	return mask;
+}
+
 struct evdev_event {
 	/* this may be a value outside the known usages above but it's just an int */
 	evdev_usage_t usage;
@@ -306,6 +363,17 @@ evdev_event_from_input_event(const struct input_event *e, uint64_t *time)
 	};
 }
 
+/**
+ * The storage for the events of one or more evdev_frames. Frames
+ * share storage after evdev_frame_clone() until one of them is
+ * modified, at which point that frame gets its own copy.
+ */
+struct evdev_frame_events {
+	int refcount; /* 0 for storage on the stack */
+	size_t max_size;
+	struct evdev_event events[];
+};
+
 /**
  * A wrapper around a SYN_REPORT-terminated set of input events.
  *
@@ -316,17 +384,44 @@ evdev_event_from_input_event(const struct input_event *e, uint64_t *time)
  * The event frame is of a fixed size given in
  * evdev_frame_new() and cannot be resized via helpers.
  *
+ * Frames are copy-on-write: evdev_frame_clone() shares the event
+ * storage and any helper that modifies the events (including
+ * evdev_frame_get_events()) first gives the frame a private copy
+ * if the storage is shared.
+ *
  * The struct should be considered opaque, use the helpers
  * to access the various fields.
  */
 struct evdev_frame {
 	int refcount;
-	size_t max_size;
 	size_t count;
 	uint64_t time;
-	struct evdev_event events[];
+	struct evdev_frame_events *storage;
 };
 
+static inline struct evdev_frame_events *
+evdev_frame_events_new(size_t max_size)
+{
+	assert(max_size > 0);
+	struct evdev_frame_events *storage =
+		zalloc(sizeof(*storage) + max_size * sizeof(*storage->events));
+
+	storage->refcount = 1;
+	storage->max_size = max_size;
+
+	return storage;
+}
+
+static inline void
+evdev_frame_events_unref(struct evdev_frame_events *storage)
+{
+	if (storage->refcount == 0) /* on the stack */
+		return;
+
+	if (--storage->refcount == 0)
+		free(storage);
+}
+
 static inline struct evdev_frame *
 evdev_frame_ref(struct evdev_frame *frame)
 {
@@ -341,7 +436,8 @@ evdev_frame_unref(struct evdev_frame *frame)
 	if (frame) {
 		assert(frame->refcount > 0);
 		if (--frame->refcount == 0) {
-			frame->max_size = 0;
+			evdev_frame_events_unref(frame->storage);
+			frame->storage = NULL;
 			frame->count = 0;
 			free(frame);
 		}
@@ -351,6 +447,34 @@ evdev_frame_unref(struct evdev_frame *frame)
 
 DEFINE_UNREF_CLEANUP_FUNC(evdev_frame);
 
+static inline bool
+evdev_frame_is_shared(const struct evdev_frame *frame)
+{
+	return frame->storage->refcount > 1;
+}
+
+/**
+ * Make sure this frame's event storage isn't shared with any other
+ * frame. If preserve is false the caller is about to discard the
+ * current events and they are not copied.
+ */
+static inline void
+evdev_frame_make_writable(struct evdev_frame *frame, bool preserve)
+{
+	if (!evdev_frame_is_shared(frame))
+		return;
+
+	struct evdev_frame_events *storage =
+		evdev_frame_events_new(frame->storage->max_size);
+	if (preserve)
+		memcpy(storage->events,
+		       frame->storage->events,
+		       frame->count * sizeof(*storage->events));
+
+	evdev_frame_events_unref(frame->storage);
+	frame->storage = storage;
+}
+
 static inline bool
 evdev_frame_is_empty(const struct evdev_frame *frame)
 {
@@ -363,13 +487,50 @@ evdev_frame_get_count(const struct evdev_frame *frame)
 	return frame->count;
 }
 
+static inline size_t
+evdev_frame_get_max_size(const struct evdev_frame *frame)
+{
+	return frame->storage->max_size;
+}
+
+/**
+ * Returns the events in this frame for reading and writing. If the
+ * frame shares its events with another frame, this copies the events
+ * first, use evdev_frame_get_events_const() where the events are only
+ * read.
+ */
 static inline struct evdev_event *
 evdev_frame_get_events(struct evdev_frame *frame, size_t *nevents)
 {
+	evdev_frame_make_writable(frame, true);
+
 	if (nevents)
 		*nevents = frame->count;
 
-	return frame->events;
+	return frame->storage->events;
+}
+
+static inline const struct evdev_event *
+evdev_frame_get_events_const(const struct evdev_frame *frame, size_t *nevents)
+{
+	if (nevents)
+		*nevents = frame->count;
+
+	return frame->storage->events;
+}
+
+/**
+ * Returns the union of the usage masks of all events in this frame.
+ */
+static inline uint64_t
+evdev_frame_get_usage_mask(const struct evdev_frame *frame)
+{
+	uint64_t mask = 0;
+
+	for (size_t i = 0; i < frame->count; i++)
+		mask |= evdev_usage_mask(frame->storage->events[i].usage);
+
+	return mask;
 }
 
 /**
@@ -387,11 +548,47 @@ evdev_frame_get_time(const struct evdev_frame *frame)
 	return frame->time;
 }
 
+/**
+ * Write the terminating SYN_REPORT into the last slot of the frame.
+ * Slots past count are never read, so they may hold stale data.
+ * The frame must be writable.
+ */
+static inline void
+evdev_frame_terminate(struct evdev_frame *frame)
+{
+	frame->storage->events[frame->count - 1] = (struct evdev_event) {
+		.usage = evdev_usage_from(EVDEV_SYN_REPORT),
+		.value = 0,
+	};
+}
+
+/**
+ * Shorten the frame to the first count events, including the
+ * terminating SYN_REPORT. The frame must be writable, this is for
+ * callers that filter the events from evdev_frame_get_events() in
+ * place.
+ */
+static inline void
+evdev_frame_truncate(struct evdev_frame *frame, size_t count)
+{
+	assert(count >= 1 && count <= frame->count);
+
+	frame->count = count;
+	evdev_frame_terminate(frame);
+}
+
+/**
+ * Reset the frame to contain only the SYN_REPORT. This is O(1), events
+ * previously in the frame are left in place but are no longer part of
+ * the frame. If the events are shared with another frame this frame
+ * gets new (empty) storage instead.
+ */
 static inline int
 evdev_frame_reset(struct evdev_frame *frame)
 {
-	memset(frame->events, 0, frame->max_size * sizeof(*frame->events));
+	evdev_frame_make_writable(frame, false);
 	frame->count = 1; /* SYN_REPORT is always there */
+	evdev_frame_terminate(frame);
 
 	return 0;
 }
@@ -399,10 +596,10 @@ evdev_frame_reset(struct evdev_frame *frame)
 static inline struct evdev_frame *
 evdev_frame_new(size_t max_size)
 {
-	struct evdev_frame *frame = zalloc(max_size * sizeof(sizeof(*frame->events)) + sizeof(*frame));
+	struct evdev_frame *frame = zalloc(sizeof(*frame));
 
 	frame->refcount = 1;
-	frame->max_size = max_size;
+	frame->storage = evdev_frame_events_new(max_size);
 	frame->count = 1; /* SYN_REPORT is always there */
 
 	return frame;
@@ -411,13 +608,18 @@ evdev_frame_new(size_t max_size)
 static inline struct evdev_frame *
 evdev_frame_new_on_stack(size_t max_size)
 {
-	assert(max_size <= 64);
-	struct evdev_frame *frame = alloca(max_size * sizeof(*frame->events) + sizeof(*frame));
+	assert(max_size > 0 && max_size <= 64);
+	struct evdev_frame *frame = alloca(sizeof(*frame));
+	struct evdev_frame_events *storage =
+		alloca(sizeof(*storage) + max_size * sizeof(*storage->events));
+
+	storage->refcount = 0;
+	storage->max_size = max_size;
 
 	frame->refcount = 1;
-	frame->max_size = max_size;
-	frame->count = 1; /* SYN_REPORT is always there */
-	memset(frame->events, 0, max_size * sizeof(*frame->events));
+	frame->storage = storage;
+	frame->time = 0;
+	evdev_frame_reset(frame);
 
 	return frame;
 }
@@ -461,11 +663,13 @@ evdev_frame_append(struct evdev_frame *frame,
 	}
 
 	if (nevents > 0) {
-		if (frame->count + nevents > frame->max_size)
+		if (frame->count + nevents > evdev_frame_get_max_size(frame))
 			return -ENOMEM;
 
-		memcpy(frame->events + frame->count - 1, events, nevents * sizeof(*events));
+		evdev_frame_make_writable(frame, true);
+		memcpy(frame->storage->events + frame->count - 1, events, nevents * sizeof(*events));
 		frame->count += nevents;
+		evdev_frame_terminate(frame);
 	}
 
 	return 0;
@@ -506,21 +710,37 @@ evdev_frame_set(struct evdev_frame *frame,
 		}
 	}
 
-	if (count > frame->max_size - 1)
+	if (count > evdev_frame_get_max_size(frame) - 1)
 		return -ENOMEM;
 
 	evdev_frame_reset(frame);
 	return evdev_frame_append(frame, events, nevents);
 }
 
+/**
+ * Returns a new frame with the same events as the given frame. The
+ * events are shared until either frame is modified so this is cheap,
+ * except for frames on the stack which are always copied.
+ */
 static inline struct evdev_frame *
 evdev_frame_clone(struct evdev_frame *frame)
 {
-	size_t nevents;
-	struct evdev_event *events = evdev_frame_get_events(frame, &nevents);
-	struct evdev_frame *clone = evdev_frame_new(nevents);
-
-	evdev_frame_append(clone, events, nevents);
+	struct evdev_frame *clone;
+
+	if (frame->storage->refcount == 0) {
+		size_t nevents;
+		const struct evdev_event *events =
+			evdev_frame_get_events_const(frame, &nevents);
+
+		clone = evdev_frame_new(nevents);
+		evdev_frame_append(clone, events, nevents);
+	} else {
+		clone = zalloc(sizeof(*clone));
+		clone->refcount = 1;
+		clone->count = frame->count;
+		clone->storage = frame->storage;
+		clone->storage->refcount++;
+	}
 	evdev_frame_set_time(clone, evdev_frame_get_time(frame));
 
 	return clone;
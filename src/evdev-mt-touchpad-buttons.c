@@ -533,8 +533,8 @@ tp_button_handle_state(struct tp_dispatch *tp, uint64_t time)
 {
 	struct tp_touch *t;
 
-	tp_for_each_touch(tp, t) {
-		if (t->state == TOUCH_NONE || t->state == TOUCH_HOVERING)
+	tp_for_each_active_touch(tp, t) {
+		if (t->state == TOUCH_HOVERING)
 			continue;
 
 		if (t->state == TOUCH_BEGIN) {
@@ -1176,7 +1176,7 @@ tp_clickfinger_set_button(struct tp_dispatch *tp)
 		{ EVDEV_BTN_LEFT, EVDEV_BTN_MIDDLE, EVDEV_BTN_RIGHT },
 	};
 
-	tp_for_each_touch(tp, t) {
+	tp_for_each_active_touch(tp, t) {
 		if (t->state != TOUCH_BEGIN && t->state != TOUCH_UPDATE)
 			continue;
 
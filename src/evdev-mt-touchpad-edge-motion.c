@@ -48,8 +48,7 @@
 #include "filter.h"
 #include "libinput-private.h"
 
-void tp_edge_motion_init(struct tp_dispatch *tp);
-struct tp_dispatch;
+static void tp_edge_motion_init(struct tp_dispatch *tp);
 
 /*
 static FILE *drag_log_file = NULL;
@@ -82,13 +81,6 @@ struct edge_motion_fsm {
     struct libinput_timer timer;
 };
 
-static struct edge_motion_fsm fsm = {
-    .current_state = STATE_IDLE,
-    .previous_state = STATE_IDLE,
-    .tp = NULL,
-    .active_touch = NULL,
-};
-
 #define EDGE_MOTION_CONFIG_SPEED_MM_S 40.0
 #define EDGE_MOTION_CONFIG_MIN_INTERVAL_US 8000
 #define EDGE_MOTION_CONFIG_EDGE_THRESHOLD_MM 7.0
@@ -136,11 +128,11 @@ static void
 log_fsm_detailed(const char *event, uint64_t time, const char *details) {
     if (!drag_log_file) return;
     fprintf(drag_log_file, "[%lu] %s: %s->%s | drag=%s->%s | edge=%s->%s | motion=(%+.2f,%+.2f) | speed_mult=(%.2f,%.2f) | count=%lu | %s\n",
-            (unsigned long)(time / 1000), event, state_to_string(fsm.previous_state),
-            state_to_string(fsm.current_state), fsm.was_dragging ? "T" : "F", fsm.is_dragging ? "T" : "F",
-            edge_to_string(fsm.previous_edge), edge_to_string(fsm.current_edge), fsm.motion_dx, fsm.motion_dy,
-            fsm.speed_multiplier_x, fsm.speed_multiplier_y,
-            (unsigned long)fsm.continuous_motion_count, details ? details : "");
+            (unsigned long)(time / 1000), event, state_to_string(fsm->previous_state),
+            state_to_string(fsm->current_state), fsm->was_dragging ? "T" : "F", fsm->is_dragging ? "T" : "F",
+            edge_to_string(fsm->previous_edge), edge_to_string(fsm->current_edge), fsm->motion_dx, fsm->motion_dy,
+            fsm->speed_multiplier_x, fsm->speed_multiplier_y,
+            (unsigned long)fsm->continuous_motion_count, details ? details : "");
     fflush(drag_log_file);
 }
 */
@@ -159,10 +151,12 @@ get_speed_multiplier_for_distance(double distance_mm) {
 static void
 update_motion_vector_and_speed(const struct tp_dispatch *tp, const struct tp_touch *t,
                                uint32_t edge) {
-    fsm.motion_dx = 0.0;
-    fsm.motion_dy = 0.0;
-    fsm.speed_multiplier_x = 1.0;
-    fsm.speed_multiplier_y = 1.0;
+    struct edge_motion_fsm *fsm = tp->tap.edge_motion;
+
+    fsm->motion_dx = 0.0;
+    fsm->motion_dy = 0.0;
+    fsm->speed_multiplier_x = 1.0;
+    fsm->speed_multiplier_y = 1.0;
 
     if (!t) return; /* Safety check */
 
@@ -185,39 +179,41 @@ update_motion_vector_and_speed(const struct tp_dispatch *tp, const struct tp_tou
 
     /* Determine motion direction and calculate speed multipliers */
     if (edge & EDGE_LEFT) {
-        fsm.motion_dx = -1.0;
-        fsm.speed_multiplier_x = get_speed_multiplier_for_distance(dist_left);
+        fsm->motion_dx = -1.0;
+        fsm->speed_multiplier_x = get_speed_multiplier_for_distance(dist_left);
     } else if (edge & EDGE_RIGHT) {
-        fsm.motion_dx = 1.0;
-        fsm.speed_multiplier_x = get_speed_multiplier_for_distance(dist_right);
+        fsm->motion_dx = 1.0;
+        fsm->speed_multiplier_x = get_speed_multiplier_for_distance(dist_right);
     }
 
     if (edge & EDGE_TOP) {
-        fsm.motion_dy = -1.0;
-        fsm.speed_multiplier_y = get_speed_multiplier_for_distance(dist_top);
+        fsm->motion_dy = -1.0;
+        fsm->speed_multiplier_y = get_speed_multiplier_for_distance(dist_top);
     } else if (edge & EDGE_BOTTOM) {
-        fsm.motion_dy = 1.0;
-        fsm.speed_multiplier_y = get_speed_multiplier_for_distance(dist_bottom);
+        fsm->motion_dy = 1.0;
+        fsm->speed_multiplier_y = get_speed_multiplier_for_distance(dist_bottom);
     }
 
     /* Normalize diagonal motion */
-    double mag = sqrt((fsm.motion_dx) * (fsm.motion_dx) + (fsm.motion_dy) * (fsm.motion_dy));
+    double mag = sqrt((fsm->motion_dx) * (fsm->motion_dx) + (fsm->motion_dy) * (fsm->motion_dy));
     if (mag > 0) {
-        fsm.motion_dx /= mag;
-        fsm.motion_dy /= mag;
+        fsm->motion_dx /= mag;
+        fsm->motion_dy /= mag;
     }
 }
 
 static void
 inject_accumulated_motion(struct tp_dispatch *tp, uint64_t time) {
+    struct edge_motion_fsm *fsm = tp->tap.edge_motion;
+
     /* Initialize timing on first call */
-    if (fsm.last_motion_time == 0) {
-        fsm.last_motion_time = time;
+    if (fsm->last_motion_time == 0) {
+        fsm->last_motion_time = time;
         return;
     }
 
     /* Calculate time delta since last motion event */
-    uint64_t time_since_last = time - fsm.last_motion_time;
+    uint64_t time_since_last = time - fsm->last_motion_time;
 
     /* Convert time delta to base distance based on configured speed */
     /* time_since_last is in microseconds, speed is mm/s */
@@ -228,18 +224,18 @@ inject_accumulated_motion(struct tp_dispatch *tp, uint64_t time) {
 
     /* Update motion vector and speed multipliers dynamically before each motion event */
     /* This ensures speed changes immediately as finger moves closer/further from edges */
-    if (fsm.active_touch && fsm.current_edge != EDGE_NONE) {
-        update_motion_vector_and_speed(fsm.tp, fsm.active_touch, fsm.current_edge);
+    if (fsm->active_touch && fsm->current_edge != EDGE_NONE) {
+        update_motion_vector_and_speed(fsm->tp, fsm->active_touch, fsm->current_edge);
     }
 
     /* Apply dynamic speed multipliers separately for X and Y */
-    double actual_dist_x = base_dist_mm * fsm.speed_multiplier_x;
-    double actual_dist_y = base_dist_mm * fsm.speed_multiplier_y;
+    double actual_dist_x = base_dist_mm * fsm->speed_multiplier_x;
+    double actual_dist_y = base_dist_mm * fsm->speed_multiplier_y;
 
     /* Create raw motion coordinates in device units */
     struct device_float_coords raw = {
-        .x = fsm.motion_dx * actual_dist_x * tp->accel.x_scale_coeff,
-        .y = fsm.motion_dy * actual_dist_y * tp->accel.y_scale_coeff
+        .x = fsm->motion_dx * actual_dist_x * tp->accel.x_scale_coeff,
+        .y = fsm->motion_dy * actual_dist_y * tp->accel.y_scale_coeff
     };
 
     /* Apply pointer acceleration and user preferences */
@@ -249,8 +245,8 @@ inject_accumulated_motion(struct tp_dispatch *tp, uint64_t time) {
     pointer_notify_motion(&tp->device->base, time, &delta, &raw);
 
     /* Update timing and statistics */
-    fsm.last_motion_time = time;
-    fsm.continuous_motion_count++;
+    fsm->last_motion_time = time;
+    fsm->continuous_motion_count++;
 }
 
 static uint32_t
@@ -313,19 +309,24 @@ tp_edge_motion_handle_timeout(uint64_t now, void *data) {
     libinput_timer_set(&fsm_ptr->timer, now + EDGE_MOTION_CONFIG_MIN_INTERVAL_US);
 }
 
-void
+static void
 tp_edge_motion_init(struct tp_dispatch *tp) {
-    if (fsm.tp) return;
-    memset(&fsm, 0, sizeof(fsm));
-    fsm.current_state = STATE_IDLE;
-    fsm.tp = tp;
-    fsm.active_touch = NULL;
-    libinput_timer_init(&fsm.timer, tp_libinput_context(tp), "edge drag motion",
-                        tp_edge_motion_handle_timeout, &fsm);
+    struct edge_motion_fsm *fsm = zalloc(sizeof(*fsm));
+
+    /* One state machine per touchpad, touchpads in different libinput
+     * contexts may be processed in parallel */
+    fsm->current_state = STATE_IDLE;
+    fsm->previous_state = STATE_IDLE;
+    fsm->tp = tp;
+    fsm->active_touch = NULL;
+    libinput_timer_init(&fsm->timer, tp_libinput_context(tp), "edge drag motion",
+                        tp_edge_motion_handle_timeout, fsm);
+    tp->tap.edge_motion = fsm;
 }
 
 void
-tp_edge_motion_cleanup(void) {
+tp_edge_motion_cleanup(struct tp_dispatch *tp) {
+    struct edge_motion_fsm *fsm = tp->tap.edge_motion;
 
     /*
     if (drag_log_file) {
@@ -335,23 +336,24 @@ tp_edge_motion_cleanup(void) {
     }
     */
 
-    /* Clean up timer resources if the FSM was initialized with a touchpad */
-    if (fsm.tp) {
-        libinput_timer_destroy(&fsm.timer);
-    }
-
-    /* Reset the entire FSM structure to zero */
-    memset(&fsm, 0, sizeof(fsm));
+    /* Nothing to do if this touchpad never got to tapping */
+    if (!fsm)
+        return;
 
-    fsm.current_state = STATE_IDLE;
-    fsm.active_touch = NULL;
+    libinput_timer_cancel(&fsm->timer);
+    libinput_timer_destroy(&fsm->timer);
+    free(fsm);
+    tp->tap.edge_motion = NULL;
 }
 
 int
 tp_edge_motion_handle_drag_state(struct tp_dispatch *tp, uint64_t time) {
+    struct edge_motion_fsm *fsm;
+
     /* Initialize the FSM if this is the first call */
-    if (!fsm.tp)
+    if (!tp->tap.edge_motion)
         tp_edge_motion_init(tp);
+    fsm = tp->tap.edge_motion;
 
     /*
      * Determine if a drag operation is currently active by checking the tap FSM state
@@ -388,7 +390,7 @@ tp_edge_motion_handle_drag_state(struct tp_dispatch *tp, uint64_t time) {
     }
 
     /* Store the active touch for dynamic updates during timer callbacks */
-    fsm.active_touch = active_touch;
+    fsm->active_touch = active_touch;
 
     /*
     if (!drag_log_file) {
@@ -401,52 +403,52 @@ tp_edge_motion_handle_drag_state(struct tp_dispatch *tp, uint64_t time) {
     */
 
     /* Update FSM state variables with current conditions */
-    fsm.previous_state = fsm.current_state;
-    fsm.current_edge = detected_edge;
-    fsm.is_dragging = drag_active;
+    fsm->previous_state = fsm->current_state;
+    fsm->current_edge = detected_edge;
+    fsm->is_dragging = drag_active;
 
     /* Calculate the next state based on current drag status and edge detection */
-    enum edge_motion_state next_state = calculate_next_state(drag_active, detected_edge, fsm.current_state);
+    enum edge_motion_state next_state = calculate_next_state(drag_active, detected_edge, fsm->current_state);
 
     /* Handle state transitions */
-    if (next_state != fsm.current_state) {
-        fsm.current_state = next_state;
-        fsm.state_entry_time = time;
+    if (next_state != fsm->current_state) {
+        fsm->current_state = next_state;
+        fsm->state_entry_time = time;
 
         /* Reset continuous motion counter when leaving continuous motion state */
-        if (fsm.current_state != STATE_DRAG_EDGE_CONTINUOUS)
-            fsm.continuous_motion_count = 0;
+        if (fsm->current_state != STATE_DRAG_EDGE_CONTINUOUS)
+            fsm->continuous_motion_count = 0;
 
         //log_fsm_detailed("STATE_TRANSITION", time, "");
     }
 
     /* Handle state-specific actions */
-    switch (fsm.current_state) {
+    switch (fsm->current_state) {
         case STATE_IDLE:
             /* No drag active - cancel any pending timers and clear active touch */
-            libinput_timer_cancel(&fsm.timer);
-            fsm.active_touch = NULL;
+            libinput_timer_cancel(&fsm->timer);
+            fsm->active_touch = NULL;
             break;
 
         case STATE_DRAG_ACTIVE_CENTERED:
             /* Drag is active but not at edge - stop generated motion and clear active touch */
-            libinput_timer_cancel(&fsm.timer);
-            fsm.active_touch = NULL;
+            libinput_timer_cancel(&fsm->timer);
+            fsm->active_touch = NULL;
             break;
 
         case STATE_DRAG_EDGE_EXIT:
             /* Touch has moved away from edge - stop generated motion and clear active touch */
-            libinput_timer_cancel(&fsm.timer);
-            fsm.active_touch = NULL;
+            libinput_timer_cancel(&fsm->timer);
+            fsm->active_touch = NULL;
             break;
 
         case STATE_DRAG_EDGE_ENTRY:
             /* Touch has just reached an edge - start generated motion */
             if (active_touch) {
-                update_motion_vector_and_speed(tp, active_touch, fsm.current_edge);
+                update_motion_vector_and_speed(tp, active_touch, fsm->current_edge);
             }
-            fsm.last_motion_time = time;
-            tp_edge_motion_handle_timeout(time, &fsm); /* Start the timer-based motion loop */
+            fsm->last_motion_time = time;
+            tp_edge_motion_handle_timeout(time, fsm); /* Start the timer-based motion loop */
             break;
 
         case STATE_DRAG_EDGE_CONTINUOUS:
@@ -458,5 +460,5 @@ tp_edge_motion_handle_drag_state(struct tp_dispatch *tp, uint64_t time) {
      * Return whether generated motion should be active
      * Returns 1 when in edge motion states, 0 (false) for idle or centered states
      */
-    return (fsm.current_state != STATE_DRAG_ACTIVE_CENTERED && fsm.current_state != STATE_IDLE);
+    return (fsm->current_state != STATE_DRAG_ACTIVE_CENTERED && fsm->current_state != STATE_IDLE);
 }
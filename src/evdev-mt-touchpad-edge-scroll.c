@@ -361,12 +361,15 @@ tp_remove_edge_scroll(struct tp_dispatch *tp)
 }
 
 void
-tp_edge_scroll_handle_state(struct tp_dispatch *tp, uint64_t time)
+tp_edge_scroll_handle_state(struct tp_dispatch *tp,
+			    uint64_t active,
+			    uint64_t dirty,
+			    uint64_t time)
 {
 	struct tp_touch *t;
 
 	if (tp->scroll.method != LIBINPUT_CONFIG_SCROLL_EDGE) {
-		tp_for_each_touch(tp, t) {
+		tp_for_each_touch_in_mask(tp, t, active) {
 			if (t->state == TOUCH_BEGIN)
 				t->scroll.edge_state =
 					EDGE_SCROLL_TOUCH_STATE_AREA;
@@ -377,10 +380,7 @@ tp_edge_scroll_handle_state(struct tp_dispatch *tp, uint64_t time)
 		return;
 	}
 
-	tp_for_each_touch(tp, t) {
-		if (!t->dirty)
-			continue;
-
+	tp_for_each_touch_in_mask(tp, t, dirty) {
 		switch (t->state) {
 		case TOUCH_NONE:
 		case TOUCH_HOVERING:
@@ -416,7 +416,9 @@ tp_edge_scroll_handle_state(struct tp_dispatch *tp, uint64_t time)
 }
 
 int
-tp_edge_scroll_post_events(struct tp_dispatch *tp, uint64_t time)
+tp_edge_scroll_post_events(struct tp_dispatch *tp,
+			   uint64_t dirty,
+			   uint64_t time)
 {
 	struct evdev_device *device = tp->device;
 	struct tp_touch *t;
@@ -427,10 +429,7 @@ tp_edge_scroll_post_events(struct tp_dispatch *tp, uint64_t time)
 	struct normalized_coords normalized, tmp;
 	const struct normalized_coords zero = { 0.0, 0.0 };
 
-	tp_for_each_touch(tp, t) {
-		if (!t->dirty)
-			continue;
-
+	tp_for_each_touch_in_mask(tp, t, dirty) {
 		if (t->palm.state != PALM_NONE || tp_thumb_ignored(tp, t))
 			continue;
 
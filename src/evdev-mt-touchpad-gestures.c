@@ -123,12 +123,10 @@ static struct device_float_coords
 tp_get_touches_delta(struct tp_dispatch *tp, bool average)
 {
 	struct tp_touch *t;
-	unsigned int i, nactive = 0;
+	unsigned int nactive = 0;
 	struct device_float_coords delta = {0.0, 0.0};
 
-	for (i = 0; i < tp->num_slots; i++) {
-		t = &tp->touches[i];
-
+	tp_for_each_touch_in_mask(tp, t, tp->touch_mask.active & tp_slot_mask(tp)) {
 		if (!tp_touch_active_for_gesture(tp, t))
 			continue;
 
@@ -238,7 +236,7 @@ tp_gesture_get_active_touches(const struct tp_dispatch *tp,
 
 	memset(touches, 0, count * sizeof(struct tp_touch *));
 
-	tp_for_each_touch(tp, t) {
+	tp_for_each_active_touch(tp, t) {
 		if (tp_touch_active_for_gesture(tp, t)) {
 			touches[n++] = t;
 			if (n == count)
@@ -2051,12 +2049,14 @@ tp_gesture_debounce_finger_changes(struct tp_dispatch *tp)
 }
 
 void
-tp_gesture_update_finger_state(struct tp_dispatch *tp, uint64_t time)
+tp_gesture_update_finger_state(struct tp_dispatch *tp,
+			       uint64_t active,
+			       uint64_t time)
 {
 	unsigned int active_touches = 0;
 	struct tp_touch *t;
 
-	tp_for_each_touch(tp, t) {
+	tp_for_each_touch_in_mask(tp, t, active) {
 		if (tp_touch_active_for_gesture(tp, t))
 			active_touches++;
 	}
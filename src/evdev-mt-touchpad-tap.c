@@ -1183,7 +1183,7 @@ tp_tap_enabled(struct tp_dispatch *tp)
 }
 
 int
-tp_tap_handle_state(struct tp_dispatch *tp, uint64_t time)
+tp_tap_handle_state(struct tp_dispatch *tp, uint64_t dirty, uint64_t time)
 {
     struct tp_touch *t;
     int filter_motion = 0;
@@ -1197,8 +1197,8 @@ tp_tap_handle_state(struct tp_dispatch *tp, uint64_t time)
     if (tp->buttons.is_clickpad && tp->queued & TOUCHPAD_EVENT_BUTTON_PRESS)
         tp_tap_handle_event(tp, NULL, TAP_EVENT_BUTTON, time);
 
-    tp_for_each_touch(tp, t) {
-        if (!t->dirty || t->state == TOUCH_NONE)
+    tp_for_each_touch_in_mask(tp, t, dirty) {
+        if (t->state == TOUCH_NONE)
             continue;
 
         if (tp->buttons.is_clickpad &&
@@ -1326,9 +1326,8 @@ tp_tap_handle_timeout(uint64_t time, void *data)
 
     tp_tap_handle_event(tp, NULL, TAP_EVENT_TIMEOUT, time);
 
-    tp_for_each_touch(tp, t) {
-        if (t->state == TOUCH_NONE ||
-            t->tap.state == TAP_TOUCH_STATE_IDLE)
+    tp_for_each_active_touch(tp, t) {
+        if (t->tap.state == TAP_TOUCH_STATE_IDLE)
             continue;
 
         t->tap.state = TAP_TOUCH_STATE_DEAD;
@@ -1350,10 +1349,7 @@ tp_tap_enabled_update(struct tp_dispatch *tp, bool suspended, bool enabled, uint
         struct tp_touch *t;
 
         /* On resume, all touches are considered palms */
-        tp_for_each_touch(tp, t) {
-            if (t->state == TOUCH_NONE)
-                continue;
-
+        tp_for_each_active_touch(tp, t) {
             t->tap.is_palm = true;
             t->tap.state = TAP_TOUCH_STATE_DEAD;
         }
@@ -1568,7 +1564,7 @@ void
 tp_remove_tap(struct tp_dispatch *tp)
 {
     libinput_timer_cancel(&tp->tap.timer);
-    tp_edge_motion_cleanup();
+    tp_edge_motion_cleanup(tp);
 }
 
 void
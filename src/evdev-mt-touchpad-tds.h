@@ -27,6 +27,6 @@
 #include "evdev-mt-touchpad.h"
 
 int tp_edge_motion_handle_drag_state(struct tp_dispatch *tp, uint64_t time);
-void tp_edge_motion_cleanup(void);
+void tp_edge_motion_cleanup(struct tp_dispatch *tp);
 
 #endif /* EVDEV_MT_TOUCHPAD_TDS */
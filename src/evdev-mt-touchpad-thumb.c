@@ -282,9 +282,8 @@ tp_thumb_update_multifinger(struct tp_dispatch *tp)
 	/* Get the first and second bottom-most touches, the max speed exceeded
 	 * count overall, and the newest and oldest touches.
 	 */
-	tp_for_each_touch(tp, t) {
-		if (t->state == TOUCH_NONE ||
-		    t->state == TOUCH_HOVERING)
+	tp_for_each_active_touch(tp, t) {
+		if (t->state == TOUCH_HOVERING)
 			continue;
 
 		if (t->state == TOUCH_BEGIN)
@@ -42,6 +42,9 @@
 #define DEFAULT_KEYBOARD_ACTIVITY_TIMEOUT_2 ms2us(500)
 #define FAKE_FINGER_OVERFLOW bit(7)
 #define THUMB_IGNORE_SPEED_THRESHOLD 20 /* mm/s */
+#define MSC_CLOCK_MAX_LAG ms2us(20)
+#define MSC_CLOCK_DRIFT_WINDOW s2us(1)
+#define MSC_CLOCK_MAX_DRIFT 0.02 /* 2%, anything above is garbage */
 
 enum notify {
 	DONT_NOTIFY,
@@ -344,7 +347,7 @@ tp_new_touch(struct tp_dispatch *tp, struct tp_touch *t, uint64_t time)
 				     "touch %d ended and began in in same frame.\n",
 				     t->index);
 		tp->nfingers_down++;
-		t->state = TOUCH_UPDATE;
+		tp_touch_set_state(tp, t, TOUCH_UPDATE);
 		t->has_ended = false;
 		return;
 	}
@@ -353,11 +356,11 @@ tp_new_touch(struct tp_dispatch *tp, struct tp_touch *t, uint64_t time)
 	 * don't know if it's a touch down or not. And BTN_TOUCH may happen
 	 * after ABS_MT_TRACKING_ID */
 	tp_motion_history_reset(t);
-	t->dirty = true;
+	tp_touch_set_dirty(tp, t);
 	t->has_ended = false;
 	t->was_down = false;
 	t->palm.state = PALM_NONE;
-	t->state = TOUCH_HOVERING;
+	tp_touch_set_state(tp, t, TOUCH_HOVERING);
 	t->pinned.is_pinned = false;
 	t->speed.last_speed = 0;
 	t->speed.exceeded_count = 0;
@@ -368,8 +371,8 @@ tp_new_touch(struct tp_dispatch *tp, struct tp_touch *t, uint64_t time)
 static inline void
 tp_begin_touch(struct tp_dispatch *tp, struct tp_touch *t, uint64_t time)
 {
-	t->dirty = true;
-	t->state = TOUCH_BEGIN;
+	tp_touch_set_dirty(tp, t);
+	tp_touch_set_state(tp, t, TOUCH_BEGIN);
 	t->initial_time = time;
 	t->was_down = true;
 	tp->nfingers_down++;
@@ -412,12 +415,12 @@ tp_maybe_end_touch(struct tp_dispatch *tp,
 	if (t->state != TOUCH_HOVERING) {
 		assert(tp->nfingers_down >= 1);
 		tp->nfingers_down--;
-		t->state = TOUCH_MAYBE_END;
+		tp_touch_set_state(tp, t, TOUCH_MAYBE_END);
 	} else {
-		t->state = TOUCH_NONE;
+		tp_touch_set_state(tp, t, TOUCH_NONE);
 	}
 
-	t->dirty = true;
+	tp_touch_set_dirty(tp, t);
 }
 
 /**
@@ -428,8 +431,8 @@ static inline void
 tp_recover_ended_touch(struct tp_dispatch *tp,
 		       struct tp_touch *t)
 {
-	t->dirty = true;
-	t->state = TOUCH_UPDATE;
+	tp_touch_set_dirty(tp, t);
+	tp_touch_set_state(tp, t, TOUCH_UPDATE);
 	tp->nfingers_down++;
 }
 
@@ -448,9 +451,9 @@ tp_end_touch(struct tp_dispatch *tp, struct tp_touch *t, uint64_t time)
 		return;
 	}
 
-	t->dirty = true;
+	tp_touch_set_dirty(tp, t);
 	t->palm.state = PALM_NONE;
-	t->state = TOUCH_END;
+	tp_touch_set_state(tp, t, TOUCH_END);
 	t->pinned.is_pinned = false;
 	t->palm.time = 0;
 	t->speed.exceeded_count = 0;
@@ -528,7 +531,7 @@ tp_process_absolute(struct tp_dispatch *tp,
 						  e->usage,
 						  e->value);
 		t->point.x = rotated(tp, e->usage, e->value);
-		t->dirty = true;
+		tp_touch_set_dirty(tp, t);
 		tp->queued |= TOUCHPAD_EVENT_MOTION;
 		break;
 	case EVDEV_ABS_MT_POSITION_Y:
@@ -536,7 +539,7 @@ tp_process_absolute(struct tp_dispatch *tp,
 						  e->usage,
 						  e->value);
 		t->point.y = rotated(tp, e->usage, e->value);
-		t->dirty = true;
+		tp_touch_set_dirty(tp, t);
 		tp->queued |= TOUCHPAD_EVENT_MOTION;
 		break;
 	case EVDEV_ABS_MT_SLOT:
@@ -553,22 +556,22 @@ tp_process_absolute(struct tp_dispatch *tp,
 		break;
 	case EVDEV_ABS_MT_PRESSURE:
 		t->pressure = e->value;
-		t->dirty = true;
+		tp_touch_set_dirty(tp, t);
 		tp->queued |= TOUCHPAD_EVENT_OTHERAXIS;
 		break;
 	case EVDEV_ABS_MT_TOOL_TYPE:
 		t->is_tool_palm = e->value == MT_TOOL_PALM;
-		t->dirty = true;
+		tp_touch_set_dirty(tp, t);
 		tp->queued |= TOUCHPAD_EVENT_OTHERAXIS;
 		break;
 	case EVDEV_ABS_MT_TOUCH_MAJOR:
 		t->major = e->value;
-		t->dirty = true;
+		tp_touch_set_dirty(tp, t);
 		tp->queued |= TOUCHPAD_EVENT_OTHERAXIS;
 		break;
 	case EVDEV_ABS_MT_TOUCH_MINOR:
 		t->minor = e->value;
-		t->dirty = true;
+		tp_touch_set_dirty(tp, t);
 		tp->queued |= TOUCHPAD_EVENT_OTHERAXIS;
 		break;
 	default:
@@ -589,7 +592,7 @@ tp_process_absolute_st(struct tp_dispatch *tp,
 						  e->usage,
 						  e->value);
 		t->point.x = rotated(tp, e->usage, e->value);
-		t->dirty = true;
+		tp_touch_set_dirty(tp, t);
 		tp->queued |= TOUCHPAD_EVENT_MOTION;
 		break;
 	case EVDEV_ABS_Y:
@@ -597,12 +600,12 @@ tp_process_absolute_st(struct tp_dispatch *tp,
 						  e->usage,
 						  e->value);
 		t->point.y = rotated(tp, e->usage, e->value);
-		t->dirty = true;
+		tp_touch_set_dirty(tp, t);
 		tp->queued |= TOUCHPAD_EVENT_MOTION;
 		break;
 	case EVDEV_ABS_PRESSURE:
 		t->pressure = e->value;
-		t->dirty = true;
+		tp_touch_set_dirty(tp, t);
 		tp->queued |= TOUCHPAD_EVENT_OTHERAXIS;
 		break;
 	default:
@@ -781,7 +784,7 @@ tp_process_msc(struct tp_dispatch *tp,
 	       const struct evdev_event *e,
 	       uint64_t time)
 {
-	if (evdev_usage_eq(e->usage, EVDEV_MSC_TIMESTAMP))
+	if (!evdev_usage_eq(e->usage, EVDEV_MSC_TIMESTAMP))
 		return;
 
 	tp->quirks.msc_timestamp.now = e->value;
@@ -1003,7 +1006,7 @@ tp_palm_detect_multifinger(struct tp_dispatch *tp, struct tp_touch *t, uint64_t
 	 * frame the second touch will still be PALM_NONE and thus detected
 	 * here as non-palm touch. This is too niche to worry about for now.
 	 */
-	tp_for_each_touch(tp, other) {
+	tp_for_each_active_touch(tp, other) {
 		if (other == t)
 			continue;
 
@@ -1205,12 +1208,7 @@ tp_unhover_pressure(struct tp_dispatch *tp, uint64_t time)
 	if (nfake_touches == FAKE_FINGER_OVERFLOW)
 		nfake_touches = 0;
 
-	for (i = 0; i < (int)tp->num_slots; i++) {
-		t = tp_get_touch(tp, i);
-
-		if (t->state == TOUCH_NONE)
-			continue;
-
+	tp_for_each_touch_in_mask(tp, t, tp->touch_mask.active & tp_slot_mask(tp)) {
 		if (t->dirty) {
 			if (t->state == TOUCH_HOVERING) {
 				if (t->pressure >= tp->pressure.high) {
@@ -1288,20 +1286,14 @@ tp_unhover_size(struct tp_dispatch *tp, uint64_t time)
 	struct tp_touch *t;
 	int low = tp->touch_size.low,
 	    high = tp->touch_size.high;
-	int i;
+	uint64_t mask = tp->touch_mask.active &
+			tp->touch_mask.dirty &
+			tp_slot_mask(tp);
 
 	/* We require 5 slots for size handling, so we don't need to care
 	 * about fake touches here */
 
-	for (i = 0; i < (int)tp->num_slots; i++) {
-		t = tp_get_touch(tp, i);
-
-		if (t->state == TOUCH_NONE)
-			continue;
-
-		if (!t->dirty)
-			continue;
-
+	tp_for_each_touch_in_mask(tp, t, mask) {
 		if (t->state == TOUCH_HOVERING) {
 			if ((t->major > high && t->minor > low) ||
 			    (t->major > low && t->minor > high)) {
@@ -1431,8 +1423,8 @@ tp_position_fake_touches(struct tp_dispatch *tp)
 
 		t->point = topmost->point;
 		t->pressure = topmost->pressure;
-		if (!t->dirty)
-			t->dirty = topmost->dirty;
+		if (topmost->dirty)
+			tp_touch_set_dirty(tp, t);
 	}
 }
 
@@ -1670,6 +1662,127 @@ tp_process_msc_timestamp(struct tp_dispatch *tp, uint64_t time)
 	}
 }
 
+static inline void
+tp_msc_clock_sync(struct msc_clock *c, uint64_t time)
+{
+	c->synced = true;
+	c->hw_time = 0;
+	c->hw_ref = 0;
+	c->base = time;
+	c->window.have_prev = false;
+	c->window.start = 0;
+	c->window.min_offset = INT64_MAX;
+}
+
+static inline uint64_t
+tp_msc_clock_predict(const struct msc_clock *c)
+{
+	return c->base + (uint64_t)((c->hw_time - c->hw_ref) * c->drift);
+}
+
+static void
+tp_msc_clock_update_drift(struct tp_dispatch *tp,
+			  struct msc_clock *c,
+			  uint64_t time)
+{
+	int64_t offset = (int64_t)time - (int64_t)c->hw_time;
+
+	/* The kernel time is the hw time plus some transport latency that
+	 * varies from frame to frame. The minimum offset within a window
+	 * is the frame with the least latency, if that minimum moves
+	 * between windows the two clocks run at different rates. */
+	c->window.min_offset = min(c->window.min_offset, offset);
+
+	if (c->hw_time - c->window.start < MSC_CLOCK_DRIFT_WINDOW)
+		return;
+
+	if (c->window.have_prev) {
+		double slope = (double)(c->window.min_offset - c->window.prev_min_offset) /
+			       (c->window.start - c->window.prev_start);
+
+		if (fabs(slope) > MSC_CLOCK_MAX_DRIFT) {
+			evdev_log_debug(tp->device,
+					"msc-clock: discarding drift estimate %.4f\n",
+					1.0 + slope);
+		} else {
+			/* Rebase so the drift change doesn't move the
+			 * current time */
+			c->base = tp_msc_clock_predict(c);
+			c->hw_ref = c->hw_time;
+			c->drift += (1.0 + slope - c->drift) / 8;
+		}
+	}
+
+	c->window.have_prev = true;
+	c->window.prev_start = c->window.start;
+	c->window.prev_min_offset = c->window.min_offset;
+	c->window.start = c->hw_time;
+	c->window.min_offset = INT64_MAX;
+}
+
+/**
+ * Returns the time to use for the current frame. Where the quirk enables
+ * it, that time is based on MSC_TIMESTAMP instead of the time the kernel
+ * assigned to the SYN_REPORT. The latter depends on when the USB/i2c/BT
+ * transport delivered the report and thus jitters, the hardware timestamp
+ * gives us the real spacing between frames.
+ *
+ * The hw clock is mapped onto CLOCK_MONOTONIC with the minimum observed
+ * latency: a frame time is never later than the kernel time (otherwise
+ * our timers and events would be in the future) and never more than
+ * MSC_CLOCK_MAX_LAG behind it. The rate difference between the two clocks
+ * is estimated continuously, see tp_msc_clock_update_drift().
+ */
+static uint64_t
+tp_msc_clock_frame_time(struct tp_dispatch *tp, uint64_t time)
+{
+	struct msc_clock *c = &tp->quirks.msc_clock;
+	uint32_t now = tp->quirks.msc_timestamp.now;
+	uint64_t frame_time;
+
+	if (!c->enabled)
+		return time;
+
+	/* Frames without a timestamp, e.g. physical buttons */
+	if (!(tp->queued & TOUCHPAD_EVENT_TIMESTAMP)) {
+		c->last_frame = time;
+		return time;
+	}
+
+	/* MSC_TIMESTAMP resets to zero after a kernel timeout (1s), any
+	 * larger delta means we missed that reset. Wraparound is handled
+	 * by the unsigned subtraction */
+	uint32_t delta = now - c->last;
+	c->last = now;
+
+	if (!c->synced || now == 0 || delta > s2us(1)) {
+		tp_msc_clock_sync(c, time);
+		frame_time = time;
+	} else {
+		c->hw_time += delta;
+		tp_msc_clock_update_drift(tp, c, time);
+
+		frame_time = tp_msc_clock_predict(c);
+		if (frame_time > time) {
+			/* This frame had less latency than any before it */
+			c->base -= frame_time - time;
+			frame_time = time;
+		} else if (time - frame_time > MSC_CLOCK_MAX_LAG) {
+			c->base += time - frame_time - MSC_CLOCK_MAX_LAG;
+			frame_time = time - MSC_CLOCK_MAX_LAG;
+		} else {
+			/* Slowly let go of the minimum so a single
+			 * low-latency outlier doesn't stick forever */
+			c->base += (time - frame_time) / 256;
+		}
+	}
+
+	frame_time = max(frame_time, c->last_frame);
+	c->last_frame = frame_time;
+
+	return frame_time;
+}
+
 static void
 tp_pre_process_state(struct tp_dispatch *tp, uint64_t time)
 {
@@ -1681,7 +1794,7 @@ tp_pre_process_state(struct tp_dispatch *tp, uint64_t time)
 	tp_process_fake_touches(tp, time);
 	tp_unhover_touches(tp, time);
 
-	tp_for_each_touch(tp, t) {
+	tp_for_each_active_touch(tp, t) {
 		if (t->state == TOUCH_MAYBE_END)
 			tp_end_touch(tp, t, time);
 
@@ -1705,10 +1818,7 @@ tp_process_state(struct tp_dispatch *tp, uint64_t time)
 
 	want_motion_reset = tp_need_motion_history_reset(tp);
 
-	tp_for_each_touch(tp, t) {
-		if (t->state == TOUCH_NONE)
-			continue;
-
+	tp_for_each_active_touch(tp, t) {
 		if (want_motion_reset) {
 			tp_motion_history_reset(t);
 			t->quirks.reset_motion_history = true;
@@ -1790,7 +1900,10 @@ tp_process_state(struct tp_dispatch *tp, uint64_t time)
 		filter_restart(tp->device->pointer.filter, tp, time);
 
 	tp_button_handle_state(tp, time);
-	tp_edge_scroll_handle_state(tp, time);
+	tp_edge_scroll_handle_state(tp,
+				    tp->touch_mask.active,
+				    tp->touch_mask.dirty,
+				    time);
 
 	/*
 	 * We have a physical button down event on a clickpad. To avoid
@@ -1802,7 +1915,7 @@ tp_process_state(struct tp_dispatch *tp, uint64_t time)
 	    tp->buttons.is_clickpad)
 		tp_pin_fingers(tp);
 
-	tp_gesture_update_finger_state(tp, time);
+	tp_gesture_update_finger_state(tp, tp->touch_mask.active, time);
 }
 
 static void
@@ -1810,22 +1923,19 @@ tp_post_process_state(struct tp_dispatch *tp, uint64_t time)
 {
 	struct tp_touch *t;
 
-	tp_for_each_touch(tp, t) {
-
-		if (!t->dirty)
-			continue;
-
+	tp_for_each_dirty_touch(tp, t) {
 		if (t->state == TOUCH_END) {
 			if (t->has_ended)
-				t->state = TOUCH_NONE;
+				tp_touch_set_state(tp, t, TOUCH_NONE);
 			else
-				t->state = TOUCH_HOVERING;
+				tp_touch_set_state(tp, t, TOUCH_HOVERING);
 		} else if (t->state == TOUCH_BEGIN) {
-			t->state = TOUCH_UPDATE;
+			tp_touch_set_state(tp, t, TOUCH_UPDATE);
 		}
 
 		t->dirty = false;
 	}
+	tp->touch_mask.dirty = 0;
 
 	tp->old_nfingers_down = tp->nfingers_down;
 	tp->buttons.old_state = tp->buttons.state;
@@ -1850,7 +1960,7 @@ tp_post_events(struct tp_dispatch *tp, uint64_t time)
 		return;
 	}
 
-	ignore_motion |= tp_tap_handle_state(tp, time);
+	ignore_motion |= tp_tap_handle_state(tp, tp->touch_mask.dirty, time);
 	ignore_motion |= tp_post_button_events(tp, time);
 
 	if (tp->palm.trackpoint_active || tp->dwt.keyboard_active) {
@@ -1866,7 +1976,7 @@ tp_post_events(struct tp_dispatch *tp, uint64_t time)
 		return;
 	}
 
-	if (tp_edge_scroll_post_events(tp, time) != 0)
+	if (tp_edge_scroll_post_events(tp, tp->touch_mask.dirty, time) != 0)
 		return;
 
 	tp_gesture_post_events(tp, time, false);
@@ -1929,13 +2039,11 @@ tp_debug_touch_state(struct tp_dispatch *tp,
 }
 
 static void
-tp_interface_process(struct evdev_dispatch *dispatch,
-		     struct evdev_device *device,
-		     struct evdev_event *e,
-		     uint64_t time)
+tp_process_event(struct tp_dispatch *tp,
+		 struct evdev_device *device,
+		 struct evdev_event *e,
+		 uint64_t time)
 {
-	struct tp_dispatch *tp = tp_dispatch(dispatch);
-
 	uint16_t type = evdev_event_type(e);
 	switch (type) {
 	case EV_ABS:
@@ -1951,6 +2059,7 @@ tp_interface_process(struct evdev_dispatch *dispatch,
 		tp_process_msc(tp, e, time);
 		break;
 	case EV_SYN:
+		time = tp_msc_clock_frame_time(tp, time);
 		tp_handle_state(tp, time);
 #if 0
 		tp_debug_touch_state(tp, device);
@@ -1959,6 +2068,31 @@ tp_interface_process(struct evdev_dispatch *dispatch,
 	}
 }
 
+static void
+tp_interface_process(struct evdev_dispatch *dispatch,
+		     struct evdev_device *device,
+		     struct evdev_event *e,
+		     uint64_t time)
+{
+	struct tp_dispatch *tp = tp_dispatch(dispatch);
+
+	tp_process_event(tp, device, e, time);
+}
+
+static void
+tp_interface_process_frame(struct evdev_dispatch *dispatch,
+			   struct evdev_device *device,
+			   struct evdev_frame *frame)
+{
+	struct tp_dispatch *tp = tp_dispatch(dispatch);
+	uint64_t time = evdev_frame_get_time(frame);
+	size_t nevents;
+	struct evdev_event *events = evdev_frame_get_events(frame, &nevents);
+
+	for (size_t i = 0; i < nevents; i++)
+		tp_process_event(tp, device, &events[i], time);
+}
+
 static void
 tp_remove_sendevents(struct tp_dispatch *tp)
 {
@@ -2717,8 +2851,8 @@ evdev_tag_touchpad(struct evdev_device *device,
 	int bustype, vendor;
 	const char *prop;
 
-	prop = udev_device_get_property_value(udev_device,
-					      "ID_INPUT_TOUCHPAD_INTEGRATION");
+	prop = evdev_device_get_property(device,
+					 "ID_INPUT_TOUCHPAD_INTEGRATION");
 	if (prop) {
 		if (streq(prop, "internal")) {
 			evdev_tag_touchpad_internal(device);
@@ -2842,6 +2976,7 @@ tp_interface_left_handed_toggled(struct evdev_dispatch *dispatch,
 
 static struct evdev_dispatch_interface tp_interface = {
 	.process = tp_interface_process,
+	.process_frame = tp_interface_process_frame,
 	.suspend = tp_interface_suspend,
 	.remove = tp_interface_remove,
 	.destroy = tp_interface_destroy,
@@ -2943,6 +3078,16 @@ tp_init_slots(struct tp_dispatch *tp,
 		}
 	}
 
+	/* We track touches in 64-bit masks, no touchpad comes close to
+	 * that number of slots */
+	if (tp->num_slots > TOUCHPAD_MAX_TOUCHES) {
+		evdev_log_bug_kernel(device,
+				     "Too many slots (%u), limiting to %d\n",
+				     tp->num_slots,
+				     TOUCHPAD_MAX_TOUCHES);
+		tp->num_slots = TOUCHPAD_MAX_TOUCHES;
+	}
+
 	tp->ntouches = max(tp->num_slots, n_btn_tool_touches);
 	tp->touches = zalloc(tp->ntouches * sizeof(struct tp_touch));
 
@@ -3685,6 +3830,27 @@ tp_init_touch_size(struct tp_dispatch *tp,
 	return true;
 }
 
+static void
+tp_init_msc_clock(struct tp_dispatch *tp,
+		  struct evdev_device *device)
+{
+	char *prop;
+
+	tp->quirks.msc_clock.drift = 1.0;
+
+	if (!libevdev_has_event_code(device->evdev, EV_MSC, MSC_TIMESTAMP))
+		return;
+
+	_unref_(quirks) *q = libinput_device_get_quirks(&device->base);
+	if (!q ||
+	    !quirks_get_string(q, QUIRK_ATTR_MSC_TIMESTAMP, &prop) ||
+	    !streq(prop, "use"))
+		return;
+
+	tp->quirks.msc_clock.enabled = true;
+	evdev_log_debug(device, "using MSC_TIMESTAMP for frame times\n");
+}
+
 static void
 tp_init_pressurepad(struct tp_dispatch *tp,
 		    struct evdev_device *device)
@@ -3762,6 +3928,8 @@ tp_init(struct tp_dispatch *tp,
 					 QUIRK_MODEL_LENOVO_X1GEN6_TOUCHPAD))
 		tp->jump.detection_disabled = true;
 
+	tp_init_msc_clock(tp, device);
+
 	device->seat_caps |= EVDEV_DEVICE_POINTER;
 	if (tp->gesture.enabled)
 		device->seat_caps |= EVDEV_DEVICE_GESTURE;
@@ -32,6 +32,9 @@
 #define TOUCHPAD_HISTORY_LENGTH 4
 #define TOUCHPAD_MIN_SAMPLES 4
 
+/* Upper limit for tp->ntouches, one bit per touch in the touch masks */
+#define TOUCHPAD_MAX_TOUCHES 64
+
 /* Convert mm to a distance normalized to DEFAULT_MOUSE_DPI */
 #define TP_MM_TO_DPI_NORMALIZED(mm) (DEFAULT_MOUSE_DPI/25.4 * mm)
 
@@ -311,6 +314,19 @@ struct tp_dispatch {
 	unsigned int num_slots;			/* number of slots */
 	unsigned int ntouches;			/* no slots inc. fakes */
 	struct tp_touch *touches;		/* len == ntouches */
+
+	/* Bit n represents touches[n]. Most touchpads have far more slots
+	 * than fingers down, these masks let us skip the unused ones.
+	 * active: t->state != TOUCH_NONE
+	 * dirty: t->dirty is set
+	 * Use tp_touch_set_state() and tp_touch_set_dirty() to keep
+	 * these in sync.
+	 */
+	struct {
+		uint64_t active;
+		uint64_t dirty;
+	} touch_mask;
+
 	/* bit 0: BTN_TOUCH
 	 * bit 1: BTN_TOOL_FINGER
 	 * bit 2: BTN_TOOL_DOUBLETAP
@@ -450,6 +466,8 @@ struct tp_dispatch {
 		enum libinput_config_drag_lock_state drag_lock;
 
 		unsigned int nfingers_down;	/* number of fingers down for tapping (excl. thumb/palm) */
+
+		struct edge_motion_fsm *edge_motion; /* tap-and-drag edge motion, allocated on demand */
 	} tap;
 
 	struct {
@@ -536,6 +554,30 @@ struct tp_dispatch {
 			uint32_t interval;
 			uint32_t now;
 		} msc_timestamp;
+
+		/* With AttrMscTimestamp=use the frame time is derived from
+		 * MSC_TIMESTAMP instead of the kernel's SYN_REPORT time,
+		 * see tp_msc_clock_frame_time() */
+		struct msc_clock {
+			bool enabled;
+			bool synced;
+			uint32_t last;		/* last MSC_TIMESTAMP, in µs */
+			uint64_t hw_time;	/* µs since sync */
+			uint64_t hw_ref;	/* hw_time that maps to base */
+			uint64_t base;		/* CLOCK_MONOTONIC in µs */
+			double drift;		/* monotonic µs per hw µs */
+			uint64_t last_frame;
+
+			/* Minimum kernel-hw offset per ~1s window, the
+			 * change in those minimums gives us the drift */
+			struct {
+				bool have_prev;
+				uint64_t start;
+				int64_t min_offset;
+				uint64_t prev_start;
+				int64_t prev_min_offset;
+			} window;
+		} msc_clock;
 	} quirks;
 
 	struct {
@@ -569,6 +611,55 @@ tp_dispatch(struct evdev_dispatch *dispatch)
 #define tp_for_each_touch(_tp, _t) \
 	for (unsigned int _i = 0; _i < (_tp)->ntouches && (_t = &(_tp)->touches[_i]); _i++)
 
+/* Iterates over the touches in the given touch mask in index order. The
+ * mask is evaluated once, changing the touch masks inside the loop body
+ * does not affect the iteration */
+#define tp_for_each_touch_in_mask(_tp, _t, _mask) \
+	for (uint64_t _m = (_mask); \
+	     _m != 0 && (_t = &(_tp)->touches[__builtin_ctzll(_m)]); \
+	     _m &= _m - 1)
+
+#define tp_for_each_active_touch(_tp, _t) \
+	tp_for_each_touch_in_mask(_tp, _t, (_tp)->touch_mask.active)
+
+#define tp_for_each_dirty_touch(_tp, _t) \
+	tp_for_each_touch_in_mask(_tp, _t, (_tp)->touch_mask.dirty)
+
+static inline uint64_t
+tp_touch_bit(const struct tp_touch *t)
+{
+	return 1ULL << t->index;
+}
+
+/* The mask of all real (i.e. non-fake) touches */
+static inline uint64_t
+tp_slot_mask(const struct tp_dispatch *tp)
+{
+	if (tp->num_slots >= TOUCHPAD_MAX_TOUCHES)
+		return ~0ULL;
+
+	return (1ULL << tp->num_slots) - 1;
+}
+
+static inline void
+tp_touch_set_dirty(struct tp_dispatch *tp, struct tp_touch *t)
+{
+	t->dirty = true;
+	tp->touch_mask.dirty |= tp_touch_bit(t);
+}
+
+static inline void
+tp_touch_set_state(struct tp_dispatch *tp,
+		   struct tp_touch *t,
+		   enum touch_state state)
+{
+	t->state = state;
+	if (state == TOUCH_NONE)
+		tp->touch_mask.active &= ~tp_touch_bit(t);
+	else
+		tp->touch_mask.active |= tp_touch_bit(t);
+}
+
 static inline struct libinput*
 tp_libinput_context(const struct tp_dispatch *tp)
 {
@@ -641,7 +732,7 @@ tp_touch_active_for_gesture(const struct tp_dispatch *tp,
 			    const struct tp_touch *t);
 
 int
-tp_tap_handle_state(struct tp_dispatch *tp, uint64_t time);
+tp_tap_handle_state(struct tp_dispatch *tp, uint64_t dirty, uint64_t time);
 
 void
 tp_tap_post_process_state(struct tp_dispatch *tp);
@@ -712,10 +803,15 @@ void
 tp_remove_edge_scroll(struct tp_dispatch *tp);
 
 void
-tp_edge_scroll_handle_state(struct tp_dispatch *tp, uint64_t time);
+tp_edge_scroll_handle_state(struct tp_dispatch *tp,
+			    uint64_t active,
+			    uint64_t dirty,
+			    uint64_t time);
 
 int
-tp_edge_scroll_post_events(struct tp_dispatch *tp, uint64_t time);
+tp_edge_scroll_post_events(struct tp_dispatch *tp,
+			   uint64_t dirty,
+			   uint64_t time);
 
 void
 tp_edge_scroll_stop_events(struct tp_dispatch *tp, uint64_t time);
@@ -743,7 +839,9 @@ void
 tp_gesture_cancel_motion_gestures(struct tp_dispatch *tp, uint64_t time);
 
 void
-tp_gesture_update_finger_state(struct tp_dispatch *tp, uint64_t time);
+tp_gesture_update_finger_state(struct tp_dispatch *tp,
+			       uint64_t active,
+			       uint64_t time);
 
 void
 tp_gesture_post_events(struct tp_dispatch *tp, uint64_t time,
@@ -24,7 +24,9 @@
 #include "config.h"
 
 #include "util-mem.h"
+#if HAVE_MTDEV
 #include <mtdev-plumbing.h>
+#endif
 
 #include "evdev.h"
 #include "evdev-plugin.h"
@@ -93,6 +95,27 @@ evdev_process_event(struct evdev_device *device,
 	dispatch->interface->process(dispatch, device, e, time);
 }
 
+static inline void
+evdev_process_frame(struct evdev_device *device,
+		    struct evdev_frame *frame,
+		    uint64_t time)
+{
+	struct evdev_dispatch *dispatch = device->dispatch;
+
+#if EVENT_DEBUGGING
+	size_t nevents;
+	struct evdev_event *events = evdev_frame_get_events(frame, &nevents);
+	for (size_t i = 0; i < nevents; i++)
+		evdev_print_event(device, &events[i], time);
+#endif
+
+	/* Timers only need to catch up once per frame, all events
+	 * within the frame share the same timestamp */
+	libinput_timer_flush(evdev_libinput_context(device), time);
+
+	dispatch->interface->process_frame(dispatch, device, frame);
+}
+
 static inline void
 evdev_device_dispatch_frame(struct libinput_plugin *plugin,
 			  struct libinput_device *libinput_device,
@@ -100,14 +123,23 @@ evdev_device_dispatch_frame(struct libinput_plugin *plugin,
 {
 	struct evdev_device *device = evdev_device(libinput_device);
 	uint64_t time = evdev_frame_get_time(frame);
-
-	size_t nevents;
-	struct evdev_event *events = evdev_frame_get_events(frame, &nevents);
-	for (size_t i = 0; i < nevents; i++) {
-		struct evdev_event *ev = &events[i];
-		if (!device->mtdev) {
-			evdev_process_event(device, ev, time);
-		} else {
+	uint64_t start = 0;
+
+	if (evdev_libinput_context(device)->stats_enabled)
+		start = libinput_now(evdev_libinput_context(device));
+
+	if (!device->mtdev && device->dispatch->interface->process_frame) {
+		evdev_process_frame(device, frame, time);
+	} else {
+		size_t nevents;
+		struct evdev_event *events = evdev_frame_get_events(frame, &nevents);
+		for (size_t i = 0; i < nevents; i++) {
+			struct evdev_event *ev = &events[i];
+			if (!device->mtdev) {
+				evdev_process_event(device, ev, time);
+				continue;
+			}
+#if HAVE_MTDEV
 			struct input_event e = evdev_event_to_input_event(ev, time);
 			mtdev_put_event(device->mtdev, &e);
 			if (evdev_usage_eq(ev->usage, EVDEV_SYN_REPORT)) {
@@ -121,9 +153,16 @@ evdev_device_dispatch_frame(struct libinput_plugin *plugin,
 					evdev_process_event(device, &ev, time);
 				}
 			}
+#endif
 		}
 	}
 
+	if (start) {
+		uint64_t end = libinput_now(evdev_libinput_context(device));
+		if (end > start)
+			libinput_device->latency.interface_time += end - start;
+	}
+
 	/* Discard event to make the plugin system aware we're done */
 	evdev_frame_reset(frame);
 }
@@ -52,6 +52,10 @@ struct pad_led_group {
 	struct libinput_tablet_pad_mode_group base;
 	struct list led_list;
 	struct list toggle_button_list;
+
+	/* current_mode may be out of sync with the LEDs, re-read them
+	 * on the next mode toggle */
+	bool mode_stale;
 };
 
 struct pad_mode_toggle_button {
@@ -210,8 +214,7 @@ pad_get_mode_group(struct pad_dispatch *pad, unsigned int index)
 static inline bool
 is_litest_device(struct evdev_device *device)
 {
-	return !!udev_device_get_property_value(device->udev_device,
-						"LIBINPUT_TEST_DEVICE");
+	return !!evdev_device_get_property(device, "LIBINPUT_TEST_DEVICE");
 }
 
 static inline struct pad_mode_toggle_button *
@@ -258,13 +261,16 @@ pad_led_get_sysfs_base_path(struct evdev_device *device,
 
 	/* For testing purposes only allow for a base path set through a
 	 * udev rule. We still expect the normal directory hierarchy inside */
-	test_path = udev_device_get_property_value(udev_device,
-						   "LIBINPUT_TEST_TABLET_PAD_SYSFS_PATH");
+	test_path = evdev_device_get_property(device,
+					      "LIBINPUT_TEST_TABLET_PAD_SYSFS_PATH");
 	if (test_path) {
 		rc = snprintf(path_out, path_out_sz, "%s", test_path);
 		return rc != -1;
 	}
 
+	if (!udev_device)
+		return false;
+
 	parent = udev_device_get_parent_with_subsystem_devtype(udev_device,
 							       "input",
 							       NULL);
@@ -330,6 +336,7 @@ pad_add_mode_group(struct pad_dispatch *pad,
 		if (rc < 0) {
 			goto out;
 		}
+		group->base.current_mode = rc;
 	}
 
 	list_insert(&pad->modes.mode_group_list, &group->base.link);
@@ -623,6 +630,17 @@ pad_destroy_leds(struct pad_dispatch *pad)
 		libinput_tablet_pad_mode_group_unref(group);
 }
 
+void
+pad_invalidate_leds(struct pad_dispatch *pad)
+{
+	struct libinput_tablet_pad_mode_group *g;
+
+	list_for_each(g, &pad->modes.mode_group_list, link) {
+		struct pad_led_group *group = (struct pad_led_group*)g;
+		group->mode_stale = true;
+	}
+}
+
 void
 pad_button_update_mode(struct libinput_tablet_pad_mode_group *g,
 		       unsigned int button_index,
@@ -637,7 +655,14 @@ pad_button_update_mode(struct libinput_tablet_pad_mode_group *g,
 	if (!libinput_tablet_pad_mode_group_button_is_toggle(g, button_index))
 		return;
 
-	if (list_empty(&group->led_list)) {
+	/* The kernel updates the LEDs on a mode toggle button press and it
+	 * does so the same way we do here, so we only need to read sysfs
+	 * if the LEDs may have been changed behind our back */
+	if (group->mode_stale && !list_empty(&group->led_list)) {
+		rc = pad_led_group_get_mode(group);
+		if (rc >= 0)
+			group->mode_stale = false;
+	} else {
 		struct pad_mode_toggle_button *button;
 		list_for_each(button, &group->toggle_button_list, link) {
 			if (button->button_index == button_index) {
@@ -650,8 +675,6 @@ pad_button_update_mode(struct libinput_tablet_pad_mode_group *g,
 				break;
 			}
 		}
-	} else {
-		rc = pad_led_group_get_mode(group);
 	}
 	if (rc >= 0)
 		group->base.current_mode = rc;
@@ -638,6 +638,9 @@ pad_suspend(struct evdev_dispatch *dispatch,
 	}
 
 	pad_flush(pad, device, libinput_now(libinput));
+
+	/* Someone else may change the LEDs while we're suspended */
+	pad_invalidate_leds(pad);
 }
 
 static void
@@ -114,6 +114,9 @@ pad_init_leds(struct pad_dispatch *pad,
 void
 pad_destroy_leds(struct pad_dispatch *pad);
 
+void
+pad_invalidate_leds(struct pad_dispatch *pad);
+
 void
 pad_button_update_mode(struct libinput_tablet_pad_mode_group *g,
 		       unsigned int button_index,
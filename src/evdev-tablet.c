@@ -1481,18 +1481,10 @@ tablet_get_tool(struct tablet_dispatch *tablet,
 	struct evdev_device *device = tablet->device;
 	struct libinput *libinput = tablet_libinput_context(tablet);
 	struct libinput_tablet_tool *tool = NULL, *t;
-	struct list *tool_list;
 
-	if (serial) {
-		tool_list = &libinput->tool_list;
-		/* Check if we already have the tool in our list of tools */
-		list_for_each(t, tool_list, link) {
-			if (type == t->type && serial == t->serial) {
-				tool = t;
-				break;
-			}
-		}
-	}
+	/* Check if we already have the tool in our list of tools */
+	if (serial)
+		tool = libinput_find_tool(libinput, type, serial);
 
 	/* If we get a tool with a delayed serial number, we already created
 	 * a 0-serial number tool for it earlier. Re-use that, even though
@@ -1500,37 +1492,36 @@ tablet_get_tool(struct tablet_dispatch *tablet,
 	 * https://bugs.freedesktop.org/show_bug.cgi?id=97526
 	 */
 	if (!tool) {
-		tool_list = &tablet->tool_list;
 		/* We can't guarantee that tools without serial numbers are
 		 * unique, so we keep them local to the tablet that they come
 		 * into proximity of instead of storing them in the global tool
 		 * list
 		 * Same as above, but don't bother checking the serial number
 		 */
-		list_for_each(t, tool_list, link) {
+		list_for_each(t, &tablet->tool_list, link) {
 			if (type == t->type) {
 				tool = t;
 				break;
 			}
 		}
-
-		/* Didn't find the tool but we have a serial. Switch
-		 * tool_list back so we create in the correct list */
-		if (!tool && serial)
-			tool_list = &libinput->tool_list;
 	}
 
 	/* If we didn't already have the new_tool in our list of tools,
 	 * add it */
 	if (!tool) {
 		tool = tablet_new_tool(tablet, type, tool_id, serial);
-		list_insert(tool_list, &tool->link);
+		if (serial)
+			libinput_add_tool(libinput, tool);
+		else
+			list_insert(&tablet->tool_list, &tool->link);
 	}
 
-	struct libinput_device *last = tool->last_device;
-	tool->last_device = libinput_device_ref(&device->base);
-	if (last)
-		libinput_device_unref(last);
+	if (tool->last_device != &device->base) {
+		struct libinput_device *last = tool->last_device;
+		tool->last_device = libinput_device_ref(&device->base);
+		if (last)
+			libinput_device_unref(last);
+	}
 
 	tool->last_tablet_id = tablet->tablet_id;
 
@@ -2183,13 +2174,29 @@ tablet_update_tool_state(struct tablet_dispatch *tablet,
 static struct libinput_tablet_tool *
 tablet_get_current_tool(struct tablet_dispatch *tablet)
 {
+	struct libinput_tablet_tool *tool = tablet->current_tool.cache.tool;
+
 	if (tablet->current_tool.type == LIBINPUT_TOOL_NONE)
 		return NULL;
 
-	return tablet_get_tool(tablet,
+	/* The lookup only depends on the type and serial. If the tool was
+	 * used on another tablet since, it needs to become ours again */
+	if (tool &&
+	    tablet->current_tool.cache.type == tablet->current_tool.type &&
+	    tablet->current_tool.cache.serial == tablet->current_tool.serial &&
+	    tool->last_device == &tablet->device->base)
+		return tool;
+
+	tool = tablet_get_tool(tablet,
 			       tablet->current_tool.type,
 			       tablet->current_tool.id,
 			       tablet->current_tool.serial);
+
+	tablet->current_tool.cache.tool = tool;
+	tablet->current_tool.cache.type = tablet->current_tool.type;
+	tablet->current_tool.cache.serial = tablet->current_tool.serial;
+
+	return tool;
 }
 
 static void
@@ -2315,6 +2322,8 @@ tablet_flush(struct tablet_dispatch *tablet,
 		tablet_change_area(device);
 		tablet_history_reset(tablet);
 		tablet_tool_apply_eraser_button(tablet, tool);
+
+		tablet->current_tool.cache.tool = NULL;
 	}
 }
 
@@ -2463,10 +2472,12 @@ tablet_remove(struct evdev_dispatch *dispatch)
 		}
 	}
 
-	list_for_each_safe(tool, &libinput->tool_list, link) {
-		if (tool->last_device == device) {
-			libinput_device_unref(tool->last_device);
-			tool->last_device = NULL;
+	ARRAY_FOR_EACH(libinput->tool_hash, bucket) {
+		list_for_each_safe(tool, bucket, link) {
+			if (tool->last_device == device) {
+				libinput_device_unref(tool->last_device);
+				tool->last_device = NULL;
+			}
 		}
 	}
 }
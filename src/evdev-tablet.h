@@ -91,6 +91,14 @@ struct tablet_dispatch {
 		enum libinput_tablet_tool_type type;
 		uint32_t id;
 		uint32_t serial;
+
+		/* The tool type and serial were resolved to, until either
+		 * changes or the tool leaves proximity */
+		struct {
+			struct libinput_tablet_tool *tool;
+			enum libinput_tablet_tool_type type;
+			uint32_t serial;
+		} cache;
 	} current_tool;
 
 	uint32_t cursor_proximity_threshold;
@@ -101,7 +101,7 @@ totem_new_tool(struct totem_dispatch *totem)
 	set_bit(tool->axis_caps, LIBINPUT_TABLET_TOOL_AXIS_SIZE_MINOR);
 	set_bit(tool->buttons, BTN_0);
 
-	list_insert(&libinput->tool_list, &tool->link);
+	libinput_add_tool(libinput, tool);
 
 	return tool;
 }
@@ -34,7 +34,6 @@
 #include "linux/input.h"
 #include <unistd.h>
 #include <fcntl.h>
-#include <mtdev-plumbing.h>
 #include <assert.h>
 #include <math.h>
 
@@ -52,6 +51,10 @@
 #include <libwacom/libwacom.h>
 #endif
 
+#if HAVE_MTDEV
+#include <mtdev-plumbing.h>
+#endif
+
 #define DEFAULT_WHEEL_CLICK_ANGLE 15
 #define DEFAULT_BUTTON_SCROLL_TIMEOUT ms2us(200)
 
@@ -113,7 +116,11 @@ parse_udev_flag(struct evdev_device *device,
 	const char *val;
 	bool b;
 
-	val = udev_device_get_property_value(udev_device, property);
+	/* Devices without a udev device carry their own properties */
+	if (udev_device)
+		val = udev_device_get_property_value(udev_device, property);
+	else
+		val = evdev_device_get_property(device, property);
 	if (!val)
 		return false;
 
@@ -975,7 +982,7 @@ evdev_init_natural_scroll(struct evdev_device *device)
 }
 
 int
-evdev_need_mtdev(struct evdev_device *device)
+evdev_is_mt_protocol_a(struct evdev_device *device)
 {
 	struct libevdev *evdev = device->evdev;
 
@@ -984,6 +991,19 @@ evdev_need_mtdev(struct evdev_device *device)
 		!libevdev_has_event_code(evdev, EV_ABS, ABS_MT_SLOT));
 }
 
+/* Protocol A devices are converted by mtdev where we have it and by the
+ * mt-protocol-a plugin otherwise. mtdev reads the axis ranges from the
+ * device node, devices without a udev device always use the plugin. */
+bool
+evdev_need_mtdev(struct evdev_device *device)
+{
+#if HAVE_MTDEV
+	return device->udev_device && evdev_is_mt_protocol_a(device);
+#else
+	return false;
+#endif
+}
+
 /* Fake MT devices have the ABS_MT_SLOT bit set because of
    the limited ABS_* range - they aren't MT devices, they
    just have too many ABS_ axes */
@@ -1018,11 +1038,59 @@ evdev_read_switch_reliability_prop(struct evdev_device *device)
 	return r;
 }
 
+static void
+evdev_device_dispatch_frame_with_latency(struct libinput *libinput,
+					 struct evdev_device *device,
+					 struct evdev_frame *frame)
+{
+	struct libinput_device *base = &device->base;
+	uint64_t frame_time = evdev_frame_get_time(frame);
+	uint64_t start, end, interface_time;
+
+	base->latency.interface_time = 0;
+
+	start = libinput_now(libinput);
+	libinput_plugin_system_notify_evdev_frame(&libinput->plugin_system,
+						  base,
+						  frame);
+	end = libinput_now(libinput);
+
+	if (start == 0 || end < start)
+		return;
+
+	interface_time = min(base->latency.interface_time, end - start);
+	libinput_device_note_latency(base,
+				     LIBINPUT_LATENCY_STAT_PLUGINS,
+				     end - start - interface_time);
+	libinput_device_note_latency(base,
+				     LIBINPUT_LATENCY_STAT_INTERFACE,
+				     interface_time);
+
+	/* Frames we sent ourselves (e.g. after SYN_DROPPED) may not
+	 * have a kernel timestamp */
+	if (frame_time == 0 || frame_time > start)
+		return;
+
+	libinput_device_note_latency(base,
+				     LIBINPUT_LATENCY_STAT_DISPATCH,
+				     start - frame_time);
+	libinput_device_note_latency(base,
+				     LIBINPUT_LATENCY_STAT_POST,
+				     end - frame_time);
+}
+
 static inline void
 evdev_device_dispatch_frame(struct libinput *libinput,
 			    struct evdev_device *device,
 			    struct evdev_frame *frame)
 {
+	if (libinput->stats_enabled) {
+		evdev_device_dispatch_frame_with_latency(libinput,
+							 device,
+							 frame);
+		return;
+	}
+
 	libinput_plugin_system_notify_evdev_frame(&libinput->plugin_system,
 						  &device->base,
 						  frame);
@@ -1038,9 +1106,16 @@ libinput_device_dispatch_frame(struct libinput_device *device,
 	evdev_device_dispatch_frame(libinput, dev, frame);
 }
 
+/**
+ * Process the sync events libevdev generated after a SYN_DROPPED. libevdev
+ * stamps those with the time of the last event it read itself and since
+ * we read the fd directly, that time is stale. Use the time of the
+ * SYN_DROPPED instead, like libevdev would have if it had read it.
+ */
 static int
 evdev_sync_device(struct libinput *libinput,
-		  struct evdev_device *device)
+		  struct evdev_device *device,
+		  uint64_t time)
 {
 	struct input_event ev;
 	int rc;
@@ -1053,6 +1128,8 @@ evdev_sync_device(struct libinput *libinput,
 		if (rc < 0)
 			break;
 
+		input_event_set_time(&ev, time);
+
 		/* No ENOMEM check here because >maxevents really should never happen */
 		evdev_frame_append_input_event(frame, &ev);
 	} while (rc == LIBEVDEV_READ_STATUS_SYNC);
@@ -1089,61 +1166,150 @@ evdev_note_time_delay(struct evdev_device *device,
 	}
 }
 
+/**
+ * Update libevdev's view of the device with an event we read from the fd
+ * ourselves. Returns false if libevdev would have discarded the event,
+ * e.g. because the event code is disabled. Like libevdev_next_event(),
+ * an out-of-range ABS_MT_SLOT is capped to the available slots and the
+ * event is modified accordingly.
+ */
+static inline bool
+evdev_update_libevdev_state(struct evdev_device *device,
+			    struct input_event *ev)
+{
+	struct libevdev *evdev = device->evdev;
+
+	if (ev->type == EV_ABS && ev->code == ABS_MT_SLOT) {
+		int nslots = libevdev_get_num_slots(evdev);
+
+		if (nslots > 0 && (ev->value < 0 || ev->value >= nslots)) {
+			evdev_log_bug_kernel(device,
+					     "invalid slot index %d, capping to %d\n",
+					     ev->value,
+					     nslots - 1);
+			ev->value = max(0, min(ev->value, nslots - 1));
+		}
+	}
+
+	switch (ev->type) {
+	case EV_SYN:
+		return true;
+	case EV_KEY:
+	case EV_ABS:
+	case EV_SW:
+	case EV_LED:
+		return libevdev_set_event_value(evdev,
+						ev->type,
+						ev->code,
+						ev->value) == 0;
+	default:
+		return libevdev_has_event_code(evdev, ev->type, ev->code);
+	}
+}
+
+static int
+evdev_handle_syn_dropped(struct libinput *libinput,
+			 struct evdev_device *device,
+			 struct evdev_frame *frame,
+			 const struct input_event *dropped)
+{
+	struct input_event ev = *dropped;
+	struct input_event unused;
+
+	evdev_log_info_ratelimit(device,
+				 &device->syn_drop_limit,
+				 "SYN_DROPPED event - some input events have been lost.\n");
+
+	/* send one more sync event so we handle all
+	   currently pending events before we sync up
+	   to the current state */
+	ev.code = SYN_REPORT;
+
+	if (evdev_frame_append_input_event(frame, &ev) == -ENOMEM) {
+		evdev_log_bug_libinput(device,
+				       "event frame overflow, discarding events.\n");
+	}
+	evdev_device_dispatch_frame(libinput, device, frame);
+	evdev_frame_reset(frame);
+
+	/* libevdev never saw the SYN_DROPPED, make it drain the fd and
+	 * sync to the kernel state as if it had */
+	libevdev_next_event(device->evdev,
+			    LIBEVDEV_READ_FLAG_FORCE_SYNC,
+			    &unused);
+
+	return evdev_sync_device(libinput, device, input_event_time(dropped));
+}
+
 static void
 evdev_device_dispatch(void *data)
 {
 	struct evdev_device *device = data;
 	struct libinput *libinput = evdev_libinput_context(device);
-	struct input_event ev;
-	int rc;
+	struct input_event events[128];
+	int rc = 0;
 	bool once = false;
 	_unref_(evdev_frame) *frame = evdev_frame_new(64);
 
-	/* If the compositor is repainting, this function is called only once
+	/* We read from the fd directly rather than through
+	 * libevdev_next_event(), libevdev's event queue is only ever used
+	 * during a sync and that drains it again. libevdev's state is
+	 * kept up-to-date through evdev_update_libevdev_state().
+	 *
+	 * If the compositor is repainting, this function is called only once
 	 * per frame and we have to process all the events available on the
 	 * fd, otherwise there will be input lag. */
-	do {
-		rc = libevdev_next_event(device->evdev,
-					 LIBEVDEV_READ_FLAG_NORMAL, &ev);
-		if (rc == LIBEVDEV_READ_STATUS_SYNC) {
-			evdev_log_info_ratelimit(device,
-						 &device->syn_drop_limit,
-						 "SYN_DROPPED event - some input events have been lost.\n");
-
-			/* send one more sync event so we handle all
-			   currently pending events before we sync up
-			   to the current state */
-			ev.code = SYN_REPORT;
-
-			if (evdev_frame_append_input_event(frame, &ev) == -ENOMEM) {
-				evdev_log_bug_libinput(device,
-						       "event frame overflow, discarding events.\n");
+	while (rc == 0) {
+		ssize_t len = read(device->fd, events, sizeof(events));
+
+		if (len < 0) {
+			rc = -errno;
+			break;
+		} else if (len == 0) {
+			rc = -EAGAIN;
+			break;
+		} else if (len % sizeof(*events) != 0) {
+			rc = -EINVAL;
+			break;
+		}
+
+		size_t nevents = len / sizeof(*events);
+		for (size_t i = 0; i < nevents; i++) {
+			struct input_event *ev = &events[i];
+
+			if (ev->type == EV_SYN && ev->code == SYN_DROPPED) {
+				/* The sync drained the fd, the rest of
+				 * this batch is stale */
+				rc = evdev_handle_syn_dropped(libinput,
+							      device,
+							      frame,
+							      ev);
+				break;
 			}
-			evdev_device_dispatch_frame(libinput, device, frame);
-			evdev_frame_reset(frame);
 
-			rc = evdev_sync_device(libinput, device);
-			if (rc == 0)
-				rc = LIBEVDEV_READ_STATUS_SUCCESS;
-		} else if (rc == LIBEVDEV_READ_STATUS_SUCCESS) {
+			if (!evdev_update_libevdev_state(device, ev))
+				continue;
+
 			if (!once) {
-				evdev_note_time_delay(device, &ev);
+				evdev_note_time_delay(device, ev);
 				once = true;
 			}
 
-			if (evdev_frame_append_input_event(frame, &ev) == -ENOMEM) {
+			if (evdev_frame_append_input_event(frame, ev) == -ENOMEM) {
 				evdev_log_bug_libinput(device,
 						       "event frame overflow, discarding events.\n");
 			}
-			if (ev.type == EV_SYN && ev.code == SYN_REPORT) {
+			if (ev->type == EV_SYN && ev->code == SYN_REPORT) {
 				evdev_device_dispatch_frame(libinput, device, frame);
 				evdev_frame_reset(frame);
 			}
-		} else if (rc == -ENODEV) {
-			evdev_device_remove(device);
-			return;
 		}
-	} while (rc == LIBEVDEV_READ_STATUS_SUCCESS);
+	}
+
+	if (rc == -ENODEV) {
+		evdev_device_remove(device);
+		return;
+	}
 
 	/* This should never happen, the kernel flushes only on SYN_REPORT */
 	if (evdev_frame_get_count(frame) > 1) {
@@ -1330,7 +1496,7 @@ evdev_read_wheel_click_prop(struct evdev_device *device,
 	int val;
 
 	*angle = DEFAULT_WHEEL_CLICK_ANGLE;
-	prop = udev_device_get_property_value(device->udev_device, prop);
+	prop = evdev_device_get_property(device, prop);
 	if (!prop)
 		return false;
 
@@ -1355,7 +1521,7 @@ evdev_read_wheel_click_count_prop(struct evdev_device *device,
 {
 	int val;
 
-	prop = udev_device_get_property_value(device->udev_device, prop);
+	prop = evdev_device_get_property(device, prop);
 	if (!prop)
 		return false;
 
@@ -1455,8 +1621,7 @@ evdev_read_dpi_prop(struct evdev_device *device)
 	if (device->tags & EVDEV_TAG_TRACKPOINT)
 		return DEFAULT_MOUSE_DPI;
 
-	mouse_dpi = udev_device_get_property_value(device->udev_device,
-						   "MOUSE_DPI");
+	mouse_dpi = evdev_device_get_property(device, "MOUSE_DPI");
 	if (mouse_dpi) {
 		dpi = parse_mouse_dpi_property(mouse_dpi);
 		if (!dpi) {
@@ -1642,9 +1807,11 @@ evdev_device_get_udev_tags(struct evdev_device *device,
 			   struct udev_device *udev_device)
 {
 	enum evdev_device_udev_tags tags = EVDEV_UDEV_TAG_NONE;
-	int i;
+	int i = 0;
 
-	for (i = 0; i < 2 && udev_device; i++) {
+	/* Without a udev device we only have the device's own properties
+	 * and no parent to look at */
+	do {
 		unsigned j;
 		for (j = 0; j < ARRAY_LENGTH(evdev_udev_tag_matches); j++) {
 			const struct evdev_udev_tag_match match = evdev_udev_tag_matches[j];
@@ -1653,8 +1820,9 @@ evdev_device_get_udev_tags(struct evdev_device *device,
 					    match.name))
 				tags |= match.tag;
 		}
-		udev_device = udev_device_get_parent(udev_device);
-	}
+		if (udev_device)
+			udev_device = udev_device_get_parent(udev_device);
+	} while (++i < 2 && udev_device);
 
 	return tags;
 }
@@ -2133,15 +2301,13 @@ out:
 }
 
 static bool
-evdev_set_device_group(struct evdev_device *device,
-		       struct udev_device *udev_device)
+evdev_set_device_group(struct evdev_device *device)
 {
 	struct libinput *libinput = evdev_libinput_context(device);
 	struct libinput_device_group *group = NULL;
 	const char *udev_group;
 
-	udev_group = udev_device_get_property_value(udev_device,
-						    "LIBINPUT_DEVICE_GROUP");
+	udev_group = evdev_device_get_property(device, "LIBINPUT_DEVICE_GROUP");
 	if (udev_group)
 		group = libinput_device_group_find_group(libinput, udev_group);
 
@@ -2183,11 +2349,11 @@ evdev_pre_configure_model_quirks(struct evdev_device *device)
 
 	/* Generally we don't care about MSC_TIMESTAMP and it can cause
 	 * unnecessary wakeups but on some devices we need to watch it for
-	 * pointer jumps */
+	 * pointer jumps or use it for the frame times */
 	_unref_(quirks) *q = libinput_device_get_quirks(&device->base);
 	if (!q ||
 	    !quirks_get_string(q, QUIRK_ATTR_MSC_TIMESTAMP, &prop) ||
-	    !streq(prop, "watch")) {
+	    (!streq(prop, "watch") && !streq(prop, "use"))) {
 		libevdev_disable_event_code(device->evdev, EV_MSC, MSC_TIMESTAMP);
 	}
 
@@ -2247,6 +2413,7 @@ evdev_pre_configure_model_quirks(struct evdev_device *device)
 
 	if (!quirks_get_bool(q, QUIRK_ATTR_IS_VIRTUAL, &is_virtual)) {
 		is_virtual = !getenv("LIBINPUT_RUNNING_TEST_SUITE") &&
+			device->udev_device &&
 			udev_device_is_virtual(device->udev_device);
 	}
 	if (is_virtual)
@@ -2299,58 +2466,47 @@ udev_device_should_be_ignored(struct udev_device *udev_device)
 	return value && !streq(value, "0");
 }
 
-struct evdev_device *
-evdev_device_create(struct libinput_seat *seat,
-		    struct udev_device *udev_device)
+static void
+evdev_device_close_fd(struct evdev_device *device)
 {
-	struct libinput *libinput = seat->libinput;
-	struct evdev_device *device = NULL;
-	int rc;
-	int fd = -1;
-	int unhandled_device = 0;
-	const char *devnode = udev_device_get_devnode(udev_device);
-	_autofree_ char *sysname = str_sanitize(udev_device_get_sysname(udev_device));
-
-	if (!devnode) {
-		log_info(libinput, "%s: no device node associated\n", sysname);
-		goto err;
-	}
+	struct libinput *libinput = evdev_libinput_context(device);
 
-	if (udev_device_should_be_ignored(udev_device)) {
-		log_debug(libinput, "%s: device is ignored\n", sysname);
-		goto err;
-	}
+	if (device->fd == -1)
+		return;
 
-	/* Use non-blocking mode so that we can loop on read on
-	 * evdev_device_data() until all events on the fd are
-	 * read.  mtdev_get() also expects this. */
-	fd = open_restricted(libinput, devnode,
-			     O_RDWR | O_NONBLOCK | O_CLOEXEC);
-	if (fd < 0) {
-		log_info(libinput,
-			 "%s: opening input device '%s' failed (%s).\n",
-			 sysname,
-			 devnode,
-			 strerror(-fd));
-		goto err;
-	}
+	/* Devices without a udev device were handed to us by the caller
+	 * and the fd is our own dup, not opened through open_restricted */
+	if (device->udev_device)
+		close_restricted(libinput, device->fd);
+	else
+		close(device->fd);
+	device->fd = -1;
+}
 
-	if (!evdev_device_have_same_syspath(udev_device, fd))
-		goto err;
+/**
+ * Set up and configure the evdev device. On failure, the libevdev
+ * context and the fd are released and NULL or EVDEV_UNHANDLED_DEVICE is
+ * returned.
+ */
+static struct evdev_device *
+evdev_device_init(struct libinput_seat *seat,
+		  struct libevdev *evdev,
+		  int fd,
+		  char *sysname,
+		  struct udev_device *udev_device,
+		  char **properties)
+{
+	struct libinput *libinput = seat->libinput;
+	struct evdev_device *device = NULL;
+	int unhandled_device = 0;
 
 	device = zalloc(sizeof *device);
-	device->sysname = steal(&sysname);
+	device->sysname = sysname;
 
 	libinput_device_init(&device->base, seat);
 	libinput_seat_ref(seat);
 
-	evdev_drain_fd(fd);
-
-	rc = libevdev_new_from_fd(fd, &device->evdev);
-	if (rc != 0)
-		goto err;
-
-	libevdev_set_clock_id(device->evdev, CLOCK_MONOTONIC);
+	device->evdev = evdev;
 	libevdev_set_device_log_function(device->evdev,
 					 libevdev_log_func,
 					 LIBEVDEV_LOG_ERROR,
@@ -2359,6 +2515,7 @@ evdev_device_create(struct libinput_seat *seat,
 	device->is_mt = 0;
 	device->mtdev = NULL;
 	device->udev_device = udev_device_ref(udev_device);
+	device->properties = properties;
 	device->dispatch = NULL;
 	device->fd = fd;
 	device->devname = libevdev_get_name(device->evdev);
@@ -2423,7 +2580,7 @@ evdev_device_create(struct libinput_seat *seat,
 	if (!device->source)
 		goto err_notify;
 
-	if (!evdev_set_device_group(device, udev_device))
+	if (!evdev_set_device_group(device))
 		goto err_notify;
 
 	list_insert(seat->devices_list.prev, &device->base.link);
@@ -2439,17 +2596,114 @@ err_notify:
 						     &device->base);
 
 err:
-	if (fd >= 0) {
-		close_restricted(libinput, fd);
-		if (device) {
-			unhandled_device = device->seat_caps == EVDEV_DEVICE_NO_CAPABILITIES;
-			evdev_device_destroy(device);
-		}
-	}
+	unhandled_device = device->seat_caps == EVDEV_DEVICE_NO_CAPABILITIES;
+	evdev_device_close_fd(device);
+	evdev_device_destroy(device);
 
 	return unhandled_device ? EVDEV_UNHANDLED_DEVICE :  NULL;
 }
 
+struct evdev_device *
+evdev_device_create(struct libinput_seat *seat,
+		    struct udev_device *udev_device)
+{
+	struct libinput *libinput = seat->libinput;
+	struct libevdev *evdev = NULL;
+	int rc;
+	int fd = -1;
+	const char *devnode = udev_device_get_devnode(udev_device);
+	_autofree_ char *sysname = str_sanitize(udev_device_get_sysname(udev_device));
+
+	if (!devnode) {
+		log_info(libinput, "%s: no device node associated\n", sysname);
+		return NULL;
+	}
+
+	if (udev_device_should_be_ignored(udev_device)) {
+		log_debug(libinput, "%s: device is ignored\n", sysname);
+		return NULL;
+	}
+
+	/* Use non-blocking mode so that we can loop on read on
+	 * evdev_device_data() until all events on the fd are
+	 * read. */
+	fd = open_restricted(libinput, devnode,
+			     O_RDWR | O_NONBLOCK | O_CLOEXEC);
+	if (fd < 0) {
+		log_info(libinput,
+			 "%s: opening input device '%s' failed (%s).\n",
+			 sysname,
+			 devnode,
+			 strerror(-fd));
+		return NULL;
+	}
+
+	if (!evdev_device_have_same_syspath(udev_device, fd))
+		goto err;
+
+	evdev_drain_fd(fd);
+
+	rc = libevdev_new_from_fd(fd, &evdev);
+	if (rc != 0)
+		goto err;
+
+	libevdev_set_clock_id(evdev, CLOCK_MONOTONIC);
+
+	return evdev_device_init(seat,
+				 evdev,
+				 fd,
+				 steal(&sysname),
+				 udev_device,
+				 NULL);
+
+err:
+	close_restricted(libinput, fd);
+	return NULL;
+}
+
+/**
+ * Create a device without a device node or udev device. The libevdev
+ * context describes the device, the events are read from the fd and
+ * the properties (KEY=value) take the place of the udev properties.
+ *
+ * NAME and PRODUCT are filled in from the libevdev context unless
+ * provided, these are the parent device's properties the quirks match on.
+ *
+ * Ownership of the libevdev context and the fd passes to the device,
+ * they are released on failure.
+ */
+struct evdev_device *
+evdev_device_create_from_evdev(struct libinput_seat *seat,
+			       struct libevdev *evdev,
+			       int fd,
+			       const char *sysname,
+			       const char **properties)
+{
+	char **props = NULL;
+
+	for (const char **p = properties; p && *p; p++)
+		props = strv_append_strdup(props, *p);
+
+	if (!strv_find_value(props, "NAME"))
+		props = strv_append_printf(props,
+					   "NAME=\"%s\"",
+					   libevdev_get_name(evdev));
+	if (!strv_find_value(props, "PRODUCT"))
+		props = strv_append_printf(props,
+					   "PRODUCT=%x/%x/%x/%x",
+					   libevdev_get_id_bustype(evdev),
+					   libevdev_get_id_vendor(evdev),
+					   libevdev_get_id_product(evdev),
+					   libevdev_get_id_version(evdev));
+
+	return evdev_device_init(seat,
+				 evdev,
+				 fd,
+				 str_sanitize(sysname),
+				 NULL,
+				 props);
+}
+
 const char *
 evdev_device_get_output(struct evdev_device *device)
 {
@@ -2492,6 +2746,17 @@ evdev_device_get_udev_device(struct evdev_device *device)
 	return udev_device_ref(device->udev_device);
 }
 
+const char *
+evdev_device_get_property(struct evdev_device *device,
+			  const char *property)
+{
+	if (device->udev_device)
+		return udev_device_get_property_value(device->udev_device,
+						      property);
+
+	return strv_find_value(device->properties, property);
+}
+
 void
 evdev_device_set_default_calibration(struct evdev_device *device,
 				     const float calibration[6])
@@ -2570,8 +2835,7 @@ evdev_read_calibration_prop(struct evdev_device *device)
 	const char *prop;
 	float calibration[6];
 
-	prop = udev_device_get_property_value(device->udev_device,
-					      "LIBINPUT_CALIBRATION_MATRIX");
+	prop = evdev_device_get_property(device, "LIBINPUT_CALIBRATION_MATRIX");
 
 	if (prop == NULL)
 		return;
@@ -2606,7 +2870,7 @@ evdev_read_fuzz_prop(struct evdev_device *device, unsigned int code)
 	if (rc == -1)
 		return 0;
 
-	prop = udev_device_get_property_value(device->udev_device, name);
+	prop = evdev_device_get_property(device, name);
 	if (prop && (safe_atoi(prop, &fuzz) == false || fuzz < 0)) {
 		evdev_log_bug_libinput(device,
 				       "invalid LIBINPUT_FUZZ property value: %s\n",
@@ -2717,10 +2981,10 @@ evdev_device_get_touch_count(struct evdev_device *device)
 
 	ntouches = libevdev_get_num_slots(device->evdev);
 	if (ntouches == -1) {
-		/* mtdev devices have multitouch but we don't know
+		/* protocol A devices have multitouch but we don't know
 		 * how many. Otherwise, any touch device with num_slots of
 		 * -1 is a single-touch device */
-		if (device->mtdev)
+		if (evdev_is_mt_protocol_a(device))
 			ntouches = 0;
 		else
 			ntouches = 1;
@@ -2944,15 +3208,50 @@ evdev_device_suspend(struct evdev_device *device)
 		device->source = NULL;
 	}
 
+#if HAVE_MTDEV
 	if (device->mtdev) {
 		mtdev_close_delete(device->mtdev);
 		device->mtdev = NULL;
 	}
+#endif
 
-	if (device->fd != -1) {
-		close_restricted(libinput, device->fd);
-		device->fd = -1;
+	/* Devices without a udev device have nothing to re-open the fd
+	 * from, they keep it until they are removed */
+	if (device->udev_device)
+		evdev_device_close_fd(device);
+}
+
+/**
+ * Resume a device added with libinput_path_add_evdev_device(). The
+ * events written while it was suspended are discarded like they would
+ * be for a closed device, but libevdev's view of the device is updated
+ * with them, there is no kernel device to sync that from.
+ */
+static int
+evdev_device_resume_without_udev(struct evdev_device *device)
+{
+	struct libinput *libinput = evdev_libinput_context(device);
+	struct input_event events[64];
+	ssize_t len;
+
+	if (device->source)
+		return 0;
+
+	while ((len = read(device->fd, events, sizeof(events))) > 0) {
+		size_t nevents = len / sizeof(*events);
+
+		for (size_t i = 0; i < nevents; i++)
+			evdev_update_libevdev_state(device, &events[i]);
 	}
+
+	device->source =
+		libinput_add_fd(libinput, device->fd, evdev_device_dispatch, device);
+	if (!device->source)
+		return -ENOMEM;
+
+	evdev_notify_resumed_device(device);
+
+	return 0;
 }
 
 int
@@ -2964,6 +3263,12 @@ evdev_device_resume(struct evdev_device *device)
 	struct input_event ev;
 	enum libevdev_read_status status;
 
+	if (!device->udev_device) {
+		if (device->was_removed)
+			return -ENODEV;
+		return evdev_device_resume_without_udev(device);
+	}
+
 	if (device->fd != -1)
 		return 0;
 
@@ -2989,11 +3294,13 @@ evdev_device_resume(struct evdev_device *device)
 
 	device->fd = fd;
 
+#if HAVE_MTDEV
 	if (evdev_need_mtdev(device)) {
 		device->mtdev = mtdev_new_open(device->fd);
 		if (!device->mtdev)
 			return -ENODEV;
 	}
+#endif
 
 	libevdev_change_fd(device->evdev, fd);
 	libevdev_set_clock_id(device->evdev, CLOCK_MONOTONIC);
@@ -3012,7 +3319,10 @@ evdev_device_resume(struct evdev_device *device)
 	device->source =
 		libinput_add_fd(libinput, fd, evdev_device_dispatch, device);
 	if (!device->source) {
+#if HAVE_MTDEV
 		mtdev_close_delete(device->mtdev);
+		device->mtdev = NULL;
+#endif
 		return -ENOMEM;
 	}
 
@@ -3041,6 +3351,7 @@ evdev_device_remove(struct evdev_device *device)
 	}
 
 	evdev_device_suspend(device);
+	evdev_device_close_fd(device);
 
 	if (device->dispatch->interface->remove)
 		device->dispatch->interface->remove(device->dispatch);
@@ -3076,5 +3387,6 @@ evdev_device_destroy(struct evdev_device *device)
 	libinput_seat_unref(device->base.seat);
 	libevdev_free(device->evdev);
 	udev_device_unref(device->udev_device);
+	strv_free(device->properties);
 	free(device);
 }
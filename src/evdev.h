@@ -171,6 +171,7 @@ struct evdev_device {
 	struct evdev_dispatch *dispatch;
 	struct libevdev *evdev;
 	struct udev_device *udev_device;
+	char **properties; /* KEY=value, only if udev_device is NULL */
 	char *output_name;
 	const char *devname;
 	char *log_prefix_name;
@@ -188,7 +189,7 @@ struct evdev_device {
 	struct ratelimit delay_warning_limit; /* ratelimit for delayd processing logging */
 	struct ratelimit nonpointer_rel_limit; /* ratelimit for REL_* events from non-pointer devices */
 	uint32_t model_flags;
-	struct mtdev *mtdev;
+	struct mtdev *mtdev; /* always NULL without HAVE_MTDEV */
 
 	struct {
 		const struct input_absinfo *absinfo_x, *absinfo_y;
@@ -294,6 +295,14 @@ struct evdev_dispatch_interface {
 			struct evdev_event *event,
 			uint64_t time);
 
+	/* Process a whole SYN_REPORT-terminated evdev frame (optional).
+	 * If set, this is used instead of process() for frames from the
+	 * device, process() is still required for events forwarded by
+	 * other dispatchers. */
+	void (*process_frame)(struct evdev_dispatch *dispatch,
+			      struct evdev_device *device,
+			      struct evdev_frame *frame);
+
 	/* Device is being suspended */
 	void (*suspend)(struct evdev_dispatch *dispatch,
 			struct evdev_device *device);
@@ -382,6 +391,13 @@ struct evdev_device *
 evdev_device_create(struct libinput_seat *seat,
 		    struct udev_device *device);
 
+struct evdev_device *
+evdev_device_create_from_evdev(struct libinput_seat *seat,
+			       struct libevdev *evdev,
+			       int fd,
+			       const char *sysname,
+			       const char **properties);
+
 static inline struct libinput *
 evdev_libinput_context(const struct evdev_device *device)
 {
@@ -457,6 +473,9 @@ bool
 evdev_is_fake_mt_device(struct evdev_device *device);
 
 int
+evdev_is_mt_protocol_a(struct evdev_device *device);
+
+bool
 evdev_need_mtdev(struct evdev_device *device);
 
 void
@@ -486,6 +505,10 @@ evdev_device_get_id_vendor(struct evdev_device *device);
 struct udev_device *
 evdev_device_get_udev_device(struct evdev_device *device);
 
+const char *
+evdev_device_get_property(struct evdev_device *device,
+			  const char *property);
+
 void
 evdev_device_set_default_calibration(struct evdev_device *device,
 				     const float calibration[6]);
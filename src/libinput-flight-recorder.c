@@ -0,0 +1,415 @@
+/*
+ * Copyright © 2025 Red Hat, Inc.
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a
+ * copy of this software and associated documentation files (the "Software"),
+ * to deal in the Software without restriction, including without limitation
+ * the rights to use, copy, modify, merge, publish, distribute, sublicense,
+ * and/or sell copies of the Software, and to permit persons to whom the
+ * Software is furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice (including the next
+ * paragraph) shall be included in all copies or substantial portions of the
+ * Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT.  IN NO EVENT SHALL
+ * THE AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING
+ * FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER
+ * DEALINGS IN THE SOFTWARE.
+ */
+
+#include "config.h"
+
+#include <inttypes.h>
+#include <string.h>
+#include <sys/utsname.h>
+#include <libevdev/libevdev.h>
+
+#include "util-mem.h"
+#include "util-strings.h"
+#include "util-time.h"
+
+#include "evdev.h"
+#include "libinput-git-version.h"
+#include "libinput-version.h"
+#include "libinput-flight-recorder.h"
+
+/* Ring sizes per second of recording. A touchpad with four fingers
+ * down sends about 40 events per frame at ~140Hz, a pointer or
+ * keyboard far less. Where a device exceeds this, the recording covers
+ * less time than requested. */
+#define FRAME_EVENTS_PER_SECOND 4096
+#define EVENTS_PER_SECOND 1024
+
+struct recorded_evdev_event {
+	uint64_t time;
+	evdev_usage_t usage;
+	int32_t value;
+};
+
+struct recorded_event {
+	uint64_t time;
+	const char *type; /* static string */
+};
+
+/**
+ * Two ring buffers that overwrite their oldest entry once full. The
+ * head is the total number of entries written, the ring index is
+ * head modulo the (power of two) size. Everything is allocated
+ * up-front, noting an event is a copy and an increment. libinput is
+ * single-threaded, so no locking is required.
+ */
+struct flight_recorder {
+	uint64_t duration; /* in µs */
+
+	struct {
+		struct recorded_evdev_event *data;
+		size_t size;
+		uint64_t head;
+	} frames;
+
+	struct {
+		struct recorded_event *data;
+		size_t size;
+		uint64_t head;
+	} events;
+};
+
+static size_t
+round_up_pow2(size_t n)
+{
+	size_t size = 1;
+
+	while (size < n)
+		size <<= 1;
+
+	return size;
+}
+
+struct flight_recorder *
+flight_recorder_new(unsigned int seconds)
+{
+	struct flight_recorder *recorder = zalloc(sizeof(*recorder));
+
+	seconds = min(seconds, FLIGHT_RECORDER_MAX_SECONDS);
+
+	recorder->duration = s2us(seconds);
+	recorder->frames.size = round_up_pow2(seconds * FRAME_EVENTS_PER_SECOND);
+	recorder->frames.data = zalloc(recorder->frames.size *
+				       sizeof(*recorder->frames.data));
+	recorder->events.size = round_up_pow2(seconds * EVENTS_PER_SECOND);
+	recorder->events.data = zalloc(recorder->events.size *
+				       sizeof(*recorder->events.data));
+
+	return recorder;
+}
+
+void
+flight_recorder_destroy(struct flight_recorder *recorder)
+{
+	if (!recorder)
+		return;
+
+	free(recorder->frames.data);
+	free(recorder->events.data);
+	free(recorder);
+}
+
+void
+flight_recorder_note_frame(struct flight_recorder *recorder,
+			   const struct evdev_frame *frame)
+{
+	size_t nevents;
+	const struct evdev_event *events = evdev_frame_get_events_const(frame, &nevents);
+	uint64_t time = evdev_frame_get_time(frame);
+	const size_t mask = recorder->frames.size - 1;
+
+	for (size_t i = 0; i < nevents; i++) {
+		struct recorded_evdev_event *e =
+			&recorder->frames.data[recorder->frames.head++ & mask];
+
+		e->time = time;
+		e->usage = events[i].usage;
+		e->value = events[i].value;
+	}
+}
+
+void
+flight_recorder_note_event(struct flight_recorder *recorder,
+			   uint64_t time,
+			   const char *type)
+{
+	const size_t mask = recorder->events.size - 1;
+	struct recorded_event *e =
+		&recorder->events.data[recorder->events.head++ & mask];
+
+	e->time = time;
+	e->type = type;
+}
+
+/**
+ * The index of the first event of the oldest complete frame that is
+ * recent enough, or the head if there is none.
+ */
+static uint64_t
+first_frame_index(struct flight_recorder *recorder, uint64_t since)
+{
+	uint64_t head = recorder->frames.head;
+	uint64_t idx = 0;
+	const size_t mask = recorder->frames.size - 1;
+
+	if (head <= recorder->frames.size)
+		goto skip_old;
+
+	/* We overwrote the oldest frame partially, skip to the
+	 * first SYN_REPORT */
+	idx = head - recorder->frames.size;
+	while (idx < head) {
+		struct recorded_evdev_event *e = &recorder->frames.data[idx++ & mask];
+		if (evdev_usage_eq(e->usage, EVDEV_SYN_REPORT))
+			break;
+	}
+
+skip_old:
+	while (idx < head && recorder->frames.data[idx & mask].time < since)
+		idx++;
+
+	return idx;
+}
+
+uint64_t
+flight_recorder_get_first_time(struct flight_recorder *recorder,
+			       uint64_t since)
+{
+	uint64_t idx = first_frame_index(recorder, since);
+
+	if (idx == recorder->frames.head)
+		return 0;
+
+	return recorder->frames.data[idx & (recorder->frames.size - 1)].time;
+}
+
+void
+flight_recorder_print_header(FILE *fp, size_t ndevices)
+{
+	struct utsname u;
+	char dmi[2048] = "unknown";
+
+	fprintf(fp, "# libinput flight recorder\n");
+	fprintf(fp, "version: 1\n");
+	fprintf(fp, "ndevices: %zu\n", ndevices);
+	fprintf(fp, "libinput:\n");
+	fprintf(fp, "  version: \"%s\"\n", LIBINPUT_VERSION);
+	fprintf(fp, "  git: \"%s\"\n", LIBINPUT_GIT_VERSION);
+	fprintf(fp, "system:\n");
+	fprintf(fp, "  kernel: \"%s\"\n", uname(&u) != -1 ? u.release : "unknown");
+
+	_autofclose_ FILE *dmifp = fopen("/sys/class/dmi/id/modalias", "r");
+	if (dmifp && fgets(dmi, sizeof(dmi), dmifp))
+		dmi[strcspn(dmi, "\n")] = '\0';
+	fprintf(fp, "  dmi: \"%s\"\n", dmi);
+	fprintf(fp, "devices:\n");
+}
+
+static inline bool
+is_recorded_property(const char *key)
+{
+	return strstartswith(key, "ID_INPUT") ||
+	       strstartswith(key, "LIBINPUT") ||
+	       strstartswith(key, "EVDEV_ABS") ||
+	       strstartswith(key, "MOUSE_DPI") ||
+	       strstartswith(key, "POINTINGSTICK_");
+}
+
+static void
+print_description(FILE *fp, struct evdev_device *device)
+{
+	struct libevdev *evdev = device->evdev;
+	const char *sep;
+
+	const char *devnode = device->udev_device ?
+		udev_device_get_devnode(device->udev_device) : NULL;
+
+	fprintf(fp, "- node: %s\n", devnode ? devnode : device->sysname);
+	fprintf(fp, "  evdev:\n");
+	fprintf(fp, "    # Name: %s\n", libevdev_get_name(evdev));
+	fprintf(fp, "    name: \"%s\"\n", libevdev_get_name(evdev));
+	fprintf(fp, "    id: [%d, %d, %d, %d]\n",
+		libevdev_get_id_bustype(evdev),
+		libevdev_get_id_vendor(evdev),
+		libevdev_get_id_product(evdev),
+		libevdev_get_id_version(evdev));
+
+	fprintf(fp, "    codes:\n");
+	for (unsigned int type = 0; type < EV_CNT; type++) {
+		int max = libevdev_event_type_get_max(type);
+
+		if (max == -1 || !libevdev_has_event_type(evdev, type))
+			continue;
+
+		sep = "";
+		fprintf(fp, "      %u: [", type);
+		for (unsigned int code = 0; code <= (unsigned int)max; code++) {
+			if (!libevdev_has_event_code(evdev, type, code))
+				continue;
+			fprintf(fp, "%s%u", sep, code);
+			sep = ", ";
+		}
+		fprintf(fp, "] # %s\n", libevdev_event_type_get_name(type));
+	}
+
+	if (libevdev_has_event_type(evdev, EV_ABS)) {
+		fprintf(fp, "    absinfo:\n");
+		for (unsigned int code = 0; code < ABS_CNT; code++) {
+			const struct input_absinfo *abs = libevdev_get_abs_info(evdev, code);
+			if (!abs)
+				continue;
+
+			fprintf(fp, "      %u: [%d, %d, %d, %d, %d]\n",
+				code,
+				abs->minimum,
+				abs->maximum,
+				abs->fuzz,
+				abs->flat,
+				abs->resolution);
+		}
+	}
+
+	sep = "";
+	fprintf(fp, "    properties: [");
+	for (unsigned int prop = 0; prop < INPUT_PROP_CNT; prop++) {
+		if (libevdev_has_property(evdev, prop)) {
+			fprintf(fp, "%s%u", sep, prop);
+			sep = ", ";
+		}
+	}
+	fprintf(fp, "]\n");
+
+	fprintf(fp, "  udev:\n");
+	fprintf(fp, "    properties:\n");
+	if (!device->udev_device) {
+		for (char **p = device->properties; p && *p; p++) {
+			if (is_recorded_property(*p))
+				fprintf(fp, "    - %s\n", *p);
+		}
+		return;
+	}
+
+	struct udev_list_entry *entry =
+		udev_device_get_properties_list_entry(device->udev_device);
+	for (; entry; entry = udev_list_entry_get_next(entry)) {
+		const char *key = udev_list_entry_get_name(entry);
+
+		if (is_recorded_property(key))
+			fprintf(fp, "    - %s=%s\n",
+				key,
+				udev_list_entry_get_value(entry));
+	}
+}
+
+static void
+print_time(FILE *fp, uint64_t time, uint64_t offset, bool is_evdev)
+{
+	time = time > offset ? time - offset : 0;
+
+	if (is_evdev)
+		fprintf(fp, "%3" PRIu64 ", %6" PRIu64,
+			time / 1000000, time % 1000000);
+	else
+		fprintf(fp, "%" PRIu64 ".%06" PRIu64,
+			time / 1000000, time % 1000000);
+}
+
+/**
+ * Print all public events up to and including the given time, starting
+ * at idx. Returns the index of the first event not printed.
+ */
+static uint64_t
+print_events(struct flight_recorder *recorder,
+	     FILE *fp,
+	     uint64_t idx,
+	     uint64_t until,
+	     uint64_t offset)
+{
+	const size_t mask = recorder->events.size - 1;
+	bool first = true;
+
+	for (; idx < recorder->events.head; idx++) {
+		struct recorded_event *e = &recorder->events.data[idx & mask];
+		const char *type = e->type;
+
+		if (e->time > until)
+			break;
+
+		if (first) {
+			fprintf(fp, "  - libinput:\n");
+			first = false;
+		}
+
+		if (strstartswith(type, "LIBINPUT_EVENT_"))
+			type += strlen("LIBINPUT_EVENT_");
+
+		fprintf(fp, "    - {time: ");
+		print_time(fp, e->time, offset, false);
+		fprintf(fp, ", type: %s}\n", type);
+	}
+
+	return idx;
+}
+
+void
+flight_recorder_print_device(struct flight_recorder *recorder,
+			     FILE *fp,
+			     struct libinput_device *device,
+			     uint64_t since,
+			     uint64_t offset)
+{
+	const size_t mask = recorder->frames.size - 1;
+	uint64_t idx = first_frame_index(recorder, since);
+	uint64_t event_idx = 0;
+	bool in_frame = false;
+
+	print_description(fp, evdev_device(device));
+
+	fprintf(fp, "  events:\n");
+
+	/* Public events older than our oldest frame are skipped */
+	if (idx < recorder->frames.head)
+		since = max(since, recorder->frames.data[idx & mask].time);
+	if (recorder->events.head > recorder->events.size)
+		event_idx = recorder->events.head - recorder->events.size;
+	while (event_idx < recorder->events.head &&
+	       recorder->events.data[event_idx & (recorder->events.size - 1)].time < since)
+		event_idx++;
+
+	for (; idx < recorder->frames.head; idx++) {
+		struct recorded_evdev_event *e = &recorder->frames.data[idx & mask];
+		uint16_t type = evdev_usage_type(e->usage),
+			 code = evdev_usage_code(e->usage);
+
+		if (!in_frame) {
+			fprintf(fp, "  - evdev:\n");
+			in_frame = true;
+		}
+
+		fprintf(fp, "    - [");
+		print_time(fp, e->time, offset, true);
+		fprintf(fp, ", %3u, %3u, %7d] # %s / %s\n",
+			type,
+			code,
+			e->value,
+			libevdev_event_type_get_name(type),
+			libevdev_event_code_get_name(type, code));
+
+		if (evdev_usage_eq(e->usage, EVDEV_SYN_REPORT)) {
+			in_frame = false;
+			event_idx = print_events(recorder, fp, event_idx, e->time, offset);
+		}
+	}
+
+	/* Anything after the last frame, e.g. from timers */
+	print_events(recorder, fp, event_idx, UINT64_MAX, offset);
+}
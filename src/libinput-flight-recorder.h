@@ -0,0 +1,76 @@
+/*
+ * Copyright © 2025 Red Hat, Inc.
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a
+ * copy of this software and associated documentation files (the "Software"),
+ * to deal in the Software without restriction, including without limitation
+ * the rights to use, copy, modify, merge, publish, distribute, sublicense,
+ * and/or sell copies of the Software, and to permit persons to whom the
+ * Software is furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice (including the next
+ * paragraph) shall be included in all copies or substantial portions of the
+ * Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT.  IN NO EVENT SHALL
+ * THE AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING
+ * FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER
+ * DEALINGS IN THE SOFTWARE.
+ */
+
+#pragma once
+
+#include "config.h"
+
+#include <stdint.h>
+#include <stdio.h>
+
+#include "evdev-frame.h"
+
+struct libinput_device;
+
+/* Upper limit for libinput_set_flight_recorder() */
+#define FLIGHT_RECORDER_MAX_SECONDS 60
+
+struct flight_recorder;
+
+struct flight_recorder *
+flight_recorder_new(unsigned int seconds);
+
+void
+flight_recorder_destroy(struct flight_recorder *recorder);
+
+void
+flight_recorder_note_frame(struct flight_recorder *recorder,
+			   const struct evdev_frame *frame);
+
+void
+flight_recorder_note_event(struct flight_recorder *recorder,
+			   uint64_t time,
+			   const char *type);
+
+/**
+ * @return the timestamp of the oldest frame recorded at or after since,
+ * or 0 if there is none
+ */
+uint64_t
+flight_recorder_get_first_time(struct flight_recorder *recorder,
+			       uint64_t since);
+
+void
+flight_recorder_print_header(FILE *fp, size_t ndevices);
+
+/**
+ * Print the device description and all frames and events recorded at
+ * or after since in the libinput record format. Timestamps are printed
+ * relative to offset.
+ */
+void
+flight_recorder_print_device(struct flight_recorder *recorder,
+			     FILE *fp,
+			     struct libinput_device *device,
+			     uint64_t since,
+			     uint64_t offset);
@@ -623,7 +623,7 @@ debounce_plugin_handle_frame(struct plugin_device *device,
 	bool flushed = false;
 
 	size_t nevents;
-	struct evdev_event *events = evdev_frame_get_events(frame, &nevents);
+	const struct evdev_event *events = evdev_frame_get_events_const(frame, &nevents);
 
         /* Strip out all button events from this frame (if any). Then
          * append the button events to that stripped frame according
@@ -634,7 +634,7 @@ debounce_plugin_handle_frame(struct plugin_device *device,
          */
         _unref_(evdev_frame) *filtered_frame = evdev_frame_new(nevents + 16);
 	for (size_t i = 0; i < nevents; i++) {
-		struct evdev_event *e = &events[i];
+		const struct evdev_event *e = &events[i];
 		if (!evdev_usage_is_button(e->usage)) {
 			evdev_frame_append(filtered_frame, e, 1);
 			continue;
@@ -665,7 +665,7 @@ debounce_plugin_handle_frame(struct plugin_device *device,
 	 *   IS_UP
 	 */
 	for (size_t i = 0; i < nevents; i++) {
-		struct evdev_event *e = &events[i];
+		const struct evdev_event *e = &events[i];
 		bool is_down = !!e->value;
 
 		if (!evdev_usage_is_button(e->usage))
@@ -700,7 +700,7 @@ debounce_plugin_handle_frame(struct plugin_device *device,
 	}
 
 	evdev_frame_set(frame,
-			evdev_frame_get_events(filtered_frame, NULL),
+			evdev_frame_get_events_const(filtered_frame, NULL),
 			evdev_frame_get_count(filtered_frame));
 }
 
@@ -743,14 +743,12 @@ debounce_plugin_device_added(struct libinput_plugin *libinput_plugin,
 	if (!libinput_device_has_capability(device, LIBINPUT_DEVICE_CAP_POINTER))
 		return;
 
-	_unref_(udev_device) *udev_device = libinput_device_get_udev_device(device);
-	if (udev_device) {
-		const char *prop = udev_device_get_property_value(udev_device,
-								  "ID_INPUT_TOUCHPAD");
-		bool val;
-		if (parse_boolean_property(prop, &val) && val) {
-			return;
-		}
+	const char *prop = libinput_plugin_get_device_property(libinput_plugin,
+							       device,
+							       "ID_INPUT_TOUCHPAD");
+	bool val;
+	if (parse_boolean_property(prop, &val) && val) {
+		return;
 	}
 
 	_unref_(quirks) *q = libinput_device_get_quirks(device);
@@ -761,7 +759,20 @@ debounce_plugin_device_added(struct libinput_plugin *libinput_plugin,
 		return;
 	}
 
-	libinput_plugin_enable_device_event_frame(libinput_plugin, device, true);
+	/* Only frames with buttons, see evdev_usage_is_button() */
+	uint64_t usages =
+		evdev_usage_mask_range(evdev_usage_from(EVDEV_BTN_MISC),
+				       evdev_usage_from_code(EV_KEY, BTN_DIGI - 1)) |
+		evdev_usage_mask(evdev_usage_from(EVDEV_BTN_STYLUS)) |
+		evdev_usage_mask(evdev_usage_from(EVDEV_BTN_STYLUS2)) |
+		evdev_usage_mask(evdev_usage_from(EVDEV_BTN_STYLUS3)) |
+		evdev_usage_mask_range(evdev_usage_from(EVDEV_BTN_WHEEL),
+				       evdev_usage_from(EVDEV_BTN_GEAR_UP)) |
+		evdev_usage_mask_range(evdev_usage_from(EVDEV_BTN_DPAD_UP),
+				       evdev_usage_from(EVDEV_BTN_DPAD_RIGHT)) |
+		evdev_usage_mask_range(evdev_usage_from(EVDEV_BTN_TRIGGER_HAPPY),
+				       evdev_usage_from(EVDEV_BTN_TRIGGER_HAPPY40));
+	libinput_plugin_enable_device_event_frame_usages(libinput_plugin, device, usages);
 
 	struct plugin_data *plugin = libinput_plugin_get_user_data(libinput_plugin);
 	struct plugin_device *pd = zalloc(sizeof(*pd));
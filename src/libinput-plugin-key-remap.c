@@ -0,0 +1,285 @@
+/*
+ * Copyright © 2025 Red Hat, Inc.
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a
+ * copy of this software and associated documentation files (the "Software"),
+ * to deal in the Software without restriction, including without limitation
+ * the rights to use, copy, modify, merge, publish, distribute, sublicense,
+ * and/or sell copies of the Software, and to permit persons to whom the
+ * Software is furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice (including the next
+ * paragraph) shall be included in all copies or substantial portions of the
+ * Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT.  IN NO EVENT SHALL
+ * THE AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING
+ * FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER
+ * DEALINGS IN THE SOFTWARE.
+ */
+
+
+#include "config.h"
+
+#include <libevdev/libevdev.h>
+#include <strings.h>
+
+#include "util-bits.h"
+#include "util-mem.h"
+#include "util-strings.h"
+
+#include "evdev-frame.h"
+#include "quirks.h"
+
+#include "libinput-log.h"
+#include "libinput-util.h"
+#include "libinput-plugin.h"
+#include "libinput-plugin-key-remap.h"
+
+/* Remaps keys and buttons as given by the AttrKeyRemap quirk. The
+ * quirk is compiled into a per-device lookup table indexed by evdev code
+ * so the frame only needs one lookup per key event. Events are rewritten
+ * (or removed) in place before any other part of libinput sees them.
+ *
+ * A chord MOD+KEY:TARGET sends TARGET instead of KEY if MOD is down
+ * when KEY is pressed. MOD itself is passed through (or remapped) as
+ * usual. The release of a key always matches whatever we sent for its
+ * press, even if the chord's modifier was released in between.
+ */
+
+struct plugin_device {
+	struct list link;
+	struct libinput_device *device;
+
+	/* Indexed by evdev code, the code to send instead or KEY_RESERVED
+	 * to drop the key */
+	uint16_t map[KEY_CNT];
+	/* Indexed by evdev code, bit n is set if the key triggers chords[n] */
+	uint32_t chord_mask[KEY_CNT];
+	struct {
+		uint16_t modifier;
+		uint16_t to;
+	} chords[32];
+
+	/* The physical key state and, for each key that is down, the code
+	 * we sent for its press */
+	unsigned long down[NLONGS(KEY_CNT)];
+	uint16_t sent[KEY_CNT];
+};
+
+struct plugin_data {
+	struct list devices;
+};
+
+static void
+plugin_device_destroy(struct plugin_device *pd)
+{
+	list_remove(&pd->link);
+	libinput_device_unref(pd->device);
+	free(pd);
+}
+
+static void
+plugin_data_destroy(void *d)
+{
+	struct plugin_data *data = d;
+
+	struct plugin_device *pd;
+	list_for_each_safe(pd, &data->devices, link) {
+		plugin_device_destroy(pd);
+	}
+
+	free(data);
+}
+
+static void
+plugin_destroy(struct libinput_plugin *libinput_plugin)
+{
+	struct plugin_data *plugin = libinput_plugin_get_user_data(libinput_plugin);
+	plugin_data_destroy(plugin);
+}
+
+static uint16_t
+key_remap_key(struct plugin_device *pd, uint16_t code, int value)
+{
+	if (code >= KEY_CNT)
+		return code;
+
+	switch (value) {
+	case 0:
+		/* A key that was down before we were set up only has its
+		 * plain mapping */
+		if (!long_bit_is_set(pd->down, code))
+			return pd->map[code];
+
+		long_clear_bit(pd->down, code);
+		return pd->sent[code];
+	case 1: {
+		uint16_t to = pd->map[code];
+		uint32_t chords = pd->chord_mask[code];
+
+		while (chords) {
+			unsigned int idx = ffs(chords) - 1;
+
+			if (long_bit_is_set(pd->down, pd->chords[idx].modifier)) {
+				to = pd->chords[idx].to;
+				break;
+			}
+			chords &= ~bit(idx);
+		}
+
+		long_set_bit(pd->down, code);
+		pd->sent[code] = to;
+		return to;
+	}
+	default: /* key repeat */
+		return long_bit_is_set(pd->down, code) ? pd->sent[code] : pd->map[code];
+	}
+}
+
+static void
+key_remap_handle_frame(struct plugin_device *pd, struct evdev_frame *frame)
+{
+	size_t nevents;
+	const struct evdev_event *in = evdev_frame_get_events_const(frame, &nevents);
+	/* Only non-NULL once we changed something, until then the
+	 * frame (and any frame sharing its events) stays untouched */
+	struct evdev_event *events = NULL;
+	size_t count = 0;
+
+	for (size_t i = 0; i < nevents; i++) {
+		struct evdev_event e = in[i];
+
+		if (evdev_usage_type(e.usage) == EV_KEY) {
+			uint16_t code = evdev_usage_code(e.usage);
+			uint16_t to = key_remap_key(pd, code, e.value);
+
+			if (to != code) {
+				if (!events) {
+					events = evdev_frame_get_events(frame, NULL);
+					in = events;
+				}
+
+				if (to == KEY_RESERVED)
+					continue;
+
+				e.usage = evdev_usage_from_code(EV_KEY, to);
+			}
+		}
+
+		if (events)
+			events[count] = e;
+		count++;
+	}
+
+	if (events)
+		evdev_frame_truncate(frame, count);
+}
+
+static void
+key_remap_plugin_evdev_frame(struct libinput_plugin *libinput_plugin,
+			     struct libinput_device *device,
+			     struct evdev_frame *frame)
+{
+	struct plugin_data *plugin = libinput_plugin_get_user_data(libinput_plugin);
+	struct plugin_device *pd;
+
+	list_for_each(pd, &plugin->devices, link) {
+		if (pd->device == device) {
+			key_remap_handle_frame(pd, frame);
+			break;
+		}
+	}
+}
+
+static void
+key_remap_plugin_device_added(struct libinput_plugin *libinput_plugin,
+			      struct libinput_device *device)
+{
+	_unref_(quirks) *q = libinput_device_get_quirks(device);
+	const struct quirk_tuples *t;
+
+	if (!quirks_get_tuples(q, QUIRK_ATTR_KEY_REMAP, &t))
+		return;
+
+	struct plugin_device *pd = zalloc(sizeof(*pd));
+	uint64_t usages = 0;
+	size_t nchords = 0;
+
+	pd->device = libinput_device_ref(device);
+	for (size_t code = 0; code < ARRAY_LENGTH(pd->map); code++)
+		pd->map[code] = code;
+
+	for (size_t i = 0; i < t->ntuples; i++) {
+		uint16_t from = t->tuples[i].first;
+		uint16_t modifier = t->tuples[i].second;
+		uint16_t to = t->tuples[i].third;
+
+		if (modifier) {
+			if (nchords >= ARRAY_LENGTH(pd->chords))
+				continue;
+
+			pd->chords[nchords].modifier = modifier;
+			pd->chords[nchords].to = to;
+			pd->chord_mask[from] |= bit(nchords);
+			nchords++;
+
+			/* We need to see the modifier to know it's down */
+			usages |= evdev_usage_mask(evdev_usage_from_code(EV_KEY, modifier));
+		} else {
+			pd->map[from] = to;
+		}
+
+		usages |= evdev_usage_mask(evdev_usage_from_code(EV_KEY, from));
+	}
+
+	libinput_plugin_enable_device_event_frame_usages(libinput_plugin, device, usages);
+
+	plugin_log_debug(libinput_plugin,
+			 "%s: remapping %zd keys\n",
+			 libinput_device_get_sysname(device),
+			 t->ntuples);
+
+	struct plugin_data *plugin = libinput_plugin_get_user_data(libinput_plugin);
+	list_take_append(&plugin->devices, pd, link);
+}
+
+static void
+key_remap_plugin_device_removed(struct libinput_plugin *libinput_plugin,
+				struct libinput_device *device)
+{
+	struct plugin_data *plugin = libinput_plugin_get_user_data(libinput_plugin);
+	struct plugin_device *pd;
+
+	list_for_each_safe(pd, &plugin->devices, link) {
+		if (pd->device == device) {
+			plugin_device_destroy(pd);
+			return;
+		}
+	}
+}
+
+static const struct libinput_plugin_interface interface = {
+	.run = NULL,
+	.destroy = plugin_destroy,
+	.device_new = NULL,
+	.device_ignored = NULL,
+	.device_added = key_remap_plugin_device_added,
+	.device_removed = key_remap_plugin_device_removed,
+	.evdev_frame = key_remap_plugin_evdev_frame,
+};
+
+void
+libinput_key_remap_plugin(struct libinput *libinput)
+{
+	struct plugin_data *plugin = zalloc(sizeof(*plugin));
+	list_init(&plugin->devices);
+
+	_unref_(libinput_plugin) *p = libinput_plugin_new(libinput,
+							  "key-remap",
+							  &interface,
+							  plugin);
+}
@@ -0,0 +1,330 @@
+/*
+ * Copyright © 2025 Red Hat, Inc.
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a
+ * copy of this software and associated documentation files (the "Software"),
+ * to deal in the Software without restriction, including without limitation
+ * the rights to use, copy, modify, merge, publish, distribute, sublicense,
+ * and/or sell copies of the Software, and to permit persons to whom the
+ * Software is furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice (including the next
+ * paragraph) shall be included in all copies or substantial portions of the
+ * Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT.  IN NO EVENT SHALL
+ * THE AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING
+ * FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER
+ * DEALINGS IN THE SOFTWARE.
+ */
+
+
+#include "config.h"
+
+#include <inttypes.h>
+#include <libevdev/libevdev.h>
+
+#include "util-mem.h"
+#include "util-time.h"
+
+#include "evdev-frame.h"
+#include "quirks.h"
+
+#include "libinput-log.h"
+#include "libinput-util.h"
+#include "libinput-plugin.h"
+#include "libinput-plugin-mouse-coalesce.h"
+
+/* Mice with polling rates of several kHz send far more motion frames
+ * than anyone can use. For devices with the AttrMaxMotionEventRate quirk
+ * we add up the REL_X/REL_Y of motion-only frames and pass them on at
+ * most once per interval. Any other frame (buttons, wheel) is a boundary
+ * that flushes the pending motion first so the ordering is preserved.
+ *
+ * The frame we pass on carries the timestamp of the most recent report
+ * we added up, so the pointer acceleration sees the summed delta over
+ * the true elapsed time between reports and the velocity it calculates
+ * is the same average velocity it would've seen across the individual
+ * reports.
+ */
+
+struct plugin_device {
+	struct list link;
+	struct plugin_data *parent;
+	struct libinput_device *device;
+	struct libinput_plugin_timer *timer;
+
+	uint64_t interval; /* in µs */
+	uint64_t last_sent;
+
+	struct {
+		int dx, dy;
+		unsigned int nframes;
+		uint64_t time; /* of the most recent frame added */
+	} pending;
+
+	struct {
+		uint64_t frames_in;
+		uint64_t frames_out;
+	} stats;
+};
+
+struct plugin_data {
+	struct libinput_plugin *plugin;
+	struct list devices;
+};
+
+static bool
+coalesce_is_motion_frame(const struct evdev_frame *frame)
+{
+	size_t nevents;
+	const struct evdev_event *events = evdev_frame_get_events_const(frame, &nevents);
+	bool has_motion = false;
+
+	for (size_t i = 0; i < nevents; i++) {
+		const struct evdev_event *e = &events[i];
+
+		switch (evdev_usage_enum(e->usage)) {
+		case EVDEV_REL_X:
+		case EVDEV_REL_Y:
+			has_motion = true;
+			break;
+		case EVDEV_SYN_REPORT:
+			break;
+		default:
+			/* MSC_SCAN and friends don't mean anything for
+			 * motion, dropping them with the frame is fine */
+			if (evdev_event_type(e) != EV_MSC)
+				return false;
+			break;
+		}
+	}
+
+	return has_motion;
+}
+
+static void
+coalesce_reset_pending(struct plugin_device *pd)
+{
+	pd->pending.dx = 0;
+	pd->pending.dy = 0;
+	pd->pending.nframes = 0;
+	libinput_plugin_timer_cancel(pd->timer);
+}
+
+/**
+ * Replace the frame's content with the pending motion.
+ */
+static void
+coalesce_set_frame(struct plugin_device *pd, struct evdev_frame *frame)
+{
+	struct evdev_event events[2];
+	size_t nevents = 0;
+
+	if (pd->pending.dx)
+		events[nevents++] = (struct evdev_event) {
+			.usage = evdev_usage_from(EVDEV_REL_X),
+			.value = pd->pending.dx,
+		};
+	if (pd->pending.dy)
+		events[nevents++] = (struct evdev_event) {
+			.usage = evdev_usage_from(EVDEV_REL_Y),
+			.value = pd->pending.dy,
+		};
+
+	if (nevents > 0) {
+		evdev_frame_set(frame, events, nevents);
+		pd->stats.frames_out++;
+	} else {
+		evdev_frame_reset(frame);
+	}
+	evdev_frame_set_time(frame, pd->pending.time);
+
+	pd->last_sent = pd->pending.time;
+	coalesce_reset_pending(pd);
+}
+
+static void
+coalesce_flush(struct plugin_device *pd, bool before_current_frame)
+{
+	if (pd->pending.nframes == 0)
+		return;
+
+	_unref_(evdev_frame) *frame = evdev_frame_new(3);
+	coalesce_set_frame(pd, frame);
+	if (evdev_frame_is_empty(frame))
+		return;
+
+	if (before_current_frame)
+		libinput_plugin_prepend_evdev_frame(pd->parent->plugin,
+						    pd->device,
+						    frame);
+	else
+		libinput_plugin_append_evdev_frame(pd->parent->plugin,
+						   pd->device,
+						   frame);
+}
+
+static void
+coalesce_handle_frame(struct plugin_device *pd, struct evdev_frame *frame)
+{
+	uint64_t time = evdev_frame_get_time(frame);
+
+	if (!coalesce_is_motion_frame(frame)) {
+		coalesce_flush(pd, true);
+		return;
+	}
+
+	size_t nevents;
+	const struct evdev_event *events = evdev_frame_get_events_const(frame, &nevents);
+	for (size_t i = 0; i < nevents; i++) {
+		const struct evdev_event *e = &events[i];
+
+		if (evdev_usage_eq(e->usage, EVDEV_REL_X))
+			pd->pending.dx += e->value;
+		else if (evdev_usage_eq(e->usage, EVDEV_REL_Y))
+			pd->pending.dy += e->value;
+	}
+	pd->pending.nframes++;
+	pd->pending.time = time;
+	pd->stats.frames_in++;
+
+	if (time >= pd->last_sent + pd->interval) {
+		coalesce_set_frame(pd, frame);
+		return;
+	}
+
+	evdev_frame_reset(frame);
+	if (pd->pending.nframes == 1)
+		libinput_plugin_timer_set(pd->timer, pd->last_sent + pd->interval);
+}
+
+static void
+coalesce_timeout(struct libinput_plugin *plugin, uint64_t now, void *data)
+{
+	struct plugin_device *pd = data;
+
+	coalesce_flush(pd, false);
+}
+
+static void
+coalesce_plugin_device_destroy(struct plugin_device *pd)
+{
+	list_remove(&pd->link);
+
+	if (pd->stats.frames_in > 0)
+		plugin_log_debug(pd->parent->plugin,
+				 "%s: %" PRIu64 " motion frames sent as %" PRIu64 "\n",
+				 libinput_device_get_sysname(pd->device),
+				 pd->stats.frames_in,
+				 pd->stats.frames_out);
+
+	libinput_plugin_timer_cancel(pd->timer);
+	libinput_plugin_timer_unref(pd->timer);
+	libinput_device_unref(pd->device);
+
+	free(pd);
+}
+
+static void
+coalesce_plugin_destroy(struct libinput_plugin *libinput_plugin)
+{
+	struct plugin_data *data = libinput_plugin_get_user_data(libinput_plugin);
+
+	struct plugin_device *pd;
+	list_for_each_safe(pd, &data->devices, link) {
+		coalesce_plugin_device_destroy(pd);
+	}
+
+	free(data);
+}
+
+static void
+coalesce_plugin_device_added(struct libinput_plugin *libinput_plugin,
+			     struct libinput_device *device)
+{
+	if (!libinput_device_has_capability(device, LIBINPUT_DEVICE_CAP_POINTER))
+		return;
+
+	_unref_(quirks) *q = libinput_device_get_quirks(device);
+	uint32_t rate;
+	if (!quirks_get_uint32(q, QUIRK_ATTR_MAX_MOTION_EVENT_RATE, &rate))
+		return;
+
+	/* Every frame may be a boundary, we need to see all of them */
+	libinput_plugin_enable_device_event_frame(libinput_plugin, device, true);
+
+	struct plugin_data *plugin = libinput_plugin_get_user_data(libinput_plugin);
+	struct plugin_device *pd = zalloc(sizeof(*pd));
+	pd->parent = plugin;
+	pd->device = libinput_device_ref(device);
+	pd->interval = s2us(1) / rate;
+	pd->timer = libinput_plugin_timer_new(libinput_plugin,
+					      libinput_device_get_sysname(device),
+					      coalesce_timeout,
+					      pd);
+
+	plugin_log_debug(libinput_plugin,
+			 "%s: limiting motion events to %u/s\n",
+			 libinput_device_get_sysname(device),
+			 rate);
+
+	list_take_append(&plugin->devices, pd, link);
+}
+
+static void
+coalesce_plugin_device_removed(struct libinput_plugin *libinput_plugin,
+			       struct libinput_device *device)
+{
+	struct plugin_data *plugin = libinput_plugin_get_user_data(libinput_plugin);
+	struct plugin_device *pd;
+
+	list_for_each_safe(pd, &plugin->devices, link) {
+		if (pd->device == device) {
+			coalesce_plugin_device_destroy(pd);
+			return;
+		}
+	}
+}
+
+static void
+coalesce_plugin_evdev_frame(struct libinput_plugin *libinput_plugin,
+			    struct libinput_device *device,
+			    struct evdev_frame *frame)
+{
+	struct plugin_data *plugin = libinput_plugin_get_user_data(libinput_plugin);
+	struct plugin_device *pd;
+
+	list_for_each(pd, &plugin->devices, link) {
+		if (pd->device == device) {
+			coalesce_handle_frame(pd, frame);
+			break;
+		}
+	}
+}
+
+static const struct libinput_plugin_interface interface = {
+	.run = NULL,
+	.destroy = coalesce_plugin_destroy,
+	.device_new = NULL,
+	.device_ignored = NULL,
+	.device_added = coalesce_plugin_device_added,
+	.device_removed = coalesce_plugin_device_removed,
+	.evdev_frame = coalesce_plugin_evdev_frame,
+};
+
+void
+libinput_mouse_plugin_coalesce(struct libinput *libinput)
+{
+	struct plugin_data *plugin = zalloc(sizeof(*plugin));
+	list_init(&plugin->devices);
+
+	_unref_(libinput_plugin) *p = libinput_plugin_new(libinput,
+							  "mouse-coalesce",
+							  &interface,
+							  plugin);
+	plugin->plugin = p;
+}
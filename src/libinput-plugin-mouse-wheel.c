@@ -232,12 +232,12 @@ wheel_remove_scroll_events(struct evdev_frame *frame)
 {
 	size_t nevents;
 	_unref_(evdev_frame) *copy = evdev_frame_clone(frame);
-	struct evdev_event *events = evdev_frame_get_events(copy, &nevents);
+	const struct evdev_event *events = evdev_frame_get_events_const(copy, &nevents);
 
 	evdev_frame_reset(frame);
 
 	for (size_t i = 0; i < nevents; i++) {
-		struct evdev_event *e = &events[i];
+		const struct evdev_event *e = &events[i];
 
 		switch (evdev_usage_enum(e->usage)) {
 		case EVDEV_REL_WHEEL:
@@ -330,7 +330,7 @@ wheel_handle_state_scrolling(struct plugin_device *pd,
 
 static void
 wheel_handle_direction_change(struct plugin_device *pd,
-			      struct evdev_event *e,
+			      const struct evdev_event *e,
 			      uint64_t time)
 {
 	enum wheel_direction new_dir = WHEEL_DIR_UNKNOW;
@@ -354,7 +354,7 @@ wheel_handle_direction_change(struct plugin_device *pd,
 
 static void
 wheel_process_relative(struct plugin_device *pd,
-		       struct evdev_event *e,
+		       const struct evdev_event *e,
 		       uint64_t time)
 {
 	switch (evdev_usage_enum(e->usage)) {
@@ -482,7 +482,13 @@ wheel_plugin_device_added(struct libinput_plugin *libinput_plugin,
 	if (!libinput_device_has_capability(device, LIBINPUT_DEVICE_CAP_POINTER))
 		return;
 
-	libinput_plugin_enable_device_event_frame(libinput_plugin, device, true);
+	/* Frames without scroll events don't change our state */
+	uint64_t usages =
+		evdev_usage_mask(evdev_usage_from(EVDEV_REL_WHEEL)) |
+		evdev_usage_mask(evdev_usage_from(EVDEV_REL_WHEEL_HI_RES)) |
+		evdev_usage_mask(evdev_usage_from(EVDEV_REL_HWHEEL)) |
+		evdev_usage_mask(evdev_usage_from(EVDEV_REL_HWHEEL_HI_RES));
+	libinput_plugin_enable_device_event_frame_usages(libinput_plugin, device, usages);
 
 	struct plugin_data *plugin = libinput_plugin_get_user_data(libinput_plugin);
 	struct plugin_device *pd = wheel_plugin_device_create(libinput_plugin,
@@ -511,10 +517,10 @@ wheel_handle_frame(struct plugin_device *pd,
 		   uint64_t time)
 {
 	size_t nevents;
-	struct evdev_event *events = evdev_frame_get_events(frame, &nevents);
+	const struct evdev_event *events = evdev_frame_get_events_const(frame, &nevents);
 
 	for (size_t i = 0; i < nevents; i++) {
-		struct evdev_event *e = &events[i];
+		const struct evdev_event *e = &events[i];
 		uint16_t type = evdev_event_type(e);
 
 		switch (type) {
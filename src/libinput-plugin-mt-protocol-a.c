@@ -0,0 +1,424 @@
+/*
+ * Copyright © 2025 Red Hat, Inc.
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a
+ * copy of this software and associated documentation files (the "Software"),
+ * to deal in the Software without restriction, including without limitation
+ * the rights to use, copy, modify, merge, publish, distribute, sublicense,
+ * and/or sell copies of the Software, and to permit persons to whom the
+ * Software is furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice (including the next
+ * paragraph) shall be included in all copies or substantial portions of the
+ * Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT.  IN NO EVENT SHALL
+ * THE AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING
+ * FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER
+ * DEALINGS IN THE SOFTWARE.
+ */
+
+#include "config.h"
+
+#include <libevdev/libevdev.h>
+
+#include "evdev.h"
+#include "evdev-frame.h"
+
+#include "libinput-log.h"
+#include "libinput-util.h"
+#include "libinput-plugin.h"
+#include "libinput-plugin-mt-protocol-a.h"
+
+/* Converts MT protocol A devices into protocol B.
+ *
+ * Protocol A devices send the full set of contacts in every frame, each
+ * contact terminated by a SYN_MT_REPORT. Contacts are matched against
+ * the slots of the previous frame by their tracking ID (if the device
+ * has one) or by the shortest distance otherwise. The frame is then
+ * rewritten to contain only ABS_MT_SLOT and the values that changed for
+ * each slot, exactly as a protocol B device would send it.
+ *
+ * Like mtdev, values are clipped to the axis range and a contact
+ * without a position is not a contact. Where the build has mtdev, this
+ * plugin only handles the devices mtdev can't, see evdev_need_mtdev().
+ */
+
+#define MT_FIRST ABS_MT_TOUCH_MAJOR
+#define MT_LAST ABS_MT_TOOL_Y
+#define MT_NVALUES (MT_LAST - MT_FIRST + 1)
+
+/* One slot value for each of ABS_MT_SLOT, ABS_MT_TRACKING_ID and the
+ * remaining MT axes */
+#define MT_MAX_EVENTS (MT_PROTOCOL_A_NUM_SLOTS * (MT_NVALUES + 1))
+
+struct mt_values {
+	uint32_t present; /* bitmask of values, indexed by code - MT_FIRST */
+	int values[MT_NVALUES];
+};
+
+struct contact {
+	struct mt_values v;
+	int slot;
+};
+
+struct slot {
+	bool active;
+	bool seen;
+	int tracking_id;
+	struct mt_values v;
+};
+
+struct plugin_device {
+	struct list link;
+	struct libinput_device *device;
+
+	struct slot slots[MT_PROTOCOL_A_NUM_SLOTS];
+	int next_tracking_id;
+	/* NULL for the axes the device doesn't have */
+	const struct input_absinfo *absinfo[MT_NVALUES];
+	struct evdev_frame *out;
+};
+
+struct plugin_data {
+	struct libinput_plugin *plugin;
+	struct list devices;
+};
+
+static inline bool
+is_mt_value(unsigned int code)
+{
+	return code >= MT_FIRST && code <= MT_LAST;
+}
+
+static inline bool
+mt_values_has(const struct mt_values *v, unsigned int code)
+{
+	return !!(v->present & bit(code - MT_FIRST));
+}
+
+static inline int
+mt_values_get(const struct mt_values *v, unsigned int code)
+{
+	return v->values[code - MT_FIRST];
+}
+
+static inline void
+mt_values_set(struct mt_values *v, unsigned int code, int value)
+{
+	v->present |= bit(code - MT_FIRST);
+	v->values[code - MT_FIRST] = value;
+}
+
+static inline uint64_t
+contact_distance(const struct mt_values *a, const struct mt_values *b)
+{
+	int64_t dx = mt_values_get(a, ABS_MT_POSITION_X) - mt_values_get(b, ABS_MT_POSITION_X);
+	int64_t dy = mt_values_get(a, ABS_MT_POSITION_Y) - mt_values_get(b, ABS_MT_POSITION_Y);
+
+	return dx * dx + dy * dy;
+}
+
+static inline void
+append_abs(struct evdev_frame *frame, unsigned int code, int value)
+{
+	struct evdev_event e = {
+		.usage = evdev_usage_from_code(EV_ABS, code),
+		.value = value,
+	};
+
+	evdev_frame_append(frame, &e, 1);
+}
+
+/**
+ * Match each contact to a slot that was active in the previous frame.
+ * Contacts with a tracking ID only ever match the slot with the same
+ * tracking ID, all others are paired up greedily by shortest distance.
+ */
+static void
+protocol_a_match_contacts(struct plugin_device *pd,
+			  struct contact *contacts,
+			  size_t ncontacts)
+{
+	for (size_t c = 0; c < ncontacts; c++) {
+		struct contact *contact = &contacts[c];
+
+		if (!mt_values_has(&contact->v, ABS_MT_TRACKING_ID))
+			continue;
+
+		int tid = mt_values_get(&contact->v, ABS_MT_TRACKING_ID);
+		for (size_t s = 0; s < ARRAY_LENGTH(pd->slots); s++) {
+			struct slot *slot = &pd->slots[s];
+
+			if (slot->active && !slot->seen &&
+			    mt_values_has(&slot->v, ABS_MT_TRACKING_ID) &&
+			    mt_values_get(&slot->v, ABS_MT_TRACKING_ID) == tid) {
+				contact->slot = s;
+				slot->seen = true;
+				break;
+			}
+		}
+	}
+
+	while (true) {
+		uint64_t best = UINT64_MAX;
+		int best_contact = -1, best_slot = -1;
+
+		for (size_t c = 0; c < ncontacts; c++) {
+			struct contact *contact = &contacts[c];
+
+			if (contact->slot != -1 ||
+			    mt_values_has(&contact->v, ABS_MT_TRACKING_ID))
+				continue;
+
+			for (size_t s = 0; s < ARRAY_LENGTH(pd->slots); s++) {
+				struct slot *slot = &pd->slots[s];
+
+				if (!slot->active || slot->seen ||
+				    mt_values_has(&slot->v, ABS_MT_TRACKING_ID))
+					continue;
+
+				uint64_t d = contact_distance(&contact->v, &slot->v);
+				if (d < best) {
+					best = d;
+					best_contact = c;
+					best_slot = s;
+				}
+			}
+		}
+
+		if (best_contact == -1)
+			break;
+
+		contacts[best_contact].slot = best_slot;
+		pd->slots[best_slot].seen = true;
+	}
+}
+
+static void
+protocol_a_handle_frame(struct plugin_data *plugin,
+			struct plugin_device *pd,
+			struct evdev_frame *frame)
+{
+	struct contact contacts[MT_PROTOCOL_A_NUM_SLOTS];
+	size_t ncontacts = 0;
+	struct mt_values current = {0};
+	struct evdev_frame *out = pd->out;
+
+	evdev_frame_reset(out);
+
+	size_t nevents;
+	const struct evdev_event *events = evdev_frame_get_events_const(frame, &nevents);
+	for (size_t i = 0; i < nevents; i++) {
+		const struct evdev_event *e = &events[i];
+		uint16_t type = evdev_event_type(e);
+		uint16_t code = evdev_event_code(e);
+
+		if (type == EV_ABS && is_mt_value(code)) {
+			const struct input_absinfo *abs = pd->absinfo[code - MT_FIRST];
+			int value = e->value;
+
+			if (abs && code != ABS_MT_TRACKING_ID)
+				value = max(abs->minimum, min(value, abs->maximum));
+			mt_values_set(&current, code, value);
+		} else if (type == EV_SYN &&
+			   (code == SYN_MT_REPORT || code == SYN_REPORT)) {
+			/* An empty SYN_MT_REPORT means no contacts, a
+			 * contact without a position isn't one either */
+			if (!mt_values_has(&current, ABS_MT_POSITION_X) ||
+			    !mt_values_has(&current, ABS_MT_POSITION_Y)) {
+				current.present = 0;
+				continue;
+			}
+
+			if (ncontacts < ARRAY_LENGTH(contacts)) {
+				contacts[ncontacts++] = (struct contact) {
+					.v = current,
+					.slot = -1,
+				};
+			}
+			current.present = 0;
+		} else if (!(type == EV_ABS && code == ABS_MT_SLOT)) {
+			evdev_frame_append(out, e, 1);
+		}
+	}
+
+	for (size_t s = 0; s < ARRAY_LENGTH(pd->slots); s++)
+		pd->slots[s].seen = false;
+
+	protocol_a_match_contacts(pd, contacts, ncontacts);
+
+	/* Slots without a contact this frame have been lifted */
+	for (size_t s = 0; s < ARRAY_LENGTH(pd->slots); s++) {
+		struct slot *slot = &pd->slots[s];
+
+		if (!slot->active || slot->seen)
+			continue;
+
+		append_abs(out, ABS_MT_SLOT, s);
+		append_abs(out, ABS_MT_TRACKING_ID, -1);
+		slot->active = false;
+		/* Don't re-use the slot within the same frame */
+		slot->seen = true;
+	}
+
+	for (size_t c = 0; c < ncontacts; c++) {
+		struct contact *contact = &contacts[c];
+		struct slot *slot;
+		bool new_touch = contact->slot == -1;
+
+		if (new_touch) {
+			for (size_t s = 0; s < ARRAY_LENGTH(pd->slots); s++) {
+				if (!pd->slots[s].active && !pd->slots[s].seen) {
+					contact->slot = s;
+					break;
+				}
+			}
+			if (contact->slot == -1)
+				continue;
+
+			slot = &pd->slots[contact->slot];
+			slot->active = true;
+			slot->seen = true;
+			slot->tracking_id = pd->next_tracking_id;
+			pd->next_tracking_id = (pd->next_tracking_id + 1) & 0xffff;
+
+			append_abs(out, ABS_MT_SLOT, contact->slot);
+			append_abs(out, ABS_MT_TRACKING_ID, slot->tracking_id);
+		} else {
+			slot = &pd->slots[contact->slot];
+		}
+
+		bool slot_sent = new_touch;
+		for (unsigned int code = MT_FIRST; code <= MT_LAST; code++) {
+			if (code == ABS_MT_TRACKING_ID ||
+			    !mt_values_has(&contact->v, code))
+				continue;
+
+			int value = mt_values_get(&contact->v, code);
+			if (!new_touch &&
+			    mt_values_has(&slot->v, code) &&
+			    mt_values_get(&slot->v, code) == value)
+				continue;
+
+			if (!slot_sent) {
+				append_abs(out, ABS_MT_SLOT, contact->slot);
+				slot_sent = true;
+			}
+			append_abs(out, code, value);
+		}
+
+		slot->v = contact->v;
+	}
+
+	if (evdev_frame_set(frame,
+			    evdev_frame_get_events_const(out, NULL),
+			    evdev_frame_get_count(out)) == -ENOMEM) {
+		/* Doesn't fit into the device's frame, send ours
+		 * in its place */
+		evdev_frame_set_time(out, evdev_frame_get_time(frame));
+		evdev_frame_reset(frame);
+		libinput_plugin_append_evdev_frame(plugin->plugin, pd->device, out);
+	}
+}
+
+static void
+protocol_a_plugin_evdev_frame(struct libinput_plugin *libinput_plugin,
+			      struct libinput_device *device,
+			      struct evdev_frame *frame)
+{
+	struct plugin_data *plugin = libinput_plugin_get_user_data(libinput_plugin);
+	struct plugin_device *pd;
+
+	list_for_each(pd, &plugin->devices, link) {
+		if (pd->device == device) {
+			protocol_a_handle_frame(plugin, pd, frame);
+			break;
+		}
+	}
+}
+
+static void
+protocol_a_plugin_device_destroy(struct plugin_device *pd)
+{
+	list_remove(&pd->link);
+	evdev_frame_unref(pd->out);
+	libinput_device_unref(pd->device);
+	free(pd);
+}
+
+static void
+protocol_a_plugin_destroy(struct libinput_plugin *libinput_plugin)
+{
+	struct plugin_data *plugin = libinput_plugin_get_user_data(libinput_plugin);
+	struct plugin_device *pd;
+
+	list_for_each_safe(pd, &plugin->devices, link) {
+		protocol_a_plugin_device_destroy(pd);
+	}
+
+	free(plugin);
+}
+
+static void
+protocol_a_plugin_device_added(struct libinput_plugin *libinput_plugin,
+			       struct libinput_device *device)
+{
+	struct evdev_device *evdev = evdev_device(device);
+
+	if (!evdev_is_mt_protocol_a(evdev) || evdev_need_mtdev(evdev))
+		return;
+
+	/* Every frame matters, a frame without contacts releases
+	 * all touches */
+	libinput_plugin_enable_device_event_frame(libinput_plugin, device, true);
+
+	struct plugin_data *plugin = libinput_plugin_get_user_data(libinput_plugin);
+	struct plugin_device *pd = zalloc(sizeof(*pd));
+	pd->device = libinput_device_ref(device);
+	pd->out = evdev_frame_new(64 + MT_MAX_EVENTS);
+	for (unsigned int code = MT_FIRST; code <= MT_LAST; code++)
+		pd->absinfo[code - MT_FIRST] = libevdev_get_abs_info(evdev->evdev, code);
+	list_take_append(&plugin->devices, pd, link);
+}
+
+static void
+protocol_a_plugin_device_removed(struct libinput_plugin *libinput_plugin,
+				 struct libinput_device *device)
+{
+	struct plugin_data *plugin = libinput_plugin_get_user_data(libinput_plugin);
+	struct plugin_device *pd;
+
+	list_for_each_safe(pd, &plugin->devices, link) {
+		if (pd->device == device) {
+			protocol_a_plugin_device_destroy(pd);
+			return;
+		}
+	}
+}
+
+static const struct libinput_plugin_interface interface = {
+	.run = NULL,
+	.destroy = protocol_a_plugin_destroy,
+	.device_new = NULL,
+	.device_ignored = NULL,
+	.device_added = protocol_a_plugin_device_added,
+	.device_removed = protocol_a_plugin_device_removed,
+	.evdev_frame = protocol_a_plugin_evdev_frame,
+};
+
+void
+libinput_mt_protocol_a_plugin(struct libinput *libinput)
+{
+	struct plugin_data *plugin = zalloc(sizeof(*plugin));
+	list_init(&plugin->devices);
+
+	_unref_(libinput_plugin) *p = libinput_plugin_new(libinput,
+							  "mt-protocol-a",
+							  &interface,
+							  plugin);
+	plugin->plugin = p;
+}
@@ -33,6 +33,7 @@
 #include "util-list.h"
 
 #include "libinput.h"
+#include "libinput-private-api.h"
 
 struct libinput;
 struct libinput_plugin;
@@ -46,6 +47,27 @@ struct libinput_plugin_system {
 	struct list removed_plugins;
 
 	size_t next_plugin_index; /* sequential index of all plugins */
+
+	/* Incremented whenever a plugin is (un)registered so devices
+	 * know to recompile their plugin chain */
+	uint64_t generation;
+
+	/* see libinput_set_flight_recorder(), 0 if disabled */
+	unsigned int flight_recorder_seconds;
+};
+
+/* The counters for one plugin, indexed by enum libinput_plugin_stat - 1 */
+struct libinput_plugin_profile {
+	uint64_t values[LIBINPUT_PLUGIN_STAT_FRAMES_SHARED];
+};
+
+/* The plugin part of a struct libinput_stats snapshot */
+struct libinput_plugin_stats {
+	size_t nplugins;
+	struct {
+		char *name;
+		struct libinput_plugin_profile profile;
+	} plugins[32];
 };
 
 void
@@ -94,3 +116,16 @@ void
 libinput_plugin_system_notify_evdev_frame(struct libinput_plugin_system *system,
 					  struct libinput_device *device,
 					  struct evdev_frame *frame);
+
+void
+libinput_plugin_system_reset_stats(struct libinput_plugin_system *system);
+
+/**
+ * Fill in the plugin statistics of the given device or, if device is
+ * NULL, the totals across all devices. The caller must free the plugin
+ * names.
+ */
+void
+libinput_plugin_system_get_stats(struct libinput_plugin_system *system,
+				 struct libinput_device *device,
+				 struct libinput_plugin_stats *stats);
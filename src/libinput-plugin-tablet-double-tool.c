@@ -103,14 +103,14 @@ double_tool_plugin_filter_frame(struct libinput_plugin *plugin,
 				enum tool_filter filter)
 {
 	size_t nevents;
-	struct evdev_event *events = evdev_frame_get_events(frame_in, &nevents);
+	const struct evdev_event *events = evdev_frame_get_events_const(frame_in, &nevents);
 
 	/* +2 because we may add BTN_TOOL_PEN and BTN_TOOL_RUBBER */
 	struct evdev_frame *frame_out = evdev_frame_new(nevents + 2);
 	evdev_frame_set_time(frame_out, evdev_frame_get_time(frame_in));
 
 	for (size_t i = 0; i < nevents; i++) {
-		struct evdev_event *event = &events[i];
+		const struct evdev_event *event = &events[i];
 
 		switch (evdev_usage_enum(event->usage)) {
 		case EVDEV_BTN_TOOL_PEN:
@@ -158,13 +158,13 @@ double_tool_plugin_device_handle_frame(struct libinput_plugin *libinput_plugin,
 				       struct evdev_frame *frame)
 {
 	size_t nevents;
-	struct evdev_event *events = evdev_frame_get_events(frame, &nevents);
+	const struct evdev_event *events = evdev_frame_get_events_const(frame, &nevents);
 
 	const struct evdev_event *eraser_toggle = NULL;
 	const struct evdev_event *pen_toggle = NULL;
 
 	for (size_t i = 0; i < nevents; i++) {
-		struct evdev_event *event = &events[i];
+		const struct evdev_event *event = &events[i];
 
 		switch (evdev_usage_enum(event->usage)) {
 		case EVDEV_BTN_TOOL_RUBBER:
@@ -292,7 +292,7 @@ double_tool_plugin_device_handle_frame(struct libinput_plugin *libinput_plugin,
 			double_tool_plugin_filter_frame(libinput_plugin, frame, SKIP_PEN);
 		size_t out_nevents;
 		evdev_frame_set(frame,
-				evdev_frame_get_events(frame_out, &out_nevents),
+				evdev_frame_get_events_const(frame_out, &out_nevents),
 				nevents);
 		bitmask_set_bit(&device->tools_seen, TOOL_DOUBLE_TOOL);
 	} else if (pen_is_down) {
@@ -300,7 +300,7 @@ double_tool_plugin_device_handle_frame(struct libinput_plugin *libinput_plugin,
 			double_tool_plugin_filter_frame(libinput_plugin, frame, PEN_IN_PROX);
 		size_t out_nevents;
 		evdev_frame_set(frame,
-				evdev_frame_get_events(frame_out, &out_nevents),
+				evdev_frame_get_events_const(frame_out, &out_nevents),
 				nevents);
 	}
 }
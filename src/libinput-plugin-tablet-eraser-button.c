@@ -189,7 +189,7 @@ eraser_button_insert_frame(struct plugin_device *device,
 			   evdev_usage_t *button)
 {
 	size_t nevents;
-	const struct evdev_event *events = evdev_frame_get_events(frame_in, &nevents);
+	const struct evdev_event *events = evdev_frame_get_events_const(frame_in, &nevents);
 
 	/* +2 because we may add BTN_TOOL_PEN and BTN_TOOL_RUBBER */
 	_unref_(evdev_frame) *frame_out = evdev_frame_new(nevents + 2);
@@ -438,13 +438,13 @@ eraser_button_handle_frame(struct plugin_device *device,
 		return;
 
 	size_t nevents;
-	struct evdev_event *events = evdev_frame_get_events(frame, &nevents);
+	const struct evdev_event *events = evdev_frame_get_events_const(frame, &nevents);
 
 	bool pen_toggled = false;
 	bool eraser_toggled = false;
 
 	for (size_t i = 0; i < nevents; i++) {
-		struct evdev_event *event = &events[i];
+		const struct evdev_event *event = &events[i];
 
 		switch (evdev_usage_enum(event->usage)) {
 		case EVDEV_BTN_TOOL_PEN:
@@ -95,12 +95,12 @@ forced_tool_plugin_device_handle_frame(struct libinput_plugin *libinput_plugin,
 				       struct evdev_frame *frame)
 {
 	size_t nevents;
-	struct evdev_event *events = evdev_frame_get_events(frame, &nevents);
+	const struct evdev_event *events = evdev_frame_get_events_const(frame, &nevents);
 
 	bool axis_change = false;
 
 	for (size_t i = 0; i < nevents; i++) {
-		struct evdev_event *event = &events[i];
+		const struct evdev_event *event = &events[i];
 		switch (evdev_usage_enum(event->usage)) {
 		case EVDEV_BTN_TOOL_PEN:
 		case EVDEV_BTN_TOOL_RUBBER:
@@ -163,9 +163,9 @@ proximity_timer_plugin_device_handle_frame(struct libinput_plugin *libinput_plug
 	bool pen_toggled = false;
 
 	size_t nevents;
-	struct evdev_event *events = evdev_frame_get_events(frame, &nevents);
+	const struct evdev_event *events = evdev_frame_get_events_const(frame, &nevents);
 	for (size_t i = 0; i < nevents; i++) {
-		struct evdev_event *event = &events[i];
+		const struct evdev_event *event = &events[i];
 
 		/* The proximity timeout is only needed for BTN_TOOL_PEN, devices
 		 * that require it don't do erasers */
@@ -27,6 +27,7 @@
 
 #include "util-files.h"
 #include "util-list.h"
+#include "util-time.h"
 
 #include "libinput-plugin.h"
 #include "libinput-plugin-private.h"
@@ -36,8 +37,12 @@
 
 #include "libinput-util.h"
 #include "libinput-private.h"
+#include "libinput-flight-recorder.h"
 #include "libinput-plugin-button-debounce.h"
+#include "libinput-plugin-key-remap.h"
+#include "libinput-plugin-mouse-coalesce.h"
 #include "libinput-plugin-mouse-wheel.h"
+#include "libinput-plugin-mt-protocol-a.h"
 #include "libinput-plugin-tablet-double-tool.h"
 #include "libinput-plugin-tablet-eraser-button.h"
 #include "libinput-plugin-tablet-forced-tool.h"
@@ -63,6 +68,10 @@ struct libinput_plugin {
 		struct list *after;
 		struct list *before;
 	} event_queue;
+
+	/* Totals across all devices, only updated while stats are
+	 * enabled */
+	struct libinput_plugin_profile profile;
 };
 
 struct libinput_plugin_timer {
@@ -94,6 +103,30 @@ plugin_log_msg(struct libinput_plugin *plugin,
 	log_msg(plugin->libinput, priority, "%s%s", prefix, message);
 }
 
+static inline bool
+plugin_stats_enabled(struct libinput_plugin *plugin)
+{
+	return plugin->libinput->stats_enabled;
+}
+
+static void
+plugin_note_stat(struct libinput_plugin *plugin,
+		 struct libinput_device *device,
+		 enum libinput_plugin_stat which,
+		 uint64_t value)
+{
+	plugin->profile.values[which - 1] += value;
+
+	if (!device || plugin->index >= ARRAY_LENGTH(device->plugin_usage_masks))
+		return;
+
+	if (!device->plugin_profile)
+		device->plugin_profile = zalloc(ARRAY_LENGTH(device->plugin_usage_masks) *
+						sizeof(*device->plugin_profile));
+
+	device->plugin_profile[plugin->index].values[which - 1] += value;
+}
+
 struct libinput_plugin *
 libinput_plugin_new(struct libinput *libinput,
 		    const char *name,
@@ -185,16 +218,58 @@ libinput_plugin_get_context(struct libinput_plugin *plugin)
 	return plugin->libinput;
 }
 
+/**
+ * Fill the device's plugin chain with all registered plugins that want
+ * evdev frames for this device, in plugin order.
+ */
+static void
+plugin_system_compile_chain(struct libinput_plugin_system *system,
+			    struct libinput_device *device)
+{
+	struct libinput_plugin *plugin;
+	size_t count = 0;
+
+	list_for_each(plugin, &system->plugins, link) {
+		if (plugin->index >= ARRAY_LENGTH(device->plugin_chain.plugins) ||
+		    !bitmask_bit_is_set(device->plugin_frame_callbacks, plugin->index))
+			continue;
+
+		uint64_t mask = device->plugin_usage_masks[plugin->index];
+		device->plugin_chain.plugins[count] = plugin;
+		device->plugin_chain.usage_masks[count] = mask;
+		count++;
+	}
+
+	device->plugin_chain.count = count;
+	device->plugin_chain.generation = system->generation;
+}
+
 void
-libinput_plugin_enable_device_event_frame(struct libinput_plugin *plugin,
-					  struct libinput_device *device,
-					  bool enable)
+libinput_plugin_enable_device_event_frame_usages(struct libinput_plugin *plugin,
+						 struct libinput_device *device,
+						 uint64_t usage_mask)
 {
-	if (enable) {
+	if (plugin->index >= ARRAY_LENGTH(device->plugin_usage_masks))
+		return;
+
+	if (usage_mask) {
 		bitmask_set_bit(&device->plugin_frame_callbacks, plugin->index);
 	} else {
 		bitmask_clear_bit(&device->plugin_frame_callbacks, plugin->index);
 	}
+	device->plugin_usage_masks[plugin->index] = usage_mask;
+
+	plugin_system_compile_chain(&plugin->libinput->plugin_system, device);
+}
+
+void
+libinput_plugin_enable_device_event_frame(struct libinput_plugin *plugin,
+					  struct libinput_device *device,
+					  bool enable)
+{
+	libinput_plugin_enable_device_event_frame_usages(plugin,
+							 device,
+							 enable ? EVDEV_USAGE_MASK_ALL : 0);
 }
 
 struct plugin_queued_event {
@@ -242,6 +317,20 @@ libinput_plugin_queue_evdev_frame(struct list *queue,
 	struct plugin_queued_event *event =
 		plugin_queued_event_new(clone, device);
 	list_take_append(queue, event, link);
+
+	if (plugin_stats_enabled(plugin)) {
+		plugin_note_stat(plugin,
+				 device,
+				 queue == plugin->event_queue.before ?
+					LIBINPUT_PLUGIN_STAT_FRAMES_PREPENDED :
+					LIBINPUT_PLUGIN_STAT_FRAMES_APPENDED,
+				 1);
+		if (evdev_frame_is_shared(clone))
+			plugin_note_stat(plugin,
+					 device,
+					 LIBINPUT_PLUGIN_STAT_FRAMES_SHARED,
+					 1);
+	}
 }
 
 void
@@ -273,6 +362,9 @@ libinput_plugin_inject_evdev_frame(struct libinput_plugin *plugin,
 				   struct libinput_device *device,
 				   struct evdev_frame *frame)
 {
+	if (plugin_stats_enabled(plugin))
+		plugin_note_stat(plugin, device, LIBINPUT_PLUGIN_STAT_FRAMES_INJECTED, 1);
+
 	if (device->inject_evdev_frame)
 		device->inject_evdev_frame(device, frame);
 }
@@ -344,6 +436,7 @@ libinput_plugin_system_register_plugin(struct libinput_plugin_system *system,
 {
 	libinput_plugin_ref(plugin);
 	list_append(&system->plugins, &plugin->link);
+	system->generation++;
 }
 
 void
@@ -355,6 +448,7 @@ libinput_plugin_system_unregister_plugin(struct libinput_plugin_system *system,
 		if (p == plugin) {
 			list_remove(&plugin->link);
 			list_append(&system->removed_plugins, &plugin->link);
+			system->generation++;
 			return;
 		}
 	}
@@ -375,6 +469,7 @@ void
 libinput_plugin_system_init(struct libinput_plugin_system *system)
 {
 	system->loaded = false;
+	system->generation = 1; /* devices start with 0, i.e. stale */
 	list_init(&system->plugins);
 	list_init(&system->removed_plugins);
 }
@@ -388,6 +483,10 @@ libinput_plugin_system_load_internal_plugins(struct libinput *libinput,
 
 	system->loaded = true;
 
+	/* Converts protocol A devices so all other plugins only ever
+	 * see slotted protocol B */
+	libinput_mt_protocol_a_plugin(libinput);
+
 	/* FIXME: this should really be one of the first in the sequence
 	 * so plugins don't have to take care of this? */
 	libinput_tablet_plugin_forced_tool(libinput);
@@ -395,7 +494,10 @@ libinput_plugin_system_load_internal_plugins(struct libinput *libinput,
 	libinput_tablet_plugin_proximity_timer(libinput);
 	libinput_tablet_plugin_eraser_button(libinput);
 	libinput_debounce_plugin(libinput);
+	/* After debouncing so we remap what the user meant to press */
+	libinput_key_remap_plugin(libinput);
 	libinput_mouse_plugin_wheel(libinput);
+	libinput_mouse_plugin_coalesce(libinput);
 
 	/* Our own event dispatch is implemented as mini-plugin,
 	 * guarantee this one to always be last (and after any
@@ -434,6 +536,10 @@ libinput_plugin_system_notify_device_added(struct libinput_plugin_system *system
 					   struct libinput_device *device)
 {
 	struct libinput_plugin *plugin;
+
+	if (system->flight_recorder_seconds && !device->flight_recorder)
+		device->flight_recorder = flight_recorder_new(system->flight_recorder_seconds);
+
 	list_for_each_safe(plugin, &system->plugins, link) {
 		libinput_plugin_notify_device_added(plugin, device);
 	}
@@ -474,6 +580,42 @@ libinput_plugin_system_notify_tablet_tool_configured(struct libinput_plugin_syst
 	libinput_plugin_system_drop_unregistered_plugins(system);
 }
 
+static inline void
+libinput_plugin_call_evdev_frame(struct libinput_plugin *plugin,
+				 struct libinput_device *device,
+				 struct evdev_frame *frame,
+				 struct list *before_events,
+				 struct list *after_events)
+{
+	bool profile = plugin_stats_enabled(plugin);
+	uint64_t start = 0;
+
+	if (profile)
+		now_in_ns(&start);
+
+	plugin->event_queue.before = before_events;
+	plugin->event_queue.after = after_events;
+
+	if (plugin->interface->evdev_frame)
+		plugin->interface->evdev_frame(plugin, device, frame);
+
+	plugin->event_queue.before = NULL;
+	plugin->event_queue.after = NULL;
+
+	if (profile) {
+		uint64_t end = 0;
+		size_t nout = list_length(before_events) + list_length(after_events);
+
+		if (!evdev_frame_is_empty(frame))
+			nout++;
+
+		now_in_ns(&end);
+		plugin_note_stat(plugin, device, LIBINPUT_PLUGIN_STAT_FRAMES_IN, 1);
+		plugin_note_stat(plugin, device, LIBINPUT_PLUGIN_STAT_FRAMES_OUT, nout);
+		plugin_note_stat(plugin, device, LIBINPUT_PLUGIN_STAT_TIME_NSEC, end - start);
+	}
+}
+
 static void
 libinput_plugin_process_frame(struct libinput_plugin *plugin,
 			      struct libinput_device *device,
@@ -483,14 +625,11 @@ libinput_plugin_process_frame(struct libinput_plugin *plugin,
 	struct list before_events = LIST_INIT(before_events);
 	struct list after_events = LIST_INIT(after_events);
 
-	plugin->event_queue.before = &before_events;
-	plugin->event_queue.after = &after_events;
-
-	if (plugin->interface->evdev_frame)
-		plugin->interface->evdev_frame(plugin, device, frame);
-
-	plugin->event_queue.before = NULL;
-	plugin->event_queue.after = NULL;
+	libinput_plugin_call_evdev_frame(plugin,
+					 device,
+					 frame,
+					 &before_events,
+					 &after_events);
 
 	list_chain(queued_events, &before_events);
 
@@ -520,10 +659,10 @@ print_frame(struct libinput *libinput,
 	time -= offset;
 
 	size_t nevents;
-	struct evdev_event *events = evdev_frame_get_events(frame, &nevents);
+	const struct evdev_event *events = evdev_frame_get_events_const(frame, &nevents);
 
 	for (size_t i = 0; i < nevents; i++) {
-		struct evdev_event *e = &events[i];
+		const struct evdev_event *e = &events[i];
 
 		switch (evdev_usage_enum(e->usage)) {
 		case EVDEV_SYN_REPORT:
@@ -561,38 +700,20 @@ print_frame(struct libinput *libinput,
 }
 
 static void
-plugin_system_notify_evdev_frame(struct libinput_plugin_system *system,
-				 struct libinput_device *device,
-				 struct evdev_frame *frame,
-				 struct libinput_plugin *sender_plugin)
+plugin_system_process_queued_events(struct libinput_plugin_system *system,
+				    struct libinput_device *device,
+				    struct libinput_plugin **plugins,
+				    const uint64_t *usage_masks,
+				    size_t nplugins,
+				    struct list *queued_events,
+				    uint64_t frame_time)
 {
-	/* This is messy because a single event frame may cause
-	 * *each* plugin to generate multiple event frames for potentially
-	 * different devices and replaying is basically breadth-first traversal.
-	 *
-	 * So we have our event (passed in as 'frame') and we create a queue.
-	 * Each plugin then creates a new event list from each frame in the
-	 * queue.
-	 */
-	struct plugin_queued_event *our_event = plugin_queued_event_new(frame, device);
-
-	struct list queued_events = LIST_INIT(queued_events);
-	list_take_insert(&queued_events, our_event, link);
-
-	uint64_t frame_time = evdev_frame_get_time(frame);
+	for (size_t i = 0; i < nplugins; i++) {
+		struct libinput_plugin *plugin = plugins[i];
+		uint64_t usage_mask = usage_masks[i];
 
-	bool delay = !!sender_plugin;
-
-	struct libinput_plugin *plugin;
-	list_for_each_safe(plugin, &system->plugins, link) {
-		/* We start processing *after* the sender plugin. sender_plugin
-		 * is only set if we're queuing (not injecting) events from
-		 * a plugin timer func
-		 */
-		if (delay) {
-			delay = plugin != sender_plugin;
+		if (!plugin->registered)
 			continue;
-		}
 
 		/* The list of queued events for the *next* plugin */
 		struct list next_events = LIST_INIT(next_events);
@@ -604,18 +725,24 @@ plugin_system_notify_evdev_frame(struct libinput_plugin_system *system,
 		 * and that list becomes the event list for the next plugin.
 		 */
 		struct plugin_queued_event *event;
-		list_for_each_safe(event, &queued_events, link) {
+		list_for_each_safe(event, queued_events, link) {
 			struct list next = LIST_INIT(next);
 
 			if (evdev_frame_get_time(event->frame) == 0)
 				evdev_frame_set_time(event->frame, frame_time);
 
-			if (!bitmask_bit_is_set(device->plugin_frame_callbacks,
-					       plugin->index)) {
+			if (usage_mask != EVDEV_USAGE_MASK_ALL &&
+			    (evdev_frame_get_usage_mask(event->frame) & usage_mask) == 0) {
+				if (plugin_stats_enabled(plugin))
+					plugin_note_stat(plugin,
+							 event->device,
+							 LIBINPUT_PLUGIN_STAT_FRAMES_SKIPPED,
+							 1);
 				list_remove(&event->link);
 				list_append(&next_events, &event->link);
 				continue;
 			}
+
 #ifdef EVENT_DEBUGGING
 			_autofree_ char *prefix = strdup_printf("plugin %-25s - %s:",
 								plugin->name,
@@ -631,11 +758,11 @@ plugin_system_notify_evdev_frame(struct libinput_plugin_system *system,
 			list_chain(&next_events, &next);
 			plugin_queued_event_destroy(event);
 		}
-		assert(list_empty(&queued_events));
-		list_chain(&queued_events, &next_events);
-		if (list_empty(&queued_events)) {
+		assert(list_empty(queued_events));
+		list_chain(queued_events, &next_events);
+		if (list_empty(queued_events)) {
 #ifdef EVENT_DEBUGGING
-			if (list_last_entry_by_type(&system->plugins, struct libinput_plugin, link) != plugin) {
+			if (i < nplugins - 1) {
 				log_debug(libinput_device_get_context(device),
 					  "%s: --- empty frame queue - end of events ---\n",
 					  plugin->name);
@@ -645,12 +772,131 @@ plugin_system_notify_evdev_frame(struct libinput_plugin_system *system,
 			break;
 		}
 	}
+}
+
+static void
+plugin_system_notify_evdev_frame(struct libinput_plugin_system *system,
+				 struct libinput_device *device,
+				 struct evdev_frame *frame,
+				 struct libinput_plugin *sender_plugin)
+{
+	/* This is messy because a single event frame may cause
+	 * *each* plugin to generate multiple event frames for potentially
+	 * different devices and replaying is basically breadth-first traversal.
+	 *
+	 * In the common case each plugin only modifies or discards our
+	 * frame, so we pass the frame straight through the device's plugin
+	 * chain. Once a plugin creates new frames we create a queue
+	 * and each subsequent plugin then creates a new event list from each
+	 * frame in the queue.
+	 */
+	if (device->plugin_chain.generation != system->generation)
+		plugin_system_compile_chain(system, device);
+
+	/* Our own copy, a plugin (or a timer it triggers) may change
+	 * the device's chain while we're iterating */
+	struct libinput_plugin *plugins[ARRAY_LENGTH(device->plugin_chain.plugins)];
+	uint64_t usage_masks[ARRAY_LENGTH(device->plugin_chain.usage_masks)];
+	size_t nplugins = device->plugin_chain.count;
+	memcpy(plugins, device->plugin_chain.plugins, nplugins * sizeof(*plugins));
+	memcpy(usage_masks, device->plugin_chain.usage_masks, nplugins * sizeof(*usage_masks));
+
+	uint64_t frame_time = evdev_frame_get_time(frame);
+	size_t idx = 0;
+
+	/* The usages in our frame, only calculated where a plugin
+	 * filters and recalculated once a plugin had access to the frame */
+	uint64_t frame_usages = 0;
+	bool frame_usages_valid = false;
+
+	/* We start processing *after* the sender plugin. sender_plugin
+	 * is only set if we're queuing (not injecting) events from
+	 * a plugin timer func
+	 */
+	if (sender_plugin) {
+		while (idx < nplugins && plugins[idx]->index <= sender_plugin->index)
+			idx++;
+	}
+
+	for (; idx < nplugins; idx++) {
+		struct libinput_plugin *plugin = plugins[idx];
+
+		if (!plugin->registered)
+			continue;
+
+		if (usage_masks[idx] != EVDEV_USAGE_MASK_ALL) {
+			if (!frame_usages_valid) {
+				frame_usages = evdev_frame_get_usage_mask(frame);
+				frame_usages_valid = true;
+			}
+			if ((frame_usages & usage_masks[idx]) == 0) {
+				if (plugin_stats_enabled(plugin))
+					plugin_note_stat(plugin,
+							 device,
+							 LIBINPUT_PLUGIN_STAT_FRAMES_SKIPPED,
+							 1);
+				continue;
+			}
+		}
+
+		frame_usages_valid = false;
+
+#ifdef EVENT_DEBUGGING
+		_autofree_ char *prefix = strdup_printf("plugin %-25s - %s:",
+							plugin->name,
+							libinput_device_get_name(device));
+		print_frame(libinput_device_get_context(device), frame, prefix);
+#endif
+
+		struct list before_events = LIST_INIT(before_events);
+		struct list after_events = LIST_INIT(after_events);
+		libinput_plugin_call_evdev_frame(plugin,
+						 device,
+						 frame,
+						 &before_events,
+						 &after_events);
+
+		if (list_empty(&before_events) && list_empty(&after_events)) {
+			if (evdev_frame_is_empty(frame))
+				break;
+			continue;
+		}
+
+		/* The plugin created new frames, switch to the queue */
+		struct list queued_events = LIST_INIT(queued_events);
+		list_chain(&queued_events, &before_events);
+		if (!evdev_frame_is_empty(frame)) {
+			struct plugin_queued_event *event = plugin_queued_event_new(frame, device);
+			list_take_append(&queued_events, event, link);
+		}
+		list_chain(&queued_events, &after_events);
+
+		plugin_system_process_queued_events(system,
+						    device,
+						    &plugins[idx + 1],
+						    &usage_masks[idx + 1],
+						    nplugins - idx - 1,
+						    &queued_events,
+						    frame_time);
+
+		/* Our own evdev plugin is last and discards the event for us */
+		if (!list_empty(&queued_events)) {
+			log_bug_libinput(libinput_device_get_context(device),
+					 "Events left over to replay after last plugin\n");
+			struct plugin_queued_event *event;
+			list_for_each_safe(event, &queued_events, link)
+				plugin_queued_event_destroy(event);
+		}
+		goto out;
+	}
 
 	/* Our own evdev plugin is last and discards the event for us */
-	if (!list_empty(&queued_events)) {
+	if (!evdev_frame_is_empty(frame)) {
 		log_bug_libinput(libinput_device_get_context(device),
 				 "Events left over to replay after last plugin\n");
 	}
+
+out:
 	libinput_plugin_system_drop_unregistered_plugins(system);
 }
 
@@ -659,9 +905,45 @@ libinput_plugin_system_notify_evdev_frame(struct libinput_plugin_system *system,
 					  struct libinput_device *device,
 					  struct evdev_frame *frame)
 {
+	/* The raw frame, before any plugin had a chance to modify it */
+	if (device->flight_recorder)
+		flight_recorder_note_frame(device->flight_recorder, frame);
+
 	plugin_system_notify_evdev_frame(system, device, frame, NULL);
 }
 
+void
+libinput_plugin_system_reset_stats(struct libinput_plugin_system *system)
+{
+	struct libinput_plugin *plugin;
+
+	list_for_each(plugin, &system->plugins, link)
+		memset(&plugin->profile, 0, sizeof(plugin->profile));
+}
+
+void
+libinput_plugin_system_get_stats(struct libinput_plugin_system *system,
+				 struct libinput_device *device,
+				 struct libinput_plugin_stats *stats)
+{
+	struct libinput_plugin *plugin;
+
+	list_for_each(plugin, &system->plugins, link) {
+		if (!plugin->registered ||
+		    stats->nplugins >= ARRAY_LENGTH(stats->plugins))
+			continue;
+
+		size_t idx = stats->nplugins++;
+		stats->plugins[idx].name = safe_strdup(plugin->name);
+
+		if (!device)
+			stats->plugins[idx].profile = plugin->profile;
+		else if (device->plugin_profile &&
+			 plugin->index < ARRAY_LENGTH(device->plugin_usage_masks))
+			stats->plugins[idx].profile = device->plugin_profile[plugin->index];
+	}
+}
+
 static void
 plugin_timer_func(uint64_t now, void *data)
 {
@@ -675,12 +957,29 @@ plugin_timer_func(uint64_t now, void *data)
 	struct list before_events = LIST_INIT(before_events);
 	struct list after_events = LIST_INIT(after_events);
 
+	bool profile = plugin_stats_enabled(plugin);
+	uint64_t start = 0;
+
+	if (profile)
+		now_in_ns(&start);
+
 	plugin->event_queue.before = &before_events;
 	plugin->event_queue.after = &after_events;
 	timer->func(plugin, now, timer->user_data);
 	plugin->event_queue.before = NULL;
 	plugin->event_queue.after = NULL;
 
+	/* Timers aren't tied to a device, so these only show up in the
+	 * plugin's totals. The frames the timer queued are counted for
+	 * their device. */
+	if (profile) {
+		uint64_t end = 0;
+
+		now_in_ns(&end);
+		plugin_note_stat(plugin, NULL, LIBINPUT_PLUGIN_STAT_TIMER_FIRINGS, 1);
+		plugin_note_stat(plugin, NULL, LIBINPUT_PLUGIN_STAT_TIME_NSEC, end - start);
+	}
+
 	list_chain(&before_events, &after_events);
 
 	struct plugin_queued_event *event;
@@ -159,6 +159,30 @@ libinput_plugin_enable_device_event_frame(struct libinput_plugin *plugin,
 					  struct libinput_device *device,
 					  bool enable);
 
+/**
+ * Returns the value of the udev property on this device or NULL. For
+ * devices without a udev device, see libinput_path_add_evdev_device(),
+ * the properties the device was created with are used instead.
+ */
+const char *
+libinput_plugin_get_device_property(struct libinput_plugin *plugin,
+				    struct libinput_device *device,
+				    const char *property);
+
+/**
+ * Like libinput_plugin_enable_device_event_frame() but the plugin's
+ * evdev_frame callback is skipped for frames that do not contain any
+ * of the usages in the usage mask, see evdev_usage_mask(). A usage mask
+ * of zero is equivalent to disabling event frames for this device.
+ *
+ * The usage mask is coarse, the plugin may still see frames that do
+ * not contain any of its usages and must handle those.
+ */
+void
+libinput_plugin_enable_device_event_frame_usages(struct libinput_plugin *plugin,
+						 struct libinput_device *device,
+						 uint64_t usage_mask);
+
 /**
  * Inject a new event frame from the given plugin. This
  * frame is treated as if it was just sent by the kernel's
@@ -0,0 +1,277 @@
+/*
+ * Copyright © 2025 Red Hat, Inc.
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a
+ * copy of this software and associated documentation files (the "Software"),
+ * to deal in the Software without restriction, including without limitation
+ * the rights to use, copy, modify, merge, publish, distribute, sublicense,
+ * and/or sell copies of the Software, and to permit persons to whom the
+ * Software is furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice (including the next
+ * paragraph) shall be included in all copies or substantial portions of the
+ * Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT.  IN NO EVENT SHALL
+ * THE AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING
+ * FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER
+ * DEALINGS IN THE SOFTWARE.
+ */
+
+/* Hooks for the in-tree tools and the test suite. None of these are part
+ * of the public API and none of them are exported by libinput.so, users
+ * must link against libinput-private.a (dep_libinput_private in meson)
+ * instead. There are no API or ABI guarantees, these may change at any
+ * time.
+ */
+
+#pragma once
+
+#include "libinput.h"
+
+struct histogram;
+struct libevdev;
+
+/**
+ * Add a device that has no device node to a libinput context initialized
+ * with libinput_path_create_context(). Instead of opening a device node,
+ * the device is described by a libevdev context and its events are read
+ * from the given file descriptor, usually the read end of a pipe. The
+ * caller writes struct input_event data to the other end, each frame
+ * terminated by a SYN_REPORT. The event timestamps are used as-is and
+ * should be in CLOCK_MONOTONIC.
+ *
+ * The libevdev context must be created with libevdev_new() and have the
+ * name, ids, event codes, absinfo and properties of the device set up.
+ * libinput takes ownership of the libevdev context, even when this
+ * function fails, and the caller must not use it afterwards. The file
+ * descriptor must be non-blocking, libinput does not change its flags.
+ * It is duplicated, the caller keeps ownership of the one passed in.
+ * The duplicate shares the file description with the caller's file
+ * descriptor, changing the flags of one changes them for both.
+ *
+ * The properties are a NULL-terminated list of "KEY=value" strings and
+ * are used in place of the udev properties, e.g. "ID_INPUT=1" and
+ * "ID_INPUT_TOUCHPAD=1". A device without the ID_INPUT property and one
+ * of the type properties is ignored. Where NAME or PRODUCT are not
+ * provided, they are filled in from the libevdev context so the device
+ * matches the same quirks as a device with that name and ids.
+ *
+ * Such a device has no udev device, libinput_device_get_udev_device()
+ * returns NULL. The device is removed on libinput_suspend() and not
+ * re-added on libinput_resume(), and libinput_device_set_seat_logical_name()
+ * fails. While the device is disabled through its send events mode, the
+ * events written to the fd are discarded. The device is otherwise handled
+ * like any other device and can be removed with
+ * libinput_path_remove_device().
+ *
+ * @param libinput A previously initialized libinput context
+ * @param evdev A libevdev context describing the device
+ * @param fd The file descriptor to read events from
+ * @param sysname The sysname of the device, e.g. "event0"
+ * @param properties A NULL-terminated list of KEY=value properties or NULL
+ * @return The newly initiated device on success, or NULL on failure.
+ */
+struct libinput_device *
+libinput_path_add_evdev_device(struct libinput *libinput,
+			       struct libevdev *evdev,
+			       int fd,
+			       const char *sysname,
+			       const char **properties);
+
+/**
+ * Use the given file as the quirks override file of this context, in
+ * place of the system-wide override file. The device quirks shipped with
+ * libinput are still loaded, the entries in the override file take
+ * precedence over them.
+ *
+ * The quirks are loaded when the first device is added, this function
+ * must be called before that.
+ *
+ * @param libinput A previously initialized libinput context
+ * @param path The path to the override file, or NULL to restore the
+ * default
+ * @return 0 on success, -EBUSY if the quirks have already been loaded or
+ * a negative errno if the file cannot be read
+ */
+int
+libinput_set_quirks_override_file(struct libinput *libinput,
+				  const char *path);
+
+/**
+ * The clock of a libinput context, see libinput_set_clock().
+ *
+ * @param libinput The libinput context
+ * @param user_data The user data passed to libinput_set_clock()
+ * @return The current time in microseconds
+ */
+typedef uint64_t (*libinput_clock_func)(struct libinput *libinput,
+					void *user_data);
+
+/**
+ * Replace the clock of this context with the given function. By default,
+ * libinput uses CLOCK_MONOTONIC, the clock of the kernel's event
+ * timestamps.
+ *
+ * With a custom clock, the internal timers (e.g. the tap timeout) no
+ * longer make the fd returned by libinput_get_fd() readable. A timer
+ * expires in the first call to libinput_dispatch() after the clock has
+ * passed its expiry time, or when an event with a later timestamp is
+ * processed. The caller lets time pass by advancing its clock and
+ * calling libinput_dispatch().
+ *
+ * The timestamps of the events read from the devices are not modified,
+ * the caller must ensure the events use the same time base as the clock,
+ * e.g. by writing the events itself to a device added with
+ * libinput_path_add_evdev_device().
+ *
+ * @param libinput A previously initialized libinput context
+ * @param func The function returning the current time, or NULL to
+ * restore the default clock
+ * @param user_data Passed to func
+ * @return 0 on success or -EBUSY if one of the timers of this context
+ * is currently running
+ */
+int
+libinput_set_clock(struct libinput *libinput,
+		   libinput_clock_func func,
+		   void *user_data);
+
+/**
+ * A snapshot of the debug statistics of a context or a device, see
+ * libinput_get_stats() and libinput_device_get_stats(). This struct is
+ * refcounted, use libinput_stats_unref().
+ */
+struct libinput_stats;
+
+/**
+ * The counters libinput keeps for each plugin while latency statistics
+ * are enabled, see libinput_set_latency_stats_enabled().
+ */
+enum libinput_plugin_stat {
+	/**
+	 * The number of evdev frames passed to the plugin. Frames a
+	 * plugin is not interested in are not passed to the plugin and
+	 * not counted.
+	 */
+	LIBINPUT_PLUGIN_STAT_FRAMES_IN = 1,
+	/**
+	 * The number of evdev frames passed on by the plugin, including
+	 * the frames it prepended or appended.
+	 */
+	LIBINPUT_PLUGIN_STAT_FRAMES_OUT,
+	/**
+	 * The number of evdev frames the plugin injected at the start of
+	 * the plugin chain.
+	 */
+	LIBINPUT_PLUGIN_STAT_FRAMES_INJECTED,
+	/**
+	 * The number of evdev frames the plugin queued before the current
+	 * frame.
+	 */
+	LIBINPUT_PLUGIN_STAT_FRAMES_PREPENDED,
+	/**
+	 * The number of evdev frames the plugin queued after the current
+	 * frame.
+	 */
+	LIBINPUT_PLUGIN_STAT_FRAMES_APPENDED,
+	/**
+	 * The number of times one of the plugin's timers fired. Timers
+	 * are not tied to a device, this value is always zero in a
+	 * snapshot returned by libinput_device_get_stats().
+	 */
+	LIBINPUT_PLUGIN_STAT_TIMER_FIRINGS,
+	/**
+	 * The cumulative time in ns spent in the plugin's frame and, in a
+	 * snapshot returned by libinput_get_stats() only, timer
+	 * callbacks.
+	 */
+	LIBINPUT_PLUGIN_STAT_TIME_NSEC,
+	/**
+	 * The number of evdev frames not passed to the plugin because
+	 * they had none of the usages the plugin subscribed to, see
+	 * libinput_plugin_enable_device_event_frame_usages().
+	 */
+	LIBINPUT_PLUGIN_STAT_FRAMES_SKIPPED,
+	/**
+	 * The number of prepended or appended evdev frames that share
+	 * their events with the frame they were copied from rather than
+	 * copying them.
+	 */
+	LIBINPUT_PLUGIN_STAT_FRAMES_SHARED,
+};
+
+/**
+ * Return a snapshot of the statistics of this context. The plugin
+ * counters and the latency histograms are summed up across all devices,
+ * the latter only for the devices currently present.
+ *
+ * @param libinput A previously initialized libinput context
+ * @return A new snapshot of the statistics. The caller must call
+ * libinput_stats_unref() on the returned object.
+ */
+struct libinput_stats *
+libinput_get_stats(struct libinput *libinput);
+
+/**
+ * Return a snapshot of the statistics of this device.
+ *
+ * @param device A current input device
+ * @return A new snapshot of the statistics. The caller must call
+ * libinput_stats_unref() on the returned object.
+ */
+struct libinput_stats *
+libinput_device_get_stats(struct libinput_device *device);
+
+/**
+ * Decrease the refcount of the statistics snapshot. Once the refcount
+ * reaches zero, the snapshot is freed.
+ *
+ * @param stats A statistics snapshot
+ * @return Always NULL
+ */
+struct libinput_stats *
+libinput_stats_unref(struct libinput_stats *stats);
+
+/**
+ * @param stats A statistics snapshot
+ * @param which The latency measurement to return
+ * @return The latency histogram, see util-histogram.h, or NULL if the
+ * measurement is invalid. The histogram is owned by the snapshot.
+ */
+const struct histogram *
+libinput_stats_get_latency(struct libinput_stats *stats,
+			   enum libinput_latency_stat which);
+
+/**
+ * @param stats A statistics snapshot
+ * @return The number of plugins in this snapshot. Plugins are listed in
+ * the order they process frames.
+ */
+unsigned int
+libinput_stats_get_num_plugins(struct libinput_stats *stats);
+
+/**
+ * @param stats A statistics snapshot
+ * @param index The plugin index, starting at 0
+ * @return The name of the plugin or NULL if the index is invalid. The
+ * string is owned by the snapshot.
+ */
+const char *
+libinput_stats_get_plugin_name(struct libinput_stats *stats,
+			       unsigned int index);
+
+/**
+ * @param stats A statistics snapshot
+ * @param index The plugin index, starting at 0
+ * @param which The counter to return
+ * @return The value of the counter or 0 if the index or counter is
+ * invalid
+ */
+uint64_t
+libinput_stats_get_plugin_value(struct libinput_stats *stats,
+				unsigned int index,
+				enum libinput_plugin_stat which);
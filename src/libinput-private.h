@@ -40,9 +40,11 @@
 #include "libinput.h"
 #include "libinput-log.h"
 #include "libinput-plugin-system.h"
+#include "libinput-private-api.h"
 #include "libinput-private-config.h"
 #include "libinput-util.h"
 #include "libinput-version.h"
+#include "util-histogram.h"
 #include "util-newtype.h"
 
 struct libinput_source;
@@ -183,6 +185,9 @@ struct libinput_interface_backend {
 				  const char *seat_name);
 };
 
+#define LIBINPUT_TOOL_HASH_BITS 6
+#define LIBINPUT_TOOL_HASH_SIZE (1 << LIBINPUT_TOOL_HASH_BITS)
+
 struct libinput {
 	int epoll_fd;
 	struct list source_destroy_list;
@@ -198,13 +203,20 @@ struct libinput {
 		struct ratelimit expiry_in_past_limit;
 	} timer;
 
+	struct {
+		libinput_clock_func func; /* NULL for CLOCK_MONOTONIC */
+		void *user_data;
+	} clock;
+
 	struct libinput_event **events;
 	size_t events_count;
 	size_t events_len;
 	size_t events_in;
 	size_t events_out;
 
-	struct list tool_list;
+	/* Tablet tools with a serial number and totems, hashed by type
+	 * and serial, see libinput_add_tool() */
+	struct list tool_hash[LIBINPUT_TOOL_HASH_SIZE];
 
 	const struct libinput_interface *interface;
 	const struct libinput_interface_backend *interface_backend;
@@ -221,9 +233,14 @@ struct libinput {
 
 	bool quirks_initialized;
 	struct quirks_context *quirks;
+	char *quirks_override_file;	/* NULL for the default */
 
 	struct libinput_plugin_system plugin_system;
 
+	/* Latency and plugin statistics, see
+	 * libinput_set_latency_stats_enabled() */
+	bool stats_enabled;
+
 #if HAVE_LIBWACOM
 	struct {
 		WacomDeviceDatabase *db;
@@ -497,6 +514,35 @@ struct libinput_device {
 
 	bitmask_t plugin_frame_callbacks;
 
+	/* Indexed by plugin index, see
+	 * libinput_plugin_enable_device_event_frame_usages() */
+	uint64_t plugin_usage_masks[32];
+
+	/* The plugins with plugin_frame_callbacks set, in plugin order.
+	 * Compiled by the plugin system, valid if the generation
+	 * matches the plugin system's generation. */
+	struct {
+		uint64_t generation;
+		size_t count;
+		struct libinput_plugin *plugins[32];
+		uint64_t usage_masks[32];
+	} plugin_chain;
+
+	/* Indexed by plugin index, allocated on demand once stats
+	 * are enabled, see libinput_set_latency_stats_enabled() */
+	struct libinput_plugin_profile *plugin_profile;
+
+	/* Allocated while the flight recorder is enabled, see
+	 * libinput_set_flight_recorder() */
+	struct flight_recorder *flight_recorder;
+
+	/* Only updated while stats are enabled */
+	struct {
+		/* µs spent in the dispatch interface for the current frame */
+		uint64_t interface_time;
+		struct histogram stats[LIBINPUT_LATENCY_STAT_INTERFACE];
+	} latency;
+
 	void (*inject_evdev_frame)(struct libinput_device *device,
 				   struct evdev_frame *frame);
 };
@@ -660,6 +706,15 @@ void
 libinput_remove_source(struct libinput *libinput,
 		       struct libinput_source *source);
 
+void
+libinput_add_tool(struct libinput *libinput,
+		  struct libinput_tablet_tool *tool);
+
+struct libinput_tablet_tool *
+libinput_find_tool(struct libinput *libinput,
+		   enum libinput_tablet_tool_type type,
+		   uint32_t serial);
+
 int
 open_restricted(struct libinput *libinput,
 		const char *path, int flags);
@@ -677,6 +732,11 @@ libinput_seat_init(struct libinput_seat *seat,
 		   const char *logical_name,
 		   libinput_seat_destroy_func destroy);
 
+void
+libinput_device_note_latency(struct libinput_device *device,
+			     enum libinput_latency_stat which,
+			     uint64_t usec);
+
 void
 libinput_device_init(struct libinput_device *device,
 		     struct libinput_seat *seat);
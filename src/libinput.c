@@ -41,6 +41,9 @@
 #include "evdev.h"
 #include "timer.h"
 #include "quirks.h"
+#include "libinput-flight-recorder.h"
+#include "libinput-plugin.h"
+#include "libinput-private-api.h"
 
 #define require_event_type(li_, type_, retval_, ...)	\
 	if (type_ == LIBINPUT_EVENT_NONE) abort(); \
@@ -1765,6 +1768,41 @@ libinput_tablet_tool_unref(struct libinput_tablet_tool *tool)
 	return NULL;
 }
 
+static inline struct list *
+libinput_tool_bucket(struct libinput *libinput,
+		     enum libinput_tablet_tool_type type,
+		     uint32_t serial)
+{
+	/* Serial numbers are often sequential, the multiplication with
+	 * 2^32/phi spreads them across the buckets */
+	uint32_t hash = (serial ^ ((uint32_t)type << 24)) * 0x9e3779b1U;
+
+	return &libinput->tool_hash[hash >> (32 - LIBINPUT_TOOL_HASH_BITS)];
+}
+
+void
+libinput_add_tool(struct libinput *libinput,
+		  struct libinput_tablet_tool *tool)
+{
+	list_insert(libinput_tool_bucket(libinput, tool->type, tool->serial),
+		    &tool->link);
+}
+
+struct libinput_tablet_tool *
+libinput_find_tool(struct libinput *libinput,
+		   enum libinput_tablet_tool_type type,
+		   uint32_t serial)
+{
+	struct libinput_tablet_tool *tool;
+
+	list_for_each(tool, libinput_tool_bucket(libinput, type, serial), link) {
+		if (tool->type == type && tool->serial == serial)
+			return tool;
+	}
+
+	return NULL;
+}
+
 LIBINPUT_EXPORT struct libinput_event *
 libinput_event_switch_get_base_event(struct libinput_event_switch *event)
 {
@@ -1879,7 +1917,8 @@ libinput_init(struct libinput *libinput,
 	list_init(&libinput->source_destroy_list);
 	list_init(&libinput->seat_list);
 	list_init(&libinput->device_group_list);
-	list_init(&libinput->tool_list);
+	ARRAY_FOR_EACH(libinput->tool_hash, bucket)
+		list_init(bucket);
 
 	libinput_plugin_system_init(&libinput->plugin_system);
 
@@ -1911,6 +1950,9 @@ libinput_init_quirks(struct libinput *libinput)
 		override_file = LIBINPUT_QUIRKS_OVERRIDE_FILE;
 	}
 
+	if (libinput->quirks_override_file)
+		override_file = libinput->quirks_override_file;
+
 	quirks = quirks_init_subsystem(data_path,
 				       override_file,
 				       log_msg_va,
@@ -1932,6 +1974,37 @@ libinput_init_quirks(struct libinput *libinput)
 	libinput->quirks = quirks;
 }
 
+int
+libinput_set_quirks_override_file(struct libinput *libinput,
+				  const char *path)
+{
+	if (libinput->quirks_initialized)
+		return -EBUSY;
+
+	if (path && access(path, R_OK) != 0)
+		return -errno;
+
+	free(libinput->quirks_override_file);
+	libinput->quirks_override_file = path ? safe_strdup(path) : NULL;
+
+	return 0;
+}
+
+int
+libinput_set_clock(struct libinput *libinput,
+		   libinput_clock_func func,
+		   void *user_data)
+{
+	/* The pending timers were set in the time base of the old clock */
+	if (!list_empty(&libinput->timer.list))
+		return -EBUSY;
+
+	libinput->clock.func = func;
+	libinput->clock.user_data = func ? user_data : NULL;
+
+	return 0;
+}
+
 static void
 libinput_device_destroy(struct libinput_device *device);
 
@@ -1981,8 +2054,9 @@ libinput_unref(struct libinput *libinput)
 
 	free(libinput->events);
 
-	list_for_each_safe(tool, &libinput->tool_list, link) {
-		libinput_tablet_tool_unref(tool);
+	ARRAY_FOR_EACH(libinput->tool_hash, bucket) {
+		list_for_each_safe(tool, bucket, link)
+			libinput_tablet_tool_unref(tool);
 	}
 
 	libinput_plugin_system_destroy(&libinput->plugin_system);
@@ -2005,6 +2079,7 @@ libinput_unref(struct libinput *libinput)
 	libinput_timer_subsys_destroy(libinput);
 	libinput_drop_destroyed_sources(libinput);
 	quirks_context_unref(libinput->quirks);
+	free(libinput->quirks_override_file);
 	close(libinput->epoll_fd);
 	free(libinput);
 
@@ -2015,12 +2090,25 @@ struct quirks *
 libinput_device_get_quirks(struct libinput_device *device)
 {
 	struct libinput *libinput = libinput_device_get_context(device);
+	struct evdev_device *evdev = evdev_device(device);
 	_unref_(udev_device) *udev_device = libinput_device_get_udev_device(device);
 	if (udev_device)
 		return quirks_fetch_for_device(libinput->quirks, udev_device);
+	if (evdev->properties)
+		return quirks_fetch_for_properties(libinput->quirks,
+						   evdev->sysname,
+						   evdev->properties);
 	return NULL;
 }
 
+const char *
+libinput_plugin_get_device_property(struct libinput_plugin *plugin,
+				    struct libinput_device *device,
+				    const char *property)
+{
+	return evdev_device_get_property(evdev_device(device), property);
+}
+
 static void
 libinput_event_tablet_tool_destroy(struct libinput_event_tablet_tool *event)
 {
@@ -2186,6 +2274,8 @@ static void
 libinput_device_destroy(struct libinput_device *device)
 {
 	assert(list_empty(&device->event_listeners));
+	free(device->plugin_profile);
+	flight_recorder_destroy(device->flight_recorder);
 	evdev_device_destroy(evdev_device(device));
 }
 
@@ -2236,6 +2326,11 @@ libinput_dispatch(struct libinput *libinput)
 		source->dispatch(source->user_data);
 	}
 
+	/* A custom clock doesn't wake up the timerfd, any timer that
+	 * expired since the last call is handled here */
+	if (libinput->clock.func)
+		libinput_timer_flush(libinput, libinput_now(libinput));
+
 	libinput_drop_destroyed_sources(libinput);
 
 	return 0;
@@ -2352,6 +2447,11 @@ post_device_event(struct libinput_device *device,
 
 	init_event_base(event, device, type);
 
+	if (device->flight_recorder)
+		flight_recorder_note_event(device->flight_recorder,
+					   time,
+					   event_type_to_str(type));
+
 	list_for_each_safe(listener, &device->event_listeners, link)
 		listener->notify_func(time, event, listener->notify_func_data);
 
@@ -3987,6 +4087,283 @@ libinput_device_group_get_user_data(struct libinput_device_group *group)
 	return group->user_data;
 }
 
+struct libinput_stats {
+	int refcount;
+	struct histogram latency[LIBINPUT_LATENCY_STAT_INTERFACE];
+	struct libinput_plugin_stats plugins;
+};
+
+void
+libinput_device_note_latency(struct libinput_device *device,
+			     enum libinput_latency_stat which,
+			     uint64_t usec)
+{
+	histogram_add(&device->latency.stats[which - 1], usec);
+}
+
+LIBINPUT_EXPORT void
+libinput_set_latency_stats_enabled(struct libinput *libinput, int enabled)
+{
+	if (enabled && !libinput->stats_enabled) {
+		struct libinput_seat *seat;
+		struct libinput_device *device;
+
+		list_for_each(seat, &libinput->seat_list, link) {
+			list_for_each(device, &seat->devices_list, link) {
+				ARRAY_FOR_EACH(device->latency.stats, h)
+					histogram_reset(h);
+				free(device->plugin_profile);
+				device->plugin_profile = NULL;
+			}
+		}
+
+		libinput_plugin_system_reset_stats(&libinput->plugin_system);
+	}
+
+	libinput->stats_enabled = !!enabled;
+}
+
+static inline const struct histogram *
+libinput_device_get_latency_histogram(struct libinput_device *device,
+				      enum libinput_latency_stat which)
+{
+	switch (which) {
+	case LIBINPUT_LATENCY_STAT_DISPATCH:
+	case LIBINPUT_LATENCY_STAT_POST:
+	case LIBINPUT_LATENCY_STAT_PLUGINS:
+	case LIBINPUT_LATENCY_STAT_INTERFACE:
+		break;
+	default:
+		return NULL;
+	}
+
+	return &device->latency.stats[which - 1];
+}
+
+LIBINPUT_EXPORT uint64_t
+libinput_device_get_latency_stats_count(struct libinput_device *device,
+					enum libinput_latency_stat which)
+{
+	const struct histogram *h =
+		libinput_device_get_latency_histogram(device, which);
+
+	if (!h) {
+		log_bug_client(libinput_device_get_context(device),
+			       "Invalid latency measurement %d\n",
+			       which);
+		return 0;
+	}
+
+	return h->count;
+}
+
+LIBINPUT_EXPORT uint64_t
+libinput_device_get_latency_stats_percentile(struct libinput_device *device,
+					     enum libinput_latency_stat which,
+					     double percentile)
+{
+	const struct histogram *h =
+		libinput_device_get_latency_histogram(device, which);
+
+	if (!h || !(percentile >= 0.0 && percentile <= 100.0)) {
+		log_bug_client(libinput_device_get_context(device),
+			       "Invalid latency measurement %d or percentile %f\n",
+			       which,
+			       percentile);
+		return 0;
+	}
+
+	return histogram_percentile(h, percentile);
+}
+
+struct libinput_stats *
+libinput_get_stats(struct libinput *libinput)
+{
+	struct libinput_stats *stats = zalloc(sizeof *stats);
+	struct libinput_seat *seat;
+	struct libinput_device *device;
+
+	stats->refcount = 1;
+
+	list_for_each(seat, &libinput->seat_list, link) {
+		list_for_each(device, &seat->devices_list, link) {
+			for (size_t i = 0; i < ARRAY_LENGTH(stats->latency); i++)
+				histogram_merge(&stats->latency[i],
+						&device->latency.stats[i]);
+		}
+	}
+
+	libinput_plugin_system_get_stats(&libinput->plugin_system,
+					 NULL,
+					 &stats->plugins);
+
+	return stats;
+}
+
+struct libinput_stats *
+libinput_device_get_stats(struct libinput_device *device)
+{
+	struct libinput *libinput = libinput_device_get_context(device);
+	struct libinput_stats *stats = zalloc(sizeof *stats);
+
+	stats->refcount = 1;
+	static_assert(sizeof(stats->latency) == sizeof(device->latency.stats),
+		      "latency histogram count mismatch");
+	memcpy(stats->latency, device->latency.stats, sizeof(stats->latency));
+
+	libinput_plugin_system_get_stats(&libinput->plugin_system,
+					 device,
+					 &stats->plugins);
+
+	return stats;
+}
+
+struct libinput_stats *
+libinput_stats_unref(struct libinput_stats *stats)
+{
+	if (!stats)
+		return NULL;
+
+	assert(stats->refcount > 0);
+	stats->refcount--;
+	if (stats->refcount == 0) {
+		for (size_t i = 0; i < stats->plugins.nplugins; i++)
+			free(stats->plugins.plugins[i].name);
+		free(stats);
+	}
+
+	return NULL;
+}
+
+const struct histogram *
+libinput_stats_get_latency(struct libinput_stats *stats,
+			   enum libinput_latency_stat which)
+{
+	switch (which) {
+	case LIBINPUT_LATENCY_STAT_DISPATCH:
+	case LIBINPUT_LATENCY_STAT_POST:
+	case LIBINPUT_LATENCY_STAT_PLUGINS:
+	case LIBINPUT_LATENCY_STAT_INTERFACE:
+		break;
+	default:
+		return NULL;
+	}
+
+	return &stats->latency[which - 1];
+}
+
+unsigned int
+libinput_stats_get_num_plugins(struct libinput_stats *stats)
+{
+	return stats->plugins.nplugins;
+}
+
+const char *
+libinput_stats_get_plugin_name(struct libinput_stats *stats,
+			       unsigned int index)
+{
+	if (index >= stats->plugins.nplugins)
+		return NULL;
+
+	return stats->plugins.plugins[index].name;
+}
+
+uint64_t
+libinput_stats_get_plugin_value(struct libinput_stats *stats,
+				unsigned int index,
+				enum libinput_plugin_stat which)
+{
+	if (index >= stats->plugins.nplugins ||
+	    which < LIBINPUT_PLUGIN_STAT_FRAMES_IN ||
+	    which > LIBINPUT_PLUGIN_STAT_FRAMES_SHARED)
+		return 0;
+
+	return stats->plugins.plugins[index].profile.values[which - 1];
+}
+
+LIBINPUT_EXPORT void
+libinput_set_flight_recorder(struct libinput *libinput,
+			     unsigned int seconds)
+{
+	struct libinput_seat *seat;
+	struct libinput_device *device;
+
+	seconds = min(seconds, FLIGHT_RECORDER_MAX_SECONDS);
+	libinput->plugin_system.flight_recorder_seconds = seconds;
+
+	list_for_each(seat, &libinput->seat_list, link) {
+		list_for_each(device, &seat->devices_list, link) {
+			flight_recorder_destroy(device->flight_recorder);
+			device->flight_recorder = seconds ? flight_recorder_new(seconds) : NULL;
+		}
+	}
+}
+
+LIBINPUT_EXPORT int
+libinput_flight_recorder_dump(struct libinput *libinput, int fd)
+{
+	struct libinput_seat *seat;
+	struct libinput_device *device;
+	unsigned int seconds = libinput->plugin_system.flight_recorder_seconds;
+	uint64_t now = libinput_now(libinput);
+	uint64_t since, offset = UINT64_MAX;
+	size_t ndevices = 0;
+	int rc = 0;
+
+	if (seconds == 0)
+		return -EINVAL;
+
+	since = now > s2us(seconds) ? now - s2us(seconds) : 0;
+
+	list_for_each(seat, &libinput->seat_list, link) {
+		list_for_each(device, &seat->devices_list, link) {
+			if (!device->flight_recorder)
+				continue;
+
+			uint64_t first = flight_recorder_get_first_time(device->flight_recorder,
+									since);
+			if (first)
+				offset = min(offset, first);
+			ndevices++;
+		}
+	}
+
+	if (offset == UINT64_MAX)
+		offset = since;
+
+	int dupfd = dup(fd);
+	if (dupfd < 0)
+		return -errno;
+
+	FILE *fp = fdopen(dupfd, "w");
+	if (!fp) {
+		rc = -errno;
+		close(dupfd);
+		return rc;
+	}
+
+	flight_recorder_print_header(fp, ndevices);
+	list_for_each(seat, &libinput->seat_list, link) {
+		list_for_each(device, &seat->devices_list, link) {
+			if (!device->flight_recorder)
+				continue;
+
+			flight_recorder_print_device(device->flight_recorder,
+						     fp,
+						     device,
+						     since,
+						     offset);
+		}
+	}
+
+	if (ferror(fp))
+		rc = -EIO;
+	if (fclose(fp) != 0 && rc == 0)
+		rc = -errno;
+
+	return rc;
+}
+
 LIBINPUT_EXPORT const char *
 libinput_config_status_to_str(enum libinput_config_status status)
 {
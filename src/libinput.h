@@ -4592,6 +4592,157 @@ libinput_device_group_set_user_data(struct libinput_device_group *group,
 void *
 libinput_device_group_get_user_data(struct libinput_device_group *group);
 
+/**
+ * @ingroup base
+ *
+ * Enable or disable the flight recorder for this context. While enabled,
+ * libinput keeps the most recent evdev frames of each device as they
+ * were read from the kernel, together with the types of the events
+ * libinput generated for that device. Use libinput_flight_recorder_dump()
+ * to write the recorded data, e.g. after the user reported a bug.
+ *
+ * The recorder uses a fixed-size buffer per device that is allocated
+ * when the recorder is enabled or the device is added, the buffer size
+ * is based on the number of seconds. A device with a high event rate
+ * may overwrite its data sooner than the given number of seconds.
+ *
+ * The flight recorder is disabled by default. Enabling the flight
+ * recorder or changing the number of seconds discards all previously
+ * recorded data.
+ *
+ * @param libinput A previously initialized libinput context
+ * @param seconds The number of seconds to keep, or 0 to disable the
+ * flight recorder. Values larger than 60 are clamped to 60.
+ *
+ * @see libinput_flight_recorder_dump
+ *
+ * @since 1.29
+ */
+void
+libinput_set_flight_recorder(struct libinput *libinput,
+			     unsigned int seconds);
+
+/**
+ * @ingroup base
+ *
+ * Write the data recorded by the flight recorder to the given file
+ * descriptor, in the format used by the libinput record tool. The output
+ * can be replayed with libinput replay. Timestamps are relative to the
+ * oldest frame written, frames older than the configured number of
+ * seconds are not written.
+ *
+ * The file descriptor is not closed by libinput.
+ *
+ * @param libinput A previously initialized libinput context
+ * @param fd A file descriptor open for writing
+ *
+ * @return 0 on success, -EINVAL if the flight recorder is disabled or a
+ * negative errno if writing failed
+ *
+ * @see libinput_set_flight_recorder
+ *
+ * @since 1.29
+ */
+int
+libinput_flight_recorder_dump(struct libinput *libinput, int fd);
+
+/**
+ * @ingroup base
+ *
+ * The latency measurements libinput keeps for each device while latency
+ * statistics are enabled, see libinput_set_latency_stats_enabled(). All
+ * values are in µs.
+ *
+ * @since 1.29
+ */
+enum libinput_latency_stat {
+	/**
+	 * The time between the kernel timestamp of an evdev frame and the
+	 * time libinput starts processing it.
+	 */
+	LIBINPUT_LATENCY_STAT_DISPATCH = 1,
+	/**
+	 * The time between the kernel timestamp of an evdev frame and the
+	 * time libinput has finished processing it, i.e. all events
+	 * resulting from that frame have been queued for the caller.
+	 */
+	LIBINPUT_LATENCY_STAT_POST,
+	/**
+	 * The time spent in libinput's internal filters for an evdev
+	 * frame, excluding the time spent in the device's own event
+	 * processing.
+	 */
+	LIBINPUT_LATENCY_STAT_PLUGINS,
+	/**
+	 * The time spent in the device's own event processing for an
+	 * evdev frame.
+	 */
+	LIBINPUT_LATENCY_STAT_INTERFACE,
+};
+
+/**
+ * @ingroup base
+ *
+ * Enable or disable the collection of latency statistics for all devices
+ * of this context. Latency statistics are disabled by default, enabling
+ * them discards all previously collected data. Disabling them keeps the
+ * data collected so far.
+ *
+ * Collecting statistics adds a few clock lookups for each evdev frame.
+ *
+ * @param libinput A previously initialized libinput context
+ * @param enabled Non-zero to enable, zero to disable
+ *
+ * @see libinput_device_get_latency_stats_count
+ * @see libinput_device_get_latency_stats_percentile
+ *
+ * @since 1.29
+ */
+void
+libinput_set_latency_stats_enabled(struct libinput *libinput, int enabled);
+
+/**
+ * @ingroup device
+ *
+ * @param device A current input device
+ * @param which The latency measurement to query
+ *
+ * @return The number of evdev frames measured for this device, or 0 if
+ * the measurement is invalid
+ *
+ * @see libinput_set_latency_stats_enabled
+ *
+ * @since 1.29
+ */
+uint64_t
+libinput_device_get_latency_stats_count(struct libinput_device *device,
+					enum libinput_latency_stat which);
+
+/**
+ * @ingroup device
+ *
+ * Return an estimate of the given percentile of the latency measured for
+ * this device. libinput does not keep every single value, the returned
+ * value is an upper limit with a resolution of a power of two, clipped to
+ * the largest value measured. A percentile of 100 returns the largest
+ * value measured.
+ *
+ * @param device A current input device
+ * @param which The latency measurement to query
+ * @param percentile The percentile in the range 0.0 to 100.0
+ *
+ * @return The latency in µs, or 0 if nothing was measured or the
+ * measurement or percentile is invalid
+ *
+ * @see libinput_set_latency_stats_enabled
+ *
+ * @since 1.29
+ */
+uint64_t
+libinput_device_get_latency_stats_percentile(struct libinput_device *device,
+					     enum libinput_latency_stat which,
+					     double percentile);
+
 /**
  * @defgroup config Device configuration
  *
@@ -23,11 +23,13 @@
 
 #include "config.h"
 
+#include <fcntl.h>
 #include <string.h>
 #include <sys/stat.h>
 #include <libudev.h>
 
 #include "evdev.h"
+#include "libinput-private-api.h"
 
 struct path_input {
 	struct libinput base;
@@ -205,7 +207,7 @@ path_device_enable(struct path_input *input,
 	}
 
 	evdev_read_calibration_prop(device);
-	output_name = udev_device_get_property_value(udev_device, "WL_OUTPUT");
+	output_name = evdev_device_get_property(device, "WL_OUTPUT");
 	device->output_name = safe_strdup(output_name);
 
 out:
@@ -280,6 +282,11 @@ path_device_change_seat(struct libinput_device *device,
 	struct udev_device *udev_device = NULL;
 	int rc = -1;
 
+	/* Devices added with libinput_path_add_evdev_device() have
+	 * nothing we could re-create them from */
+	if (!evdev->udev_device)
+		return -1;
+
 	udev_device = evdev->udev_device;
 	udev_device_ref(udev_device);
 	libinput_path_remove_device(device);
@@ -397,6 +404,90 @@ libinput_path_add_device(struct libinput *libinput,
 	return device;
 }
 
+struct libinput_device *
+libinput_path_add_evdev_device(struct libinput *libinput,
+			       struct libevdev *evdev,
+			       int fd,
+			       const char *sysname,
+			       const char **properties)
+{
+	struct path_input *input = (struct path_input *)libinput;
+	struct path_seat *seat;
+	struct evdev_device *device;
+	const char *output_name;
+	int flags;
+
+	if (libinput->interface_backend != &interface_backend) {
+		log_bug_client(libinput, "Mismatching backends.\n");
+		libevdev_free(evdev);
+		return NULL;
+	}
+
+	if (!evdev || fd < 0 || !sysname) {
+		log_bug_client(libinput, "Invalid evdev device arguments\n");
+		libevdev_free(evdev);
+		return NULL;
+	}
+
+	/* We read until EAGAIN so the fd must be non-blocking. We can't
+	 * set O_NONBLOCK ourselves, our dup shares the file description
+	 * (and thus the flag) with the caller's fd */
+	flags = fcntl(fd, F_GETFL);
+	if (flags < 0 || !(flags & O_NONBLOCK)) {
+		log_bug_client(libinput,
+			       "%s: the fd must be a valid non-blocking fd\n",
+			       sysname);
+		libevdev_free(evdev);
+		return NULL;
+	}
+
+	/* The fd is ours from here on, whatever the caller does with
+	 * theirs */
+	fd = fcntl(fd, F_DUPFD_CLOEXEC, 0);
+	if (fd < 0) {
+		log_error(libinput,
+			  "%s: failed to duplicate the device fd (%s)\n",
+			  sysname,
+			  strerror(errno));
+		libevdev_free(evdev);
+		return NULL;
+	}
+
+	libinput_plugin_system_load_internal_plugins(libinput,
+						     &libinput->plugin_system);
+	libinput_init_quirks(libinput);
+
+	seat = path_seat_get_named(input, default_seat, default_seat_name);
+	if (!seat)
+		seat = path_seat_create(input, default_seat, default_seat_name);
+	libinput_seat_ref(&seat->base);
+
+	device = evdev_device_create_from_evdev(&seat->base,
+						evdev,
+						fd,
+						sysname,
+						properties);
+	libinput_seat_unref(&seat->base);
+
+	if (device == EVDEV_UNHANDLED_DEVICE) {
+		log_info(libinput,
+			 "%-7s - not using input device.\n",
+			 sysname);
+		return NULL;
+	} else if (device == NULL) {
+		log_info(libinput,
+			 "%-7s - failed to create input device.\n",
+			 sysname);
+		return NULL;
+	}
+
+	evdev_read_calibration_prop(device);
+	output_name = evdev_device_get_property(device, "WL_OUTPUT");
+	device->output_name = safe_strdup(output_name);
+
+	return &device->base;
+}
+
 LIBINPUT_EXPORT void
 libinput_path_remove_device(struct libinput_device *device)
 {
@@ -293,6 +293,8 @@ quirk_get_name(enum quirk q)
 	case QUIRK_ATTR_EVENT_CODE:			return "AttrEventCode";
 	case QUIRK_ATTR_INPUT_PROP:			return "AttrInputProp";
 	case QUIRK_ATTR_IS_VIRTUAL:			return "AttrIsVirtual";
+	case QUIRK_ATTR_KEY_REMAP:			return "AttrKeyRemap";
+	case QUIRK_ATTR_MAX_MOTION_EVENT_RATE:		return "AttrMaxMotionEventRate";
 	default:
 		abort();
 	}
@@ -837,7 +839,7 @@ parse_attr(struct quirks_context *ctx,
 		rc = true;
 	} else if (streq(key, quirk_get_name(QUIRK_ATTR_MSC_TIMESTAMP))) {
 		p->id = QUIRK_ATTR_MSC_TIMESTAMP;
-		if (!streq(value, "watch"))
+		if (!streq(value, "watch") && !streq(value, "use"))
 			goto out;
 		p->type = PT_STRING;
 		p->value.s = safe_strdup(value);
@@ -886,6 +888,32 @@ parse_attr(struct quirks_context *ctx,
 			goto out;
 		p->type = PT_BOOL;
 		p->value.b = b;
+		rc = true;
+	} else if (streq(key, quirk_get_name(QUIRK_ATTR_MAX_MOTION_EVENT_RATE))) {
+		p->id = QUIRK_ATTR_MAX_MOTION_EVENT_RATE;
+		if (!safe_atou(value, &v) || v == 0)
+			goto out;
+		p->type = PT_UINT;
+		p->value.u = v;
+		rc = true;
+	} else if (streq(key, quirk_get_name(QUIRK_ATTR_KEY_REMAP))) {
+		struct key_remap remaps[32];
+		size_t nremaps = ARRAY_LENGTH(remaps);
+
+		p->id = QUIRK_ATTR_KEY_REMAP;
+
+		if (!parse_key_remap_property(value, remaps, &nremaps) ||
+		    nremaps == 0)
+			goto out;
+
+		for (size_t i = 0; i < nremaps; i++) {
+			p->value.tuples.tuples[i].first = remaps[i].from;
+			p->value.tuples.tuples[i].second = remaps[i].modifier;
+			p->value.tuples.tuples[i].third = remaps[i].to;
+		}
+		p->value.tuples.ntuples = nremaps;
+		p->type = PT_TUPLES;
+
 		rc = true;
 	} else {
 		qlog_error(ctx, "Unknown key %s in %s\n", key, s->name);
@@ -1261,17 +1289,29 @@ quirks_unref(struct quirks *q)
 	return NULL;
 }
 
+/**
+ * The source of the properties a device is matched on, either a udev
+ * device or a list of KEY=value properties.
+ */
+struct match_device {
+	struct udev_device *udev_device;
+	char **properties;
+};
+
 /**
  * Searches for the udev property on this device and its parent devices.
  *
  * @return the value of the property or NULL
  */
 static const char *
-udev_prop(struct udev_device *device, const char *prop)
+udev_prop(struct match_device *device, const char *prop)
 {
-	struct udev_device *d = device;
+	struct udev_device *d = device->udev_device;
 	const char *value = NULL;
 
+	if (!d)
+		return strv_find_value(device->properties, prop);
+
 	do {
 		value = udev_device_get_property_value(d, prop);
 		d = udev_device_get_parent(d);
@@ -1282,7 +1322,7 @@ udev_prop(struct udev_device *device, const char *prop)
 
 static inline void
 match_fill_name(struct match *m,
-		struct udev_device *device)
+		struct match_device *device)
 {
 	const char *str = udev_prop(device, "NAME");
 	size_t slen;
@@ -1305,7 +1345,7 @@ match_fill_name(struct match *m,
 
 static inline void
 match_fill_uniq(struct match *m,
-		struct udev_device *device)
+		struct match_device *device)
 {
 	const char *str = udev_prop(device, "UNIQ");
 	size_t slen;
@@ -1328,7 +1368,7 @@ match_fill_uniq(struct match *m,
 
 static inline void
 match_fill_bus_vid_pid(struct match *m,
-		       struct udev_device *device)
+		       struct match_device *device)
 {
 	const char *str;
 	unsigned int product, vendor, bus, version;
@@ -1379,7 +1419,7 @@ match_fill_bus_vid_pid(struct match *m,
 
 static inline void
 match_fill_udev_type(struct match *m,
-		     struct udev_device *device)
+		     struct match_device *device)
 {
 	struct ut_map {
 		const char *prop;
@@ -1417,7 +1457,7 @@ match_fill_dmi_dt(struct match *m, char *dmi, char *dt)
 }
 
 static struct match *
-match_new(struct udev_device *device,
+match_new(struct match_device *device,
 	  char *dmi, char *dt)
 {
 	struct match *m = zalloc(sizeof *m);
@@ -1524,8 +1564,7 @@ static bool
 quirk_match_section(struct quirks_context *ctx,
 		    struct quirks *q,
 		    struct section *s,
-		    struct match *m,
-		    struct udev_device *device)
+		    struct match *m)
 {
 	uint32_t matched_flags = 0x0;
 
@@ -1613,9 +1652,10 @@ quirk_match_section(struct quirks_context *ctx,
 	return true;
 }
 
-struct quirks *
-quirks_fetch_for_device(struct quirks_context *ctx,
-			struct udev_device *udev_device)
+static struct quirks *
+quirks_fetch(struct quirks_context *ctx,
+	     const char *name,
+	     struct match_device *device)
 {
 	struct section *s;
 	struct match *m;
@@ -1623,15 +1663,14 @@ quirks_fetch_for_device(struct quirks_context *ctx,
 	if (!ctx)
 		return NULL;
 
-	qlog_debug(ctx, "%s: fetching quirks\n",
-		   udev_device_get_devnode(udev_device));
+	qlog_debug(ctx, "%s: fetching quirks\n", name);
 
 	_unref_(quirks) *q = quirks_new();
 
-	m = match_new(udev_device, ctx->dmi, ctx->dt);
+	m = match_new(device, ctx->dmi, ctx->dt);
 
 	list_for_each(s, &ctx->sections, link) {
-		quirk_match_section(ctx, q, s, m, udev_device);
+		quirk_match_section(ctx, q, s, m);
 	}
 
 	match_free(m);
@@ -1645,6 +1684,29 @@ quirks_fetch_for_device(struct quirks_context *ctx,
 	return steal(&q);
 }
 
+struct quirks *
+quirks_fetch_for_device(struct quirks_context *ctx,
+			struct udev_device *udev_device)
+{
+	struct match_device device = {
+		.udev_device = udev_device,
+	};
+
+	return quirks_fetch(ctx, udev_device_get_devnode(udev_device), &device);
+}
+
+struct quirks *
+quirks_fetch_for_properties(struct quirks_context *ctx,
+			    const char *name,
+			    char **properties)
+{
+	struct match_device device = {
+		.properties = properties,
+	};
+
+	return quirks_fetch(ctx, name, &device);
+}
+
 static inline struct property *
 quirk_find_prop(struct quirks *q, enum quirk which)
 {
@@ -115,6 +115,8 @@ enum quirk {
 	QUIRK_ATTR_EVENT_CODE,
 	QUIRK_ATTR_INPUT_PROP,
 	QUIRK_ATTR_IS_VIRTUAL,
+	QUIRK_ATTR_KEY_REMAP,
+	QUIRK_ATTR_MAX_MOTION_EVENT_RATE,
 
 	_QUIRK_LAST_ATTR_QUIRK_, /* Guard: do not modify */
 };
@@ -199,6 +201,20 @@ struct quirks *
 quirks_fetch_for_device(struct quirks_context *ctx,
 			struct udev_device *device);
 
+/**
+ * Fetch the quirks for a device described by a list of KEY=value udev
+ * properties instead of a udev device. The device is matched as if
+ * those were the properties of the device and its parents. The name is
+ * used for logging only. If no quirks are defined, this function
+ * returns NULL.
+ *
+ * @return A new quirks struct, use quirks_unref() to release
+ */
+struct quirks *
+quirks_fetch_for_properties(struct quirks_context *ctx,
+			    const char *name,
+			    char **properties);
+
 /**
  * Reduce the refcount by one. When the refcount reaches zero, the
  * associated struct is released.
@@ -74,7 +74,9 @@ libinput_timer_arm_timer_fd(struct libinput *libinput)
 			earliest_expire = timer->expire;
 	}
 
-	if (earliest_expire != UINT64_MAX) {
+	/* With a custom clock the timers expire in libinput_dispatch(),
+	 * the timerfd stays disarmed */
+	if (earliest_expire != UINT64_MAX && !libinput->clock.func) {
 		its.it_value.tv_sec = earliest_expire / ms2us(1000);
 		its.it_value.tv_nsec = (earliest_expire % ms2us(1000)) * 1000;
 	}
@@ -255,8 +257,12 @@ uint64_t
 libinput_now(struct libinput *libinput)
 {
 	uint64_t now;
-	int rc = now_in_us(&now);
+	int rc;
 
+	if (libinput->clock.func)
+		return libinput->clock.func(libinput, libinput->clock.user_data);
+
+	rc = now_in_us(&now);
 	if (rc < 0) {
 		log_error(libinput, "clock_gettime failed: %s\n", strerror(-rc));
 		return 0;
@@ -0,0 +1,122 @@
+/*
+ * Copyright © 2026 Red Hat, Inc.
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a
+ * copy of this software and associated documentation files (the "Software"),
+ * to deal in the Software without restriction, including without limitation
+ * the rights to use, copy, modify, merge, publish, distribute, sublicense,
+ * and/or sell copies of the Software, and to permit persons to whom the
+ * Software is furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice (including the next
+ * paragraph) shall be included in all copies or substantial portions of the
+ * Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT.  IN NO EVENT SHALL
+ * THE AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING
+ * FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER
+ * DEALINGS IN THE SOFTWARE.
+ */
+
+#ifndef UTIL_HISTOGRAM_H
+#define UTIL_HISTOGRAM_H
+
+#include <stdint.h>
+#include <string.h>
+
+/* A histogram with power-of-two buckets. Bucket 0 holds the value 0,
+ * bucket n holds the values [2^(n-1), 2^n), the last bucket holds
+ * everything that doesn't fit elsewhere. For µs values that's a
+ * resolution good enough to tell 1ms from 2ms, with ~4s as the
+ * largest explicit upper limit.
+ */
+#define HISTOGRAM_NBUCKETS 24
+
+struct histogram {
+	uint64_t buckets[HISTOGRAM_NBUCKETS];
+	uint64_t count;
+	uint64_t sum;
+	uint64_t max;
+};
+
+static inline void
+histogram_reset(struct histogram *h)
+{
+	memset(h, 0, sizeof(*h));
+}
+
+static inline unsigned int
+histogram_bucket_index(uint64_t value)
+{
+	if (value == 0)
+		return 0;
+
+	unsigned int idx = 64 - __builtin_clzll(value);
+	return idx < HISTOGRAM_NBUCKETS ? idx : HISTOGRAM_NBUCKETS - 1;
+}
+
+/**
+ * The exclusive upper limit of the values in the given bucket or
+ * UINT64_MAX for the last bucket.
+ */
+static inline uint64_t
+histogram_bucket_limit(unsigned int idx)
+{
+	if (idx >= HISTOGRAM_NBUCKETS - 1)
+		return UINT64_MAX;
+
+	return 1ULL << idx;
+}
+
+static inline void
+histogram_add(struct histogram *h, uint64_t value)
+{
+	h->buckets[histogram_bucket_index(value)]++;
+	h->count++;
+	h->sum += value;
+	if (value > h->max)
+		h->max = value;
+}
+
+static inline void
+histogram_merge(struct histogram *h, const struct histogram *other)
+{
+	for (unsigned int i = 0; i < HISTOGRAM_NBUCKETS; i++)
+		h->buckets[i] += other->buckets[i];
+	h->count += other->count;
+	h->sum += other->sum;
+	if (other->max > h->max)
+		h->max = other->max;
+}
+
+/**
+ * Returns an upper estimate of the given percentile (0.0 - 100.0), i.e.
+ * the upper limit of the bucket the percentile falls into, clipped to the
+ * maximum value seen.
+ */
+static inline uint64_t
+histogram_percentile(const struct histogram *h, double percentile)
+{
+	if (h->count == 0)
+		return 0;
+
+	uint64_t rank = (uint64_t)(h->count * percentile / 100.0 + 0.5);
+	if (rank == 0)
+		rank = 1;
+
+	uint64_t seen = 0;
+	for (unsigned int i = 0; i < HISTOGRAM_NBUCKETS; i++) {
+		seen += h->buckets[i];
+		if (seen >= rank) {
+			uint64_t upper = histogram_bucket_limit(i) - 1;
+			return upper < h->max ? upper : h->max;
+		}
+	}
+
+	return h->max;
+}
+
+#endif
@@ -31,8 +31,8 @@
 #include "util-strings.h"
 #include "util-libinput.h"
 
-static const char *
-event_type_to_str(enum libinput_event_type evtype)
+const char *
+libinput_event_type_to_str(enum libinput_event_type evtype)
 {
 	const char *type;
 
@@ -149,7 +149,7 @@ print_event_header(struct libinput_event *ev, size_t event_count)
 	/* use for pointer value only, do not dereference */
 	static void *last_device = NULL;
 	struct libinput_device *dev = libinput_event_get_device(ev);
-	const char *type = event_type_to_str(libinput_event_get_type(ev));
+	const char *type = libinput_event_type_to_str(libinput_event_get_type(ev));
 	char count[10];
 
 	if (event_count > 1)
@@ -34,6 +34,12 @@ struct libinput_print_options {
 	bool show_keycodes;
 };
 
+/**
+ * @return the name of the event type, e.g. "POINTER_MOTION"
+ */
+const char *
+libinput_event_type_to_str(enum libinput_event_type evtype);
+
 char *
 libinput_event_to_str(struct libinput_event *ev,
 		      size_t event_repeat_count,
@@ -422,6 +422,85 @@ out:
 	return rc;
 }
 
+static bool
+parse_key_code_string(const char *s, unsigned int *code_out)
+{
+	int type, code;
+
+	if (!parse_evcode_string(s, &type, &code) ||
+	    type != EV_KEY ||
+	    code == EVENT_CODE_UNDEFINED ||
+	    code == KEY_RESERVED)
+		return false;
+
+	*code_out = code;
+
+	return true;
+}
+
+/**
+ * Parses a string of the format "KEY_A:KEY_B;KEY_CAPSLOCK:none;KEY_FN+KEY_F1:KEY_MUTE"
+ * where each element maps a named key or button to another named key or
+ * button, or to "none" to drop it. An element may be prefixed with a
+ * second key and '+' to only apply while that key is held down.
+ *
+ * remaps must point to an existing array of size nremaps.
+ * nremaps specifies the size of the array in remaps and returns the number
+ * of items, elements exceeding nremaps are simply ignored.
+ *
+ * On success, remaps contains nremaps elements with the to code set to
+ * KEY_RESERVED for keys that are dropped.
+ */
+bool
+parse_key_remap_property(const char *prop, struct key_remap *remaps, size_t *nremaps)
+{
+	bool rc = false;
+	/* A randomly chosen max so we avoid crazy quirks */
+	struct key_remap r[32];
+
+	memset(r, 0, sizeof r);
+
+	size_t count;
+	char **strv = strv_from_string(prop, ";", &count);
+	if (!strv || count == 0 || count > ARRAY_LENGTH(r))
+		goto out;
+
+	count = min(*nremaps, count);
+	for (size_t idx = 0; strv[idx]; idx++) {
+		size_t nelem;
+		_autostrvfree_ char **kv = strv_from_string(strv[idx], ":", &nelem);
+		if (!kv || nelem != 2)
+			goto out;
+
+		size_t nkeys;
+		_autostrvfree_ char **keys = strv_from_string(kv[0], "+", &nkeys);
+		if (!keys || nkeys == 0 || nkeys > 2)
+			goto out;
+
+		if (nkeys == 2 &&
+		    (!parse_key_code_string(keys[0], &r[idx].modifier) ||
+		     !parse_key_code_string(keys[1], &r[idx].from) ||
+		     r[idx].modifier == r[idx].from))
+			goto out;
+		else if (nkeys == 1 &&
+			 !parse_key_code_string(keys[0], &r[idx].from))
+			goto out;
+
+		if (streq(kv[1], "none"))
+			r[idx].to = KEY_RESERVED;
+		else if (!parse_key_code_string(kv[1], &r[idx].to))
+			goto out;
+	}
+
+	memcpy(remaps, r, count * sizeof *remaps);
+	*nremaps = count;
+	rc = true;
+
+out:
+	strv_free(strv);
+	return rc;
+}
+
 /**
  * Parses a string of the format "+INPUT_PROP_BUTTONPAD;-INPUT_PROP_POINTER;+0x123;"
  * where each element must be a named input prop OR a hexcode in the form
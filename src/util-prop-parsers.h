@@ -46,6 +46,13 @@ bool parse_boolean_property(const char *prop, bool *b);
 bool parse_evcode_property(const char *prop, struct input_event *events, size_t *nevents);
 bool parse_input_prop_property(const char *prop, struct input_prop *props_out, size_t *nprops);
 
+struct key_remap {
+	unsigned int modifier; /* 0 unless this is a chord */
+	unsigned int from;
+	unsigned int to; /* KEY_RESERVED to drop the key */
+};
+bool parse_key_remap_property(const char *prop, struct key_remap *remaps, size_t *nremaps);
+
 enum tpkbcombo_layout {
 	TPKBCOMBO_LAYOUT_UNKNOWN,
 	TPKBCOMBO_LAYOUT_BELOW,
@@ -335,6 +335,27 @@ strv_find_substring(char **strv, const char *needle, size_t *index_out)
 	return false;
 }
 
+/**
+ * Look up the value for key in a strv of "KEY=value" strings.
+ *
+ * @return a pointer to the value within the strv or NULL if the key
+ * is not present
+ */
+const char *
+strv_find_value(char **strv, const char *key)
+{
+	if (!strv || !key)
+		return NULL;
+
+	size_t keylen = strlen(key);
+	for (char **s = strv; *s != NULL; s++) {
+		if (strneq(*s, key, keylen) && (*s)[keylen] == '=')
+			return *s + keylen + 1;
+	}
+
+	return NULL;
+}
+
 /**
  * Return a pointer to the basename within filename.
  * If the filename the empty string or a directory (i.e. the last char of
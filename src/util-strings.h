@@ -334,6 +334,7 @@ char **strv_append_vprintf(char **strv, const char *fmt, va_list args);
 
 bool strv_find(char **strv, const char *needle, size_t *index_out);
 bool strv_find_substring(char **strv, const char *needle, size_t *index_out);
+const char *strv_find_value(char **strv, const char *key);
 
 typedef int (*strv_foreach_callback_t)(const char *str, size_t index, void *data);
 int strv_for_each(const char **strv, strv_foreach_callback_t func, void *data);
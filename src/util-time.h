@@ -117,6 +117,17 @@ us2tv(uint64_t time)
 	return tv;
 }
 
+static inline struct timespec
+us2ts(uint64_t time)
+{
+	struct timespec ts;
+
+	ts.tv_sec = time / ms2us(1000);
+	ts.tv_nsec = (time % ms2us(1000)) * 1000;
+
+	return ts;
+}
+
 static inline int
 now_in_us(uint64_t *us)
 {
@@ -131,6 +142,20 @@ now_in_us(uint64_t *us)
 	return 0;
 }
 
+static inline int
+now_in_ns(uint64_t *ns)
+{
+	struct timespec ts = { 0, 0 };
+
+	if (clock_gettime(CLOCK_MONOTONIC, &ts) != 0) {
+		*ns = 0;
+		return -errno;
+	}
+
+	*ns = s2us(ts.tv_sec) * 1000 + ts.tv_nsec;
+	return 0;
+}
+
 struct human_time {
 	unsigned int value;
 	const char *unit;
@@ -65,9 +65,6 @@ all_codes_create(struct litest_device *d)
 	events[idx++] = -1;
 	events[idx++] = -1;
 
-	d->uinput = litest_create_uinput_device_from_description(NAME,
-								 &input_id,
-								 NULL,
-								 events);
+	litest_create_kernel_device(d, NAME, &input_id, NULL, events);
 	return false;
 }
@@ -0,0 +1,661 @@
+/*
+ * Copyright © 2025 Red Hat, Inc.
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a
+ * copy of this software and associated documentation files (the "Software"),
+ * to deal in the Software without restriction, including without limitation
+ * the rights to use, copy, modify, merge, publish, distribute, sublicense,
+ * and/or sell copies of the Software, and to permit persons to whom the
+ * Software is furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice (including the next
+ * paragraph) shall be included in all copies or substantial portions of the
+ * Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT.  IN NO EVENT SHALL
+ * THE AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING
+ * FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER
+ * DEALINGS IN THE SOFTWARE.
+ */
+
+/* Test devices without uinput or udev, used with --no-uinput.
+ *
+ * The device is described by a libevdev context and added with
+ * libinput_path_add_evdev_device(), its events are written to a pipe.
+ * What the kernel and udev would otherwise do for a uinput device is
+ * done here:
+ * - the ID_INPUT properties are guessed the way udev's input_id builtin
+ *   does, the litest udev properties and EVDEV_ABS overrides are applied
+ *   on top
+ * - the fuzz of touchpads and touchscreens is moved into the
+ *   LIBINPUT_FUZZ properties like the libinput udev rules do
+ * - events are filtered like the kernel's input core does, i.e.
+ *   unchanged values are dropped, the fuzz is applied, ABS_MT_SLOT is
+ *   only sent before a slot's values change and empty frames are dropped
+ * - the events carry the time of the test clock, see litest_clock_now()
+ *
+ * The hwdb is not available, properties from the hwdb (e.g.
+ * ID_INPUT_TOUCHPAD_INTEGRATION) are not set unless the test device
+ * sets them.
+ */
+
+#include "config.h"
+
+#include <errno.h>
+#include <fcntl.h>
+#include <unistd.h>
+
+#include <libevdev/libevdev.h>
+
+#include "litest.h"
+#include "litest-int.h"
+#include "libinput-util.h"
+#include "libinput-private-api.h"
+#include "quirks.h"
+#include "util-input-event.h"
+#include "util-prop-parsers.h"
+
+#define FRAME_INTERVAL_US 100
+
+struct litest_fake_device {
+	char *name;
+	struct input_id id;
+	struct input_absinfo *absinfo; /* terminated by .value == -1 */
+	int *events;	/* terminated by -1, -1 */
+	char *sysname;
+	char **properties;
+
+	/* The kernel's view of the device, used to filter events */
+	struct libevdev *kernel;
+	int slot;	/* the slot of the last ABS_MT_SLOT written */
+	int last_slot;	/* the slot of the last ABS_MT_SLOT sent */
+
+	int fds[2];
+	bool added;
+};
+
+static void
+fake_device_set_property(struct litest_fake_device *fake,
+			 const char *key,
+			 const char *value)
+{
+	size_t keylen = strlen(key);
+
+	for (char **p = fake->properties; p && *p; p++) {
+		if (strneq(*p, key, keylen) && (*p)[keylen] == '=') {
+			free(*p);
+			*p = strdup_printf("%s=%s", key, value);
+			return;
+		}
+	}
+
+	fake->properties = strv_append_printf(fake->properties,
+					      "%s=%s", key, value);
+}
+
+static inline bool
+has_code(struct libevdev *evdev, unsigned int type, unsigned int code)
+{
+	return libevdev_has_event_code(evdev, type, code);
+}
+
+/**
+ * The same classification as systemd's udev input_id builtin, minus the
+ * joystick detection none of our test devices need.
+ */
+static void
+fake_device_input_id(struct litest_fake_device *fake)
+{
+	struct libevdev *evdev = fake->kernel;
+	bool has_abs = has_code(evdev, EV_ABS, ABS_X) &&
+		       has_code(evdev, EV_ABS, ABS_Y);
+	bool has_mt = has_code(evdev, EV_ABS, ABS_MT_POSITION_X) &&
+		      has_code(evdev, EV_ABS, ABS_MT_POSITION_Y);
+	bool has_rel = has_code(evdev, EV_REL, REL_X) &&
+		       has_code(evdev, EV_REL, REL_Y);
+	bool has_pen = has_code(evdev, EV_KEY, BTN_TOOL_PEN);
+	bool stylus_or_pen = has_pen || has_code(evdev, EV_KEY, BTN_STYLUS);
+	bool finger_but_no_pen = has_code(evdev, EV_KEY, BTN_TOOL_FINGER) &&
+				 !has_pen;
+	bool has_touch = has_code(evdev, EV_KEY, BTN_TOUCH);
+	bool has_mouse_button = has_code(evdev, EV_KEY, BTN_LEFT);
+	bool has_pad_buttons = has_code(evdev, EV_KEY, BTN_0) &&
+			       has_code(evdev, EV_KEY, BTN_1) &&
+			       !has_pen;
+	bool has_wheel = has_code(evdev, EV_REL, REL_WHEEL) ||
+			 has_code(evdev, EV_REL, REL_HWHEEL);
+	bool is_direct = libevdev_has_property(evdev, INPUT_PROP_DIRECT);
+	bool is_pointing_stick = libevdev_has_property(evdev, INPUT_PROP_POINTING_STICK);
+	bool is_tablet = false,
+	     is_tablet_pad = false,
+	     is_touchpad = false,
+	     is_touchscreen = false,
+	     is_mouse = false,
+	     is_abs_mouse = false,
+	     is_key = false,
+	     is_keyboard = true;
+
+	if (libevdev_has_property(evdev, INPUT_PROP_ACCELEROMETER)) {
+		fake_device_set_property(fake, "ID_INPUT", "1");
+		fake_device_set_property(fake, "ID_INPUT_ACCELEROMETER", "1");
+		return;
+	}
+
+	if (has_abs) {
+		if (stylus_or_pen)
+			is_tablet = true;
+		else if (finger_but_no_pen && !is_direct)
+			is_touchpad = true;
+		else if (has_mouse_button)
+			is_abs_mouse = true;
+		else if (has_touch || is_direct)
+			is_touchscreen = true;
+	}
+
+	if (has_mt) {
+		if (stylus_or_pen)
+			is_tablet = true;
+		else if (finger_but_no_pen && !is_direct)
+			is_touchpad = true;
+		else if (has_touch || is_direct)
+			is_touchscreen = true;
+	}
+
+	if (is_tablet && has_pad_buttons)
+		is_tablet_pad = true;
+
+	if (has_pad_buttons && has_wheel && !has_rel) {
+		is_tablet = true;
+		is_tablet_pad = true;
+	}
+
+	if (!is_tablet && !is_touchpad && has_mouse_button &&
+	    (has_rel || !has_abs))
+		is_mouse = true;
+
+	/* There is no such thing as an i2c mouse */
+	if (is_mouse && fake->id.bustype == BUS_I2C)
+		is_pointing_stick = true;
+
+	/* Any key below BTN_MISC or in the higher key blocks makes it a
+	 * key device, all of KEY_ESC to KEY_S make it a keyboard */
+	for (unsigned int code = KEY_ESC; code < BTN_MISC; code++) {
+		if (has_code(evdev, EV_KEY, code))
+			is_key = true;
+		else if (code < 32)
+			is_keyboard = false;
+	}
+	for (unsigned int code = KEY_OK; !is_key && code < BTN_DPAD_UP; code++)
+		is_key = has_code(evdev, EV_KEY, code);
+	for (unsigned int code = KEY_ALS_TOGGLE; !is_key && code < BTN_TRIGGER_HAPPY; code++)
+		is_key = has_code(evdev, EV_KEY, code);
+
+	struct {
+		bool is;
+		const char *property;
+	} types[] = {
+		{ is_pointing_stick, "ID_INPUT_POINTINGSTICK" },
+		{ is_mouse || is_abs_mouse, "ID_INPUT_MOUSE" },
+		{ is_touchpad, "ID_INPUT_TOUCHPAD" },
+		{ is_touchscreen, "ID_INPUT_TOUCHSCREEN" },
+		{ is_tablet, "ID_INPUT_TABLET" },
+		{ is_tablet_pad, "ID_INPUT_TABLET_PAD" },
+		{ is_key, "ID_INPUT_KEY" },
+		{ is_keyboard, "ID_INPUT_KEYBOARD" },
+		{ libevdev_has_event_type(evdev, EV_SW), "ID_INPUT_SWITCH" },
+	};
+	bool is_input = false;
+
+	ARRAY_FOR_EACH(types, t) {
+		if (t->is) {
+			fake_device_set_property(fake, t->property, "1");
+			is_input = true;
+		}
+	}
+
+	if (is_input)
+		fake_device_set_property(fake, "ID_INPUT", "1");
+}
+
+/**
+ * 90-libinput-fuzz-override.rules: the x/y fuzz of touchpads and
+ * touchscreens moves into the LIBINPUT_FUZZ properties and the kernel
+ * fuzz becomes zero.
+ */
+static void
+fake_device_extract_fuzz(struct litest_fake_device *fake)
+{
+	unsigned int axes[] = {
+		ABS_X,
+		ABS_Y,
+		ABS_MT_POSITION_X,
+		ABS_MT_POSITION_Y,
+	};
+
+	if (!strv_find_value(fake->properties, "ID_INPUT_TOUCHPAD") &&
+	    !strv_find_value(fake->properties, "ID_INPUT_TOUCHSCREEN"))
+		return;
+
+	ARRAY_FOR_EACH(axes, code) {
+		int fuzz;
+
+		if (!has_code(fake->kernel, EV_ABS, *code))
+			continue;
+
+		fuzz = libevdev_get_abs_fuzz(fake->kernel, *code);
+		if (fuzz) {
+			char key[32];
+			char value[16];
+
+			snprintf(key, sizeof(key), "LIBINPUT_FUZZ_%02x", *code);
+			snprintf(value, sizeof(value), "%d", fuzz);
+			fake_device_set_property(fake, key, value);
+			libevdev_set_abs_fuzz(fake->kernel, *code, 0);
+		}
+	}
+}
+
+/**
+ * The udev keyboard builtin applies EVDEV_ABS_xx=min:max:res:fuzz:flat
+ * to the kernel device.
+ */
+static void
+fake_device_apply_evdev_abs(struct litest_fake_device *fake)
+{
+	for (char **p = fake->properties; p && *p; p++) {
+		_autostrvfree_ char **kv = NULL;
+		size_t nelems;
+		unsigned int code;
+
+		if (!strstartswith(*p, "EVDEV_ABS_"))
+			continue;
+
+		kv = strv_from_string(*p + strlen("EVDEV_ABS_"), "=", &nelems);
+		if (nelems != 2 ||
+		    !safe_atou_base(kv[0], &code, 16) ||
+		    !has_code(fake->kernel, EV_ABS, code))
+			continue;
+
+		struct input_absinfo abs = *libevdev_get_abs_info(fake->kernel, code);
+		litest_assert(parse_evdev_abs_prop(kv[1], &abs) != 0);
+		libevdev_set_abs_info(fake->kernel, code, &abs);
+	}
+}
+
+static void
+fake_device_apply_udev_properties(struct litest_fake_device *fake,
+				  struct list *test_devices)
+{
+	struct litest_test_device *dev;
+
+	fake_device_input_id(fake);
+	litest_assert_msg(strv_find_value(fake->properties, "ID_INPUT"),
+			  "%s is not an input device\n", fake->name);
+
+	fake_device_extract_fuzz(fake);
+
+	fake_device_set_property(fake, "LIBINPUT_TEST_DEVICE", "1");
+
+	/* Same as the ATTRS{name}=="litest <name>*" match of the generated
+	 * udev rules, in the same order */
+	list_for_each(dev, test_devices, node) {
+		char prefix[512];
+
+		snprintf(prefix, sizeof(prefix), "litest %s", dev->name);
+		if (!strstartswith(fake->name, prefix))
+			continue;
+
+		for (const struct key_value_str *kv = dev->udev_properties;
+		     kv->key;
+		     kv++)
+			fake_device_set_property(fake, kv->key, kv->value);
+	}
+
+	fake_device_apply_evdev_abs(fake);
+}
+
+/**
+ * A new libevdev context with the device as the kernel describes it.
+ */
+static struct libevdev *
+fake_device_evdev_from_description(struct litest_fake_device *fake)
+{
+	struct libevdev *evdev = libevdev_new();
+	const struct input_absinfo default_abs = {
+		.value = 0,
+		.minimum = 0,
+		.maximum = 100,
+		.resolution = 100,
+	};
+	/* Same as the uinput default, see litest_create_uinput() */
+	const struct input_absinfo default_abs_mt_slot = {
+		.value = 0,
+		.minimum = 0,
+		.maximum = 64,
+		.resolution = 100,
+	};
+	const int *e;
+	int rc;
+
+	litest_assert_ptr_notnull(evdev);
+
+	libevdev_set_name(evdev, fake->name);
+	libevdev_set_id_bustype(evdev, fake->id.bustype);
+	libevdev_set_id_vendor(evdev, fake->id.vendor);
+	libevdev_set_id_product(evdev, fake->id.product);
+	libevdev_set_id_version(evdev, fake->id.version);
+
+	for (const struct input_absinfo *abs = fake->absinfo;
+	     abs && abs->value != -1;
+	     abs++) {
+		struct input_absinfo a = *abs;
+
+		a.value = abs->minimum;
+		rc = libevdev_enable_event_code(evdev, EV_ABS, abs->value, &a);
+		litest_assert_int_eq(rc, 0);
+	}
+
+	for (e = fake->events; e && e[0] != -1 && e[1] != -1; e += 2) {
+		unsigned int type = e[0],
+			     code = e[1];
+
+		if (type == INPUT_PROP_MAX) {
+			rc = libevdev_enable_property(evdev, code);
+		} else {
+			const struct input_absinfo *abs =
+				(code == ABS_MT_SLOT) ? &default_abs_mt_slot : &default_abs;
+			rc = libevdev_enable_event_code(evdev, type, code,
+							type == EV_ABS ? abs : NULL);
+		}
+		litest_assert_int_eq(rc, 0);
+	}
+
+	return evdev;
+}
+
+struct litest_fake_device *
+litest_fake_device_new(const char *name,
+		       const struct input_id *id,
+		       const struct input_absinfo *abs,
+		       const int *events,
+		       struct list *test_devices)
+{
+	static unsigned int sysnum = 1000;
+	struct litest_fake_device *fake = zalloc(sizeof(*fake));
+	size_t nabs = 0, nevents = 0;
+
+	fake->name = strdup_printf("litest %s", name);
+	if (id)
+		fake->id = *id;
+	fake->sysname = strdup_printf("event%u", sysnum++);
+
+	while (abs && abs[nabs].value != -1)
+		nabs++;
+	fake->absinfo = zalloc((nabs + 1) * sizeof(*fake->absinfo));
+	if (nabs)
+		memcpy(fake->absinfo, abs, nabs * sizeof(*abs));
+	fake->absinfo[nabs].value = -1;
+
+	while (events && events[nevents] != -1 && events[nevents + 1] != -1)
+		nevents += 2;
+	fake->events = zalloc((nevents + 2) * sizeof(*fake->events));
+	if (nevents)
+		memcpy(fake->events, events, nevents * sizeof(*events));
+	fake->events[nevents] = -1;
+	fake->events[nevents + 1] = -1;
+
+	fake->kernel = fake_device_evdev_from_description(fake);
+	fake_device_apply_udev_properties(fake, test_devices);
+	fake->slot = 0;
+	fake->last_slot = 0;
+
+	/* libinput needs a non-blocking read end. The kernel buffers a
+	 * few thousand events per client before it drops them, the
+	 * default 64k of a pipe is close to that. Writes must never
+	 * block either, the test is the only reader */
+	litest_assert_errno_success(pipe2(fake->fds, O_CLOEXEC | O_NONBLOCK));
+	(void)fcntl(fake->fds[1], F_SETPIPE_SZ, 1024 * 1024);
+
+	return fake;
+}
+
+void
+litest_fake_device_destroy(struct litest_fake_device *fake)
+{
+	if (!fake)
+		return;
+
+	close(fake->fds[0]);
+	close(fake->fds[1]);
+	libevdev_free(fake->kernel);
+	strv_free(fake->properties);
+	free(fake->sysname);
+	free(fake->events);
+	free(fake->absinfo);
+	free(fake->name);
+	free(fake);
+}
+
+struct libevdev *
+litest_fake_device_new_evdev(struct litest_fake_device *fake)
+{
+	struct libevdev *evdev = fake_device_evdev_from_description(fake);
+
+	/* What a libevdev_new_from_fd() on the kernel device would see */
+	for (unsigned int code = 0; code < ABS_CNT; code++) {
+		if (has_code(fake->kernel, EV_ABS, code))
+			libevdev_set_abs_info(evdev, code,
+					      libevdev_get_abs_info(fake->kernel, code));
+	}
+
+	return evdev;
+}
+
+struct libinput_device *
+litest_fake_device_add(struct litest_fake_device *fake,
+		       struct libinput *libinput)
+{
+	struct libinput_device *device;
+
+	/* Only one reader, the pipe can't copy events for two contexts
+	 * the way the kernel does for two clients */
+	litest_assert_msg(!fake->added,
+			  "%s: fake devices can only be added to one context\n",
+			  fake->name);
+
+	device = libinput_path_add_evdev_device(libinput,
+						litest_fake_device_new_evdev(fake),
+						fake->fds[0],
+						fake->sysname,
+						(const char **)fake->properties);
+	fake->added = device != NULL;
+
+	return device;
+}
+
+struct quirks *
+litest_fake_device_fetch_quirks(struct litest_fake_device *fake,
+				struct quirks_context *ctx)
+{
+	_autostrvfree_ char **properties = NULL;
+
+	/* Same as libinput: NAME and PRODUCT are what the quirks
+	 * match on */
+	for (char **p = fake->properties; p && *p; p++)
+		properties = strv_append_strdup(properties, *p);
+	properties = strv_append_printf(properties, "NAME=\"%s\"", fake->name);
+	properties = strv_append_printf(properties,
+					"PRODUCT=%x/%x/%x/%x",
+					fake->id.bustype,
+					fake->id.vendor,
+					fake->id.product,
+					fake->id.version);
+
+	return quirks_fetch_for_properties(ctx, fake->sysname, properties);
+}
+
+const char *
+litest_fake_device_get_property(struct litest_fake_device *fake,
+				const char *key)
+{
+	return strv_find_value(fake->properties, key);
+}
+
+/* input_defuzz_abs_event() in the kernel */
+static inline int
+defuzz(int value, int old, int fuzz)
+{
+	if (fuzz) {
+		if (value > old - fuzz / 2 && value < old + fuzz / 2)
+			return old;
+
+		if (value > old - fuzz && value < old + fuzz)
+			return (old * 3 + value) / 4;
+
+		if (value > old - fuzz * 2 && value < old + fuzz * 2)
+			return (old + value) / 2;
+	}
+
+	return value;
+}
+
+static inline bool
+is_mt_value(unsigned int code)
+{
+	return code >= ABS_MT_TOUCH_MAJOR && code <= ABS_MT_TOOL_Y;
+}
+
+/**
+ * input_handle_abs_event() in the kernel. Returns the number of events
+ * to send, two if the pending ABS_MT_SLOT goes first.
+ */
+static size_t
+fake_device_filter_abs(struct litest_fake_device *fake,
+		       struct input_event *ev,
+		       struct input_event out[2])
+{
+	struct libevdev *kernel = fake->kernel;
+	int nslots = libevdev_get_num_slots(kernel);
+	int fuzz = libevdev_get_abs_fuzz(kernel, ev->code);
+	int old;
+
+	if (ev->code == ABS_MT_SLOT) {
+		/* sent with the first value that changes in this slot */
+		if (nslots > 0 && ev->value >= 0 && ev->value < nslots)
+			fake->slot = ev->value;
+		return 0;
+	}
+
+	if (!is_mt_value(ev->code)) {
+		old = libevdev_get_event_value(kernel, EV_ABS, ev->code);
+		ev->value = defuzz(ev->value, old, fuzz);
+		if (ev->value == old)
+			return 0;
+		libevdev_set_event_value(kernel, EV_ABS, ev->code, ev->value);
+	} else if (nslots > 0) {
+		old = libevdev_get_slot_value(kernel, fake->slot, ev->code);
+		ev->value = defuzz(ev->value, old, fuzz);
+		if (ev->value == old)
+			return 0;
+		libevdev_set_slot_value(kernel, fake->slot, ev->code, ev->value);
+
+		if (fake->slot != fake->last_slot) {
+			fake->last_slot = fake->slot;
+			out[0] = *ev;
+			out[0].code = ABS_MT_SLOT;
+			out[0].value = fake->slot;
+			out[1] = *ev;
+			return 2;
+		}
+	} /* else protocol A, nothing to filter against */
+
+	out[0] = *ev;
+	return 1;
+}
+
+/**
+ * input_get_disposition() in the kernel, the events that reach an evdev
+ * client.
+ */
+static size_t
+fake_device_filter(struct litest_fake_device *fake,
+		   struct input_event *ev,
+		   struct input_event out[2])
+{
+	struct libevdev *kernel = fake->kernel;
+
+	if (ev->type != EV_SYN && !has_code(kernel, ev->type, ev->code))
+		return 0;
+
+	switch (ev->type) {
+	case EV_KEY:
+		/* key repeat bypasses the state */
+		if (ev->value == 2)
+			break;
+		_fallthrough_;
+	case EV_SW:
+	case EV_LED:
+		if (!!libevdev_get_event_value(kernel, ev->type, ev->code) == !!ev->value)
+			return 0;
+		libevdev_set_event_value(kernel, ev->type, ev->code, !!ev->value);
+		break;
+	case EV_ABS:
+		return fake_device_filter_abs(fake, ev, out);
+	case EV_REL:
+		if (ev->value == 0)
+			return 0;
+		break;
+	default:
+		break;
+	}
+
+	out[0] = *ev;
+	return 1;
+}
+
+void
+litest_fake_device_write_frame(struct litest_fake_device *fake,
+			       const struct input_event *events,
+			       size_t nevents,
+			       int syn_report_value)
+{
+	struct input_event frame[nevents * 2 + 1];
+	size_t count = 0;
+	uint64_t now;
+	ssize_t len;
+
+	for (size_t i = 0; i < nevents; i++) {
+		struct input_event ev = events[i];
+
+		count += fake_device_filter(fake, &ev, &frame[count]);
+	}
+
+	/* The kernel only flushes a frame with events in it */
+	if (count == 0)
+		return;
+
+	frame[count++] = (struct input_event) {
+		.type = EV_SYN,
+		.code = SYN_REPORT,
+		.value = syn_report_value,
+	};
+
+	/* All events of a frame carry the time of the SYN_REPORT. Writing
+	 * a frame to a uinput device and reading it back takes a while,
+	 * the test clock advances accordingly so consecutive frames are not
+	 * at the same time, e.g. for the touchpad motion speed */
+	now = litest_clock_now();
+	if (litest_has_test_clock())
+		litest_clock_advance(FRAME_INTERVAL_US);
+	for (size_t i = 0; i < count; i++)
+		input_event_set_time(&frame[i], now);
+
+	len = write(fake->fds[1], frame, count * sizeof(*frame));
+	litest_assert_msg(len == (ssize_t)(count * sizeof(*frame)),
+			  "%s: failed to write events (%s), the test must dispatch more often\n",
+			  fake->name,
+			  len < 0 ? strerror(errno) : "short write");
+}
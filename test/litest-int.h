@@ -181,6 +181,7 @@ struct test {
 	struct range range;
 	int rangeval;
 	bool deviceless;
+	bool no_device_pool;
 
 	struct litest_test_parameters *params;
 };
@@ -189,6 +190,8 @@ struct suite {
 	struct list node;
 	struct list tests;
 	char *name;
+	bool no_device_pool;
+	bool uinput_optional;
 };
 
 enum litest_runner_result litest_run(struct list *suites, int jobs);
@@ -205,4 +208,71 @@ void litest_set_current_device(struct litest_device *device);
 int litest_scale(const struct litest_device *d, unsigned int axis, double val);
 void litest_generic_device_teardown(void);
 
+/**
+ * Create the kernel device for d, a uinput device or, with --no-uinput,
+ * a fake device. For devices with a custom create function.
+ */
+void
+litest_create_kernel_device(struct litest_device *d,
+			    const char *name,
+			    const struct input_id *id,
+			    const struct input_absinfo *abs,
+			    const int *events);
+
+/**
+ * True if the test's libinput contexts run on the test clock, i.e. with
+ * --no-uinput unless --no-test-clock was given.
+ */
+bool
+litest_has_test_clock(void);
+
+/**
+ * The current time of the test's libinput contexts in µs. On the test
+ * clock, this only advances when the test sleeps and when a fake device
+ * writes a frame, otherwise it is CLOCK_MONOTONIC like the timestamps of
+ * uinput events.
+ */
+uint64_t
+litest_clock_now(void);
+
+/**
+ * Advance the test clock, only valid if litest_has_test_clock().
+ */
+void
+litest_clock_advance(uint64_t us);
+
+/* litest-fake-device.c, devices without uinput */
+struct quirks_context;
+
+struct litest_fake_device *
+litest_fake_device_new(const char *name,
+		       const struct input_id *id,
+		       const struct input_absinfo *abs,
+		       const int *events,
+		       struct list *test_devices);
+
+void
+litest_fake_device_destroy(struct litest_fake_device *fake);
+
+struct libevdev *
+litest_fake_device_new_evdev(struct litest_fake_device *fake);
+
+struct libinput_device *
+litest_fake_device_add(struct litest_fake_device *fake,
+		       struct libinput *libinput);
+
+struct quirks *
+litest_fake_device_fetch_quirks(struct litest_fake_device *fake,
+				struct quirks_context *ctx);
+
+const char *
+litest_fake_device_get_property(struct litest_fake_device *fake,
+				const char *key);
+
+void
+litest_fake_device_write_frame(struct litest_fake_device *fake,
+			       const struct input_event *events,
+			       size_t nevents,
+			       int syn_report_value);
+
 #endif
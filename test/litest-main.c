@@ -73,6 +73,7 @@ extern bool use_colors;
 extern bool in_debugger;
 extern bool verbose;
 extern bool run_deviceless;
+extern bool run_without_uinput;
 extern struct suite *current_suite;
 
 static bool
@@ -252,7 +253,8 @@ main(int argc, char **argv)
 		return EXIT_SUCCESS;
 	}
 
-	if (!run_deviceless && (rc = check_device_access()) != 0)
+	if (!run_deviceless && !run_without_uinput &&
+	    (rc = check_device_access()) != 0)
 		return rc;
 
 	enum litest_runner_result result = litest_run(&all_test_suites, jobs);
@@ -32,6 +32,7 @@
 #include <sys/syscall.h>
 #endif
 #include <fcntl.h>
+#include <inttypes.h>
 #include <stdlib.h>
 #include <signal.h>
 #include <setjmp.h>
@@ -81,6 +82,15 @@ struct litest_runner_test {
 		uint64_t start_millis;
 		uint64_t end_millis;
 	} times;
+
+	size_t index;		/* in order of litest_runner_add_test() */
+	uint64_t estimate_millis; /* duration from the timing db or a guess */
+	size_t slot;		/* the job slot the test ran in */
+};
+
+struct litest_runner_timing {
+	char *name;
+	uint64_t duration_millis;
 };
 
 struct litest_runner {
@@ -96,6 +106,22 @@ struct litest_runner {
 	struct list tests; /* struct litest_runner_test */
 	struct list tests_running; /* struct litest_runner_test */
 	struct list tests_complete; /* struct litest_runner_test */
+	size_t ntests;
+
+	bool *slots; /* true if a job slot is busy */
+	size_t nslots;
+
+	struct {
+		char *path;
+		struct litest_runner_timing *entries; /* sorted by name */
+		size_t nentries;
+		size_t sz;
+	} timing_db;
+
+	struct {
+		unsigned int index; /* 0-based */
+		unsigned int count; /* 0 for no sharding */
+	} shard;
 
 	struct {
 		time_t start;
@@ -248,6 +274,11 @@ litest_runner_destroy(struct litest_runner *runner)
 	list_for_each_safe(t, &runner->tests_running, node) {
 		litest_runner_test_destroy(t);
 	}
+	for (size_t i = 0; i < runner->timing_db.nentries; i++)
+		free(runner->timing_db.entries[i].name);
+	free(runner->timing_db.entries);
+	free(runner->timing_db.path);
+	free(runner->slots);
 	free(runner);
 }
 
@@ -619,13 +650,25 @@ litest_runner_run_test(struct litest_runner *runner, struct litest_runner_test *
 		}
 		r = 0; /* -Wclobbered */
 	} else {
+		if (t->desc.prefork)
+			t->desc.prefork(&t->desc);
 		r = litest_runner_fork_test(runner, t);
 		if (r >= 0)
 			r = litest_runner_test_setup_monitoring(runner, t);
 		litest_runner_test_update_errno(t, -r);
+		/* fork failed, nothing uses what prefork set up */
+		if (r < 0 && t->pid == 0 && t->desc.postfork)
+			t->desc.postfork(&t->desc);
 	}
 
 	if (r >= 0) {
+		for (size_t i = 0; i < runner->nslots; i++) {
+			if (!runner->slots[i]) {
+				runner->slots[i] = true;
+				t->slot = i;
+				break;
+			}
+		}
 		list_remove(&t->node);
 		list_append(&runner->tests_running, &t->node);
 	}
@@ -838,6 +881,24 @@ litest_runner_set_exit_on_fail(struct litest_runner *runner, bool do_exit)
 	runner->exit_on_fail = do_exit;
 }
 
+void
+litest_runner_set_timing_db(struct litest_runner *runner, const char *path)
+{
+	free(runner->timing_db.path);
+	runner->timing_db.path = path ? safe_strdup(path) : NULL;
+}
+
+void
+litest_runner_set_shard(struct litest_runner *runner,
+			unsigned int index,
+			unsigned int count)
+{
+	litest_assert_int_lt(index, count);
+
+	runner->shard.index = index;
+	runner->shard.count = count;
+}
+
 void
 litest_runner_set_setup_funcs(struct litest_runner *runner,
 			      litest_runner_global_setup_func_t setup,
@@ -856,6 +917,7 @@ litest_runner_add_test(struct litest_runner *runner,
 	struct litest_runner_test *t = zalloc(sizeof(*t));
 
 	t->desc = *desc;
+	t->index = runner->ntests++;
 	t->epollfd = -1;
 	t->pidfd = -1;
 	t->timerfd = -1;
@@ -889,8 +951,13 @@ litest_runner_check_finished_tests(struct litest_runner *runner)
 		if (r < 0)
 			litest_runner_test_update_errno(running, -r);
 
+		if (runner->max_forks > 0 && running->desc.postfork)
+			running->desc.postfork(&running->desc);
+
 		litest_runner_log_test_result(runner, running);
 		litest_runner_test_close(running);
+		if (running->slot < runner->nslots)
+			runner->slots[running->slot] = false;
 		list_remove(&running->node);
 		list_append(&runner->tests_complete, &running->node);
 		count++;
@@ -899,6 +966,303 @@ litest_runner_check_finished_tests(struct litest_runner *runner)
 	return count;
 }
 
+static int
+litest_runner_timing_cmp(const void *a, const void *b)
+{
+	const struct litest_runner_timing *ta = a, *tb = b;
+
+	return strcmp(ta->name, tb->name);
+}
+
+static struct litest_runner_timing *
+litest_runner_timing_db_lookup(struct litest_runner *runner,
+			       const char *name,
+			       size_t nentries)
+{
+	struct litest_runner_timing key = { .name = (char *)name };
+
+	if (nentries == 0)
+		return NULL;
+
+	return bsearch(&key, runner->timing_db.entries, nentries,
+		       sizeof(key), litest_runner_timing_cmp);
+}
+
+static void
+litest_runner_timing_db_append(struct litest_runner *runner,
+			       const char *name,
+			       uint64_t duration_millis)
+{
+	size_t n = runner->timing_db.nentries;
+
+	if (n == runner->timing_db.sz) {
+		runner->timing_db.sz = max(n * 2, 256U);
+		runner->timing_db.entries = realloc(runner->timing_db.entries,
+						    runner->timing_db.sz * sizeof(*runner->timing_db.entries));
+		litest_assert_ptr_notnull(runner->timing_db.entries);
+	}
+
+	runner->timing_db.entries[n].name = safe_strdup(name);
+	runner->timing_db.entries[n].duration_millis = duration_millis;
+	runner->timing_db.nentries++;
+}
+
+static void
+litest_runner_timing_db_sort(struct litest_runner *runner)
+{
+	struct litest_runner_timing *entries = runner->timing_db.entries;
+	size_t n = 0;
+
+	if (runner->timing_db.nentries == 0)
+		return;
+
+	qsort(entries, runner->timing_db.nentries, sizeof(*entries),
+	      litest_runner_timing_cmp);
+
+	/* Databases merged from several shards may have duplicates,
+	 * keep the longer duration */
+	for (size_t i = 1; i < runner->timing_db.nentries; i++) {
+		if (streq(entries[n].name, entries[i].name)) {
+			entries[n].duration_millis = max(entries[n].duration_millis,
+							 entries[i].duration_millis);
+			free(entries[i].name);
+		} else {
+			entries[++n] = entries[i];
+		}
+	}
+	runner->timing_db.nentries = n + 1;
+}
+
+/**
+ * The timing database is a text file with one line per test in the
+ * format "<duration in ms> <test name>". Lines starting with # are
+ * ignored.
+ */
+static void
+litest_runner_timing_db_load(struct litest_runner *runner)
+{
+	_autofclose_ FILE *fp = fopen(runner->timing_db.path, "r");
+	char line[1024];
+
+	if (!fp)
+		return;
+
+	while (fgets(line, sizeof(line), fp)) {
+		uint64_t duration;
+		int offset = 0;
+
+		line[strcspn(line, "\n")] = '\0';
+		if (line[0] == '#')
+			continue;
+
+		if (sscanf(line, "%" SCNu64 " %n", &duration, &offset) != 1 ||
+		    offset == 0 || line[offset] == '\0')
+			continue;
+
+		litest_runner_timing_db_append(runner, &line[offset], duration);
+	}
+
+	litest_runner_timing_db_sort(runner);
+}
+
+static void
+litest_runner_timing_db_save(struct litest_runner *runner)
+{
+	struct litest_runner_test *t;
+	size_t nentries = runner->timing_db.nentries;
+
+	/* Entries for tests that didn't run this time (filtered out or
+	 * in a different shard) are kept as-is */
+	list_for_each(t, &runner->tests_complete, node) {
+		uint64_t duration = t->times.end_millis - t->times.start_millis;
+		struct litest_runner_timing *e;
+
+		if (t->result == LITEST_SYSTEM_ERROR)
+			continue;
+
+		e = litest_runner_timing_db_lookup(runner, t->desc.name, nentries);
+		if (e)
+			e->duration_millis = duration;
+		else
+			litest_runner_timing_db_append(runner, t->desc.name, duration);
+	}
+	litest_runner_timing_db_sort(runner);
+
+	_autofree_ char *tmppath = strdup_printf("%s.XXXXXX", runner->timing_db.path);
+	int fd = mkstemp(tmppath);
+	if (fd == -1) {
+		fprintf(stderr, "Failed to write timing db %s: %m\n", runner->timing_db.path);
+		return;
+	}
+
+	_autofclose_ FILE *fp = fdopen(fd, "w");
+	if (!fp) {
+		close(fd);
+		unlink(tmppath);
+		return;
+	}
+
+	fprintf(fp, "# litest timing database: <duration in ms> <test name>\n");
+	for (size_t i = 0; i < runner->timing_db.nentries; i++) {
+		fprintf(fp, "%" PRIu64 " %s\n",
+			runner->timing_db.entries[i].duration_millis,
+			runner->timing_db.entries[i].name);
+	}
+
+	if (fflush(fp) != 0 || rename(tmppath, runner->timing_db.path) != 0) {
+		fprintf(stderr, "Failed to write timing db %s: %m\n", runner->timing_db.path);
+		unlink(tmppath);
+	}
+}
+
+static int
+litest_runner_test_schedule_cmp(const void *a, const void *b)
+{
+	const struct litest_runner_test *ta = *(struct litest_runner_test * const *)a;
+	const struct litest_runner_test *tb = *(struct litest_runner_test * const *)b;
+
+	if (ta->estimate_millis != tb->estimate_millis)
+		return ta->estimate_millis > tb->estimate_millis ? -1 : 1;
+
+	return ta->index < tb->index ? -1 : ta->index > tb->index;
+}
+
+/**
+ * Sort the tests longest-first based on the timing db and drop the ones
+ * that are not in our shard.
+ *
+ * Shards are assigned greedily to the shard with the least estimated
+ * work so far, the result is the same on every machine as long as they
+ * run the same set of tests with the same timing db.
+ */
+static void
+litest_runner_schedule_tests(struct litest_runner *runner)
+{
+	size_t ntests = list_length(&runner->tests);
+	size_t nknown = 0;
+	uint64_t known_total = 0;
+	struct litest_runner_test *t;
+
+	if (ntests == 0)
+		return;
+
+	_autofree_ struct litest_runner_test **tests = zalloc(ntests * sizeof(*tests));
+	size_t idx = 0;
+	list_for_each(t, &runner->tests, node) {
+		struct litest_runner_timing *e;
+
+		e = litest_runner_timing_db_lookup(runner,
+						   t->desc.name,
+						   runner->timing_db.nentries);
+		if (e) {
+			t->estimate_millis = e->duration_millis;
+			known_total += e->duration_millis;
+			nknown++;
+		} else {
+			t->estimate_millis = UINT64_MAX;
+		}
+		tests[idx++] = t;
+	}
+
+	/* Tests we haven't seen before are assumed to be average */
+	uint64_t guess = nknown > 0 ? known_total / nknown : 0;
+	for (idx = 0; idx < ntests; idx++) {
+		if (tests[idx]->estimate_millis == UINT64_MAX)
+			tests[idx]->estimate_millis = guess;
+	}
+
+	qsort(tests, ntests, sizeof(*tests), litest_runner_test_schedule_cmp);
+
+	if (runner->shard.count > 0) {
+		_autofree_ uint64_t *load = zalloc(runner->shard.count * sizeof(*load));
+
+		for (idx = 0; idx < ntests; idx++) {
+			unsigned int shard = 0;
+
+			for (unsigned int s = 1; s < runner->shard.count; s++) {
+				if (load[s] < load[shard])
+					shard = s;
+			}
+			/* All-zero estimates must still spread the tests */
+			load[shard] += max(tests[idx]->estimate_millis, 1U);
+
+			if (shard != runner->shard.index) {
+				litest_runner_test_destroy(tests[idx]);
+				tests[idx] = NULL;
+			}
+		}
+	}
+
+	for (idx = 0; idx < ntests; idx++) {
+		if (!tests[idx])
+			continue;
+		list_remove(&tests[idx]->node);
+		list_append(&runner->tests, &tests[idx]->node);
+	}
+}
+
+/**
+ * The wall-clock time is determined by the job slot that finished last,
+ * print what it spent its time on.
+ */
+static void
+litest_runner_print_critical_path(struct litest_runner *runner)
+{
+	struct litest_runner_test *t, *last = NULL;
+	struct litest_runner_test *longest[5] = {0};
+	uint64_t busy = 0, longest_test = 0;
+	uint64_t path_busy = 0;
+	size_t path_ntests = 0;
+
+	list_for_each(t, &runner->tests_complete, node) {
+		uint64_t duration = t->times.end_millis - t->times.start_millis;
+
+		busy += duration;
+		longest_test = max(longest_test, duration);
+		if (!last || t->times.end_millis >= last->times.end_millis)
+			last = t;
+	}
+
+	if (!last)
+		return;
+
+	list_for_each(t, &runner->tests_complete, node) {
+		uint64_t duration = t->times.end_millis - t->times.start_millis;
+
+		if (t->slot != last->slot)
+			continue;
+
+		path_busy += duration;
+		path_ntests++;
+
+		for (size_t i = 0; i < ARRAY_LENGTH(longest); i++) {
+			if (!longest[i] ||
+			    duration > longest[i]->times.end_millis - longest[i]->times.start_millis) {
+				memmove(&longest[i + 1], &longest[i],
+					(ARRAY_LENGTH(longest) - i - 1) * sizeof(*longest));
+				longest[i] = t;
+				break;
+			}
+		}
+	}
+
+	fprintf(runner->fp, "critical-path:\n");
+	fprintf(runner->fp, "  duration: %" PRIu64 "  # (ms) until the last test finished\n",
+		last->times.end_millis - runner->times.start_millis);
+	fprintf(runner->fp, "  busy: %" PRIu64 "  # (ms) spent in the %zu tests of the last job\n",
+		path_busy, path_ntests);
+	fprintf(runner->fp, "  lower-bound: %" PRIu64 "  # (ms) max(longest test, all tests / jobs)\n",
+		max(longest_test, busy / max(runner->nslots, 1U)));
+	fprintf(runner->fp, "  longest:\n");
+	ARRAY_FOR_EACH(longest, l) {
+		if (!*l)
+			break;
+		fprintf(runner->fp, "    - name: \"%s\"\n", (*l)->desc.name);
+		fprintf(runner->fp, "      duration: %" PRIu64 "  # (ms)\n",
+			(*l)->times.end_millis - (*l)->times.start_millis);
+	}
+}
+
 static void
 runner_sighandler(int sig)
 {
@@ -939,6 +1303,13 @@ litest_runner_run_tests(struct litest_runner *runner)
 
 	global_runner = runner; /* sigh, need this for signal handling */
 
+	runner->nslots = available_jobs;
+	runner->slots = zalloc(runner->nslots * sizeof(*runner->slots));
+
+	if (runner->timing_db.path)
+		litest_runner_timing_db_load(runner);
+	litest_runner_schedule_tests(runner);
+
 	if (runner->global.setup)
 		runner->global.setup(runner->global.userdata);
 
@@ -955,6 +1326,9 @@ litest_runner_run_tests(struct litest_runner *runner)
 	strftime(timestamp, sizeof(timestamp), "%FT%H:%M", ltime);
 	fprintf(runner->fp, "start: %ld  # \"%s\"\n", runner->times.start, timestamp);
 	fprintf(runner->fp, "jobs: %zd\n", runner->max_forks);
+	if (runner->shard.count > 0)
+		fprintf(runner->fp, "shard: %u/%u\n",
+			runner->shard.index + 1, runner->shard.count);
 	fprintf(runner->fp, "tests:\n");
 	list_for_each_safe(t, &runner->tests, node) {
 		int r = litest_runner_run_test(runner, t);
@@ -1000,6 +1374,9 @@ litest_runner_run_tests(struct litest_runner *runner)
 	if (runner->global.teardown)
 		runner->global.teardown(runner->global.userdata);
 
+	if (runner->timing_db.path)
+		litest_runner_timing_db_save(runner);
+
 	size_t npass = 0, nfail = 0, nskip = 0, nna = 0;
 	size_t ncomplete = 0;
 
@@ -1032,6 +1409,7 @@ litest_runner_run_tests(struct litest_runner *runner)
 		runner->times.end - runner->times.start,
 		(runner->times.end - runner->times.start) / 60,
 		(runner->times.end - runner->times.start) % 60);
+	litest_runner_print_critical_path(runner);
 	fprintf(runner->fp, "summary:\n");
 	fprintf(runner->fp, "  completed: %zd\n", ncomplete);
 	fprintf(runner->fp, "  pass: %zd\n", npass);
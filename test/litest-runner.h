@@ -139,6 +139,11 @@ struct litest_runner_test_description {
 	void (*setup)(const struct litest_runner_test_description *);
 	void (*teardown)(const struct litest_runner_test_description *);
 
+	/* called in the runner process before a test is forked and
+	 * after the forked test has completed, if any */
+	void (*prefork)(const struct litest_runner_test_description *);
+	void (*postfork)(const struct litest_runner_test_description *);
+
 	struct {
 		struct range range;	/* The range this test applies to */
 		int signal;		/* expected signal for fail tests */
@@ -160,6 +165,21 @@ void litest_runner_set_verbose(struct litest_runner *runner, bool verbose);
 void litest_runner_set_use_colors(struct litest_runner *runner, bool use_colors);
 void litest_runner_set_exit_on_fail(struct litest_runner *runner, bool do_exit);
 void litest_runner_set_output_file(struct litest_runner *runner, FILE *fp);
+
+/**
+ * Read the test durations of previous runs from the given file to
+ * schedule the longest tests first and write the updated durations back
+ * to it when the tests complete.
+ */
+void litest_runner_set_timing_db(struct litest_runner *runner, const char *path);
+
+/**
+ * Only run the tests of the given 0-based shard index out of count
+ * shards.
+ */
+void litest_runner_set_shard(struct litest_runner *runner,
+			     unsigned int index,
+			     unsigned int count);
 void litest_runner_add_test(struct litest_runner *runner,
 			    const struct litest_runner_test_description *t);
 enum litest_runner_result litest_runner_run_tests(struct litest_runner *runner);
@@ -29,6 +29,7 @@
 #include <fcntl.h>
 #include <fnmatch.h>
 #include <getopt.h>
+#include <inttypes.h>
 #include <poll.h>
 #include <signal.h>
 #include <stdint.h>
@@ -60,6 +61,7 @@
 #include "litest-runner.h"
 #include "litest-int.h"
 #include "libinput-util.h"
+#include "libinput-private-api.h"
 #include "quirks.h"
 #include "builddir.h"
 
@@ -81,9 +83,18 @@
 bool verbose = false;
 bool in_debugger = false;
 bool run_deviceless = false;
+bool run_without_uinput = false;
+/* The clock of all contexts with --no-uinput in µs. Every test is forked
+ * and starts at the same time, the clock only advances when the test
+ * says so, see litest_clock_now() */
+static uint64_t test_clock = 1000000000;
+static bool disable_test_clock = false;
 static bool use_system_rules_quirks = false;
 static bool exit_first = false;
 static FILE * outfile = NULL;
+static char *timing_db = NULL;
+static unsigned int shard_index = 0;
+static unsigned int shard_count = 0;
 static const char *filter_test = NULL;
 static const char *filter_device = NULL;
 static const char *filter_group = NULL;
@@ -123,6 +134,12 @@ struct suite *current_suite = NULL;
 static void litest_init_udev_rules(struct list *created_files_list);
 static void litest_remove_udev_rules(struct list *created_files_list);
 static void litest_print_event(struct libinput_event *event, const char *message);
+static void litest_device_pool_reset(struct libevdev_uinput *uinput,
+				     const struct input_absinfo *absinfo);
+static void litest_device_pool_prefork(const struct litest_runner_test_description *desc);
+static void litest_device_pool_prefork_no_pool(const struct litest_runner_test_description *desc);
+static void litest_device_pool_postfork(const struct litest_runner_test_description *desc);
+static void litest_device_pool_destroy(void);
 
 enum quirks_setup_mode {
 	QUIRKS_SETUP_USE_SRCDIR,
@@ -638,10 +655,14 @@ grab_device(struct litest_device *device, bool mode)
 {
 	struct libinput *li = libinput_device_get_context(device->libinput_device);
 	struct litest_context *ctx = libinput_get_user_data(li);
-	_unref_(udev_device) *udev_device;
+	_unref_(udev_device) *udev_device = NULL;
 	const char *devnode;
 	struct path *p;
 
+	/* fake devices don't reach anyone else */
+	if (device->fake)
+		return;
+
 	udev_device = libinput_device_get_udev_device(device->libinput_device);
 	litest_assert_ptr_notnull(udev_device);
 
@@ -688,6 +709,37 @@ void litest_generic_device_teardown(void)
 
 static struct list devices = LIST_INIT(devices); /* struct litest_test_device */
 
+/* uinput devices created by the runner process and handed to the forked
+ * tests, so the kernel device and its udev processing outlive the test.
+ * Only the libinput context is new for each test. */
+struct litest_device_pool_entry {
+	struct list link;
+	enum litest_device_type which;
+	struct libevdev_uinput *uinput;
+	const struct litest_runner_test_description *user; /* NULL if idle */
+	uint64_t last_used;
+};
+
+static struct {
+	bool enabled;
+	size_t max_entries;
+	struct list entries;
+	size_t nentries;
+	uint64_t serial;
+	/* Set before the fork, in the test: the entry for this test */
+	struct litest_device_pool_entry *claimed;
+	struct {
+		uint64_t reused;
+		uint64_t created;
+		uint64_t evicted;
+		uint64_t bypassed;
+		uint64_t unpooled;
+	} stats;
+} device_pool = {
+	.enabled = true,
+	.entries = LIST_INIT(device_pool.entries),
+};
+
 void litest_add_test_device(struct list *device)
 {
 	list_append(&devices, device);
@@ -738,6 +790,9 @@ litest_add_tcase_for_device(struct suite *suite,
 	if (run_deviceless)
 		return;
 
+	if (run_without_uinput && !suite->uinput_optional)
+		return;
+
 	if (!range)
 		range = &no_range;
 
@@ -753,6 +808,7 @@ litest_add_tcase_for_device(struct suite *suite,
 			t->setup = dev->setup;
 			t->teardown = dev->teardown ?
 					dev->teardown : litest_generic_device_teardown;
+			t->no_device_pool = suite->no_device_pool;
 			if (range)
 				t->range = *range;
 			t->rangeval = rangeval;
@@ -816,6 +872,7 @@ permutation_func(struct litest_parameters_permutation *permutation, void *userda
 		t->setup = data->dev->setup;
 		t->teardown = data->dev->teardown ?
 				data->dev->teardown : litest_generic_device_teardown;
+		t->no_device_pool = data->suite->no_device_pool;
 	} else {
 		t->devname = safe_strdup(data->devname);
 		t->setup = NULL;
@@ -839,6 +896,9 @@ litest_add_tcase_for_device_with_params(struct suite *suite,
 	if (run_deviceless)
 		return;
 
+	if (run_without_uinput && !suite->uinput_optional)
+		return;
+
 	struct permutation_userdata data = {
 		.suite = suite,
 		.funcname = funcname,
@@ -866,6 +926,9 @@ litest_add_tcase_no_device(struct suite *suite,
 	if (run_deviceless)
 		return;
 
+	if (run_without_uinput && !suite->uinput_optional)
+		return;
+
 	if (!range)
 		range = &no_range;
 
@@ -904,6 +967,9 @@ litest_add_tcase_no_device_with_params(struct suite *suite,
 	if (run_deviceless)
 		return;
 
+	if (run_without_uinput && !suite->uinput_optional)
+		return;
+
 	struct permutation_userdata data = {
 		.suite = suite,
 		.funcname = funcname,
@@ -1507,6 +1573,7 @@ init_quirks(void *userdata)
 static void
 teardown_quirks(void *userdata)
 {
+	litest_device_pool_destroy();
 	quirks_context_unref(quirks_context);
 }
 
@@ -1519,12 +1586,18 @@ litest_run_suite(struct list *suites, int njobs)
 	_destroy_(litest_runner) *runner = litest_runner_new();
 
 	litest_runner_set_num_parallel(runner, njobs > 0 ? njobs : 0);
+	/* Four devices per job but at least 32, enough for a single job
+	 * to keep the devices of a few tests around */
+	device_pool.max_entries = njobs > 0 ? max(njobs * 4, 32) : 0;
 	if (outfile)
 		litest_runner_set_output_file(runner, outfile);
 	litest_runner_set_verbose(runner, verbose);
 	litest_runner_set_use_colors(runner, use_colors);
 	litest_runner_set_timeout(runner, 30);
 	litest_runner_set_exit_on_fail(runner, exit_first);
+	litest_runner_set_timing_db(runner, timing_db);
+	if (shard_count > 0)
+		litest_runner_set_shard(runner, shard_index, shard_count);
 	litest_runner_set_setup_funcs(runner, init_quirks, teardown_quirks, NULL);
 
 	list_for_each(s, suites, node) {
@@ -1569,6 +1642,15 @@ litest_run_suite(struct list *suites, int njobs)
 			tdesc.args.range = t->range;
 			tdesc.rangeval = t->rangeval;
 			tdesc.params = t->params;
+			if (device_pool.enabled) {
+				tdesc.prefork = t->no_device_pool ?
+					litest_device_pool_prefork_no_pool :
+					litest_device_pool_prefork;
+				tdesc.postfork = litest_device_pool_postfork;
+			} else if (!run_without_uinput) {
+				/* Only to count the devices for comparison */
+				tdesc.prefork = litest_device_pool_prefork_no_pool;
+			}
 			litest_runner_add_test(runner, &tdesc);
 			ntests++;
 		}
@@ -1590,7 +1672,7 @@ inhibit(void)
 	_unref_(sd_bus) *bus = NULL;
 	int rc;
 
-	if (run_deviceless)
+	if (run_deviceless || run_without_uinput)
 		return -1;
 
 	rc = sd_bus_open_system(&bus);
@@ -1687,6 +1769,11 @@ litest_run(struct list *suites, int njobs)
 	if (run_deviceless) {
 		litest_setup_quirks(&created_files_list,
 				    QUIRKS_SETUP_USE_SRCDIR);
+	} else if (run_without_uinput) {
+		/* No udev rules, the fake devices apply the properties
+		 * themselves */
+		litest_setup_quirks(&created_files_list,
+				    QUIRKS_SETUP_FULL);
 	} else {
 		enum quirks_setup_mode mode;
 		litest_init_udev_rules(&created_files_list);
@@ -1701,7 +1788,7 @@ litest_run(struct list *suites, int njobs)
 	 * avoid messing up our host. But if we're inside gdb or running
 	 * without forking, leave it as-is.
 	 */
-	if (!run_deviceless && njobs > 1 && !in_debugger)
+	if (!run_deviceless && !run_without_uinput && njobs > 1 && !in_debugger)
 		tty_mode = disable_tty();
 
 	inhibit_lock_fd = inhibit();
@@ -1964,7 +2051,13 @@ litest_setup_quirks(struct list *created_files_list,
 {
 	struct created_file *file = NULL;
 	const char *dirname;
-	char tmpdir[] = "/run/litest-XXXXXX";
+	char tmpdir[PATH_MAX];
+	const char *rundir = "/run";
+
+	/* /run needs root, --no-uinput doesn't */
+	if (run_without_uinput)
+		rundir = getenv("TMPDIR") ? getenv("TMPDIR") : "/tmp";
+	snprintf(tmpdir, sizeof(tmpdir), "%s/litest-XXXXXX", rundir);
 
 	switch (mode) {
 	case QUIRKS_SETUP_USE_SRCDIR:
@@ -2006,7 +2099,8 @@ litest_remove_udev_rules(struct list *created_files_list)
 	struct created_file *f;
 	bool reload_udev;
 
-	reload_udev = !list_empty(created_files_list);
+	/* with --no-uinput, the list only has the quirks */
+	reload_udev = !run_without_uinput && !list_empty(created_files_list);
 
 	list_for_each_safe(f, created_files_list, link) {
 		created_file_unlink(f);
@@ -2017,8 +2111,25 @@ litest_remove_udev_rules(struct list *created_files_list)
 		litest_reload_udev_rules();
 }
 
+void
+litest_create_kernel_device(struct litest_device *d,
+			    const char *name,
+			    const struct input_id *id,
+			    const struct input_absinfo *abs,
+			    const int *events)
+{
+	if (run_without_uinput)
+		d->fake = litest_fake_device_new(name, id, abs, events, &devices);
+	else
+		d->uinput = litest_create_uinput_device_from_description(name,
+									 id,
+									 abs,
+									 events);
+}
+
 /**
- * Creates a uinput device but does not add it to a libinput context
+ * Creates a uinput device (or a fake device with --no-uinput) but does
+ * not add it to a libinput context
  */
 struct litest_device *
 litest_create(enum litest_device_type which,
@@ -2066,10 +2177,19 @@ litest_create(enum litest_device_type which,
 	id = id_override ? id_override : dev->id;
 
 	if (create_device) {
-		d->uinput = litest_create_uinput_device_from_description(name,
-									 id,
-									 abs,
-									 events);
+		struct litest_device_pool_entry *pooled = device_pool.claimed;
+
+		if (pooled && pooled->which == which &&
+		    !name_override && !id_override &&
+		    !abs_override && !events_override) {
+			/* Only the first device of this type in a test */
+			device_pool.claimed = NULL;
+			d->uinput = pooled->uinput;
+			d->pooled = true;
+			litest_device_pool_reset(d->uinput, abs);
+		} else {
+			litest_create_kernel_device(d, name, id, abs, events);
+		}
 		d->interface = dev->interface;
 
 		for (e = events; *e != -1; e += 2) {
@@ -2084,6 +2204,11 @@ litest_create(enum litest_device_type which,
 		}
 	}
 
+	if (d->fake) {
+		d->evdev = litest_fake_device_new_evdev(d->fake);
+		return d;
+	}
+
 	path = libevdev_uinput_get_devnode(d->uinput);
 	litest_assert_ptr_notnull(path);
 	fd = open(path, O_RDWR|O_NONBLOCK);
@@ -2096,6 +2221,12 @@ litest_create(enum litest_device_type which,
 
 }
 
+static uint64_t
+litest_clock(struct libinput *libinput, void *user_data)
+{
+	return test_clock;
+}
+
 struct libinput *
 litest_create_context(void)
 {
@@ -2112,6 +2243,11 @@ litest_create_context(void)
 	if (verbose)
 		libinput_log_set_priority(libinput, LIBINPUT_LOG_PRIORITY_DEBUG);
 
+	if (litest_has_test_clock()) {
+		int rc = libinput_set_clock(libinput, litest_clock, NULL);
+		litest_assert_neg_errno_success(rc);
+	}
+
 	return libinput;
 }
 
@@ -2205,14 +2341,20 @@ litest_add_device_with_overrides(struct libinput *libinput,
 			  abs_override,
 			  events_override);
 
-	path = libevdev_uinput_get_devnode(d->uinput);
-	litest_assert_ptr_notnull(path);
-
 	d->libinput = libinput;
-	d->libinput_device = libinput_path_add_device(d->libinput, path);
-	litest_assert_ptr_notnull(d->libinput_device);
-	_unref_(udev_device) *ud = libinput_device_get_udev_device(d->libinput_device);
-	d->quirks = quirks_fetch_for_device(quirks_context, ud);
+	if (d->fake) {
+		d->libinput_device = litest_fake_device_add(d->fake, libinput);
+		litest_assert_ptr_notnull(d->libinput_device);
+		d->quirks = litest_fake_device_fetch_quirks(d->fake, quirks_context);
+	} else {
+		path = libevdev_uinput_get_devnode(d->uinput);
+		litest_assert_ptr_notnull(path);
+
+		d->libinput_device = libinput_path_add_device(d->libinput, path);
+		litest_assert_ptr_notnull(d->libinput_device);
+		_unref_(udev_device) *ud = libinput_device_get_udev_device(d->libinput_device);
+		d->quirks = quirks_fetch_for_device(quirks_context, ud);
+	}
 
 	libinput_device_ref(d->libinput_device);
 
@@ -2332,10 +2474,14 @@ litest_device_destroy(struct litest_device *d)
 	if (!d)
 		return;
 
-	udev_monitor = udev_setup_monitor();
-	snprintf(path, sizeof(path),
-		 "%s/event",
-		 libevdev_uinput_get_syspath(d->uinput));
+	/* pooled devices are kept alive by the runner process, fake
+	 * devices have no udev device */
+	if (!d->pooled && !d->fake) {
+		udev_monitor = udev_setup_monitor();
+		snprintf(path, sizeof(path),
+			 "%s/event",
+			 libevdev_uinput_get_syspath(d->uinput));
+	}
 
 	litest_assert_int_eq(d->skip_ev_syn, 0);
 
@@ -2349,18 +2495,375 @@ litest_device_destroy(struct litest_device *d)
 		libinput_dispatch(d->libinput);
 		litest_destroy_context(d->libinput);
 	}
-	close(libevdev_get_fd(d->evdev));
+	if (!d->fake)
+		close(libevdev_get_fd(d->evdev));
 	libevdev_free(d->evdev);
-	libevdev_uinput_destroy(d->uinput);
+	if (d->fake)
+		litest_fake_device_destroy(d->fake);
+	else if (!d->pooled)
+		libevdev_uinput_destroy(d->uinput);
 	free(d->private);
 	memset(d,0, sizeof(*d));
 	free(d);
 
+	if (udev_monitor)
+		udev_device = udev_wait_for_device_event(udev_monitor, // NOLINT: deadcode.DeadStores
+							 "remove",
+							 path);
+}
+
+/**
+ * Bring a pooled device back to its initial state: the previous test
+ * may have crashed or timed out with keys down or touches active.
+ * Called before any libinput context opens the device so the context
+ * never sees these events.
+ */
+/* The value litest_create_uinput() gives a new device from this
+ * description: described axes start at their minimum, all others at
+ * default_abs.value */
+static int
+litest_initial_abs_value(const struct input_absinfo *absinfo, unsigned int code)
+{
+	for (const struct input_absinfo *a = absinfo; a && a->value != -1; a++) {
+		if ((unsigned int)a->value == code)
+			return a->minimum;
+	}
+
+	return 0;
+}
+
+static void
+litest_device_pool_reset(struct libevdev_uinput *uinput,
+			 const struct input_absinfo *absinfo)
+{
+	struct libevdev *evdev;
+	int fuzz[ABS_CNT] = {0};
+	int fd, rc;
+
+	fd = open(libevdev_uinput_get_devnode(uinput), O_RDWR|O_NONBLOCK);
+	litest_assert_errno_success(fd);
+	rc = libevdev_new_from_fd(fd, &evdev);
+	litest_assert_neg_errno_success(rc);
+
+	for (unsigned int code = 0; code <= KEY_MAX; code++) {
+		if (libevdev_has_event_code(evdev, EV_KEY, code) &&
+		    libevdev_get_event_value(evdev, EV_KEY, code))
+			libevdev_uinput_write_event(uinput, EV_KEY, code, 0);
+	}
+
+	for (unsigned int code = 0; code <= SW_MAX; code++) {
+		if (libevdev_has_event_code(evdev, EV_SW, code) &&
+		    libevdev_get_event_value(evdev, EV_SW, code))
+			libevdev_uinput_write_event(uinput, EV_SW, code, 0);
+	}
+
+	/* The kernel filters out any change smaller than the fuzz, drop
+	 * the fuzz while we reset the axes and restore it afterwards */
+	for (unsigned int code = 0; code <= ABS_MAX; code++) {
+		struct input_absinfo abs;
+
+		if (code == ABS_MT_SLOT ||
+		    !libevdev_has_event_code(evdev, EV_ABS, code))
+			continue;
+
+		abs = *libevdev_get_abs_info(evdev, code);
+		fuzz[code] = abs.fuzz;
+		if (abs.fuzz == 0)
+			continue;
+
+		abs.fuzz = 0;
+		rc = libevdev_kernel_set_abs_info(evdev, code, &abs);
+		litest_assert_neg_errno_success(rc);
+	}
+
+	/* uinput initializes the slots to zero and tracking IDs to -1 */
+	for (int slot = 0; slot < libevdev_get_num_slots(evdev); slot++) {
+		libevdev_uinput_write_event(uinput, EV_ABS, ABS_MT_SLOT, slot);
+		for (unsigned int code = ABS_MT_TOUCH_MAJOR; code <= ABS_MT_TOOL_Y; code++) {
+			if (libevdev_has_event_code(evdev, EV_ABS, code))
+				libevdev_uinput_write_event(uinput, EV_ABS, code,
+							    code == ABS_MT_TRACKING_ID ? -1 : 0);
+		}
+	}
+
+	/* libinput may have changed the axis ranges through quirks, reset
+	 * to what the description says, not the current minimum */
+	for (unsigned int code = 0; code <= ABS_MT_SLOT; code++) {
+		if (libevdev_has_event_code(evdev, EV_ABS, code))
+			libevdev_uinput_write_event(uinput, EV_ABS, code,
+						    litest_initial_abs_value(absinfo, code));
+	}
+
+	libevdev_uinput_write_event(uinput, EV_SYN, SYN_REPORT, 0);
+
+	for (unsigned int code = 0; code <= ABS_MAX; code++) {
+		struct input_absinfo abs;
+
+		if (fuzz[code] == 0)
+			continue;
+
+		abs = *libevdev_get_abs_info(evdev, code);
+		abs.fuzz = fuzz[code];
+		rc = libevdev_kernel_set_abs_info(evdev, code, &abs);
+		litest_assert_neg_errno_success(rc);
+	}
+
+	for (unsigned int code = 0; code <= LED_MAX; code++) {
+		if (libevdev_has_event_code(evdev, EV_LED, code) &&
+		    libevdev_get_event_value(evdev, EV_LED, code))
+			libevdev_kernel_set_led_value(evdev, code, LIBEVDEV_LED_OFF);
+	}
+
+	libevdev_free(evdev);
+
+	/* Re-read the device state to make sure the reset took effect */
+	rc = libevdev_new_from_fd(fd, &evdev);
+	litest_assert_neg_errno_success(rc);
+
+	for (unsigned int code = 0; code <= KEY_MAX; code++) {
+		if (libevdev_has_event_code(evdev, EV_KEY, code))
+			litest_assert_int_eq(libevdev_get_event_value(evdev, EV_KEY, code), 0);
+	}
+
+	for (unsigned int code = 0; code <= SW_MAX; code++) {
+		if (libevdev_has_event_code(evdev, EV_SW, code))
+			litest_assert_int_eq(libevdev_get_event_value(evdev, EV_SW, code), 0);
+	}
+
+	for (int slot = 0; slot < libevdev_get_num_slots(evdev); slot++) {
+		for (unsigned int code = ABS_MT_TOUCH_MAJOR; code <= ABS_MT_TOOL_Y; code++) {
+			if (libevdev_has_event_code(evdev, EV_ABS, code))
+				litest_assert_int_eq(libevdev_get_slot_value(evdev, slot, code),
+						     code == ABS_MT_TRACKING_ID ? -1 : 0);
+		}
+	}
+
+	for (unsigned int code = 0; code <= ABS_MT_SLOT; code++) {
+		if (libevdev_has_event_code(evdev, EV_ABS, code))
+			litest_assert_int_eq(libevdev_get_event_value(evdev, EV_ABS, code),
+					     litest_initial_abs_value(absinfo, code));
+	}
+
+	for (unsigned int code = 0; code <= LED_MAX; code++) {
+		if (libevdev_has_event_code(evdev, EV_LED, code))
+			litest_assert_int_eq(libevdev_get_event_value(evdev, EV_LED, code), 0);
+	}
+
+	libevdev_free(evdev);
+	close(fd);
+}
+
+static void
+litest_device_pool_entry_destroy(struct litest_device_pool_entry *entry)
+{
+	_unref_(udev_monitor) *udev_monitor = udev_setup_monitor();
+	_unref_(udev_device) *udev_device = NULL;
+	char path[PATH_MAX];
+
+	snprintf(path, sizeof(path),
+		 "%s/event",
+		 libevdev_uinput_get_syspath(entry->uinput));
+
+	libevdev_uinput_destroy(entry->uinput);
+	list_remove(&entry->link);
+	device_pool.nentries--;
+	free(entry);
+
 	udev_device = udev_wait_for_device_event(udev_monitor, // NOLINT: deadcode.DeadStores
 						 "remove",
 						 path);
 }
 
+/* Runs in the runner process before the test is forked */
+static struct litest_test_device *
+litest_device_pool_find_device(const struct litest_runner_test_description *desc)
+{
+	struct litest_test_device *dev;
+
+	/* The TEST_DEVICE setup function is unique per device */
+	list_for_each(dev, &devices, node) {
+		if ((void*)dev->setup == (void*)desc->setup)
+			return dev;
+	}
+
+	return NULL;
+}
+
+static void
+litest_device_pool_prefork(const struct litest_runner_test_description *desc)
+{
+	struct litest_device_pool_entry *entry, *lru = NULL;
+	struct litest_test_device *dev;
+
+	device_pool.claimed = NULL;
+
+	dev = litest_device_pool_find_device(desc);
+	if (!dev)
+		return;
+
+	/* Devices with a custom create function may set up state we
+	 * cannot reset */
+	if (dev->create) {
+		device_pool.stats.unpooled++;
+		return;
+	}
+
+	list_for_each(entry, &device_pool.entries, link) {
+		if (entry->user)
+			continue;
+
+		if (entry->which == dev->type) {
+			device_pool.stats.reused++;
+			goto claim;
+		}
+
+		if (!lru || entry->last_used < lru->last_used)
+			lru = entry;
+	}
+
+	if (device_pool.nentries >= device_pool.max_entries) {
+		if (!lru) {
+			device_pool.stats.bypassed++;
+			return;
+		}
+		litest_device_pool_entry_destroy(lru);
+		device_pool.stats.evicted++;
+	}
+
+	entry = zalloc(sizeof(*entry));
+	entry->which = dev->type;
+	entry->uinput = litest_create_uinput_device_from_description(dev->name,
+								     dev->id,
+								     dev->absinfo,
+								     dev->events);
+	list_append(&device_pool.entries, &entry->link);
+	device_pool.nentries++;
+	device_pool.stats.created++;
+
+claim:
+	entry->user = desc;
+	entry->last_used = ++device_pool.serial;
+	device_pool.claimed = entry;
+}
+
+/* For tests that opted out and with --no-device-pool, only makes sure
+ * the test doesn't pick up the previous test's device and counts the
+ * device the test creates itself */
+static void
+litest_device_pool_prefork_no_pool(const struct litest_runner_test_description *desc)
+{
+	device_pool.claimed = NULL;
+
+	if (litest_device_pool_find_device(desc))
+		device_pool.stats.unpooled++;
+}
+
+/* Runs in the runner process after the forked test has completed */
+static void
+litest_device_pool_postfork(const struct litest_runner_test_description *desc)
+{
+	struct litest_device_pool_entry *entry;
+
+	list_for_each(entry, &device_pool.entries, link) {
+		if (entry->user == desc) {
+			entry->user = NULL;
+			break;
+		}
+	}
+}
+
+static void
+litest_device_pool_destroy(void)
+{
+	struct litest_device_pool_entry *entry;
+	FILE *fp = outfile ? outfile : stderr;
+
+	if (device_pool.stats.created == 0 && device_pool.stats.unpooled == 0)
+		return;
+
+	list_for_each_safe(entry, &device_pool.entries, link)
+		litest_device_pool_entry_destroy(entry);
+
+	fprintf(fp, "device-pool:\n");
+	fprintf(fp, "  created: %" PRIu64 "\n", device_pool.stats.created);
+	fprintf(fp, "  reused: %" PRIu64 "\n", device_pool.stats.reused);
+	fprintf(fp, "  evicted: %" PRIu64 "\n", device_pool.stats.evicted);
+	fprintf(fp, "  bypassed: %" PRIu64 "  # pool was full\n", device_pool.stats.bypassed);
+	fprintf(fp, "  unpooled: %" PRIu64 "  # pool disabled or not possible\n", device_pool.stats.unpooled);
+}
+
+void
+litest_device_pool_opt_out(void)
+{
+	litest_assert_ptr_notnull(current_suite);
+	current_suite->no_device_pool = true;
+}
+
+void
+litest_uinput_optional(void)
+{
+	litest_assert_ptr_notnull(current_suite);
+	current_suite->uinput_optional = true;
+}
+
+bool
+litest_has_uinput(void)
+{
+	return !run_without_uinput;
+}
+
+bool
+litest_has_test_clock(void)
+{
+	return run_without_uinput && !disable_test_clock;
+}
+
+uint64_t
+litest_clock_now(void)
+{
+	uint64_t now;
+
+	if (litest_has_test_clock())
+		return test_clock;
+
+	int rc = now_in_us(&now);
+	litest_assert_neg_errno_success(rc);
+
+	return now;
+}
+
+void
+litest_clock_advance(uint64_t us)
+{
+	litest_assert(litest_has_test_clock());
+	test_clock += us;
+}
+
+void
+litest_msleep(int millis)
+{
+	if (litest_has_test_clock())
+		litest_clock_advance(ms2us(millis));
+	else
+		msleep(millis);
+}
+
+const char *
+litest_device_get_property(struct litest_device *d, const char *key)
+{
+	_unref_(udev_device) *udev_device = NULL;
+
+	if (d->fake)
+		return litest_fake_device_get_property(d->fake, key);
+
+	/* The string belongs to the udev device, libinput keeps that
+	 * around for as long as the device exists */
+	udev_device = libinput_device_get_udev_device(d->libinput_device);
+	litest_assert_ptr_notnull(udev_device);
+
+	return udev_device_get_property_value(udev_device, key);
+}
+
 void
 litest_event(struct litest_device *d, unsigned int type,
 	     unsigned int code, int value)
@@ -2372,6 +2875,15 @@ litest_event(struct litest_device *d, unsigned int type,
 		if (d->skip_ev_syn)
 			return;
 
+		if (d->fake) {
+			litest_fake_device_write_frame(d->fake,
+						       d->frame.events,
+						       d->frame.nevents,
+						       value);
+			d->frame.nevents = 0;
+			return;
+		}
+
 		for (size_t i = 0; i < d->frame.nevents; i++) {
 			struct input_event *e = &d->frame.events[i];
 			int ret = libevdev_uinput_write_event(d->uinput, e->type, e->code, e->value);
@@ -2829,7 +3341,7 @@ litest_touch_move_to_extended(struct litest_device *d,
 					   y_from + (y_to - y_from)/steps * i,
 					   axes);
 		libinput_dispatch(d->libinput);
-		msleep(sleep_ms);
+		litest_msleep(sleep_ms);
 		libinput_dispatch(d->libinput);
 	}
 	litest_touch_move_extended(d, slot, x_to, y_to, axes);
@@ -3036,7 +3548,7 @@ litest_touch_move_two_touches(struct litest_device *d,
 						y1 + dy / steps * i);
 		}
 		libinput_dispatch(d->libinput);
-		msleep(sleep_ms);
+		litest_msleep(sleep_ms);
 		libinput_dispatch(d->libinput);
 	}
 	litest_with_event_frame(d) {
@@ -3066,7 +3578,7 @@ litest_touch_move_three_touches(struct litest_device *d,
 		}
 
 		libinput_dispatch(d->libinput);
-		msleep(sleep_ms);
+		litest_msleep(sleep_ms);
 	}
 	libinput_dispatch(d->libinput);
 }
@@ -3145,7 +3657,7 @@ litest_hover_move_to(struct litest_device *d,
 				  x_from + (x_to - x_from)/steps * i,
 				  y_from + (y_to - y_from)/steps * i);
 		libinput_dispatch(d->libinput);
-		msleep(sleep_ms);
+		litest_msleep(sleep_ms);
 		libinput_dispatch(d->libinput);
 	}
 	litest_hover_move(d, slot, x_to, y_to);
@@ -3168,7 +3680,7 @@ litest_hover_move_two_touches(struct litest_device *d,
 						y1 + dy / steps * i);
 		}
 		libinput_dispatch(d->libinput);
-		msleep(sleep_ms);
+		litest_msleep(sleep_ms);
 		libinput_dispatch(d->libinput);
 	}
 	litest_with_event_frame(d) {
@@ -3477,26 +3989,30 @@ _litest_wait_for_event_of_type(struct libinput *li,
 	fds.revents = 0;
 
 	const int timeout = 2000;
-	uint64_t expiry = 0;
-	int rc = now_in_us(&expiry);
-	expiry += ms2us(timeout);
-	litest_assert_errno_success(rc);
+	uint64_t expiry = litest_clock_now() + ms2us(timeout);
 
 	while (1) {
 		size_t i;
 		enum libinput_event_type type;
 
 		while ((type = libinput_next_event_type(li)) == LIBINPUT_EVENT_NONE) {
-			int rc = poll(&fds, 1, timeout);
-			litest_assert_errno_success(rc);
-			litest_assert_int_gt(rc, 0);
+			if (litest_has_test_clock()) {
+				/* The test clock doesn't make the fd
+				 * readable, we let the time pass until a
+				 * timer expires */
+				if (litest_clock_now() > expiry)
+					break;
+				litest_clock_advance(ms2us(1));
+			} else {
+				int rc = poll(&fds, 1, timeout);
+				litest_assert_errno_success(rc);
+				litest_assert_int_gt(rc, 0);
+			}
 			litest_dispatch(li);
 		}
 
 		if (type == LIBINPUT_EVENT_NONE) {
-			uint64_t now;
-			now_in_us(&now);
-			if (now > expiry) {
+			if (litest_clock_now() > expiry) {
 				_litest_abort_msg(NULL, lineno, func,
 						  "Waited >%dms for events, but no events are pending",
 						  timeout);
@@ -3896,6 +4412,9 @@ litest_create_uinput_device_from_description(const char *name,
 	const char *syspath;
 	char path[PATH_MAX];
 
+	litest_assert_msg(!run_without_uinput,
+			  "uinput devices cannot be created with --no-uinput\n");
+
 	_unref_(udev_monitor) *udev_monitor = udev_setup_monitor();
 	_unref_(udev_device) *udev_device = NULL;
 
@@ -4758,7 +5277,7 @@ _litest_timeout(struct libinput *li, const char *func, int lineno, int millis)
 {
        if (li)
                _litest_dispatch(li, func, lineno);
-       msleep(millis);
+       litest_msleep(millis);
        if (li)
                _litest_dispatch(li, func, lineno);
 }
@@ -5068,6 +5587,11 @@ litest_parse_argv(int argc, char **argv, int *njobs_out)
 		OPT_JOBS,
 		OPT_LIST,
 		OPT_VERBOSE,
+		OPT_SHARD,
+		OPT_TIMING_DB,
+		OPT_NO_DEVICE_POOL,
+		OPT_NO_UINPUT,
+		OPT_NO_TEST_CLOCK,
 	};
 	static const struct option opts[] = {
 		{ "filter-test", 1, 0, OPT_FILTER_TEST },
@@ -5081,6 +5605,11 @@ litest_parse_argv(int argc, char **argv, int *njobs_out)
 		{ "jobs", 1, 0, OPT_JOBS },
 		{ "list", 0, 0, OPT_LIST },
 		{ "verbose", 0, 0, OPT_VERBOSE },
+		{ "shard", 1, 0, OPT_SHARD },
+		{ "timing-db", 1, 0, OPT_TIMING_DB },
+		{ "no-device-pool", 0, 0, OPT_NO_DEVICE_POOL },
+		{ "no-uinput", 0, 0, OPT_NO_UINPUT },
+		{ "no-test-clock", 0, 0, OPT_NO_TEST_CLOCK },
 		{ "help", 0, 0, 'h'},
 		{ 0, 0, 0, 0}
 	};
@@ -5090,12 +5619,21 @@ litest_parse_argv(int argc, char **argv, int *njobs_out)
 		JOBS_CUSTOM
 	} want_jobs = JOBS_DEFAULT;
 	char *jobs_env;
+	const char *timing_db_env;
 	int jobs = 0;
+	_autofree_ char *builddir = NULL;
 
 	/* If we are not running from the builddir, we assume we're running
 	 * against the system as installed */
-	if (!builddir_lookup(NULL))
+	if (!builddir_lookup(&builddir))
 		use_system_rules_quirks = true;
+	else
+		timing_db = strdup_printf("%s/litest-timings.txt", builddir);
+
+	if ((timing_db_env = getenv("LITEST_TIMING_DB"))) {
+		free(timing_db);
+		timing_db = strlen(timing_db_env) > 0 ? safe_strdup(timing_db_env) : NULL;
+	}
 
 	if (in_debugger)
 		want_jobs = JOBS_SINGLE;
@@ -5142,6 +5680,19 @@ litest_parse_argv(int argc, char **argv, int *njobs_out)
 			       "	  This overrides the LITEST_JOBS environment variable.\n"
 			       "    --list\n"
 			       "          List all tests\n"
+			       "    --shard=i/n\n"
+			       "          Only run the i-th of n roughly equally long subsets of the tests\n"
+			       "    --no-device-pool\n"
+			       "          Create a new uinput device for every test\n"
+			       "    --no-uinput\n"
+			       "          Use fake devices instead of uinput, this does not need root.\n"
+			       "          Only the test collections that support this are run.\n"
+			       "    --no-test-clock\n"
+			       "          With --no-uinput, run the contexts on CLOCK_MONOTONIC instead of\n"
+			       "          the test clock and sleep for real\n"
+			       "    --timing-db=/path/to/file\n"
+			       "          Read and update the test durations used to schedule the longest\n"
+			       "          tests first. This overrides the LITEST_TIMING_DB environment variable.\n"
 			       "\n"
 			       "See the libinput-test-suite(1) man page for details.\n",
 			       program_invocation_short_name);
@@ -5198,6 +5749,33 @@ litest_parse_argv(int argc, char **argv, int *njobs_out)
 		case OPT_VERBOSE:
 			verbose = true;
 			break;
+		case OPT_SHARD: {
+			size_t n;
+			_autostrvfree_ char **strv = strv_from_string(optarg, "/", &n);
+			if (n != 2 ||
+			    !safe_atou(strv[0], &shard_index) ||
+			    !safe_atou(strv[1], &shard_count) ||
+			    shard_index < 1 || shard_index > shard_count) {
+				fprintf(stderr, "Invalid shard '%s', expected i/n with 1 <= i <= n\n", optarg);
+				exit(1);
+			}
+			shard_index--;
+			break;
+		}
+		case OPT_NO_DEVICE_POOL:
+			device_pool.enabled = false;
+			break;
+		case OPT_NO_UINPUT:
+			run_without_uinput = true;
+			device_pool.enabled = false;
+			break;
+		case OPT_NO_TEST_CLOCK:
+			disable_test_clock = true;
+			break;
+		case OPT_TIMING_DB:
+			free(timing_db);
+			timing_db = strlen(optarg) > 0 ? safe_strdup(optarg) : NULL;
+			break;
 		case OPT_OUTPUT_FILE:
 			outfile = fopen(optarg, "w+");
 			if (!outfile) {
@@ -427,6 +427,7 @@ enum litest_device_type {
 	LITEST_SYNAPTICS_CLICKPAD_X220,
 	LITEST_SYNAPTICS_HOVER_SEMI_MT,
 	LITEST_SYNAPTICS_I2C,
+	LITEST_SYNAPTICS_I2C_MSC_TIMESTAMP,
 	LITEST_SYNAPTICS_PHANTOMCLICKS,
 	LITEST_SYNAPTICS_PRESSUREPAD,
 	LITEST_SYNAPTICS_RMI4,
@@ -464,6 +465,7 @@ enum litest_device_type {
 	LITEST_KEYBOARD_BLADE_STEALTH_VIDEOSWITCH,
 	LITEST_KEYBOARD_LOGITECH_MEDIA_KEYBOARD_ELITE,
 	LITEST_KEYBOARD_QUIRKED,
+	LITEST_KEYBOARD_REMAPPED,
 	LITEST_LENOVO_SCROLLPOINT,
 	LITEST_LOGITECH_TRACKBALL,
 	LITEST_MAGICMOUSE,
@@ -472,6 +474,7 @@ enum litest_device_type {
 	LITEST_MOUSE_LOW_DPI,
 	LITEST_MOUSE_ROCCAT,
 	LITEST_MOUSE_VIRTUAL,
+	LITEST_MOUSE_MOTION_RATE,
 	LITEST_MOUSE_WHEEL_CLICK_ANGLE,
 	LITEST_MOUSE_WHEEL_CLICK_COUNT,
 	LITEST_MOUSE_WHEEL_TILT,
@@ -525,9 +528,15 @@ enum litest_device_type {
 	LITEST_WACOM_ISDV4_4200_PEN,
 	LITEST_WACOM_ISDV4_524C_PEN,
 	LITEST_WACOM_MOBILESTUDIO_PRO_16_PAD,
+	LITEST_WACOM_MOBILESTUDIO_PRO_16_PAD_LEDS,
 	LITEST_WALTOP,
 };
 
+/* The fake sysfs directory of the LITEST_WACOM_MOBILESTUDIO_PRO_16_PAD_LEDS
+ * status LEDs, the brightness files are in
+ * LITEST_PAD_LEDS_SYSFS_PATH/wacom-<group>.<mode>/brightness */
+#define LITEST_PAD_LEDS_SYSFS_PATH "/run/litest-pad-leds"
+
 #define LITEST_DEVICELESS	-2
 #define LITEST_DISABLE_DEVICE	-1
 #define LITEST_ANY		0
@@ -591,6 +600,8 @@ struct litest_device {
 	struct libinput *libinput;
 	struct quirks *quirks;
 	bool owns_context;
+	bool pooled; /* uinput device is owned by the device pool */
+	struct litest_fake_device *fake; /* set instead of uinput with --no-uinput */
 	struct libinput_device *libinput_device;
 	struct litest_device_interface *interface;
 
@@ -851,6 +862,38 @@ litest_add_device_with_overrides(struct libinput *libinput,
 struct litest_device *
 litest_current_device(void);
 
+/**
+ * Tests added after this call in the current TEST_COLLECTION get a newly
+ * created uinput device instead of one from the device pool. Use this
+ * for tests that need the kernel device to go away when the test removes
+ * it.
+ */
+void
+litest_device_pool_opt_out(void);
+
+/**
+ * Tests added after this call in the current TEST_COLLECTION also run
+ * with --no-uinput, where the test devices are fake devices without a
+ * device node or udev device. Tests in such a collection that need
+ * either must check litest_has_uinput() and skip.
+ */
+void
+litest_uinput_optional(void);
+
+/**
+ * @return false if the test devices are fake devices, see
+ * litest_uinput_optional()
+ */
+bool
+litest_has_uinput(void);
+
+/**
+ * @return the value of the device's udev property or NULL. The string is
+ * valid for as long as the device is.
+ */
+const char *
+litest_device_get_property(struct litest_device *d, const char *key);
+
 void
 litest_grab_device(struct litest_device *d);
 
@@ -1323,6 +1366,14 @@ litest_create_uinput_abs_device(const char *name,
 				const struct input_absinfo *abs,
 				...);
 
+/**
+ * Sleep for the given time. With --no-uinput, the test clock advances by
+ * that time instead, use this instead of msleep() in tests that support
+ * fake devices.
+ */
+void
+litest_msleep(int millis);
+
 void
 _litest_timeout(struct libinput *li, const char *func, int lineno, int millis);
 
@@ -1720,20 +1771,14 @@ litest_disable_hold_gestures(struct libinput_device *device)
 static inline bool
 litest_touchpad_is_external(struct litest_device *dev)
 {
-	struct udev_device *udev_device;
 	const char *prop;
-	bool is_external;
 
 	if (libinput_device_get_id_vendor(dev->libinput_device) == VENDOR_ID_WACOM)
 		return true;
 
-	udev_device = libinput_device_get_udev_device(dev->libinput_device);
-	prop = udev_device_get_property_value(udev_device,
-					      "ID_INPUT_TOUCHPAD_INTEGRATION");
-	is_external = prop && streq(prop, "external");
-	udev_device_unref(udev_device);
+	prop = litest_device_get_property(dev, "ID_INPUT_TOUCHPAD_INTEGRATION");
 
-	return is_external;
+	return prop && streq(prop, "external");
 }
 
 static inline int
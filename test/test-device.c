@@ -31,6 +31,8 @@
 
 #include "litest.h"
 #include "libinput-util.h"
+#include "libinput-private-api.h"
+#include "util-histogram.h"
 
 START_TEST(device_sendevents_config)
 {
@@ -1594,6 +1596,298 @@ START_TEST(device_seat_phys_name)
 }
 END_TEST
 
+START_TEST(device_latency_stats)
+{
+	struct litest_device *dev = litest_current_device();
+	struct libinput_device *device = dev->libinput_device;
+	struct libinput *li = dev->libinput;
+	struct libinput_stats *stats;
+	const struct histogram *h;
+	enum libinput_latency_stat which;
+
+	litest_drain_events(li);
+
+	/* disabled by default */
+	litest_event(dev, EV_REL, REL_X, 1);
+	litest_event(dev, EV_SYN, SYN_REPORT, 0);
+	litest_dispatch(li);
+	litest_drain_events(li);
+
+	stats = libinput_device_get_stats(device);
+	h = libinput_stats_get_latency(stats, LIBINPUT_LATENCY_STAT_DISPATCH);
+	litest_assert_int_eq(h->count, 0U);
+	libinput_stats_unref(stats);
+
+	libinput_set_latency_stats_enabled(li, 1);
+	for (int i = 0; i < 10; i++) {
+		litest_event(dev, EV_REL, REL_X, 1);
+		litest_event(dev, EV_SYN, SYN_REPORT, 0);
+		litest_dispatch(li);
+	}
+	litest_drain_events(li);
+
+	stats = libinput_device_get_stats(device);
+	for (which = LIBINPUT_LATENCY_STAT_DISPATCH;
+	     which <= LIBINPUT_LATENCY_STAT_INTERFACE;
+	     which++) {
+		uint64_t total = 0;
+
+		h = libinput_stats_get_latency(stats, which);
+		litest_assert_int_eq(h->count, 10U);
+		litest_assert_int_le(h->sum / h->count, h->max);
+		litest_assert_int_le(histogram_percentile(h, 50), h->max);
+
+		for (unsigned int i = 0; i < HISTOGRAM_NBUCKETS; i++)
+			total += h->buckets[i];
+		litest_assert_int_eq(total, 10U);
+
+		/* The public API reports the same data */
+		litest_assert_int_eq(libinput_device_get_latency_stats_count(device, which), 10U);
+		litest_assert_int_eq(libinput_device_get_latency_stats_percentile(device, which, 50),
+				     histogram_percentile(h, 50));
+		litest_assert_int_eq(libinput_device_get_latency_stats_percentile(device, which, 100),
+				     h->max);
+	}
+	libinput_stats_unref(stats);
+
+	/* The context snapshot includes our device */
+	stats = libinput_get_stats(li);
+	h = libinput_stats_get_latency(stats, LIBINPUT_LATENCY_STAT_POST);
+	litest_assert_int_ge(h->count, 10U);
+	libinput_stats_unref(stats);
+
+	libinput_set_latency_stats_enabled(li, 0);
+	litest_event(dev, EV_REL, REL_X, 1);
+	litest_event(dev, EV_SYN, SYN_REPORT, 0);
+	litest_dispatch(li);
+	litest_drain_events(li);
+
+	stats = libinput_device_get_stats(device);
+	h = libinput_stats_get_latency(stats, LIBINPUT_LATENCY_STAT_POST);
+	litest_assert_int_eq(h->count, 10U);
+	libinput_stats_unref(stats);
+
+	/* Re-enabling resets the histograms */
+	libinput_set_latency_stats_enabled(li, 1);
+	stats = libinput_device_get_stats(device);
+	h = libinput_stats_get_latency(stats, LIBINPUT_LATENCY_STAT_POST);
+	litest_assert_int_eq(h->count, 0U);
+	libinput_stats_unref(stats);
+}
+END_TEST
+
+static unsigned int
+find_plugin_stats_index(struct libinput_stats *stats, const char *name)
+{
+	for (unsigned int i = 0; i < libinput_stats_get_num_plugins(stats); i++) {
+		if (streq(libinput_stats_get_plugin_name(stats, i), name))
+			return i;
+	}
+
+	litest_abort_msg("Plugin %s not found", name);
+}
+
+START_TEST(device_plugin_stats)
+{
+	struct litest_device *dev = litest_current_device();
+	struct libinput_device *device = dev->libinput_device;
+	struct libinput *li = dev->libinput;
+	struct libinput_stats *stats;
+	unsigned int idx;
+
+	litest_drain_events(li);
+
+	/* disabled by default */
+	litest_event(dev, EV_REL, REL_X, 1);
+	litest_event(dev, EV_SYN, SYN_REPORT, 0);
+	litest_dispatch(li);
+	litest_drain_events(li);
+
+	stats = libinput_device_get_stats(device);
+	idx = find_plugin_stats_index(stats, "evdev");
+	litest_assert_int_eq(libinput_stats_get_plugin_value(stats, idx, LIBINPUT_PLUGIN_STAT_FRAMES_IN), 0U);
+	litest_assert_int_eq(libinput_stats_get_plugin_value(stats, idx, LIBINPUT_PLUGIN_STAT_TIME_NSEC), 0U);
+	libinput_stats_unref(stats);
+
+	libinput_set_latency_stats_enabled(li, 1);
+	for (int i = 0; i < 10; i++) {
+		litest_event(dev, EV_REL, REL_X, 1);
+		litest_event(dev, EV_SYN, SYN_REPORT, 0);
+		litest_dispatch(li);
+	}
+	litest_drain_events(li);
+
+	/* The evdev plugin is last and consumes every frame */
+	stats = libinput_device_get_stats(device);
+	idx = find_plugin_stats_index(stats, "evdev");
+	litest_assert_int_eq(idx, libinput_stats_get_num_plugins(stats) - 1);
+	litest_assert_int_eq(libinput_stats_get_plugin_value(stats, idx, LIBINPUT_PLUGIN_STAT_FRAMES_IN), 10U);
+	litest_assert_int_eq(libinput_stats_get_plugin_value(stats, idx, LIBINPUT_PLUGIN_STAT_FRAMES_OUT), 0U);
+	litest_assert_int_eq(libinput_stats_get_plugin_value(stats, idx, LIBINPUT_PLUGIN_STAT_FRAMES_APPENDED), 0U);
+	litest_assert_int_eq(libinput_stats_get_plugin_value(stats, idx, LIBINPUT_PLUGIN_STAT_TIMER_FIRINGS), 0U);
+	litest_assert_int_eq(libinput_stats_get_plugin_value(stats, idx, 0), 0U);
+	litest_assert(libinput_stats_get_plugin_name(stats, libinput_stats_get_num_plugins(stats)) == NULL);
+	libinput_stats_unref(stats);
+
+	/* The context totals include our device */
+	stats = libinput_get_stats(li);
+	idx = find_plugin_stats_index(stats, "evdev");
+	litest_assert_int_ge(libinput_stats_get_plugin_value(stats, idx, LIBINPUT_PLUGIN_STAT_FRAMES_IN), 10U);
+	libinput_stats_unref(stats);
+
+	libinput_set_latency_stats_enabled(li, 0);
+	litest_event(dev, EV_REL, REL_X, 1);
+	litest_event(dev, EV_SYN, SYN_REPORT, 0);
+	litest_dispatch(li);
+	litest_drain_events(li);
+
+	stats = libinput_device_get_stats(device);
+	idx = find_plugin_stats_index(stats, "evdev");
+	litest_assert_int_eq(libinput_stats_get_plugin_value(stats, idx, LIBINPUT_PLUGIN_STAT_FRAMES_IN), 10U);
+	libinput_stats_unref(stats);
+
+	/* Re-enabling resets the counters */
+	libinput_set_latency_stats_enabled(li, 1);
+	stats = libinput_device_get_stats(device);
+	idx = find_plugin_stats_index(stats, "evdev");
+	litest_assert_int_eq(libinput_stats_get_plugin_value(stats, idx, LIBINPUT_PLUGIN_STAT_FRAMES_IN), 0U);
+	libinput_stats_unref(stats);
+}
+END_TEST
+
+START_TEST(device_plugin_stats_usage_mask)
+{
+	struct litest_device *dev = litest_current_device();
+	struct libinput_device *device = dev->libinput_device;
+	struct libinput *li = dev->libinput;
+	struct libinput_stats *stats;
+	unsigned int wheel, debounce;
+
+	litest_drain_events(li);
+	libinput_set_latency_stats_enabled(li, 1);
+
+	/* Motion only: neither the wheel nor the debounce plugin care */
+	for (int i = 0; i < 3; i++) {
+		litest_event(dev, EV_REL, REL_X, 1);
+		litest_event(dev, EV_SYN, SYN_REPORT, 0);
+		litest_dispatch(li);
+	}
+	litest_assert_only_typed_events(li, LIBINPUT_EVENT_POINTER_MOTION);
+
+	stats = libinput_device_get_stats(device);
+	wheel = find_plugin_stats_index(stats, "mouse-wheel");
+	debounce = find_plugin_stats_index(stats, "button-debounce");
+	litest_assert_int_eq(libinput_stats_get_plugin_value(stats, wheel, LIBINPUT_PLUGIN_STAT_FRAMES_IN), 0U);
+	litest_assert_int_eq(libinput_stats_get_plugin_value(stats, wheel, LIBINPUT_PLUGIN_STAT_FRAMES_SKIPPED), 3U);
+	litest_assert_int_eq(libinput_stats_get_plugin_value(stats, debounce, LIBINPUT_PLUGIN_STAT_FRAMES_IN), 0U);
+	litest_assert_int_eq(libinput_stats_get_plugin_value(stats, debounce, LIBINPUT_PLUGIN_STAT_FRAMES_SKIPPED), 3U);
+	libinput_stats_unref(stats);
+
+	/* A button frame goes to the debounce plugin only */
+	litest_button_click_debounced(dev, li, BTN_LEFT, true);
+	litest_button_click_debounced(dev, li, BTN_LEFT, false);
+	litest_assert_button_event(li, BTN_LEFT, LIBINPUT_BUTTON_STATE_PRESSED);
+	litest_assert_button_event(li, BTN_LEFT, LIBINPUT_BUTTON_STATE_RELEASED);
+
+	stats = libinput_device_get_stats(device);
+	litest_assert_int_eq(libinput_stats_get_plugin_value(stats, wheel, LIBINPUT_PLUGIN_STAT_FRAMES_IN), 0U);
+	litest_assert_int_ge(libinput_stats_get_plugin_value(stats, wheel, LIBINPUT_PLUGIN_STAT_FRAMES_SKIPPED), 5U);
+	litest_assert_int_ge(libinput_stats_get_plugin_value(stats, debounce, LIBINPUT_PLUGIN_STAT_FRAMES_IN), 2U);
+	litest_assert_int_eq(libinput_stats_get_plugin_value(stats, debounce, LIBINPUT_PLUGIN_STAT_FRAMES_SKIPPED), 3U);
+	libinput_stats_unref(stats);
+
+	/* A wheel frame goes to the wheel plugin only */
+	litest_event(dev, EV_REL, REL_WHEEL, 1);
+	litest_event(dev, EV_REL, REL_WHEEL_HI_RES, 120);
+	litest_event(dev, EV_SYN, SYN_REPORT, 0);
+	litest_dispatch(li);
+	litest_assert_only_axis_events(li, LIBINPUT_EVENT_POINTER_SCROLL_WHEEL);
+
+	stats = libinput_device_get_stats(device);
+	litest_assert_int_eq(libinput_stats_get_plugin_value(stats, wheel, LIBINPUT_PLUGIN_STAT_FRAMES_IN), 1U);
+	litest_assert_int_eq(libinput_stats_get_plugin_value(stats, debounce, LIBINPUT_PLUGIN_STAT_FRAMES_SKIPPED), 4U);
+	libinput_stats_unref(stats);
+}
+END_TEST
+
+static char *
+read_flight_recorder(struct libinput *li)
+{
+	_autofclose_ FILE *fp = tmpfile();
+	char buf[65536] = {0};
+
+	litest_assert_notnull(fp);
+	litest_assert_int_eq(libinput_flight_recorder_dump(li, fileno(fp)), 0);
+
+	rewind(fp);
+	size_t n = fread(buf, 1, sizeof(buf) - 1, fp);
+	litest_assert_int_gt(n, 0U);
+
+	return safe_strdup(buf);
+}
+
+START_TEST(device_flight_recorder)
+{
+	struct litest_device *dev = litest_current_device();
+	struct libinput *li = dev->libinput;
+
+	litest_drain_events(li);
+
+	/* disabled by default */
+	litest_assert_int_eq(libinput_flight_recorder_dump(li, STDERR_FILENO), -EINVAL);
+
+	libinput_set_flight_recorder(li, 5);
+	for (int i = 0; i < 3; i++) {
+		litest_event(dev, EV_REL, REL_X, 1);
+		litest_event(dev, EV_SYN, SYN_REPORT, 0);
+		litest_dispatch(li);
+	}
+	litest_drain_events(li);
+
+	_autofree_ char *dump = read_flight_recorder(li);
+	litest_assert(strstr(dump, "version: 1\n") != NULL);
+	litest_assert(strstr(dump, "ndevices: 1\n") != NULL);
+	litest_assert(strstr(dump, "  - evdev:\n") != NULL);
+	litest_assert(strstr(dump, "EV_REL / REL_X") != NULL);
+	litest_assert(strstr(dump, "type: POINTER_MOTION}") != NULL);
+
+	/* Changing the duration discards the data */
+	libinput_set_flight_recorder(li, 10);
+	_autofree_ char *empty = read_flight_recorder(li);
+	litest_assert(strstr(empty, "ndevices: 1\n") != NULL);
+	litest_assert(strstr(empty, "  - evdev:\n") == NULL);
+
+	libinput_set_flight_recorder(li, 0);
+	litest_assert_int_eq(libinput_flight_recorder_dump(li, STDERR_FILENO), -EINVAL);
+}
+END_TEST
+
+START_TEST(device_latency_stats_invalid)
+{
+	struct litest_device *dev = litest_current_device();
+	struct libinput_device *device = dev->libinput_device;
+	struct libinput *li = dev->libinput;
+	struct libinput_stats *stats;
+
+	stats = libinput_device_get_stats(device);
+	litest_assert(libinput_stats_get_latency(stats, 0) == NULL);
+	litest_assert(libinput_stats_get_latency(stats, LIBINPUT_LATENCY_STAT_INTERFACE + 1) == NULL);
+	litest_assert_notnull(libinput_stats_get_latency(stats, LIBINPUT_LATENCY_STAT_DISPATCH));
+	litest_assert_int_eq(libinput_stats_get_plugin_value(stats,
+							     libinput_stats_get_num_plugins(stats),
+							     LIBINPUT_PLUGIN_STAT_FRAMES_IN),
+			     0U);
+	libinput_stats_unref(stats);
+
+	litest_set_log_handler_bug(li);
+	litest_assert_int_eq(libinput_device_get_latency_stats_count(device, 0), 0U);
+	litest_assert_int_eq(libinput_device_get_latency_stats_count(device, LIBINPUT_LATENCY_STAT_INTERFACE + 1), 0U);
+	litest_assert_int_eq(libinput_device_get_latency_stats_percentile(device, LIBINPUT_LATENCY_STAT_POST, -1), 0U);
+	litest_assert_int_eq(libinput_device_get_latency_stats_percentile(device, LIBINPUT_LATENCY_STAT_POST, 100.5), 0U);
+	litest_restore_log_handler(li);
+}
+END_TEST
+
 START_TEST(device_button_down_remove)
 {
 	struct litest_device *lidev = litest_current_device();
@@ -1744,4 +2038,10 @@ TEST_COLLECTION(device)
 	litest_add(device_seat_phys_name, LITEST_ANY, LITEST_ANY);
 
 	litest_add(device_button_down_remove, LITEST_BUTTON, LITEST_ANY);
+
+	litest_add_for_device(device_latency_stats, LITEST_MOUSE);
+	litest_add_for_device(device_latency_stats_invalid, LITEST_MOUSE);
+	litest_add_for_device(device_plugin_stats, LITEST_MOUSE);
+	litest_add_for_device(device_plugin_stats_usage_mask, LITEST_MOUSE);
+	litest_add_for_device(device_flight_recorder, LITEST_MOUSE);
 }
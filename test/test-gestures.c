@@ -2243,6 +2243,8 @@ END_TEST
 
 TEST_COLLECTION(gestures)
 {
+	litest_uinput_optional();
+
 	litest_add(gestures_cap, LITEST_TOUCHPAD, LITEST_SINGLE_TOUCH);
 	litest_add(gestures_nocap, LITEST_ANY, LITEST_TOUCHPAD);
 
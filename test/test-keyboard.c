@@ -475,6 +475,157 @@ START_TEST(keyboard_no_scroll)
 }
 END_TEST
 
+START_TEST(keyboard_state_after_syn_dropped)
+{
+	struct litest_device *dev = litest_current_device();
+	struct libinput *li = dev->libinput;
+	struct libinput_event *event;
+	enum libinput_key_state state_a = LIBINPUT_KEY_STATE_PRESSED;
+	uint32_t seat_count = 1;
+
+	litest_drain_events(li);
+
+	litest_keyboard_key(dev, KEY_A, true);
+	litest_dispatch(li);
+	litest_assert_key_event(li, KEY_A, LIBINPUT_KEY_STATE_PRESSED);
+
+	/* Force a SYN_DROPPED, then release KEY_A while the queue
+	 * is still overflowing */
+	for (int i = 0; i < 500; i++) {
+		litest_keyboard_key(dev, KEY_B, true);
+		litest_keyboard_key(dev, KEY_B, false);
+	}
+	litest_keyboard_key(dev, KEY_A, false);
+	litest_dispatch(li);
+
+	while ((event = libinput_get_event(li))) {
+		litest_assert_event_type(event, LIBINPUT_EVENT_KEYBOARD_KEY);
+		struct libinput_event_keyboard *kev = libinput_event_get_keyboard_event(event);
+		if (libinput_event_keyboard_get_key(kev) == KEY_A)
+			state_a = libinput_event_keyboard_get_key_state(kev);
+		seat_count = libinput_event_keyboard_get_seat_key_count(kev);
+		libinput_event_destroy(event);
+	}
+
+	litest_assert_enum_eq(state_a, LIBINPUT_KEY_STATE_RELEASED);
+	litest_assert_int_eq(seat_count, 0U);
+
+	/* And we're back to normal */
+	litest_keyboard_key(dev, KEY_C, true);
+	litest_keyboard_key(dev, KEY_C, false);
+	litest_dispatch(li);
+	litest_assert_key_event(li, KEY_C, LIBINPUT_KEY_STATE_PRESSED);
+	litest_assert_key_event(li, KEY_C, LIBINPUT_KEY_STATE_RELEASED);
+	litest_assert_empty_queue(li);
+}
+END_TEST
+
+START_TEST(keyboard_remap_key)
+{
+	struct litest_device *dev = litest_current_device();
+	struct libinput *li = dev->libinput;
+
+	litest_drain_events(li);
+
+	litest_keyboard_key(dev, KEY_A, true);
+	litest_keyboard_key(dev, KEY_A, false);
+	litest_dispatch(li);
+
+	litest_assert_key_event(li, KEY_B, LIBINPUT_KEY_STATE_PRESSED);
+	litest_assert_key_event(li, KEY_B, LIBINPUT_KEY_STATE_RELEASED);
+	litest_assert_empty_queue(li);
+
+	/* Keys not in the table are left alone */
+	litest_keyboard_key(dev, KEY_ESC, true);
+	litest_keyboard_key(dev, KEY_ESC, false);
+	litest_dispatch(li);
+
+	litest_assert_key_event(li, KEY_ESC, LIBINPUT_KEY_STATE_PRESSED);
+	litest_assert_key_event(li, KEY_ESC, LIBINPUT_KEY_STATE_RELEASED);
+	litest_assert_empty_queue(li);
+}
+END_TEST
+
+START_TEST(keyboard_remap_key_none)
+{
+	struct litest_device *dev = litest_current_device();
+	struct libinput *li = dev->libinput;
+
+	litest_drain_events(li);
+
+	litest_keyboard_key(dev, KEY_CAPSLOCK, true);
+	litest_keyboard_key(dev, KEY_CAPSLOCK, false);
+	litest_dispatch(li);
+	litest_assert_empty_queue(li);
+
+	/* Other keys in the same frame are kept */
+	litest_event(dev, EV_KEY, KEY_CAPSLOCK, 1);
+	litest_event(dev, EV_KEY, KEY_ESC, 1);
+	litest_event(dev, EV_SYN, SYN_REPORT, 0);
+	litest_event(dev, EV_KEY, KEY_ESC, 0);
+	litest_event(dev, EV_KEY, KEY_CAPSLOCK, 0);
+	litest_event(dev, EV_SYN, SYN_REPORT, 0);
+	litest_dispatch(li);
+
+	litest_assert_key_event(li, KEY_ESC, LIBINPUT_KEY_STATE_PRESSED);
+	litest_assert_key_event(li, KEY_ESC, LIBINPUT_KEY_STATE_RELEASED);
+	litest_assert_empty_queue(li);
+}
+END_TEST
+
+START_TEST(keyboard_remap_chord)
+{
+	struct litest_device *dev = litest_current_device();
+	struct libinput *li = dev->libinput;
+
+	litest_drain_events(li);
+
+	/* Without the modifier the key is sent as-is */
+	litest_keyboard_key(dev, KEY_C, true);
+	litest_keyboard_key(dev, KEY_C, false);
+	litest_dispatch(li);
+
+	litest_assert_key_event(li, KEY_C, LIBINPUT_KEY_STATE_PRESSED);
+	litest_assert_key_event(li, KEY_C, LIBINPUT_KEY_STATE_RELEASED);
+
+	litest_keyboard_key(dev, KEY_LEFTCTRL, true);
+	litest_keyboard_key(dev, KEY_C, true);
+	litest_keyboard_key(dev, KEY_C, false);
+	litest_keyboard_key(dev, KEY_D, true);
+	litest_keyboard_key(dev, KEY_D, false);
+	litest_keyboard_key(dev, KEY_LEFTCTRL, false);
+	litest_dispatch(li);
+
+	litest_assert_key_event(li, KEY_LEFTCTRL, LIBINPUT_KEY_STATE_PRESSED);
+	litest_assert_key_event(li, KEY_COPY, LIBINPUT_KEY_STATE_PRESSED);
+	litest_assert_key_event(li, KEY_COPY, LIBINPUT_KEY_STATE_RELEASED);
+	litest_assert_key_event(li, KEY_LEFTCTRL, LIBINPUT_KEY_STATE_RELEASED);
+	litest_assert_empty_queue(li);
+}
+END_TEST
+
+START_TEST(keyboard_remap_chord_modifier_released_first)
+{
+	struct litest_device *dev = litest_current_device();
+	struct libinput *li = dev->libinput;
+
+	litest_drain_events(li);
+
+	litest_keyboard_key(dev, KEY_LEFTCTRL, true);
+	litest_keyboard_key(dev, KEY_C, true);
+	litest_keyboard_key(dev, KEY_LEFTCTRL, false);
+	litest_keyboard_key(dev, KEY_C, false);
+	litest_dispatch(li);
+
+	/* The release matches the press, not the current modifier state */
+	litest_assert_key_event(li, KEY_LEFTCTRL, LIBINPUT_KEY_STATE_PRESSED);
+	litest_assert_key_event(li, KEY_COPY, LIBINPUT_KEY_STATE_PRESSED);
+	litest_assert_key_event(li, KEY_LEFTCTRL, LIBINPUT_KEY_STATE_RELEASED);
+	litest_assert_key_event(li, KEY_COPY, LIBINPUT_KEY_STATE_RELEASED);
+	litest_assert_empty_queue(li);
+}
+END_TEST
+
 TEST_COLLECTION(keyboard)
 {
 	litest_add_no_device(keyboard_seat_key_count);
@@ -490,4 +641,11 @@ TEST_COLLECTION(keyboard)
 	litest_add(keyboard_leds, LITEST_ANY, LITEST_ANY);
 
 	litest_add(keyboard_no_scroll, LITEST_KEYS, LITEST_WHEEL);
+
+	litest_add_for_device(keyboard_state_after_syn_dropped, LITEST_KEYBOARD);
+
+	litest_add_for_device(keyboard_remap_key, LITEST_KEYBOARD_REMAPPED);
+	litest_add_for_device(keyboard_remap_key_none, LITEST_KEYBOARD_REMAPPED);
+	litest_add_for_device(keyboard_remap_chord, LITEST_KEYBOARD_REMAPPED);
+	litest_add_for_device(keyboard_remap_chord_modifier_released_first, LITEST_KEYBOARD_REMAPPED);
 }
@@ -189,7 +189,8 @@ TEST_COLLECTION(log)
 	litest_add_no_device(log_priority);
 
 	litest_with_parameters(params, "axis", 'I', 2, litest_named_i32(ABS_X), litest_named_i32(ABS_Y)) {
-		/* mtdev clips to axis ranges */
+		/* protocol A devices are clipped to the axis ranges,
+		 * by mtdev or the mt-protocol-a plugin */
 		litest_add_parametrized(log_axisrange_warning, LITEST_TOUCH, LITEST_PROTOCOL_A, params);
 		litest_add_parametrized(log_axisrange_warning, LITEST_TOUCHPAD, LITEST_ANY, params);
 	}
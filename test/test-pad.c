@@ -28,6 +28,8 @@
 #include <libinput.h>
 #include <unistd.h>
 #include <stdbool.h>
+#include <stdio.h>
+#include <sys/stat.h>
 
 #if HAVE_LIBWACOM
 #include <libwacom/libwacom.h>
@@ -1179,6 +1181,134 @@ START_TEST(pad_send_events_disabled)
 }
 END_TEST
 
+#if HAVE_LIBWACOM
+static void
+pad_fake_leds_set_mode(unsigned int nmodes, unsigned int mode)
+{
+	for (unsigned int m = 0; m < nmodes; m++) {
+		_autofree_ char *dir = strdup_printf("%s/wacom-0.%u",
+						     LITEST_PAD_LEDS_SYSFS_PATH,
+						     m);
+		_autofree_ char *path = strdup_printf("%s/brightness", dir);
+		FILE *fp;
+		int rc;
+
+		rc = mkdir(dir, 0755);
+		if (rc == -1)
+			litest_assert_int_eq(errno, EEXIST);
+
+		fp = fopen(path, "w");
+		litest_assert_notnull(fp);
+		fprintf(fp, "%u\n", m == mode ? 255 : 0);
+		fclose(fp);
+	}
+}
+
+static void
+pad_fake_leds_remove(unsigned int nmodes)
+{
+	for (unsigned int m = 0; m < nmodes; m++) {
+		_autofree_ char *dir = strdup_printf("%s/wacom-0.%u",
+						     LITEST_PAD_LEDS_SYSFS_PATH,
+						     m);
+		_autofree_ char *path = strdup_printf("%s/brightness", dir);
+
+		unlink(path);
+		rmdir(dir);
+	}
+	rmdir(LITEST_PAD_LEDS_SYSFS_PATH);
+}
+
+static unsigned int
+pad_click_get_mode(struct litest_device *dev, unsigned int code)
+{
+	struct libinput *li = dev->libinput;
+	struct libinput_event *ev;
+	struct libinput_event_tablet_pad *pev;
+	unsigned int mode;
+
+	litest_button_click(dev, code, 1);
+	litest_dispatch(li);
+
+	ev = libinput_get_event(li);
+	litest_assert_event_type(ev, LIBINPUT_EVENT_TABLET_PAD_BUTTON);
+	pev = libinput_event_get_tablet_pad_event(ev);
+	litest_assert_enum_eq(libinput_event_tablet_pad_get_button_state(pev),
+			      LIBINPUT_BUTTON_STATE_PRESSED);
+	mode = libinput_event_tablet_pad_get_mode(pev);
+	libinput_event_destroy(ev);
+
+	litest_button_click(dev, code, 0);
+	litest_drain_events(li);
+
+	return mode;
+}
+
+START_TEST(pad_mode_group_leds)
+{
+	_litest_context_destroy_ struct libinput *li = litest_create_context();
+	struct litest_device *dev;
+	struct libinput_tablet_pad_mode_group *group;
+	const unsigned int nmodes = 4;
+	enum libinput_config_status status;
+	unsigned int mode;
+	int rc;
+
+	rc = mkdir(LITEST_PAD_LEDS_SYSFS_PATH, 0755);
+	if (rc == -1)
+		litest_assert_int_eq(errno, EEXIST);
+	pad_fake_leds_set_mode(nmodes, 2);
+
+	dev = litest_add_device(li, LITEST_WACOM_MOBILESTUDIO_PRO_16_PAD_LEDS);
+	litest_drain_events(li);
+
+	/* The initial mode is read from the LEDs */
+	group = libinput_device_tablet_pad_get_mode_group(dev->libinput_device, 0);
+	litest_assert_int_eq(libinput_tablet_pad_mode_group_get_num_modes(group), nmodes);
+	litest_assert_int_eq(libinput_tablet_pad_mode_group_get_mode(group), 2U);
+
+	/* Nothing updates our fake LEDs, they stay in mode 2. A toggle
+	 * that reads sysfs would stay in mode 2 too. BTN_C is
+	 * either the mode 3 button or the next mode, both are 3. */
+	mode = pad_click_get_mode(dev, BTN_C);
+	litest_assert_int_eq(mode, 3U);
+
+	/* BTN_A switches to mode 1, or to the next mode where libwacom
+	 * doesn't know about the target modes */
+	mode = pad_click_get_mode(dev, BTN_A);
+#ifdef HAVE_LIBWACOM_BUTTON_MODESWITCH_MODE
+	litest_assert_int_eq(mode, 1U);
+#else
+	litest_assert_int_eq(mode, 0U);
+#endif
+
+	/* While suspended, someone else changes the LEDs. The next toggle
+	 * must pick up the LED state instead of BTN_9's mode 0 or the
+	 * next mode 1 */
+	status = libinput_device_config_send_events_set_mode(dev->libinput_device,
+							      LIBINPUT_CONFIG_SEND_EVENTS_DISABLED);
+	litest_assert_enum_eq(status, LIBINPUT_CONFIG_STATUS_SUCCESS);
+	pad_fake_leds_set_mode(nmodes, 2);
+	status = libinput_device_config_send_events_set_mode(dev->libinput_device,
+							      LIBINPUT_CONFIG_SEND_EVENTS_ENABLED);
+	litest_assert_enum_eq(status, LIBINPUT_CONFIG_STATUS_SUCCESS);
+	litest_drain_events(li);
+
+	mode = pad_click_get_mode(dev, BTN_9);
+	litest_assert_int_eq(mode, 2U);
+
+	/* And only that one toggle, after that we're back to tracking
+	 * the mode in memory */
+	mode = pad_click_get_mode(dev, BTN_C);
+	litest_assert_int_eq(mode, 3U);
+	litest_assert_int_eq(libinput_tablet_pad_mode_group_get_mode(group), 3U);
+
+	litest_device_destroy(dev);
+	pad_fake_leds_remove(nmodes);
+}
+END_TEST
+#endif
+
 TEST_COLLECTION(pad)
 {
 	litest_add(pad_cap, LITEST_TABLET_PAD, LITEST_ANY);
@@ -1219,6 +1349,9 @@ TEST_COLLECTION(pad)
 	litest_add(pad_mode_group_has, LITEST_TABLET_PAD, LITEST_ANY);
 	litest_add(pad_mode_group_has_invalid, LITEST_TABLET_PAD, LITEST_ANY);
 	litest_add(pad_mode_group_has_no_toggle, LITEST_TABLET_PAD, LITEST_ANY);
+#if HAVE_LIBWACOM
+	litest_add_no_device(pad_mode_group_leds);
+#endif
 
 	litest_add(pad_keys, LITEST_TABLET_PAD, LITEST_ANY);
 
@@ -32,6 +32,8 @@
 
 #include "litest.h"
 #include "libinput-util.h"
+#include "libinput-private-api.h"
+#include "util-input-event.h"
 
 struct counter {
 	int open_func_count;
@@ -1004,6 +1006,475 @@ START_TEST(path_ignore_device)
 }
 END_TEST
 
+/* The read end must be non-blocking for libinput_path_add_evdev_device(),
+ * the write end stays blocking */
+static void
+create_evdev_pipe(int fds[2])
+{
+	litest_assert_errno_success(pipe2(fds, O_CLOEXEC));
+	litest_assert_errno_success(fcntl(fds[0], F_SETFL, O_NONBLOCK));
+}
+
+static struct libevdev *
+create_evdev_mouse(void)
+{
+	struct libevdev *evdev = libevdev_new();
+
+	libevdev_set_name(evdev, "litest evdev mouse");
+	libevdev_set_id_bustype(evdev, BUS_USB);
+	libevdev_set_id_vendor(evdev, 0x1);
+	libevdev_set_id_product(evdev, 0x2);
+	libevdev_enable_event_code(evdev, EV_REL, REL_X, NULL);
+	libevdev_enable_event_code(evdev, EV_REL, REL_Y, NULL);
+	libevdev_enable_event_code(evdev, EV_KEY, BTN_LEFT, NULL);
+	libevdev_enable_event_code(evdev, EV_KEY, BTN_RIGHT, NULL);
+	libevdev_enable_event_code(evdev, EV_KEY, BTN_MIDDLE, NULL);
+
+	return evdev;
+}
+
+START_TEST(path_add_evdev_device)
+{
+	struct libinput_device *device;
+	struct libinput_event *event;
+	const char *properties[] = {
+		"ID_INPUT=1",
+		"ID_INPUT_MOUSE=1",
+		NULL,
+	};
+	int fds[2];
+	uint64_t now;
+
+	create_evdev_pipe(fds);
+
+	_litest_context_destroy_ struct libinput *li = litest_create_context();
+	device = libinput_path_add_evdev_device(li,
+						create_evdev_mouse(),
+						fds[0],
+						"event9999",
+						properties);
+	litest_assert_notnull(device);
+	litest_assert_str_eq(libinput_device_get_sysname(device), "event9999");
+	litest_assert_str_eq(libinput_device_get_name(device), "litest evdev mouse");
+	litest_assert_ptr_null(libinput_device_get_udev_device(device));
+	litest_assert(libinput_device_has_capability(device,
+						     LIBINPUT_DEVICE_CAP_POINTER));
+
+	/* ours, the device has its own fd */
+	close(fds[0]);
+
+	litest_dispatch(li);
+	event = libinput_get_event(li);
+	litest_assert_event_type(event, LIBINPUT_EVENT_DEVICE_ADDED);
+	libinput_event_destroy(event);
+	litest_assert_empty_queue(li);
+
+	now_in_us(&now);
+	struct input_event events[] = {
+		input_event_init(now, EV_REL, REL_X, 1),
+		input_event_init(now, EV_SYN, SYN_REPORT, 0),
+	};
+	litest_assert_int_eq(write(fds[1], events, sizeof(events)),
+			     (ssize_t)sizeof(events));
+
+	litest_dispatch(li);
+	event = libinput_get_event(li);
+	litest_assert_event_type(event, LIBINPUT_EVENT_POINTER_MOTION);
+	libinput_event_destroy(event);
+	litest_assert_empty_queue(li);
+
+	libinput_path_remove_device(device);
+	litest_dispatch(li);
+	event = libinput_get_event(li);
+	litest_assert_event_type(event, LIBINPUT_EVENT_DEVICE_REMOVED);
+	libinput_event_destroy(event);
+
+	close(fds[1]);
+}
+END_TEST
+
+START_TEST(path_add_evdev_device_untagged)
+{
+	struct libinput_device *device;
+	int fds[2];
+
+	create_evdev_pipe(fds);
+
+	_litest_context_destroy_ struct libinput *li = litest_create_context();
+
+	/* No ID_INPUT properties, so not a supported input device */
+	device = libinput_path_add_evdev_device(li,
+						create_evdev_mouse(),
+						fds[0],
+						"event9999",
+						NULL);
+	litest_assert_ptr_null(device);
+
+	litest_dispatch(li);
+	litest_assert_empty_queue(li);
+
+	close(fds[0]);
+	close(fds[1]);
+}
+END_TEST
+
+START_TEST(path_add_evdev_device_blocking_fd)
+{
+	struct libinput_device *device;
+	const char *properties[] = {
+		"ID_INPUT=1",
+		"ID_INPUT_MOUSE=1",
+		NULL,
+	};
+	int fds[2];
+
+	litest_assert_errno_success(pipe2(fds, O_CLOEXEC));
+
+	_litest_context_destroy_ struct libinput *li = litest_create_context();
+	litest_set_log_handler_bug(li);
+	device = libinput_path_add_evdev_device(li,
+						create_evdev_mouse(),
+						fds[0],
+						"event9999",
+						properties);
+	litest_assert_ptr_null(device);
+	litest_restore_log_handler(li);
+
+	/* The caller's fd is left alone */
+	litest_assert_int_eq(fcntl(fds[0], F_GETFL) & O_NONBLOCK, 0);
+
+	close(fds[0]);
+	close(fds[1]);
+}
+END_TEST
+
+START_TEST(path_add_evdev_device_suspend)
+{
+	struct libinput_device *device;
+	struct libinput_event *event;
+	const char *properties[] = {
+		"ID_INPUT=1",
+		"ID_INPUT_MOUSE=1",
+		NULL,
+	};
+	int fds[2];
+
+	create_evdev_pipe(fds);
+
+	_litest_context_destroy_ struct libinput *li = litest_create_context();
+	device = libinput_path_add_evdev_device(li,
+						create_evdev_mouse(),
+						fds[0],
+						"event9999",
+						properties);
+	litest_assert_notnull(device);
+	litest_drain_events(li);
+
+	/* Nothing to re-open these from, they stay removed */
+	libinput_suspend(li);
+	litest_dispatch(li);
+	event = libinput_get_event(li);
+	litest_assert_event_type(event, LIBINPUT_EVENT_DEVICE_REMOVED);
+	libinput_event_destroy(event);
+
+	litest_assert_int_eq(libinput_resume(li), 0);
+	litest_dispatch(li);
+	litest_assert_empty_queue(li);
+
+	close(fds[0]);
+	close(fds[1]);
+}
+END_TEST
+
+START_TEST(path_add_evdev_device_send_events)
+{
+	struct libinput_device *device;
+	struct libinput_event *event;
+	enum libinput_config_status status;
+	const char *properties[] = {
+		"ID_INPUT=1",
+		"ID_INPUT_MOUSE=1",
+		NULL,
+	};
+	int fds[2];
+	uint64_t now;
+
+	create_evdev_pipe(fds);
+
+	_litest_context_destroy_ struct libinput *li = litest_create_context();
+	device = libinput_path_add_evdev_device(li,
+						create_evdev_mouse(),
+						fds[0],
+						"event9999",
+						properties);
+	litest_assert_notnull(device);
+	close(fds[0]);
+	litest_drain_events(li);
+
+	status = libinput_device_config_send_events_set_mode(device,
+			LIBINPUT_CONFIG_SEND_EVENTS_DISABLED);
+	litest_assert_enum_eq(status, LIBINPUT_CONFIG_STATUS_SUCCESS);
+
+	now_in_us(&now);
+	struct input_event events[] = {
+		input_event_init(now, EV_REL, REL_X, 1),
+		input_event_init(now, EV_SYN, SYN_REPORT, 0),
+	};
+	litest_assert_int_eq(write(fds[1], events, sizeof(events)),
+			     (ssize_t)sizeof(events));
+	litest_dispatch(li);
+	litest_assert_empty_queue(li);
+
+	/* The events written while disabled are discarded, the fd
+	 * survives for the ones after */
+	status = libinput_device_config_send_events_set_mode(device,
+			LIBINPUT_CONFIG_SEND_EVENTS_ENABLED);
+	litest_assert_enum_eq(status, LIBINPUT_CONFIG_STATUS_SUCCESS);
+	litest_dispatch(li);
+	litest_assert_empty_queue(li);
+
+	litest_assert_int_eq(write(fds[1], events, sizeof(events)),
+			     (ssize_t)sizeof(events));
+	litest_dispatch(li);
+	event = libinput_get_event(li);
+	litest_assert_event_type(event, LIBINPUT_EVENT_POINTER_MOTION);
+	libinput_event_destroy(event);
+	litest_assert_empty_queue(li);
+
+	close(fds[1]);
+}
+END_TEST
+
+START_TEST(path_add_evdev_device_slot_capped)
+{
+	struct libinput_device *device;
+	struct libinput_event *event;
+	struct libinput_event_touch *tev;
+	struct libevdev *evdev;
+	struct input_absinfo abs = {
+		.minimum = 0,
+		.maximum = 1000,
+		.resolution = 10,
+	};
+	struct input_absinfo slots = {
+		.minimum = 0,
+		.maximum = 1,
+	};
+	struct input_absinfo tracking_id = {
+		.minimum = 0,
+		.maximum = 0xffff,
+	};
+	const char *properties[] = {
+		"ID_INPUT=1",
+		"ID_INPUT_TOUCHSCREEN=1",
+		NULL,
+	};
+	int fds[2];
+	uint64_t now;
+
+	evdev = libevdev_new();
+	libevdev_set_name(evdev, "litest evdev touchscreen");
+	libevdev_set_id_bustype(evdev, BUS_USB);
+	libevdev_set_id_vendor(evdev, 0x1);
+	libevdev_set_id_product(evdev, 0x3);
+	libevdev_enable_property(evdev, INPUT_PROP_DIRECT);
+	libevdev_enable_event_code(evdev, EV_KEY, BTN_TOUCH, NULL);
+	libevdev_enable_event_code(evdev, EV_ABS, ABS_X, &abs);
+	libevdev_enable_event_code(evdev, EV_ABS, ABS_Y, &abs);
+	libevdev_enable_event_code(evdev, EV_ABS, ABS_MT_SLOT, &slots);
+	libevdev_enable_event_code(evdev, EV_ABS, ABS_MT_POSITION_X, &abs);
+	libevdev_enable_event_code(evdev, EV_ABS, ABS_MT_POSITION_Y, &abs);
+	libevdev_enable_event_code(evdev, EV_ABS, ABS_MT_TRACKING_ID, &tracking_id);
+
+	create_evdev_pipe(fds);
+
+	_litest_context_destroy_ struct libinput *li = litest_create_context();
+	device = libinput_path_add_evdev_device(li,
+						evdev,
+						fds[0],
+						"event9999",
+						properties);
+	litest_assert_notnull(device);
+	close(fds[0]);
+	litest_drain_events(li);
+
+	now_in_us(&now);
+	struct input_event first[] = {
+		input_event_init(now, EV_ABS, ABS_MT_SLOT, 0),
+		input_event_init(now, EV_ABS, ABS_MT_TRACKING_ID, 1),
+		input_event_init(now, EV_ABS, ABS_MT_POSITION_X, 100),
+		input_event_init(now, EV_ABS, ABS_MT_POSITION_Y, 100),
+		input_event_init(now, EV_KEY, BTN_TOUCH, 1),
+		input_event_init(now, EV_ABS, ABS_X, 100),
+		input_event_init(now, EV_ABS, ABS_Y, 100),
+		input_event_init(now, EV_SYN, SYN_REPORT, 0),
+	};
+	litest_assert_int_eq(write(fds[1], first, sizeof(first)),
+			     (ssize_t)sizeof(first));
+	litest_dispatch(li);
+
+	event = libinput_get_event(li);
+	tev = litest_is_touch_event(event, LIBINPUT_EVENT_TOUCH_DOWN);
+	litest_assert_int_eq(libinput_event_touch_get_slot(tev), 0);
+	libinput_event_destroy(event);
+	event = libinput_get_event(li);
+	litest_is_touch_event(event, LIBINPUT_EVENT_TOUCH_FRAME);
+	libinput_event_destroy(event);
+
+	/* Slot 5 is out of range and capped to the last slot, the second
+	 * touch must not end up in slot 0 */
+	now += ms2us(10);
+	struct input_event second[] = {
+		input_event_init(now, EV_ABS, ABS_MT_SLOT, 5),
+		input_event_init(now, EV_ABS, ABS_MT_TRACKING_ID, 2),
+		input_event_init(now, EV_ABS, ABS_MT_POSITION_X, 500),
+		input_event_init(now, EV_ABS, ABS_MT_POSITION_Y, 500),
+		input_event_init(now, EV_SYN, SYN_REPORT, 0),
+	};
+	litest_assert_int_eq(write(fds[1], second, sizeof(second)),
+			     (ssize_t)sizeof(second));
+	litest_dispatch(li);
+
+	event = libinput_get_event(li);
+	tev = litest_is_touch_event(event, LIBINPUT_EVENT_TOUCH_DOWN);
+	litest_assert_int_eq(libinput_event_touch_get_slot(tev), 1);
+	libinput_event_destroy(event);
+	event = libinput_get_event(li);
+	litest_is_touch_event(event, LIBINPUT_EVENT_TOUCH_FRAME);
+	libinput_event_destroy(event);
+	litest_assert_empty_queue(li);
+
+	close(fds[1]);
+}
+END_TEST
+
+START_TEST(path_set_quirks_override_file)
+{
+	struct libinput_device *device;
+	const char *properties[] = {
+		"ID_INPUT=1",
+		"ID_INPUT_MOUSE=1",
+		NULL,
+	};
+	const char quirks[] =
+		"[litest evdev mouse]\n"
+		"MatchName=litest evdev mouse\n"
+		"AttrEventCode=-BTN_MIDDLE\n";
+	char path[] = "/tmp/litest_quirks_XXXXXX";
+	int fds[2];
+	int fd;
+
+	fd = mkstemp(path);
+	litest_assert_int_ge(fd, 0);
+	litest_assert_int_eq(write(fd, quirks, strlen(quirks)), (ssize_t)strlen(quirks));
+	close(fd);
+
+	_litest_context_destroy_ struct libinput *li = litest_create_context();
+	litest_assert_int_eq(libinput_set_quirks_override_file(li, "/does/not/exist"),
+			     -ENOENT);
+	litest_assert_int_eq(libinput_set_quirks_override_file(li, path), 0);
+
+	create_evdev_pipe(fds);
+	device = libinput_path_add_evdev_device(li,
+						create_evdev_mouse(),
+						fds[0],
+						"event9999",
+						properties);
+	litest_assert_notnull(device);
+	litest_assert_int_eq(libinput_device_pointer_has_button(device, BTN_LEFT), 1);
+	litest_assert_int_eq(libinput_device_pointer_has_button(device, BTN_MIDDLE), 0);
+
+	/* The quirks are loaded now, too late to change them */
+	litest_assert_int_eq(libinput_set_quirks_override_file(li, NULL), -EBUSY);
+
+	close(fds[0]);
+	close(fds[1]);
+	unlink(path);
+}
+END_TEST
+
+static uint64_t
+test_clock(struct libinput *libinput, void *user_data)
+{
+	uint64_t *now = user_data;
+
+	return *now;
+}
+
+START_TEST(path_set_clock)
+{
+	struct libinput_device *device;
+	struct libevdev *evdev;
+	enum libinput_config_status status;
+	const char *properties[] = {
+		"ID_INPUT=1",
+		"ID_INPUT_MOUSE=1",
+		NULL,
+	};
+	uint64_t now = s2us(1000);
+	int fds[2];
+
+	_litest_context_destroy_ struct libinput *li = litest_create_context();
+	litest_assert_int_eq(libinput_set_clock(li, test_clock, &now), 0);
+
+	/* No middle button so we can use the middle button emulation
+	 * timer */
+	evdev = create_evdev_mouse();
+	libevdev_disable_event_code(evdev, EV_KEY, BTN_MIDDLE);
+
+	create_evdev_pipe(fds);
+	device = libinput_path_add_evdev_device(li,
+						evdev,
+						fds[0],
+						"event9999",
+						properties);
+	litest_assert_notnull(device);
+	close(fds[0]);
+	litest_drain_events(li);
+
+	status = libinput_device_config_middle_emulation_set_enabled(device,
+			LIBINPUT_CONFIG_MIDDLE_EMULATION_ENABLED);
+	litest_assert_enum_eq(status, LIBINPUT_CONFIG_STATUS_SUCCESS);
+
+	struct input_event press[] = {
+		input_event_init(now, EV_KEY, BTN_LEFT, 1),
+		input_event_init(now, EV_SYN, SYN_REPORT, 0),
+	};
+	litest_assert_int_eq(write(fds[1], press, sizeof(press)),
+			     (ssize_t)sizeof(press));
+	litest_dispatch(li);
+	litest_assert_empty_queue(li);
+
+	/* The middle button timer is running in our time base */
+	litest_assert_int_eq(libinput_set_clock(li, NULL, NULL), -EBUSY);
+
+	/* Real time doesn't matter, only our clock does */
+	msleep(60);
+	litest_dispatch(li);
+	litest_assert_empty_queue(li);
+
+	now += ms2us(60);
+	litest_dispatch(li);
+	litest_assert_button_event(li, BTN_LEFT, LIBINPUT_BUTTON_STATE_PRESSED);
+
+	struct input_event release[] = {
+		input_event_init(now, EV_KEY, BTN_LEFT, 0),
+		input_event_init(now, EV_SYN, SYN_REPORT, 0),
+	};
+	litest_assert_int_eq(write(fds[1], release, sizeof(release)),
+			     (ssize_t)sizeof(release));
+	litest_dispatch(li);
+	litest_assert_button_event(li, BTN_LEFT, LIBINPUT_BUTTON_STATE_RELEASED);
+
+	/* Let the debounce timer expire */
+	now += ms2us(100);
+	litest_dispatch(li);
+	litest_assert_empty_queue(li);
+
+	close(fds[1]);
+}
+END_TEST
+
 TEST_COLLECTION(path)
 {
 	litest_add_no_device(path_create_NULL);
@@ -1033,4 +1504,13 @@ TEST_COLLECTION(path)
 	litest_add_for_device(path_udev_assign_seat, LITEST_SYNAPTICS_CLICKPAD_X220);
 
 	litest_add_no_device(path_ignore_device);
+
+	litest_add_no_device(path_add_evdev_device);
+	litest_add_no_device(path_add_evdev_device_untagged);
+	litest_add_no_device(path_add_evdev_device_blocking_fd);
+	litest_add_no_device(path_add_evdev_device_suspend);
+	litest_add_no_device(path_add_evdev_device_send_events);
+	litest_add_no_device(path_add_evdev_device_slot_capped);
+	litest_add_no_device(path_set_quirks_override_file);
+	litest_add_no_device(path_set_clock);
 }
@@ -376,6 +376,70 @@ START_TEST(pointer_motion_unaccel)
 }
 END_TEST
 
+static void
+assert_unaccel_motion_event(struct libinput *li, double dx, double dy)
+{
+	struct libinput_event *event = libinput_get_event(li);
+	struct libinput_event_pointer *ptrev = litest_is_motion_event(event);
+
+	litest_assert_double_eq(libinput_event_pointer_get_dx_unaccelerated(ptrev), dx);
+	litest_assert_double_eq(libinput_event_pointer_get_dy_unaccelerated(ptrev), dy);
+	libinput_event_destroy(event);
+}
+
+START_TEST(pointer_motion_coalesced)
+{
+	struct litest_device *dev = litest_current_device();
+	struct libinput *li = dev->libinput;
+
+	litest_drain_events(li);
+
+	for (int i = 0; i < 10; i++) {
+		litest_event(dev, EV_REL, REL_X, 1);
+		litest_event(dev, EV_REL, REL_Y, -1);
+		litest_event(dev, EV_SYN, SYN_REPORT, 0);
+	}
+	litest_dispatch(li);
+
+	/* The first frame goes through, the others are added up until the
+	 * interval is over */
+	assert_unaccel_motion_event(li, 1, -1);
+	litest_assert_empty_queue(li);
+
+	litest_timeout(li, 150);
+	assert_unaccel_motion_event(li, 9, -9);
+	litest_assert_empty_queue(li);
+}
+END_TEST
+
+START_TEST(pointer_motion_coalesced_button)
+{
+	struct litest_device *dev = litest_current_device();
+	struct libinput *li = dev->libinput;
+
+	litest_drain_events(li);
+
+	for (int i = 0; i < 3; i++) {
+		litest_event(dev, EV_REL, REL_X, 2);
+		litest_event(dev, EV_SYN, SYN_REPORT, 0);
+	}
+	litest_button_click_debounced(dev, li, BTN_LEFT, true);
+	litest_button_click_debounced(dev, li, BTN_LEFT, false);
+	litest_dispatch(li);
+
+	/* The button flushes the pending motion before it */
+	assert_unaccel_motion_event(li, 2, 0);
+	assert_unaccel_motion_event(li, 4, 0);
+	litest_assert_button_event(li, BTN_LEFT, LIBINPUT_BUTTON_STATE_PRESSED);
+	litest_assert_button_event(li, BTN_LEFT, LIBINPUT_BUTTON_STATE_RELEASED);
+	litest_assert_empty_queue(li);
+
+	/* Nothing pending, the timer mustn't send anything */
+	litest_timeout(li, 150);
+	litest_assert_empty_queue(li);
+}
+END_TEST
+
 static void
 test_button_event(struct litest_device *dev, unsigned int button, int state)
 {
@@ -3706,6 +3770,8 @@ TEST_COLLECTION(pointer)
 	}
 	litest_add(pointer_motion_absolute, LITEST_ABSOLUTE, LITEST_ANY);
 	litest_add(pointer_motion_unaccel, LITEST_RELATIVE, LITEST_ANY);
+	litest_add_for_device(pointer_motion_coalesced, LITEST_MOUSE_MOTION_RATE);
+	litest_add_for_device(pointer_motion_coalesced_button, LITEST_MOUSE_MOTION_RATE);
 	litest_add(pointer_button, LITEST_BUTTON, LITEST_CLICKPAD);
 	litest_add_no_device(pointer_button_auto_release);
 	litest_add_no_device(pointer_seat_button_count);
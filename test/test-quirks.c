@@ -1453,6 +1453,51 @@ START_TEST(quirks_call_NULL)
 }
 END_TEST
 
+START_TEST(quirks_match_properties)
+{
+	const char quirks_file[] =
+	"[Section name]\n"
+	"MatchName=*Foo*\n"
+	"MatchBus=usb\n"
+	"MatchVendor=0x1234\n"
+	"MatchUdevType=touchpad\n"
+	"ModelAppleTouchpad=1\n";
+	_destroy_(data_dir) *dd = data_dir_new(quirks_file);
+	char *match[] = {
+		"NAME=\"Foo Touchpad\"",
+		"PRODUCT=3/1234/5678/1",
+		"ID_INPUT=1",
+		"ID_INPUT_TOUCHPAD=1",
+		NULL,
+	};
+	char *nomatch[] = {
+		"NAME=\"Foo Touchpad\"",
+		"PRODUCT=3/4321/5678/1",
+		"ID_INPUT=1",
+		"ID_INPUT_TOUCHPAD=1",
+		NULL,
+	};
+	bool isset;
+
+	_unref_(quirks_context) *ctx = quirks_init_subsystem(dd->dirname,
+							     NULL,
+							     log_handler,
+							     NULL,
+							     QLOG_CUSTOM_LOG_PRIORITIES);
+	litest_assert_notnull(ctx);
+
+	_unref_(quirks) *q = quirks_fetch_for_properties(ctx, "event0", match);
+	litest_assert_notnull(q);
+	litest_assert(quirks_get_bool(q, QUIRK_MODEL_APPLE_TOUCHPAD, &isset));
+	litest_assert(isset == true);
+
+	_unref_(quirks) *q2 = quirks_fetch_for_properties(ctx, "event0", nomatch);
+	litest_assert_ptr_null(q2);
+
+	litest_assert_ptr_null(quirks_fetch_for_properties(NULL, "event0", match));
+}
+END_TEST
+
 START_TEST(quirks_ctx_ref)
 {
 	struct quirks_context *ctx, *ctx2;
@@ -1540,5 +1585,6 @@ TEST_COLLECTION(quirks)
 	litest_add(quirks_model_synaptics_serial, LITEST_TOUCHPAD, LITEST_ANY);
 
 	litest_add_deviceless(quirks_call_NULL);
+	litest_add_deviceless(quirks_match_properties);
 	litest_add_deviceless(quirks_ctx_ref);
 }
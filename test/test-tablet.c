@@ -2602,6 +2602,138 @@ START_TEST(tools_with_serials)
 }
 END_TEST
 
+START_TEST(tools_with_serials_many)
+{
+	_litest_context_destroy_ struct libinput *li = litest_create_context();
+	struct litest_device *dev[2];
+	struct libinput_tablet_tool *tools[40] = {0};
+	struct libinput_event *event;
+
+	for (int i = 0; i < 2; i++)
+		dev[i] = litest_add_device(li, LITEST_WACOM_INTUOS5_PEN);
+	litest_drain_events(li);
+
+	/* Every tool does a two-frame 500Hz stroke on both tablets, all
+	 * events of a tool must have the same tool object. Keep the
+	 * strokes short, with uinput every frame is a real write. */
+	for (int i = 0; i < 2; i++) {
+		for (size_t t = 0; t < ARRAY_LENGTH(tools); t++) {
+			uint32_t serial = 100 + t;
+
+			litest_with_event_frame(dev[i]) {
+				litest_tablet_proximity_in(dev[i], 10, 10, NULL);
+				litest_event(dev[i], EV_MSC, MSC_SERIAL, serial);
+			}
+			for (int x = 11; x < 13; x++) {
+				litest_msleep(2);
+				litest_with_event_frame(dev[i]) {
+					litest_tablet_motion(dev[i], x, 10, NULL);
+					litest_event(dev[i], EV_MSC, MSC_SERIAL, serial);
+				}
+			}
+			litest_with_event_frame(dev[i]) {
+				litest_tablet_proximity_out(dev[i]);
+				litest_event(dev[i], EV_MSC, MSC_SERIAL, serial);
+			}
+			litest_dispatch(li);
+
+			while ((event = libinput_get_event(li))) {
+				struct libinput_event_tablet_tool *tev;
+				struct libinput_tablet_tool *tool;
+
+				tev = libinput_event_get_tablet_tool_event(event);
+				litest_assert_notnull(tev);
+				tool = libinput_event_tablet_tool_get_tool(tev);
+				if (!tools[t])
+					tools[t] = tool;
+				litest_assert_ptr_eq(tool, tools[t]);
+				litest_assert_int_eq(libinput_tablet_tool_get_serial(tool),
+						     (uint64_t)serial);
+				libinput_event_destroy(event);
+			}
+		}
+	}
+
+	for (size_t t = 0; t < ARRAY_LENGTH(tools); t++) {
+		litest_assert_notnull(tools[t]);
+		for (size_t u = t + 1; u < ARRAY_LENGTH(tools); u++)
+			litest_assert_ptr_ne(tools[t], tools[u]);
+	}
+
+	litest_device_destroy(dev[0]);
+	litest_device_destroy(dev[1]);
+}
+END_TEST
+
+START_TEST(tools_with_serials_stroke_timing)
+{
+	_litest_context_destroy_ struct libinput *li = litest_create_context();
+	struct litest_device *dev[2];
+	struct libinput_tablet_tool *tools[40] = {0};
+	struct libinput_event *event;
+	uint64_t elapsed = 0;
+	size_t nframes = 0;
+
+	/* A real 500Hz stroke through uinput takes a second per stroke,
+	 * on the test clock it takes as long as libinput needs */
+	if (litest_has_uinput())
+		return LITEST_SKIP;
+
+	for (int i = 0; i < 2; i++)
+		dev[i] = litest_add_device(li, LITEST_WACOM_INTUOS5_PEN);
+	litest_drain_events(li);
+
+	/* Every tool does a one second 500Hz stroke on both tablets, the
+	 * time spent in libinput_dispatch() is printed with --verbose.
+	 * Run this at the parent commit of the tool lookup change to
+	 * compare against the list walk. */
+	for (int i = 0; i < 2; i++) {
+		for (size_t t = 0; t < ARRAY_LENGTH(tools); t++) {
+			uint32_t serial = 100 + t;
+
+			for (int x = 0; x < 500; x++) {
+				uint64_t start, end;
+
+				litest_msleep(2);
+				litest_with_event_frame(dev[i]) {
+					if (x == 0)
+						litest_tablet_proximity_in(dev[i], 10, 10, NULL);
+					else if (x == 499)
+						litest_tablet_proximity_out(dev[i]);
+					else
+						litest_tablet_motion(dev[i], 10 + x / 10, 10, NULL);
+					litest_event(dev[i], EV_MSC, MSC_SERIAL, serial);
+				}
+
+				now_in_us(&start);
+				litest_dispatch(li);
+				now_in_us(&end);
+				elapsed += end - start;
+				nframes++;
+
+				while ((event = libinput_get_event(li))) {
+					struct libinput_event_tablet_tool *tev;
+					struct libinput_tablet_tool *tool;
+
+					tev = libinput_event_get_tablet_tool_event(event);
+					tool = libinput_event_tablet_tool_get_tool(tev);
+					if (!tools[t])
+						tools[t] = tool;
+					litest_assert_ptr_eq(tool, tools[t]);
+					libinput_event_destroy(event);
+				}
+			}
+		}
+	}
+
+	printf("%zu frames from %zu tools, %.2fus per frame in libinput_dispatch()\n",
+	       nframes, ARRAY_LENGTH(tools), (double)elapsed / nframes);
+
+	litest_device_destroy(dev[0]);
+	litest_device_destroy(dev[1]);
+}
+END_TEST
+
 START_TEST(tools_without_serials)
 {
 	_litest_context_destroy_ struct libinput *li = litest_create_context();
@@ -2903,6 +3035,9 @@ START_TEST(tool_in_prox_before_start)
 	const char *devnode;
 	uint64_t serial;
 
+	if (!litest_has_uinput())
+		return LITEST_SKIP;
+
 	litest_tablet_proximity_in(dev, 10, 10, axes);
 
 	/* for simplicity, we create a new litest context */
@@ -3647,7 +3782,7 @@ device_has_calibration(struct litest_device *dev)
 		libevdev_has_event_code(dev->evdev, EV_KEY, BTN_STYLUS);
 
 #if HAVE_LIBWACOM
-	WacomDeviceDatabase *db = libwacom_database_new();
+	WacomDeviceDatabase *db = litest_has_uinput() ? libwacom_database_new() : NULL;
 	if (db) {
 		WacomDevice *d = libwacom_new_from_path(db, libevdev_uinput_get_devnode(dev->uinput), WFALLBACK_NONE, NULL);
 		if (d) {
@@ -7025,7 +7160,7 @@ START_TEST(huion_static_btn_tool_pen_no_timeout_during_usage)
 		litest_event(dev, EV_ABS, ABS_Y, 20000 - 10 * i);
 		litest_event(dev, EV_SYN, SYN_REPORT, 0);
 		litest_dispatch(li);
-		msleep(5);
+		litest_msleep(5);
 	}
 	litest_assert_only_typed_events(li,
 					LIBINPUT_EVENT_TABLET_TOOL_AXIS);
@@ -7480,6 +7615,8 @@ END_TEST
 
 TEST_COLLECTION(tablet)
 {
+	litest_uinput_optional();
+
 	litest_add(tool_ref, LITEST_TABLET | LITEST_TOOL_SERIAL, LITEST_ANY);
 	litest_add(tool_user_data, LITEST_TABLET | LITEST_TOOL_SERIAL, LITEST_ANY);
 	litest_add(tool_capability, LITEST_TABLET, LITEST_ANY);
@@ -7498,6 +7635,8 @@ TEST_COLLECTION(tablet)
 	litest_add(serial_changes_tool, LITEST_TABLET | LITEST_TOOL_SERIAL, LITEST_ANY);
 	litest_add(invalid_serials, LITEST_TABLET | LITEST_TOOL_SERIAL, LITEST_ANY);
 	litest_add_no_device(tools_with_serials);
+	litest_add_no_device(tools_with_serials_many);
+	litest_add_no_device(tools_with_serials_stroke_timing);
 	litest_add_no_device(tools_without_serials);
 	litest_add_for_device(tool_delayed_serial, LITEST_WACOM_HID4800_PEN);
 	litest_add(proximity_out_clear_buttons, LITEST_TABLET, LITEST_FORCED_PROXOUT);
@@ -7644,6 +7783,8 @@ TEST_COLLECTION(tablet)
 
 TEST_COLLECTION(tablet_left_handed)
 {
+	litest_uinput_optional();
+
 	litest_add_for_device(left_handed, LITEST_WACOM_INTUOS5_PEN);
 	litest_add_for_device(left_handed_tilt, LITEST_WACOM_INTUOS5_PEN);
 	litest_add_for_device(left_handed_mouse_rotation, LITEST_WACOM_INTUOS5_PEN);
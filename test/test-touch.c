@@ -806,6 +806,303 @@ START_TEST(touch_protocol_a_2fg_touch)
 }
 END_TEST
 
+/* With mtdev, the mt-protocol-a plugin only converts devices without a
+ * device node, see evdev_need_mtdev() */
+static bool
+protocol_a_uses_mtdev(void)
+{
+	return HAVE_MTDEV && litest_has_uinput();
+}
+
+struct protocol_a_contact {
+	int tracking_id; /* -1 for none */
+	int x, y;
+};
+
+static void
+protocol_a_send_frame(struct litest_device *dev,
+		      const struct protocol_a_contact *contacts,
+		      size_t ncontacts)
+{
+	for (size_t i = 0; i < ncontacts; i++) {
+		if (contacts[i].tracking_id != -1)
+			litest_event(dev, EV_ABS, ABS_MT_TRACKING_ID, contacts[i].tracking_id);
+		litest_event(dev, EV_ABS, ABS_MT_POSITION_X, contacts[i].x);
+		litest_event(dev, EV_ABS, ABS_MT_POSITION_Y, contacts[i].y);
+		litest_event(dev, EV_SYN, SYN_MT_REPORT, 0);
+	}
+
+	/* An empty SYN_MT_REPORT means no contacts */
+	if (ncontacts == 0)
+		litest_event(dev, EV_SYN, SYN_MT_REPORT, 0);
+
+	litest_event(dev, EV_KEY, BTN_TOUCH, ncontacts > 0);
+	litest_event(dev, EV_SYN, SYN_REPORT, 0);
+}
+
+struct protocol_a_touches {
+	unsigned int ndown, nmotion, nup;
+	double x[10]; /* in percent of the width, per slot */
+};
+
+static void
+protocol_a_collect_touches(struct libinput *li,
+			   struct protocol_a_touches *touches)
+{
+	struct libinput_event *ev;
+
+	memset(touches, 0, sizeof(*touches));
+
+	litest_dispatch(li);
+	while ((ev = libinput_get_event(li))) {
+		struct libinput_event_touch *tev = libinput_event_get_touch_event(ev);
+		enum libinput_event_type type = libinput_event_get_type(ev);
+		int slot;
+
+		litest_assert_notnull(tev);
+
+		if (type != LIBINPUT_EVENT_TOUCH_FRAME) {
+			slot = libinput_event_touch_get_slot(tev);
+			litest_assert_int_ge(slot, 0);
+			litest_assert_int_lt(slot, (int)ARRAY_LENGTH(touches->x));
+		}
+
+		switch (type) {
+		case LIBINPUT_EVENT_TOUCH_DOWN:
+			touches->ndown++;
+			touches->x[slot] = libinput_event_touch_get_x_transformed(tev, 100);
+			break;
+		case LIBINPUT_EVENT_TOUCH_MOTION:
+			touches->nmotion++;
+			touches->x[slot] = libinput_event_touch_get_x_transformed(tev, 100);
+			break;
+		case LIBINPUT_EVENT_TOUCH_UP:
+			touches->nup++;
+			break;
+		default:
+			break;
+		}
+
+		libinput_event_destroy(ev);
+	}
+}
+
+START_TEST(touch_protocol_a_tracking_id)
+{
+	struct litest_device *dev;
+	struct libinput *li;
+	struct protocol_a_touches touches;
+	struct input_absinfo abs[] = {
+		{ ABS_MT_TRACKING_ID, 0, 65535, 0, 0, 0 },
+		{ .value = -1 },
+	};
+	int left;
+
+	if (protocol_a_uses_mtdev())
+		return LITEST_SKIP;
+
+	dev = litest_create_device_with_overrides(LITEST_PROTOCOL_A_SCREEN,
+						  "litest Protocol A tracking ID",
+						  NULL, abs, NULL);
+	li = dev->libinput;
+	litest_drain_events(li);
+
+	struct protocol_a_contact down[] = {
+		{ 10, 3000, 3000 },
+		{ 11, 30000, 30000 },
+	};
+	protocol_a_send_frame(dev, down, ARRAY_LENGTH(down));
+	protocol_a_collect_touches(li, &touches);
+	litest_assert_int_eq(touches.ndown, 2U);
+	left = touches.x[0] < 50 ? 0 : 1;
+
+	/* The contacts swap places, closer to each other's old position
+	 * than to their own. Matching by distance would swap the slots,
+	 * the tracking IDs say they didn't. */
+	struct protocol_a_contact swapped[] = {
+		{ 11, 4000, 4000 },
+		{ 10, 29000, 29000 },
+	};
+	protocol_a_send_frame(dev, swapped, ARRAY_LENGTH(swapped));
+	protocol_a_collect_touches(li, &touches);
+	litest_assert_int_eq(touches.ndown, 0U);
+	litest_assert_int_eq(touches.nup, 0U);
+	litest_assert_int_eq(touches.nmotion, 2U);
+	litest_assert_double_gt(touches.x[left], 50.0);
+	litest_assert_double_lt(touches.x[1 - left], 50.0);
+
+	/* A new tracking ID is a new touch, even in the same place */
+	struct protocol_a_contact replaced[] = {
+		{ 12, 4000, 4000 },
+		{ 10, 29000, 29000 },
+	};
+	protocol_a_send_frame(dev, replaced, ARRAY_LENGTH(replaced));
+	protocol_a_collect_touches(li, &touches);
+	litest_assert_int_eq(touches.nup, 1U);
+	litest_assert_int_eq(touches.ndown, 1U);
+
+	protocol_a_send_frame(dev, NULL, 0);
+	protocol_a_collect_touches(li, &touches);
+	litest_assert_int_eq(touches.nup, 2U);
+
+	litest_device_destroy(dev);
+}
+END_TEST
+
+START_TEST(touch_protocol_a_distance_matching)
+{
+	struct litest_device *dev = litest_current_device();
+	struct libinput *li = dev->libinput;
+	struct protocol_a_touches touches;
+	int left;
+
+	litest_drain_events(li);
+
+	struct protocol_a_contact down[] = {
+		{ -1, 3000, 3000 },
+		{ -1, 30000, 30000 },
+	};
+	protocol_a_send_frame(dev, down, ARRAY_LENGTH(down));
+	protocol_a_collect_touches(li, &touches);
+	litest_assert_int_eq(touches.ndown, 2U);
+	left = touches.x[0] < 50 ? 0 : 1;
+
+	/* Protocol A has no order, each contact must stay with the
+	 * touch closest to it */
+	struct protocol_a_contact reordered[] = {
+		{ -1, 29000, 29000 },
+		{ -1, 4000, 4000 },
+	};
+	protocol_a_send_frame(dev, reordered, ARRAY_LENGTH(reordered));
+	protocol_a_collect_touches(li, &touches);
+	litest_assert_int_eq(touches.ndown, 0U);
+	litest_assert_int_eq(touches.nup, 0U);
+	litest_assert_int_eq(touches.nmotion, 2U);
+	litest_assert_double_lt(touches.x[left], 50.0);
+	litest_assert_double_gt(touches.x[1 - left], 50.0);
+
+	/* One contact left, it's the one on the right */
+	struct protocol_a_contact lifted[] = {
+		{ -1, 29000, 29000 },
+	};
+	protocol_a_send_frame(dev, lifted, ARRAY_LENGTH(lifted));
+	protocol_a_collect_touches(li, &touches);
+	litest_assert_int_eq(touches.nup, 1U);
+	litest_assert_int_eq(touches.ndown, 0U);
+
+	protocol_a_send_frame(dev, NULL, 0);
+	protocol_a_collect_touches(li, &touches);
+	litest_assert_int_eq(touches.nup, 1U);
+}
+END_TEST
+
+START_TEST(touch_protocol_a_too_many_contacts)
+{
+	struct litest_device *dev = litest_current_device();
+	struct libinput *li = dev->libinput;
+	struct protocol_a_touches touches;
+	struct protocol_a_contact contacts[12];
+
+	if (protocol_a_uses_mtdev())
+		return LITEST_SKIP;
+
+	litest_drain_events(li);
+
+	for (size_t i = 0; i < ARRAY_LENGTH(contacts); i++) {
+		contacts[i] = (struct protocol_a_contact) {
+			.tracking_id = -1,
+			.x = 1000 + i * 2500,
+			.y = 1000 + i * 2500,
+		};
+	}
+
+	/* We have 10 slots, the extra contacts are ignored */
+	protocol_a_send_frame(dev, contacts, ARRAY_LENGTH(contacts));
+	protocol_a_collect_touches(li, &touches);
+	litest_assert_int_eq(touches.ndown, 10U);
+
+	protocol_a_send_frame(dev, NULL, 0);
+	protocol_a_collect_touches(li, &touches);
+	litest_assert_int_eq(touches.nup, 10U);
+
+	/* And the slots are usable again */
+	protocol_a_send_frame(dev, contacts, 1);
+	protocol_a_collect_touches(li, &touches);
+	litest_assert_int_eq(touches.ndown, 1U);
+
+	protocol_a_send_frame(dev, NULL, 0);
+	protocol_a_collect_touches(li, &touches);
+	litest_assert_int_eq(touches.nup, 1U);
+}
+END_TEST
+
+START_TEST(touch_protocol_a_frame_overflow)
+{
+	struct litest_device *dev;
+	struct libinput *li;
+	struct protocol_a_touches touches;
+	struct input_absinfo abs[] = {
+		{ ABS_MT_TOUCH_MAJOR, 0, 255, 0, 0, 0 },
+		{ ABS_MT_TOUCH_MINOR, 0, 255, 0, 0, 0 },
+		{ .value = -1 },
+	};
+
+	dev = litest_create_device_with_overrides(LITEST_PROTOCOL_A_SCREEN,
+						  "litest Protocol A touch size",
+						  NULL, abs, NULL);
+	li = dev->libinput;
+	litest_drain_events(li);
+
+	/* 10 new touches with 5 axes each fit into the frame we read,
+	 * but not once every touch has its ABS_MT_SLOT and
+	 * ABS_MT_TRACKING_ID */
+	for (int i = 0; i < 10; i++) {
+		litest_event(dev, EV_ABS, ABS_MT_POSITION_X, 1000 + i * 3000);
+		litest_event(dev, EV_ABS, ABS_MT_POSITION_Y, 1000 + i * 3000);
+		litest_event(dev, EV_ABS, ABS_MT_PRESSURE, 1);
+		litest_event(dev, EV_ABS, ABS_MT_TOUCH_MAJOR, 20 + i);
+		litest_event(dev, EV_ABS, ABS_MT_TOUCH_MINOR, 10 + i);
+		litest_event(dev, EV_SYN, SYN_MT_REPORT, 0);
+	}
+	litest_event(dev, EV_KEY, BTN_TOUCH, 1);
+	litest_event(dev, EV_SYN, SYN_REPORT, 0);
+
+	protocol_a_collect_touches(li, &touches);
+	litest_assert_int_eq(touches.ndown, 10U);
+	for (size_t i = 1; i < ARRAY_LENGTH(touches.x); i++)
+		litest_assert_double_ne(touches.x[i], touches.x[i - 1]);
+
+	protocol_a_send_frame(dev, NULL, 0);
+	protocol_a_collect_touches(li, &touches);
+	litest_assert_int_eq(touches.nup, 10U);
+
+	litest_device_destroy(dev);
+}
+END_TEST
+
+START_TEST(touch_protocol_a_clip_to_axis_range)
+{
+	struct litest_device *dev = litest_current_device();
+	struct libinput *li = dev->libinput;
+	struct protocol_a_touches touches;
+
+	litest_drain_events(li);
+
+	struct protocol_a_contact outside[] = {
+		{ -1, 40000, 1000 },
+	};
+	protocol_a_send_frame(dev, outside, ARRAY_LENGTH(outside));
+	protocol_a_collect_touches(li, &touches);
+	litest_assert_int_eq(touches.ndown, 1U);
+	for (size_t i = 0; i < ARRAY_LENGTH(touches.x); i++)
+		litest_assert_double_le(touches.x[i], 100.0);
+
+	protocol_a_send_frame(dev, NULL, 0);
+	protocol_a_collect_touches(li, &touches);
+	litest_assert_int_eq(touches.nup, 1U);
+}
+END_TEST
+
 START_TEST(touch_initial_state)
 {
 	struct litest_device *dev;
@@ -897,6 +1194,65 @@ START_TEST(touch_time_usec)
 }
 END_TEST
 
+START_TEST(touch_time_after_syn_dropped)
+{
+	struct litest_device *dev = litest_current_device();
+	struct libinput *li = dev->libinput;
+	struct libinput_event *event;
+	uint64_t last_time = 0;
+	int ndown = 0;
+
+	litest_drain_events(li);
+
+	litest_touch_down(dev, 0, 10, 10);
+	litest_dispatch(li);
+
+	/* Force a SYN_DROPPED */
+	for (int i = 0; i < 500; i++)
+		litest_touch_move(dev, 0, 10 + 0.1 * i, 10 + 0.1 * i);
+
+	/* still within SYN_DROPPED, the sync frame must have the new
+	 * touches and a timestamp that doesn't go backwards */
+	litest_touch_up(dev, 0);
+	litest_touch_down(dev, 0, 50, 50);
+	litest_touch_down(dev, 1, 70, 50);
+	litest_dispatch(li);
+
+	while ((event = libinput_get_event(li))) {
+		struct libinput_event_touch *tev = libinput_event_get_touch_event(event);
+		uint64_t time;
+
+		litest_assert_notnull(tev);
+		time = libinput_event_touch_get_time_usec(tev);
+		litest_assert_int_ge(time, last_time);
+		last_time = time;
+
+		if (libinput_event_get_type(event) == LIBINPUT_EVENT_TOUCH_DOWN)
+			ndown++;
+		libinput_event_destroy(event);
+	}
+	litest_assert_int_ge(ndown, 2);
+
+	/* And we're back to normal */
+	litest_touch_move_two_touches(dev, 50, 50, 70, 50, 10, 10, 5);
+	litest_dispatch(li);
+
+	while ((event = libinput_get_event(li))) {
+		struct libinput_event_touch *tev = libinput_event_get_touch_event(event);
+		uint64_t time;
+
+		litest_assert_notnull(tev);
+		time = libinput_event_touch_get_time_usec(tev);
+		litest_assert_int_ge(time, last_time);
+		last_time = time;
+		libinput_event_destroy(event);
+	}
+
+	litest_touch_up(dev, 0);
+	litest_touch_up(dev, 1);
+}
+END_TEST
+
 START_TEST(touch_fuzz)
 {
 	struct litest_device *dev = litest_current_device();
@@ -1355,12 +1711,18 @@ TEST_COLLECTION(touch)
 	litest_add(touch_protocol_a_init, LITEST_PROTOCOL_A, LITEST_ANY);
 	litest_add(touch_protocol_a_touch, LITEST_PROTOCOL_A, LITEST_ANY);
 	litest_add(touch_protocol_a_2fg_touch, LITEST_PROTOCOL_A, LITEST_ANY);
+	litest_add_no_device(touch_protocol_a_tracking_id);
+	litest_add(touch_protocol_a_distance_matching, LITEST_PROTOCOL_A, LITEST_ANY);
+	litest_add(touch_protocol_a_too_many_contacts, LITEST_PROTOCOL_A, LITEST_ANY);
+	litest_add_no_device(touch_protocol_a_frame_overflow);
+	litest_add(touch_protocol_a_clip_to_axis_range, LITEST_PROTOCOL_A, LITEST_ANY);
 
 	litest_with_parameters(params, "axis", 'I', 2, litest_named_i32(ABS_X), litest_named_i32(ABS_Y)) {
 		litest_add_parametrized(touch_initial_state, LITEST_TOUCH, LITEST_PROTOCOL_A, params);
 	}
 
 	litest_add(touch_time_usec, LITEST_TOUCH, LITEST_TOUCHPAD);
+	litest_add(touch_time_after_syn_dropped, LITEST_TOUCH, LITEST_TOUCHPAD|LITEST_PROTOCOL_A);
 
 	litest_add_for_device(touch_fuzz, LITEST_MULTITOUCH_FUZZ_SCREEN);
 	litest_add_for_device(touch_fuzz_property, LITEST_MULTITOUCH_FUZZ_SCREEN);
@@ -2204,6 +2204,9 @@ START_TEST(touchpad_non_clickpad_detection)
 	};
 	uint32_t methods;
 
+	if (!litest_has_uinput())
+		return LITEST_SKIP;
+
 	/* Create a touchpad with only a left button but missing
 	 * INPUT_PROP_BUTTONPAD. We should treat this as clickpad.
 	 */
@@ -2230,6 +2233,8 @@ END_TEST
 
 TEST_COLLECTION(touchpad_buttons)
 {
+	litest_uinput_optional();
+
 	litest_add(touchpad_button, LITEST_TOUCHPAD, LITEST_CLICKPAD);
 
 	litest_add(touchpad_1fg_clickfinger, LITEST_CLICKPAD, LITEST_ANY);
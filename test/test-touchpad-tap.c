@@ -117,7 +117,7 @@ START_TEST(touchpad_doubletap)
 		litest_touch_down(dev, 0, 40, 30);
 		break;
 	}
-	msleep(10);
+	litest_msleep(10);
 	switch (nfingers) {
 	case 3:
 		litest_touch_up(dev, 2);
@@ -129,7 +129,7 @@ START_TEST(touchpad_doubletap)
 		litest_touch_up(dev, 0);
 		break;
 	}
-	msleep(10);
+	litest_msleep(10);
 
 	switch (nfingers2) {
 	case 3:
@@ -142,7 +142,7 @@ START_TEST(touchpad_doubletap)
 		litest_touch_down(dev, 0, 40, 30);
 		break;
 	}
-	msleep(10);
+	litest_msleep(10);
 	switch (nfingers2) {
 	case 3:
 		litest_touch_up(dev, 2);
@@ -254,7 +254,7 @@ START_TEST(touchpad_multitap)
 		}
 
 		litest_dispatch(li);
-		msleep(10);
+		litest_msleep(10);
 	}
 
 	litest_timeout_tapndrag(li);
@@ -342,7 +342,7 @@ START_TEST(touchpad_multitap_n_drag_move)
 			break;
 		}
 		litest_dispatch(li);
-		msleep(10);
+		litest_msleep(10);
 	}
 
 	litest_dispatch(li);
@@ -454,7 +454,7 @@ START_TEST(touchpad_multitap_n_drag_2fg)
 		}
 
 		litest_dispatch(li);
-		msleep(10);
+		litest_msleep(10);
 	}
 
 	litest_dispatch(li);
@@ -567,7 +567,7 @@ START_TEST(touchpad_multitap_n_drag_click)
 		}
 
 		litest_dispatch(li);
-		msleep(10);
+		litest_msleep(10);
 	}
 
 	litest_touch_down(dev, 0, 50, 50);
@@ -655,7 +655,7 @@ START_TEST(touchpad_multitap_timeout)
 			litest_touch_down(dev, 0, 40, 30);
 			break;
 		}
-		msleep(10);
+		litest_msleep(10);
 		switch (nfingers) {
 		case 3:
 			litest_touch_up(dev, 2);
@@ -669,7 +669,7 @@ START_TEST(touchpad_multitap_timeout)
 		}
 
 		litest_dispatch(li);
-		msleep(10);
+		litest_msleep(10);
 	}
 
 	litest_timeout_tapndrag(li);
@@ -743,7 +743,7 @@ START_TEST(touchpad_multitap_n_drag_timeout)
 			litest_touch_down(dev, 0, 40, 30);
 			break;
 		}
-		msleep(10);
+		litest_msleep(10);
 		switch (nfingers) {
 		case 3:
 			litest_touch_up(dev, 2);
@@ -757,7 +757,7 @@ START_TEST(touchpad_multitap_n_drag_timeout)
 		}
 
 		litest_dispatch(li);
-		msleep(10);
+		litest_msleep(10);
 	}
 
 	litest_dispatch(li);
@@ -855,7 +855,7 @@ START_TEST(touchpad_multitap_n_drag_high_delay)
 			break;
 		}
 		litest_dispatch(li);
-		msleep(100);
+		litest_msleep(100);
 
 		switch (nfingers) {
 		case 3:
@@ -869,7 +869,7 @@ START_TEST(touchpad_multitap_n_drag_high_delay)
 			break;
 		}
 		litest_dispatch(li);
-		msleep(100);
+		litest_msleep(100);
 	}
 
 	litest_dispatch(li);
@@ -946,7 +946,7 @@ START_TEST(touchpad_multitap_n_drag_tap)
 			litest_touch_down(dev, 0, 40, 30);
 			break;
 		}
-		msleep(10);
+		litest_msleep(10);
 		switch (nfingers) {
 		case 3:
 			litest_touch_up(dev, 2);
@@ -960,7 +960,7 @@ START_TEST(touchpad_multitap_n_drag_tap)
 		}
 
 		litest_dispatch(li);
-		msleep(10);
+		litest_msleep(10);
 	}
 
 	litest_dispatch(li);
@@ -1058,7 +1058,7 @@ START_TEST(touchpad_multitap_n_drag_tap_click)
 			litest_touch_down(dev, 0, 40, 30);
 			break;
 		}
-		msleep(10);
+		litest_msleep(10);
 		switch (nfingers) {
 		case 3:
 			litest_touch_up(dev, 2);
@@ -1072,7 +1072,7 @@ START_TEST(touchpad_multitap_n_drag_tap_click)
 		}
 
 		litest_dispatch(li);
-		msleep(10);
+		litest_msleep(10);
 	}
 
 	litest_dispatch(li);
@@ -2861,11 +2861,11 @@ START_TEST(touchpad_3fg_tap)
 		litest_drain_events(li);
 
 		litest_touch_down(dev, 0, 50, 50);
-		msleep(5);
+		litest_msleep(5);
 		litest_touch_down(dev, 1, 70, 50);
-		msleep(5);
+		litest_msleep(5);
 		litest_touch_down(dev, 2, 80, 50);
-		msleep(10);
+		litest_msleep(10);
 
 		litest_touch_up(dev, (i + 2) % 3);
 		litest_touch_up(dev, (i + 1) % 3);
@@ -2911,15 +2911,15 @@ START_TEST(touchpad_3fg_tap_tap_again)
 	litest_drain_events(li);
 
 	litest_touch_down(dev, 0, 50, 50);
-	msleep(5);
+	litest_msleep(5);
 	litest_touch_down(dev, 1, 70, 50);
-	msleep(5);
+	litest_msleep(5);
 	litest_touch_down(dev, 2, 80, 50);
-	msleep(10);
+	litest_msleep(10);
 	litest_touch_up(dev, 0);
-	msleep(10);
+	litest_msleep(10);
 	litest_touch_down(dev, 0, 80, 50);
-	msleep(10);
+	litest_msleep(10);
 	litest_touch_up(dev, 0);
 	litest_touch_up(dev, 1);
 	litest_touch_up(dev, 2);
@@ -3277,7 +3277,7 @@ START_TEST(touchpad_3fg_tap_slot_release_btntool)
 	litest_event(dev, EV_KEY, BTN_TOUCH, 1);
 	litest_event(dev, EV_SYN, SYN_REPORT, 0);
 	litest_dispatch(li);
-	msleep(2);
+	litest_msleep(2);
 
 	/* touch 2 and TRIPLETAP down */
 	litest_event(dev, EV_ABS, ABS_MT_SLOT, 1);
@@ -3289,7 +3289,7 @@ START_TEST(touchpad_3fg_tap_slot_release_btntool)
 	litest_event(dev, EV_KEY, BTN_TOOL_TRIPLETAP, 1);
 	litest_event(dev, EV_SYN, SYN_REPORT, 0);
 	litest_dispatch(li);
-	msleep(2);
+	litest_msleep(2);
 
 	/* touch 2 up, coordinate jump + ends slot 1, TRIPLETAP stays */
 	litest_disable_log_handler(li);
@@ -3304,7 +3304,7 @@ START_TEST(touchpad_3fg_tap_slot_release_btntool)
 	litest_event(dev, EV_ABS, ABS_PRESSURE, 78);
 	litest_event(dev, EV_SYN, SYN_REPORT, 0);
 	litest_dispatch(li);
-	msleep(2);
+	litest_msleep(2);
 
 	/* slot 2 reactivated
 	 */
@@ -4017,7 +4017,7 @@ START_TEST(touchpad_drag_disabled_immediate)
 		litest_touch_down(dev, 0, 40, 30);
 		break;
 	}
-	msleep(10); /* to force a time difference */
+	litest_msleep(10); /* to force a time difference */
 	litest_dispatch(li);
 	switch (nfingers) {
 	case 3:
@@ -4111,7 +4111,7 @@ START_TEST(touchpad_drag_disabled_multitap_no_drag)
 		}
 
 		litest_dispatch(li);
-		msleep(10);
+		litest_msleep(10);
 	}
 
 	litest_dispatch(li);
@@ -5175,7 +5175,7 @@ START_TEST(touchpad_tap_palm_multitap)
 		}
 
 		litest_dispatch(li);
-		msleep(10);
+		litest_msleep(10);
 	}
 
 	litest_touch_down(dev, 0, 50, 50);
@@ -5259,7 +5259,7 @@ START_TEST(touchpad_tap_palm_multitap_timeout)
 		}
 
 		litest_dispatch(li);
-		msleep(10);
+		litest_msleep(10);
 	}
 
 	litest_touch_down(dev, 0, 50, 50);
@@ -5342,7 +5342,7 @@ START_TEST(touchpad_tap_palm_multitap_down_again)
 		}
 
 		litest_dispatch(li);
-		msleep(10);
+		litest_msleep(10);
 	}
 
 	litest_touch_down(dev, 0, 50, 50);
@@ -5375,7 +5375,7 @@ START_TEST(touchpad_tap_palm_multitap_down_again)
 		}
 
 		litest_dispatch(li);
-		msleep(10);
+		litest_msleep(10);
 	}
 
 	litest_timeout_tap(li);
@@ -5457,7 +5457,7 @@ START_TEST(touchpad_tap_palm_multitap_click)
 		}
 
 		litest_dispatch(li);
-		msleep(10);
+		litest_msleep(10);
 	}
 
 	litest_touch_down(dev, 0, 50, 50);
@@ -5619,6 +5619,8 @@ END_TEST
 
 TEST_COLLECTION(touchpad_tap)
 {
+	litest_uinput_optional();
+
 	litest_add(touchpad_1fg_tap, LITEST_TOUCHPAD, LITEST_ANY);
 	litest_with_parameters(params, "fingers_1st", 'i', 3, 1, 2, 3,
 				       "fingers_2nd", 'i', 3, 1, 2, 3) {
@@ -5692,6 +5694,8 @@ TEST_COLLECTION(touchpad_tap)
 
 TEST_COLLECTION(touchpad_tap_drag)
 {
+	litest_uinput_optional();
+
 	litest_add(touchpad_drag_lock_default_disabled, LITEST_TOUCHPAD, LITEST_ANY);
 	litest_add(touchpad_drag_lock_default_unavailable, LITEST_ANY, LITEST_TOUCHPAD);
 
@@ -5747,6 +5751,8 @@ TEST_COLLECTION(touchpad_tap_drag)
 
 TEST_COLLECTION(touchpad_tap_palm)
 {
+	litest_uinput_optional();
+
 	litest_add(touchpad_tap_palm_on_idle, LITEST_TOUCHPAD, LITEST_ANY);
 	litest_add(touchpad_tap_palm_on_touch, LITEST_TOUCHPAD, LITEST_ANY);
 	litest_add(touchpad_tap_palm_on_touch_hold_timeout, LITEST_TOUCHPAD, LITEST_ANY);
@@ -352,7 +352,7 @@ START_TEST(touchpad_2fg_scroll_axis_lock_switch)
 	litest_assert(is_single_axis_2fg_scroll(dev, axis));
 	litest_drain_events(li);
 
-	msleep(200);
+	litest_msleep(200);
 	litest_dispatch(li);
 
 	/* Move roughly vertically for >100ms to switch axis lock. This will
@@ -3565,6 +3565,9 @@ START_TEST(touchpad_initial_state)
 	int x = 40, y = 60;
 	int axis = litest_test_param_get_i32(test_env->params, "axis");
 
+	if (!litest_has_uinput())
+		return LITEST_SKIP;
+
 	dev = litest_current_device();
 	libinput1 = dev->libinput;
 
@@ -3627,6 +3630,9 @@ START_TEST(touchpad_fingers_down_before_init)
 {
 	struct litest_device *dev = litest_current_device();
 
+	if (!litest_has_uinput())
+		return LITEST_SKIP;
+
 	int finger_count = litest_test_param_get_i32(test_env->params, "fingers");
 	unsigned int map[] = {0, BTN_TOOL_PEN, BTN_TOOL_DOUBLETAP,
 			      BTN_TOOL_TRIPLETAP, BTN_TOOL_QUADTAP,
@@ -3700,6 +3706,10 @@ START_TEST(touchpad_state_after_syn_dropped_2fg_change)
 	struct litest_device *dev = litest_current_device();
 	struct libinput *li = dev->libinput;
 
+	/* fake devices never overflow, there is no SYN_DROPPED */
+	if (!litest_has_uinput())
+		return LITEST_SKIP;
+
 	litest_drain_events(li);
 	litest_disable_tap(dev->libinput_device);
 	litest_disable_hold_gestures(dev->libinput_device);
@@ -3838,7 +3848,7 @@ START_TEST(touchpad_dwt_enable_touch)
 
 	/* finger down after last key event, but
 	   we're still within timeout - no events */
-	msleep(10);
+	litest_msleep(10);
 	litest_touch_down(touchpad, 0, 50, 50);
 	litest_touch_move_to(touchpad, 0, 50, 50, 70, 50, 10);
 	litest_assert_empty_queue(li);
@@ -3870,7 +3880,7 @@ START_TEST(touchpad_dwt_touch_hold)
 	litest_drain_events(li);
 
 	litest_keyboard_key(keyboard, KEY_A, true);
-	msleep(1); /* make sure touch starts after key press */
+	litest_msleep(1); /* make sure touch starts after key press */
 	litest_touch_down(touchpad, 0, 50, 50);
 	litest_touch_move_to(touchpad, 0, 50, 50, 70, 50, 5);
 
@@ -4462,7 +4472,7 @@ START_TEST(touchpad_dwt_tap_drag)
 
 	litest_keyboard_key(keyboard, KEY_A, true);
 	litest_dispatch(li);
-	msleep(1); /* make sure touch starts after key press */
+	litest_msleep(1); /* make sure touch starts after key press */
 	litest_touch_down(touchpad, 0, 50, 50);
 	litest_touch_up(touchpad, 0);
 	litest_touch_down(touchpad, 0, 50, 50);
@@ -5381,6 +5391,108 @@ START_TEST(touchpad_thumb_speed_empty_slots)
 }
 END_TEST
 
+START_TEST(touchpad_2fg_scroll_high_slots)
+{
+	struct litest_device *dev = litest_current_device();
+	struct libinput *li = dev->libinput;
+	int nslots = libevdev_get_num_slots(dev->evdev);
+
+	if (nslots < 4)
+		return LITEST_NOT_APPLICABLE;
+
+	litest_disable_tap(dev->libinput_device);
+	litest_enable_2fg_scroll(dev);
+	litest_disable_hold_gestures(dev->libinput_device);
+	litest_drain_events(li);
+
+	/* scroll with the two highest slots only, all lower slots
+	 * stay empty */
+	int s1 = nslots - 2,
+	    s2 = nslots - 1;
+
+	litest_touch_down(dev, s1, 50, 50);
+	litest_touch_down(dev, s2, 55, 50);
+	litest_dispatch(li);
+	for (int i = 0, y = 50; i < 10; i++, y++) {
+		litest_touch_move_to(dev, s1, 50, y, 50, y + 1, 1);
+		litest_touch_move_to(dev, s2, 55, y, 55, y + 1, 1);
+	}
+	litest_dispatch(li);
+	litest_touch_up(dev, s1);
+	litest_touch_up(dev, s2);
+	litest_dispatch(li);
+	litest_assert_scroll(li,
+			     LIBINPUT_EVENT_POINTER_SCROLL_FINGER,
+			     LIBINPUT_POINTER_AXIS_SCROLL_VERTICAL,
+			     2);
+}
+END_TEST
+
+START_TEST(touchpad_msc_timestamp_frame_time)
+{
+	struct litest_device *dev = litest_current_device();
+	struct libinput *li = dev->libinput;
+	uint64_t prev_time = 0;
+	uint64_t start, now;
+	int prev_frame = -1;
+	int npairs = 0;
+
+	litest_disable_tap(dev->libinput_device);
+	litest_disable_hold_gestures(dev->libinput_device);
+	litest_drain_events(li);
+
+	now_in_us(&start);
+	litest_event(dev, EV_MSC, MSC_TIMESTAMP, 0);
+	litest_touch_down(dev, 0, 30, 50);
+	litest_dispatch(li);
+
+	/* The kernel sees a frame every 9ms, the hardware claims 8ms. Our
+	 * event times must follow the hardware */
+	for (int i = 1; i < 8; i++) {
+		struct libinput_event *event;
+		bool check = true;
+
+		litest_msleep(9);
+
+		/* With uinput the kernel times are real times. Where the
+		 * sleeps took so long that the kernel time is close to the
+		 * maximum lag behind the hw time, the frame time follows
+		 * the kernel time instead, don't check those frames */
+		if (litest_has_uinput()) {
+			now_in_us(&now);
+			check = (int64_t)(now - start) - i * 8000 < (int64_t)ms2us(15);
+		}
+
+		litest_event(dev, EV_MSC, MSC_TIMESTAMP, i * 8000);
+		litest_touch_move(dev, 0, 30 + 3 * i, 50);
+		litest_dispatch(li);
+
+		while ((event = libinput_get_event(li))) {
+			struct libinput_event_pointer *ptrev;
+			uint64_t time;
+
+			ptrev = litest_is_motion_event(event);
+			time = libinput_event_pointer_get_time_usec(ptrev);
+			if (check && prev_frame == i - 1) {
+				litest_assert_int_ge(time - prev_time, 7500U);
+				litest_assert_int_le(time - prev_time, 8500U);
+				npairs++;
+			}
+			prev_time = time;
+			prev_frame = i;
+			libinput_event_destroy(event);
+		}
+	}
+
+	/* On the test clock every frame is on time */
+	litest_assert_int_ge(npairs, litest_has_uinput() ? 1 : 3);
+
+	litest_touch_up(dev, 0);
+	litest_dispatch(li);
+	litest_drain_events(li);
+}
+END_TEST
+
 START_TEST(touchpad_thumb_area_clickfinger)
 {
 	struct litest_device *dev = litest_current_device();
@@ -5492,7 +5604,7 @@ START_TEST(touchpad_thumb_no_doublethumb)
 	 * between to make it more likely that this is really testing thumb
 	 * detection.
 	 */
-	msleep(200);
+	litest_msleep(200);
 	litest_dispatch(li);
 	litest_touch_down(dev, 1, 70, 99);
 	litest_dispatch(li);
@@ -5531,7 +5643,7 @@ START_TEST(touchpad_tool_tripletap_touch_count)
 	litest_event(dev, EV_KEY, BTN_TOUCH, 1);
 	litest_event(dev, EV_SYN, SYN_REPORT, 0);
 	litest_dispatch(li);
-	msleep(2);
+	litest_msleep(2);
 
 	/* touch 2 down */
 	litest_event(dev, EV_ABS, ABS_MT_SLOT, 1);
@@ -5543,7 +5655,7 @@ START_TEST(touchpad_tool_tripletap_touch_count)
 	litest_event(dev, EV_KEY, BTN_TOOL_DOUBLETAP, 1);
 	litest_event(dev, EV_SYN, SYN_REPORT, 0);
 	litest_dispatch(li);
-	msleep(2);
+	litest_msleep(2);
 
 	/* touch 3 down, coordinate jump + ends slot 1 */
 	litest_event(dev, EV_ABS, ABS_MT_SLOT, 0);
@@ -5559,7 +5671,7 @@ START_TEST(touchpad_tool_tripletap_touch_count)
 	litest_event(dev, EV_KEY, BTN_TOOL_TRIPLETAP, 1);
 	litest_event(dev, EV_SYN, SYN_REPORT, 0);
 	litest_dispatch(li);
-	msleep(2);
+	litest_msleep(2);
 
 	/* slot 2 reactivated */
 	litest_event(dev, EV_ABS, ABS_MT_SLOT, 0);
@@ -5576,7 +5688,7 @@ START_TEST(touchpad_tool_tripletap_touch_count)
 	litest_event(dev, EV_ABS, ABS_PRESSURE, 78);
 	litest_event(dev, EV_SYN, SYN_REPORT, 0);
 	litest_dispatch(li);
-	msleep(2);
+	litest_msleep(2);
 
 	/* now a click should trigger middle click */
 	litest_event(dev, EV_KEY, BTN_LEFT, 1);
@@ -5637,7 +5749,7 @@ START_TEST(touchpad_tool_tripletap_touch_count_late)
 	litest_event(dev, EV_KEY, BTN_TOUCH, 1);
 	litest_event(dev, EV_SYN, SYN_REPORT, 0);
 	litest_dispatch(li);
-	msleep(10);
+	litest_msleep(10);
 
 	/* touch 2 and TRIPLETAP down */
 	litest_event(dev, EV_ABS, ABS_MT_SLOT, 1);
@@ -5649,7 +5761,7 @@ START_TEST(touchpad_tool_tripletap_touch_count_late)
 	litest_event(dev, EV_KEY, BTN_TOOL_TRIPLETAP, 1);
 	litest_event(dev, EV_SYN, SYN_REPORT, 0);
 	litest_dispatch(li);
-	msleep(10);
+	litest_msleep(10);
 
 	/* touch 2 up, coordinate jump + ends slot 1, TRIPLETAP stays */
 	litest_disable_log_handler(li);
@@ -5664,7 +5776,7 @@ START_TEST(touchpad_tool_tripletap_touch_count_late)
 	litest_event(dev, EV_ABS, ABS_PRESSURE, 78);
 	litest_event(dev, EV_SYN, SYN_REPORT, 0);
 	litest_dispatch(li);
-	msleep(10);
+	litest_msleep(10);
 
 	/* slot 2 reactivated */
 	litest_event(dev, EV_ABS, ABS_MT_SLOT, 0);
@@ -5681,7 +5793,7 @@ START_TEST(touchpad_tool_tripletap_touch_count_late)
 	litest_event(dev, EV_ABS, ABS_PRESSURE, 78);
 	litest_event(dev, EV_SYN, SYN_REPORT, 0);
 	litest_dispatch(li);
-	msleep(10);
+	litest_msleep(10);
 	litest_restore_log_handler(li);
 
 	/* now a click should trigger middle click */
@@ -5793,6 +5905,9 @@ START_TEST(touchpad_finger_always_down)
 {
 	struct litest_device *dev = litest_current_device();
 
+	if (!litest_has_uinput())
+		return LITEST_SKIP;
+
 	/* Set BTN_TOOL_FINGER before a new context is initialized */
 	litest_event(dev, EV_KEY, BTN_TOOL_FINGER, 1);
 	litest_event(dev, EV_SYN, SYN_REPORT, 0);
@@ -5923,6 +6038,75 @@ START_TEST(touchpad_jump_delta)
 }
 END_TEST
 
+static double
+touchpad_msc_jump_motion(struct litest_device *dev, uint32_t timestamp)
+{
+	struct libinput *li = dev->libinput;
+	struct libinput_event *event;
+	double dx = 0.0;
+
+	litest_event(dev, EV_MSC, MSC_TIMESTAMP, 0);
+	litest_touch_down(dev, 0, 30, 50);
+	litest_dispatch(li);
+	litest_msleep(2);
+	litest_event(dev, EV_MSC, MSC_TIMESTAMP, 7300);
+	litest_touch_move(dev, 0, 31, 50);
+	litest_dispatch(li);
+	litest_drain_events(li);
+
+	litest_msleep(2);
+	litest_event(dev, EV_MSC, MSC_TIMESTAMP, timestamp);
+	litest_touch_move(dev, 0, 35, 50);
+	litest_dispatch(li);
+
+	while ((event = libinput_get_event(li))) {
+		struct libinput_event_pointer *ptrev;
+
+		ptrev = litest_is_motion_event(event);
+		dx += libinput_event_pointer_get_dx(ptrev);
+		libinput_event_destroy(event);
+	}
+
+	litest_touch_up(dev, 0);
+	litest_dispatch(li);
+	litest_drain_events(li);
+
+	return dx;
+}
+
+START_TEST(touchpad_msc_timestamp_jump)
+{
+	_litest_context_destroy_ struct libinput *li = litest_create_context();
+	struct litest_device *dev;
+	int events[] = {
+		EV_MSC, MSC_TIMESTAMP,
+		-1, -1,
+	};
+	double dx_normal, dx_jump;
+
+	dev = litest_add_device_with_overrides(li,
+					       LITEST_SYNAPTICS_I2C,
+					       NULL, NULL, NULL,
+					       events);
+	litest_disable_tap(dev->libinput_device);
+	litest_disable_hold_gestures(dev->libinput_device);
+	litest_drain_events(li);
+
+	/* After a hw sleep, the first MSC_TIMESTAMP is 0 and the third
+	 * frame claims far more time than the interval of the second
+	 * one: the hw swallowed frames and the motion is spread across
+	 * that time. The same movement with a normal interval is
+	 * accelerated more */
+	dx_normal = touchpad_msc_jump_motion(dev, 14600);
+	dx_jump = touchpad_msc_jump_motion(dev, 123456);
+
+	litest_assert_double_gt(dx_jump, 0.0);
+	litest_assert_double_lt(dx_jump, dx_normal);
+
+	litest_device_destroy(dev);
+}
+END_TEST
+
 START_TEST(touchpad_disabled_on_mouse)
 {
 	struct litest_device *dev = litest_current_device();
@@ -7181,6 +7365,8 @@ END_TEST
 
 TEST_COLLECTION(touchpad)
 {
+	litest_uinput_optional();
+
 	litest_add(touchpad_1fg_motion, LITEST_TOUCHPAD, LITEST_ANY);
 	litest_add(touchpad_2fg_no_motion, LITEST_TOUCHPAD, LITEST_SINGLE_TOUCH);
 
@@ -7261,6 +7447,8 @@ TEST_COLLECTION(touchpad)
 	litest_add(touchpad_thumb_lower_area_movement, LITEST_CLICKPAD, LITEST_ANY);
 	litest_add(touchpad_thumb_lower_area_movement_rethumb, LITEST_CLICKPAD, LITEST_ANY);
 	litest_add(touchpad_thumb_speed_empty_slots, LITEST_TOUCHPAD, LITEST_SINGLE_TOUCH);
+	litest_add(touchpad_2fg_scroll_high_slots, LITEST_TOUCHPAD, LITEST_SINGLE_TOUCH);
+	litest_add_for_device(touchpad_msc_timestamp_frame_time, LITEST_SYNAPTICS_I2C_MSC_TIMESTAMP);
 	litest_add(touchpad_thumb_area_clickfinger, LITEST_CLICKPAD, LITEST_ANY);
 	litest_add(touchpad_thumb_area_btnarea, LITEST_CLICKPAD, LITEST_ANY);
 	litest_add(touchpad_thumb_no_doublethumb, LITEST_CLICKPAD, LITEST_ANY);
@@ -7274,6 +7462,7 @@ TEST_COLLECTION(touchpad)
 
 	litest_add_for_device(touchpad_jump_finger_motion, LITEST_SYNAPTICS_CLICKPAD_X220);
 	litest_add_for_device(touchpad_jump_delta, LITEST_SYNAPTICS_CLICKPAD_X220);
+	litest_add_no_device(touchpad_msc_timestamp_jump);
 
 	litest_add_for_device(touchpad_disabled_on_mouse, LITEST_SYNAPTICS_CLICKPAD_X220);
 	litest_add_for_device(touchpad_disabled_on_mouse_suspend_mouse, LITEST_SYNAPTICS_CLICKPAD_X220);
@@ -7314,6 +7503,8 @@ TEST_COLLECTION(touchpad)
 
 TEST_COLLECTION(touchpad_dwt)
 {
+	litest_uinput_optional();
+
 	litest_add(touchpad_dwt, LITEST_TOUCHPAD, LITEST_ANY);
 	litest_add_for_device(touchpad_dwt_ext_and_int_keyboard, LITEST_SYNAPTICS_I2C);
 	litest_add(touchpad_dwt_enable_touch, LITEST_TOUCHPAD, LITEST_ANY);
@@ -7361,6 +7552,8 @@ TEST_COLLECTION(touchpad_dwt)
 
 TEST_COLLECTION(touchpad_palm)
 {
+	litest_uinput_optional();
+
 	litest_add(touchpad_palm_detect_at_edge, LITEST_TOUCHPAD, LITEST_ANY);
 	litest_add(touchpad_palm_detect_at_top, LITEST_TOUCHPAD, LITEST_TOPBUTTONPAD);
 	litest_add(touchpad_palm_detect_at_bottom_corners, LITEST_TOUCHPAD, LITEST_CLICKPAD);
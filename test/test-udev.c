@@ -584,6 +584,10 @@ END_TEST
 
 TEST_COLLECTION(udev)
 {
+	/* These tests look at devices being added and removed through
+	 * udev */
+	litest_device_pool_opt_out();
+
 	litest_add_no_device(udev_create_NULL);
 	litest_add_no_device(udev_create_seat0);
 	litest_add_no_device(udev_create_empty_seat);
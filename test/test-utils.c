@@ -40,6 +40,7 @@
 #include "util-macros.h"
 #include "util-bits.h"
 #include "util-range.h"
+#include "util-histogram.h"
 #include "util-ratelimit.h"
 #include "util-stringbuf.h"
 #include "util-matrix.h"
@@ -1019,6 +1020,62 @@ START_TEST(evcode_prop_parser)
 }
 END_TEST
 
+START_TEST(key_remap_prop_parser)
+{
+	struct parser_test_remap {
+		const char *prop;
+		bool success;
+		size_t nremaps;
+		struct key_remap remaps[4];
+	} tests[] = {
+		{ "KEY_A:KEY_B", true, 1, {{ .from = KEY_A, .to = KEY_B }} },
+		{ "KEY_A:KEY_B;", true, 1, {{ .from = KEY_A, .to = KEY_B }} },
+		{ "BTN_SIDE:BTN_MIDDLE", true, 1, {{ .from = BTN_SIDE, .to = BTN_MIDDLE }} },
+		{ "KEY_CAPSLOCK:none", true, 1, {{ .from = KEY_CAPSLOCK, .to = KEY_RESERVED }} },
+		{ "KEY_LEFTCTRL+KEY_C:KEY_COPY", true, 1,
+			{{ .modifier = KEY_LEFTCTRL, .from = KEY_C, .to = KEY_COPY }} },
+		{ "KEY_A:KEY_B;KEY_CAPSLOCK:none;KEY_FN+KEY_F1:KEY_MUTE", true, 3,
+			{{ .from = KEY_A, .to = KEY_B },
+			 { .from = KEY_CAPSLOCK, .to = KEY_RESERVED },
+			 { .modifier = KEY_FN, .from = KEY_F1, .to = KEY_MUTE }} },
+		{ .prop = "", .success = false },
+		{ .prop = "KEY_A", .success = false },
+		{ .prop = "KEY_A:", .success = false },
+		{ .prop = ":KEY_A", .success = false },
+		{ .prop = "KEY_A:KEY_B:KEY_C", .success = false },
+		{ .prop = "KEY_A:KEY_UNKNOWN", .success = false },
+		{ .prop = "KEY_A:REL_X", .success = false },
+		{ .prop = "EV_KEY:KEY_A", .success = false },
+		{ .prop = "KEY_A:KEY_RESERVED", .success = false },
+		{ .prop = "none:KEY_A", .success = false },
+		{ .prop = "KEY_A+KEY_A:KEY_B", .success = false },
+		{ .prop = "KEY_A+KEY_B+KEY_C:KEY_D", .success = false },
+		{ .prop = "KEY_A:KEY_B;KEY_C", .success = false },
+		{ .prop = NULL },
+	};
+	struct parser_test_remap *t;
+
+	for (int i = 0; tests[i].prop; i++) {
+		bool success;
+		struct key_remap remaps[32];
+		size_t nremaps = ARRAY_LENGTH(remaps);
+
+		t = &tests[i];
+		success = parse_key_remap_property(t->prop, remaps, &nremaps);
+		litest_assert(success == t->success);
+		if (!success)
+			continue;
+
+		litest_assert_int_eq(nremaps, t->nremaps);
+		for (size_t j = 0; j < nremaps; j++) {
+			litest_assert_int_eq(remaps[j].modifier, t->remaps[j].modifier);
+			litest_assert_int_eq(remaps[j].from, t->remaps[j].from);
+			litest_assert_int_eq(remaps[j].to, t->remaps[j].to);
+		}
+	}
+}
+END_TEST
+
 START_TEST(input_prop_parser)
 {
 	struct parser_test_val {
@@ -1765,6 +1822,21 @@ START_TEST(strv_find_substring_test)
 }
 END_TEST
 
+START_TEST(strv_find_value_test)
+{
+	char *strv[] = {"FOO=1", "FOOBAR=2", "BAR=", "BAZ", NULL};
+
+	litest_assert_str_eq(strv_find_value(strv, "FOO"), "1");
+	litest_assert_str_eq(strv_find_value(strv, "FOOBAR"), "2");
+	litest_assert_str_eq(strv_find_value(strv, "BAR"), "");
+	litest_assert_ptr_null(strv_find_value(strv, "BAZ"));
+	litest_assert_ptr_null(strv_find_value(strv, "FO"));
+	litest_assert_ptr_null(strv_find_value(strv, "1"));
+	litest_assert_ptr_null(strv_find_value(strv, NULL));
+	litest_assert_ptr_null(strv_find_value(NULL, "FOO"));
+}
+END_TEST
+
 START_TEST(double_array_from_string_test)
 {
 	struct double_array_from_string_test {
@@ -2410,6 +2482,62 @@ START_TEST(range_test)
 }
 END_TEST
 
+START_TEST(histogram_test)
+{
+	struct histogram h;
+
+	histogram_reset(&h);
+	litest_assert_int_eq(h.count, 0U);
+	litest_assert_int_eq(histogram_percentile(&h, 50), 0U);
+
+	litest_assert_int_eq(histogram_bucket_index(0), 0U);
+	litest_assert_int_eq(histogram_bucket_index(1), 1U);
+	litest_assert_int_eq(histogram_bucket_index(2), 2U);
+	litest_assert_int_eq(histogram_bucket_index(3), 2U);
+	litest_assert_int_eq(histogram_bucket_index(4), 3U);
+	litest_assert_int_eq(histogram_bucket_index(1023), 10U);
+	litest_assert_int_eq(histogram_bucket_index(1024), 11U);
+	litest_assert_int_eq(histogram_bucket_index(UINT64_MAX), HISTOGRAM_NBUCKETS - 1U);
+
+	litest_assert_int_eq(histogram_bucket_limit(0), 1U);
+	litest_assert_int_eq(histogram_bucket_limit(10), 1024U);
+	litest_assert_int_eq(histogram_bucket_limit(HISTOGRAM_NBUCKETS - 1), UINT64_MAX);
+
+	/* every value is below its bucket limit and at or above the
+	 * previous bucket's limit */
+	for (uint64_t v = 0; v < 100000; v += 7) {
+		unsigned int idx = histogram_bucket_index(v);
+		litest_assert_int_lt(v, histogram_bucket_limit(idx));
+		if (idx > 0)
+			litest_assert_int_ge(v, histogram_bucket_limit(idx - 1));
+	}
+
+	for (int i = 0; i < 90; i++)
+		histogram_add(&h, 100);
+	for (int i = 0; i < 9; i++)
+		histogram_add(&h, 1000);
+	histogram_add(&h, 5000);
+
+	litest_assert_int_eq(h.count, 100U);
+	litest_assert_int_eq(h.max, 5000U);
+	litest_assert_int_eq(h.sum, 90U * 100 + 9 * 1000 + 5000);
+	litest_assert_int_eq(h.buckets[histogram_bucket_index(100)], 90U);
+
+	litest_assert_int_eq(histogram_percentile(&h, 0), 127U);
+	litest_assert_int_eq(histogram_percentile(&h, 50), 127U);
+	litest_assert_int_eq(histogram_percentile(&h, 90), 127U);
+	litest_assert_int_eq(histogram_percentile(&h, 95), 1023U);
+	litest_assert_int_eq(histogram_percentile(&h, 99), 1023U);
+	litest_assert_int_eq(histogram_percentile(&h, 100), 5000U);
+
+	histogram_reset(&h);
+	histogram_add(&h, 0);
+	litest_assert_int_eq(histogram_percentile(&h, 100), 0U);
+	histogram_add(&h, 300);
+	litest_assert_int_eq(histogram_percentile(&h, 100), 300U);
+}
+END_TEST
+
 START_TEST(stringbuf_test)
 {
 	struct stringbuf buf;
@@ -2799,6 +2927,60 @@ START_TEST(macros_expand)
 }
 END_TEST
 
+START_TEST(evdev_usage_masks)
+{
+#define U(u_) evdev_usage_from_uint32_t(u_)
+	uint64_t wheel = evdev_usage_mask(U(EVDEV_REL_WHEEL)) |
+			 evdev_usage_mask(U(EVDEV_REL_HWHEEL));
+	uint64_t buttons = evdev_usage_mask_range(U(EVDEV_BTN_LEFT),
+						  U(EVDEV_BTN_TASK));
+
+	/* Each usage has exactly one bit */
+	litest_assert_int_eq(__builtin_popcountll(evdev_usage_mask(U(EVDEV_KEY_ESC))), 1);
+	litest_assert_int_eq(__builtin_popcountll(evdev_usage_mask(U(EVDEV_ABS_MAX))), 1);
+
+	/* Different types never share a bit */
+	uint64_t all_types = 0;
+	unsigned int types[] = { EV_SYN, EV_KEY, EV_REL, EV_ABS, EV_MSC, EV_SW, EV_LED, EV_SND };
+	ARRAY_FOR_EACH(types, t) {
+		uint64_t type_mask = evdev_usage_mask_range(evdev_usage_from_code(*t, 0),
+							    evdev_usage_from_code(*t, libevdev_event_type_get_max(*t)));
+		litest_assert_int_eq(all_types & type_mask, 0U);
+		all_types |= type_mask;
+	}
+
+	litest_assert_int_eq(wheel & buttons, 0U);
+	litest_assert_int_eq(evdev_usage_mask(U(EVDEV_REL_X)) & wheel, 0U);
+	litest_assert_int_eq(evdev_usage_mask(U(EVDEV_SYN_REPORT)) & (wheel|buttons), 0U);
+
+	{
+		struct evdev_event events[] = {
+			{ .usage = U(EVDEV_REL_X), .value = 1, },
+			{ .usage = U(EVDEV_REL_Y), .value = 2, },
+			{ .usage = U(EVDEV_SYN_REPORT), .value = 0, },
+		};
+		_unref_(evdev_frame) *frame = evdev_frame_new(8);
+		evdev_frame_set(frame, events, ARRAY_LENGTH(events));
+
+		uint64_t mask = evdev_frame_get_usage_mask(frame);
+		litest_assert_int_eq(mask & wheel, 0U);
+		litest_assert_int_eq(mask & buttons, 0U);
+
+		struct evdev_event e = { .usage = U(EVDEV_BTN_RIGHT), .value = 1 };
+		evdev_frame_append(frame, &e, 1);
+		mask = evdev_frame_get_usage_mask(frame);
+		litest_assert_int_eq(mask & wheel, 0U);
+		litest_assert_int_ne(mask & buttons, 0U);
+
+		e.usage = U(EVDEV_REL_HWHEEL);
+		evdev_frame_append(frame, &e, 1);
+		mask = evdev_frame_get_usage_mask(frame);
+		litest_assert_int_ne(mask & wheel, 0U);
+	}
+#undef U
+}
+END_TEST
+
 START_TEST(evdev_frames)
 {
 #define U(u_) evdev_usage_from_uint32_t(u_)
@@ -2835,7 +3017,7 @@ START_TEST(evdev_frames)
 		int rc = evdev_frame_set(frame, events, ARRAY_LENGTH(events));
 		litest_assert_neg_errno_success(rc);
 		litest_assert_int_eq(evdev_frame_get_count(frame), ARRAY_LENGTH(events));
-		litest_assert_int_eq(frame->max_size, ARRAY_LENGTH(events));
+		litest_assert_int_eq(evdev_frame_get_max_size(frame), ARRAY_LENGTH(events));
 
 		size_t nevents;
 		rc = memcmp(evdev_frame_get_events(frame, &nevents), events, sizeof(events));
@@ -2890,6 +3072,180 @@ START_TEST(evdev_frames)
 		/* We never appended a timestamp */
 		litest_assert_int_eq(evdev_frame_get_time(frame), 0U);
 	}
+#undef U
+}
+END_TEST
+
+static struct evdev_frame *
+evdev_frame_new_poisoned(size_t max_size)
+{
+	struct evdev_frame *frame = evdev_frame_new(max_size);
+
+	memset(frame->storage->events, 0xab, max_size * sizeof(*frame->storage->events));
+
+	return frame;
+}
+
+static void
+assert_frame_terminated(struct evdev_frame *frame)
+{
+	size_t nevents;
+	struct evdev_event *events = evdev_frame_get_events(frame, &nevents);
+
+	litest_assert_int_ge(nevents, 1U);
+	litest_assert(evdev_usage_eq(events[nevents - 1].usage, EVDEV_SYN_REPORT));
+	litest_assert_int_eq(events[nevents - 1].value, 0);
+}
+
+START_TEST(evdev_frames_poisoned_tail)
+{
+#define U(u_) evdev_usage_from_uint32_t(u_)
+	struct evdev_event events[] = {
+		{ .usage = U(EVDEV_ABS_X), .value = 1, },
+		{ .usage = U(EVDEV_ABS_Y), .value = 2, },
+		{ .usage = U(EVDEV_BTN_LEFT), .value = 1, },
+		{ .usage = U(EVDEV_SYN_REPORT), .value = 0, },
+	};
+
+	{
+		_unref_(evdev_frame) *frame = evdev_frame_new_poisoned(8);
+		evdev_frame_reset(frame);
+		litest_assert_int_eq(evdev_frame_get_count(frame), 1U);
+		assert_frame_terminated(frame);
+		litest_assert(evdev_frame_is_empty(frame));
+		litest_assert_int_eq(evdev_frame_get_usage_mask(frame),
+				     evdev_usage_mask(evdev_usage_from(EVDEV_SYN_REPORT)));
+	}
+	{
+		_unref_(evdev_frame) *frame = evdev_frame_new_poisoned(8);
+		int rc = evdev_frame_set(frame, events, ARRAY_LENGTH(events));
+		litest_assert_neg_errno_success(rc);
+		litest_assert_int_eq(evdev_frame_get_count(frame), ARRAY_LENGTH(events));
+		size_t nevents;
+		rc = memcmp(evdev_frame_get_events(frame, &nevents), events, sizeof(events));
+		litest_assert_int_eq(rc, 0);
+	}
+	{
+		_unref_(evdev_frame) *frame = evdev_frame_new_poisoned(8);
+		evdev_frame_reset(frame);
+		for (size_t i = 0; i < ARRAY_LENGTH(events) - 1; i++) {
+			int rc = evdev_frame_append(frame, &events[i], 1);
+			litest_assert_neg_errno_success(rc);
+			litest_assert_int_eq(evdev_frame_get_count(frame), i + 2);
+			assert_frame_terminated(frame);
+		}
+
+		/* Shrinking via reset followed by a shorter set must not
+		 * leak the previous frame's events */
+		int rc = evdev_frame_set(frame, &events[2], 1);
+		litest_assert_neg_errno_success(rc);
+		litest_assert_int_eq(evdev_frame_get_count(frame), 2U);
+		assert_frame_terminated(frame);
+		litest_assert(evdev_usage_eq(frame->storage->events[0].usage, EVDEV_BTN_LEFT));
+	}
+	{
+		_unref_(evdev_frame) *frame = evdev_frame_new_poisoned(8);
+		evdev_frame_reset(frame);
+		evdev_frame_append(frame, events, ARRAY_LENGTH(events));
+
+		_unref_(evdev_frame) *clone = evdev_frame_clone(frame);
+		litest_assert_int_eq(evdev_frame_get_count(clone), ARRAY_LENGTH(events));
+		size_t nevents;
+		int rc = memcmp(evdev_frame_get_events(clone, &nevents), events, sizeof(events));
+		litest_assert_int_eq(rc, 0);
+	}
+	{
+		struct evdev_frame *frame = evdev_frame_new_on_stack(8);
+		litest_assert_int_eq(evdev_frame_get_count(frame), 1U);
+		assert_frame_terminated(frame);
+		litest_assert_int_eq(evdev_frame_get_time(frame), 0U);
+	}
+#undef U
+}
+END_TEST
+
+START_TEST(evdev_frames_copy_on_write)
+{
+#define U(u_) evdev_usage_from_uint32_t(u_)
+	struct evdev_event events[] = {
+		{ .usage = U(EVDEV_ABS_X), .value = 1, },
+		{ .usage = U(EVDEV_ABS_Y), .value = 2, },
+		{ .usage = U(EVDEV_SYN_REPORT), .value = 0, },
+	};
+	struct evdev_event extra = { .usage = U(EVDEV_BTN_LEFT), .value = 1 };
+	size_t nevents;
+
+	{
+		_unref_(evdev_frame) *frame = evdev_frame_new(8);
+		evdev_frame_set(frame, events, ARRAY_LENGTH(events));
+		evdev_frame_set_time(frame, 1234);
+
+		/* A clone shares the events */
+		_unref_(evdev_frame) *clone = evdev_frame_clone(frame);
+		litest_assert(evdev_frame_is_shared(frame));
+		litest_assert(evdev_frame_is_shared(clone));
+		litest_assert_ptr_eq(evdev_frame_get_events_const(frame, NULL),
+				     evdev_frame_get_events_const(clone, NULL));
+		litest_assert_int_eq(evdev_frame_get_count(clone), ARRAY_LENGTH(events));
+		litest_assert_int_eq(evdev_frame_get_time(clone), 1234U);
+
+		/* Appending to the clone gives it a private copy */
+		int rc = evdev_frame_append(clone, &extra, 1);
+		litest_assert_neg_errno_success(rc);
+		litest_assert(!evdev_frame_is_shared(frame));
+		litest_assert(!evdev_frame_is_shared(clone));
+		litest_assert_int_eq(evdev_frame_get_count(clone), ARRAY_LENGTH(events) + 1);
+		litest_assert_int_eq(evdev_frame_get_count(frame), ARRAY_LENGTH(events));
+		rc = memcmp(evdev_frame_get_events_const(frame, &nevents), events, sizeof(events));
+		litest_assert_int_eq(rc, 0);
+		rc = memcmp(evdev_frame_get_events_const(clone, &nevents), events, 2 * sizeof(*events));
+		litest_assert_int_eq(rc, 0);
+	}
+	{
+		_unref_(evdev_frame) *frame = evdev_frame_new(8);
+		evdev_frame_set(frame, events, ARRAY_LENGTH(events));
+		_unref_(evdev_frame) *clone = evdev_frame_clone(frame);
+
+		/* Resetting the original must not affect the clone */
+		evdev_frame_reset(frame);
+		litest_assert(!evdev_frame_is_shared(clone));
+		litest_assert(evdev_frame_is_empty(frame));
+		litest_assert_int_eq(evdev_frame_get_count(clone), ARRAY_LENGTH(events));
+		int rc = memcmp(evdev_frame_get_events_const(clone, &nevents), events, sizeof(events));
+		litest_assert_int_eq(rc, 0);
+	}
+	{
+		_unref_(evdev_frame) *frame = evdev_frame_new(8);
+		evdev_frame_set(frame, events, ARRAY_LENGTH(events));
+		_unref_(evdev_frame) *clone = evdev_frame_clone(frame);
+
+		/* Writable access copies, read-only access doesn't */
+		evdev_frame_get_events_const(clone, NULL);
+		litest_assert(evdev_frame_is_shared(clone));
+		struct evdev_event *e = evdev_frame_get_events(clone, NULL);
+		litest_assert(!evdev_frame_is_shared(clone));
+		e[0].value = 10;
+		litest_assert_int_eq(evdev_frame_get_events_const(frame, NULL)[0].value, 1);
+	}
+	{
+		/* Releasing the last sharer makes the frame writable in place */
+		_unref_(evdev_frame) *frame = evdev_frame_new(8);
+		evdev_frame_set(frame, events, ARRAY_LENGTH(events));
+		struct evdev_frame *clone = evdev_frame_clone(frame);
+		const struct evdev_event *before = evdev_frame_get_events_const(frame, NULL);
+		evdev_frame_unref(clone);
+		litest_assert(!evdev_frame_is_shared(frame));
+		litest_assert_ptr_eq(evdev_frame_get_events(frame, NULL), before);
+	}
+	{
+		/* Stack frames are always copied */
+		struct evdev_frame *frame = evdev_frame_new_on_stack(8);
+		evdev_frame_set(frame, events, ARRAY_LENGTH(events));
+		_unref_(evdev_frame) *clone = evdev_frame_clone(frame);
+		litest_assert(!evdev_frame_is_shared(clone));
+		litest_assert_int_eq(evdev_frame_get_count(clone), ARRAY_LENGTH(events));
+	}
+#undef U
 }
 END_TEST
 
@@ -2930,6 +3286,7 @@ int main(void)
 	ADD_TEST(boolean_prop_parser);
 	ADD_TEST(evcode_prop_parser);
 	ADD_TEST(input_prop_parser);
+	ADD_TEST(key_remap_prop_parser);
 	ADD_TEST(evdev_abs_parser);
 	ADD_TEST(safe_atoi_test);
 	ADD_TEST(safe_atoi_base_16_test);
@@ -2944,6 +3301,7 @@ int main(void)
 	ADD_TEST(strv_append_test);
 	ADD_TEST(strv_find_test);
 	ADD_TEST(strv_find_substring_test);
+	ADD_TEST(strv_find_value_test);
 	ADD_TEST(double_array_from_string_test);
 	ADD_TEST(strargv_test);
 	ADD_TEST(kvsplit_double_test);
@@ -2969,6 +3327,7 @@ int main(void)
 	ADD_TEST(absinfo_normalize_value_test);
 
 	ADD_TEST(range_test);
+	ADD_TEST(histogram_test);
 	ADD_TEST(stringbuf_test);
 	ADD_TEST(multivalue_test);
 
@@ -2976,7 +3335,10 @@ int main(void)
 	ADD_TEST(attribute_cleanup);
 	ADD_TEST(macros_expand);
 
+	ADD_TEST(evdev_usage_masks);
 	ADD_TEST(evdev_frames);
+	ADD_TEST(evdev_frames_poisoned_tail);
+	ADD_TEST(evdev_frames_copy_on_write);
 
 	enum litest_runner_result result = litest_runner_run_tests(runner);
 	litest_runner_destroy(runner);
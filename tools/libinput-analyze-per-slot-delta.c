@@ -0,0 +1,606 @@
+/*
+ * Copyright © 2018 Red Hat, Inc.
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a
+ * copy of this software and associated documentation files (the "Software"),
+ * to deal in the Software without restriction, including without limitation
+ * the rights to use, copy, modify, merge, publish, distribute, sublicense,
+ * and/or sell copies of the Software, and to permit persons to whom the
+ * Software is furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice (including the next
+ * paragraph) shall be included in all copies or substantial portions of the
+ * Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT.  IN NO EVENT SHALL
+ * THE AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING
+ * FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER
+ * DEALINGS IN THE SOFTWARE.
+ */
+
+/* Measures the relative motion between touch events (based on slots)
+ *
+ * Input is a libinput record yaml file, the output matches the
+ * Python tool this replaces.
+ */
+
+#include "config.h"
+
+#include <getopt.h>
+#include <inttypes.h>
+#include <math.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <unistd.h>
+
+#include "linux/input.h"
+#include "util-input-event.h"
+#include "util-macros.h"
+#include "util-strings.h"
+#include "shared.h"
+
+static const char *color_reset = "\x1b[0m";
+static const char *color_red = "\x1b[6;31m";
+static const char *color_blue = "\x1b[6;34m";
+static const char *color_green = "\x1b[6;32m";
+
+enum slot_state {
+	SLOT_STATE_NONE,
+	SLOT_STATE_BEGIN,
+	SLOT_STATE_UPDATE,
+	SLOT_STATE_END,
+};
+
+struct point {
+	int x, y;
+};
+
+struct slot {
+	enum slot_state state;
+	struct point position;
+	struct point delta;
+	struct point origin;
+	int pressure;
+	bool used;
+	bool dirty;
+};
+
+struct options {
+	bool use_mm;
+	bool show_distance;
+	bool use_st;
+	bool use_absolute;
+	bool have_threshold;
+	double threshold;
+	bool have_ignore_below;
+	double ignore_below;
+	int pressure_min;
+	int pressure_max;
+	double xres, yres;
+};
+
+struct formatter {
+	const struct options *options;
+	int width;
+	char line[4096];
+	size_t len;
+	bool have_data;
+	bool filtered;
+};
+
+/* Number of characters (not bytes) in a UTF-8 string */
+static size_t
+utf8_strlen(const char *str)
+{
+	size_t len = 0;
+
+	for (const char *c = str; *c; c++) {
+		if ((*c & 0xc0) != 0x80)
+			len++;
+	}
+
+	return len;
+}
+
+static void
+formatter_append(struct formatter *fmt, const char *str, size_t width)
+{
+	size_t len = utf8_strlen(str);
+	int rc;
+
+	if (fmt->len > 0) {
+		rc = snprintf(fmt->line + fmt->len, sizeof(fmt->line) - fmt->len, " | ");
+		fmt->len = min(fmt->len + rc, sizeof(fmt->line) - 1);
+	}
+
+	rc = snprintf(fmt->line + fmt->len,
+		      sizeof(fmt->line) - fmt->len,
+		      "%s%*s",
+		      str,
+		      (int)(width > len ? width - len : 0), "");
+	fmt->len = min(fmt->len + rc, sizeof(fmt->line) - 1);
+}
+
+/* Same padding as Python's str.center() */
+static void
+formatter_append_centered(struct formatter *fmt, const char *str)
+{
+	int len = utf8_strlen(str);
+	int margin = fmt->width - len;
+	int left;
+	char buf[256];
+
+	if (margin <= 0) {
+		formatter_append(fmt, str, 0);
+		return;
+	}
+
+	left = margin / 2 + (margin & fmt->width & 1);
+	snprintf(buf, sizeof(buf), "%*s%s%*s", left, "", str, margin - left, "");
+	formatter_append(fmt, buf, 0);
+}
+
+static const char *
+direction(double dx, double dy)
+{
+	static const char *directions[] = {
+		"↖↑", "↖←", "↙←", "↙↓", "↓↘", "→↘", "→↗", "↑↗",
+	};
+
+	if (dx != 0 && dy != 0) {
+		double t = atan2(dx, dy) + M_PI; /* in [0, 2pi] range now */
+
+		if (t == 0)
+			t = 0.01;
+		else
+			t = t * 180.0 / M_PI;
+
+		return directions[min((int)(t / 45), 7)];
+	}
+
+	if (dy == 0)
+		return dx < 0 ? "←←" : "→→";
+
+	return dy < 0 ? "↑↑" : "↓↓";
+}
+
+static void
+format_slot(struct formatter *fmt, const struct slot *slot)
+{
+	const struct options *options = fmt->options;
+	const char *color = color_reset;
+	const char *reset = color_reset;
+	char string[512];
+	double dx, dy, distx, disty;
+
+	switch (slot->state) {
+	case SLOT_STATE_BEGIN:
+		formatter_append_centered(fmt, "+++++++");
+		fmt->have_data = true;
+		return;
+	case SLOT_STATE_END:
+		formatter_append_centered(fmt, "-------");
+		fmt->have_data = true;
+		return;
+	case SLOT_STATE_NONE: {
+		char stars[64];
+		int nstars = min(fmt->width - 2, (int)sizeof(stars) - 1);
+
+		memset(stars, '*', nstars);
+		stars[nstars] = '\0';
+		formatter_append_centered(fmt, stars);
+		return;
+	}
+	case SLOT_STATE_UPDATE:
+		break;
+	}
+
+	if (!slot->dirty) {
+		formatter_append_centered(fmt, " ");
+		return;
+	}
+
+	dx = slot->delta.x;
+	dy = slot->delta.y;
+	distx = abs(slot->position.x - slot->origin.x);
+	disty = abs(slot->position.y - slot->origin.y);
+	if (options->use_mm) {
+		dx /= options->xres;
+		dy /= options->yres;
+		distx /= options->xres;
+		disty /= options->yres;
+	}
+
+	if (!options->use_absolute) {
+		char coords[64];
+		char distance[128] = "";
+		size_t len = 0;
+		const char *components[5];
+
+		if (options->pressure_max > 0 &&
+		    slot->pressure > options->pressure_max) {
+			color = color_green;
+		} else if (options->pressure_min > 0 &&
+			   slot->pressure > options->pressure_min) {
+			color = color_blue;
+		}
+
+		if (options->have_ignore_below || options->have_threshold) {
+			double dist = hypot(dx, dy);
+
+			if (options->have_ignore_below && dist < options->ignore_below) {
+				formatter_append_centered(fmt, " ");
+				fmt->filtered = true;
+				return;
+			}
+			if (options->have_threshold && dist >= options->threshold)
+				color = color_red;
+		}
+
+		if (options->use_mm)
+			snprintf(coords, sizeof(coords), "%+3.2f/%+03.2f", dx, dy);
+		else
+			snprintf(coords, sizeof(coords), "%+4d/%+4d",
+				 slot->delta.x, slot->delta.y);
+
+		if (options->show_distance)
+			snprintf(distance, sizeof(distance),
+				 "dist: (%3.1f/%3.1f, %3.1f)",
+				 distx, disty, hypot(distx, disty));
+
+		components[0] = direction(dx, dy);
+		components[1] = color;
+		components[2] = coords;
+		components[3] = distance;
+		components[4] = reset;
+
+		string[0] = '\0';
+		ARRAY_FOR_EACH(components, c) {
+			if (**c == '\0')
+				continue;
+			len += snprintf(string + len, sizeof(string) - len,
+					"%s%s", len > 0 ? " " : "", *c);
+			len = min(len, sizeof(string) - 1);
+		}
+	} else {
+		snprintf(string, sizeof(string), "%s %s%4d/%4d%s",
+			 direction(dx, dy),
+			 color,
+			 slot->position.x,
+			 slot->position.y,
+			 reset);
+	}
+
+	fmt->have_data = true;
+	formatter_append(fmt, string,
+			 fmt->width + strlen(color) + strlen(reset));
+}
+
+static void
+usage(void)
+{
+	printf("Usage: libinput analyze per-slot-delta [--help] [options] recording.yml\n"
+	       "\n"
+	       "Measure delta between event frames for each slot\n"
+	       "\n"
+	       "Options:\n"
+	       "  --use-mm ............ Use mm instead of device deltas\n"
+	       "  --show-distance ..... Show the absolute distance relative to the first position\n"
+	       "  --use-st ............ Use ABS_X/ABS_Y instead of ABS_MT_POSITION_X/Y\n"
+	       "  --use-absolute ...... Use absolute coordinates, not deltas\n"
+	       "  --threshold=T ....... Mark any delta above this threshold\n"
+	       "  --ignore-below=T .... Ignore any delta below this threshold\n"
+	       "  --pressure-min=P .... Highlight touches above this pressure minimum\n"
+	       "  --pressure-max=P .... Highlight touches below this pressure maximum\n");
+}
+
+int
+main(int argc, char **argv)
+{
+	struct options options = {
+		.xres = 1.0,
+		.yres = 1.0,
+	};
+	struct recording_reader *reader;
+	const struct recording_device *device;
+	struct recording_frame frame;
+	struct slot *slots;
+	size_t nslots;
+	size_t slot = 0;
+	uint64_t last_time = 0;
+	bool have_last_time = false;
+	unsigned int nskipped_lines = 0;
+	struct {
+		int touch, doubletap, tripletap, quadtap, quinttap;
+		int left, middle, right;
+	} keys = {0};
+	int rc;
+
+	while (1) {
+		int c;
+		int option_index = 0;
+		enum {
+			OPT_USE_MM = 1,
+			OPT_SHOW_DISTANCE,
+			OPT_USE_ST,
+			OPT_USE_ABSOLUTE,
+			OPT_THRESHOLD,
+			OPT_IGNORE_BELOW,
+			OPT_PRESSURE_MIN,
+			OPT_PRESSURE_MAX,
+		};
+		static struct option opts[] = {
+			{ "help",           no_argument,       0, 'h' },
+			{ "use-mm",         no_argument,       0, OPT_USE_MM },
+			{ "show-distance",  no_argument,       0, OPT_SHOW_DISTANCE },
+			{ "use-st",         no_argument,       0, OPT_USE_ST },
+			{ "use-absolute",   no_argument,       0, OPT_USE_ABSOLUTE },
+			{ "threshold",      required_argument, 0, OPT_THRESHOLD },
+			{ "ignore-below",   required_argument, 0, OPT_IGNORE_BELOW },
+			{ "pressure-min",   required_argument, 0, OPT_PRESSURE_MIN },
+			{ "pressure-max",   required_argument, 0, OPT_PRESSURE_MAX },
+			{ 0, 0, 0, 0 },
+		};
+
+		c = getopt_long(argc, argv, "h", opts, &option_index);
+		if (c == -1)
+			break;
+
+		switch (c) {
+		case 'h':
+			usage();
+			return EXIT_SUCCESS;
+		case OPT_USE_MM:
+			options.use_mm = true;
+			break;
+		case OPT_SHOW_DISTANCE:
+			options.show_distance = true;
+			break;
+		case OPT_USE_ST:
+			options.use_st = true;
+			break;
+		case OPT_USE_ABSOLUTE:
+			options.use_absolute = true;
+			break;
+		case OPT_THRESHOLD:
+			if (!safe_atod(optarg, &options.threshold)) {
+				usage();
+				return EXIT_INVALID_USAGE;
+			}
+			options.have_threshold = true;
+			break;
+		case OPT_IGNORE_BELOW:
+			if (!safe_atod(optarg, &options.ignore_below)) {
+				usage();
+				return EXIT_INVALID_USAGE;
+			}
+			options.have_ignore_below = true;
+			break;
+		case OPT_PRESSURE_MIN:
+			if (!safe_atoi(optarg, &options.pressure_min)) {
+				usage();
+				return EXIT_INVALID_USAGE;
+			}
+			break;
+		case OPT_PRESSURE_MAX:
+			if (!safe_atoi(optarg, &options.pressure_max)) {
+				usage();
+				return EXIT_INVALID_USAGE;
+			}
+			break;
+		default:
+			usage();
+			return EXIT_INVALID_USAGE;
+		}
+	}
+
+	if (optind + 1 != argc) {
+		usage();
+		return EXIT_INVALID_USAGE;
+	}
+
+	if (!isatty(STDOUT_FILENO)) {
+		color_reset = "";
+		color_red = "";
+		color_green = "";
+		color_blue = "";
+	}
+
+	reader = recording_reader_new(argv[optind]);
+	if (!reader)
+		return EXIT_FAILURE;
+
+	device = recording_reader_get_device(reader, 0);
+	if (recording_device_has_code(device, EV_ABS, ABS_MT_SLOT))
+		nslots = device->absinfo[ABS_MT_SLOT].maximum + 1;
+	else
+		options.use_st = true;
+
+	if (options.use_st)
+		nslots = 1;
+
+	slots = zalloc(nslots * sizeof(*slots));
+	slots[0].used = true;
+
+	if (options.use_mm) {
+		options.xres = device->absinfo[ABS_X].resolution;
+		options.yres = device->absinfo[ABS_Y].resolution;
+		if (!options.xres || !options.yres) {
+			printf("Error: device doesn't have a resolution, cannot use mm\n");
+			rc = 1;
+			goto out;
+		}
+	}
+
+	if (options.use_st)
+		printf("Warning: slot coordinates on FINGER/DOUBLETAP change may be incorrect\n");
+
+	/* Only the first device is analyzed */
+	while ((rc = recording_reader_next_frame(reader, &frame)) > 0 &&
+	       frame.device == 0) {
+		for (size_t i = 0; i < frame.nevents; i++) {
+			const struct input_event *e = &frame.events[i];
+			struct slot *s = &slots[slot];
+			bool is_x = false, is_y = false;
+
+			if (e->type == EV_KEY) {
+				switch (e->code) {
+				case BTN_TOUCH: keys.touch = e->value; break;
+				case BTN_TOOL_DOUBLETAP: keys.doubletap = e->value; break;
+				case BTN_TOOL_TRIPLETAP: keys.tripletap = e->value; break;
+				case BTN_TOOL_QUADTAP: keys.quadtap = e->value; break;
+				case BTN_TOOL_QUINTTAP: keys.quinttap = e->value; break;
+				case BTN_LEFT: keys.left = e->value; break;
+				case BTN_MIDDLE: keys.middle = e->value; break;
+				case BTN_RIGHT: keys.right = e->value; break;
+				}
+			}
+
+			if (options.use_st) {
+				/* Note: this relies on the EV_KEY events to come in
+				 * before the x/y events, otherwise the last/first
+				 * event in each slot will be wrong. */
+				if (e->type == EV_KEY &&
+				    (e->code == BTN_TOOL_FINGER ||
+				     e->code == BTN_TOOL_PEN ||
+				     e->code == BTN_TOOL_DOUBLETAP)) {
+					slot = (e->code == BTN_TOOL_DOUBLETAP && nslots > 1) ? 1 : 0;
+					s = &slots[slot];
+					s->dirty = true;
+					s->state = e->value ? SLOT_STATE_BEGIN : SLOT_STATE_END;
+				} else if (e->type == EV_ABS && e->code == ABS_PRESSURE) {
+					s->pressure = e->value;
+				}
+
+				is_x = e->type == EV_ABS && e->code == ABS_X;
+				is_y = e->type == EV_ABS && e->code == ABS_Y;
+			} else {
+				if (e->type == EV_ABS && e->code == ABS_MT_SLOT) {
+					if (e->value < 0 || (size_t)e->value >= nslots)
+						continue;
+					slot = e->value;
+					s = &slots[slot];
+					s->dirty = true;
+					/* bcm5974 cycles through slot numbers, so let's
+					 * say all below our current slot number was used */
+					for (size_t sl = 0; sl <= slot; sl++)
+						slots[sl].used = true;
+				} else if (e->type == EV_ABS && e->code == ABS_MT_TRACKING_ID) {
+					if (e->value == -1) {
+						s->state = SLOT_STATE_END;
+					} else {
+						s->state = SLOT_STATE_BEGIN;
+						s->delta = (struct point){0, 0};
+					}
+					s->dirty = true;
+				} else if (e->type == EV_ABS && e->code == ABS_MT_PRESSURE) {
+					s->pressure = e->value;
+				}
+
+				is_x = e->type == EV_ABS && e->code == ABS_MT_POSITION_X;
+				is_y = e->type == EV_ABS && e->code == ABS_MT_POSITION_Y;
+			}
+
+			if (is_x || is_y) {
+				s->dirty = true;
+
+				/* If recording started after touch down */
+				if (s->state == SLOT_STATE_NONE) {
+					s->state = SLOT_STATE_BEGIN;
+					s->delta = (struct point){0, 0};
+				}
+
+				if (is_x) {
+					if (s->state == SLOT_STATE_UPDATE)
+						s->delta.x = e->value - s->position.x;
+					s->position.x = e->value;
+				} else {
+					if (s->state == SLOT_STATE_UPDATE)
+						s->delta.y = e->value - s->position.y;
+					s->position.y = e->value;
+				}
+			}
+
+			if (e->type == EV_SYN && e->code == SYN_REPORT) {
+				uint64_t t = input_event_time(e);
+				int tdelta = 0;
+				const char *tool_state = "   ";
+				char button_state[4] = "";
+				struct formatter fmt = {
+					.options = &options,
+					.width = options.show_distance ? 35 : 16,
+				};
+
+				if (have_last_time)
+					tdelta = (int)((int64_t)(t - last_time) / 1000); /* ms */
+				last_time = t;
+				have_last_time = true;
+
+				if (keys.quinttap)
+					tool_state = "QIN";
+				else if (keys.quadtap)
+					tool_state = "QAD";
+				else if (keys.tripletap)
+					tool_state = "TRI";
+				else if (keys.doubletap)
+					tool_state = "DBL";
+				else if (keys.touch)
+					tool_state = "TOU";
+
+				snprintf(button_state, sizeof(button_state), "%s%s%s",
+					 keys.left ? "L" : "",
+					 keys.middle ? "M" : "",
+					 keys.right ? "R" : "");
+				if (button_state[0] == '\0')
+					button_state[0] = '.', button_state[1] = '\0';
+
+				for (size_t sl = 0; sl < nslots; sl++) {
+					struct slot *s = &slots[sl];
+
+					if (!s->used)
+						continue;
+
+					format_slot(&fmt, s);
+
+					s->dirty = false;
+					s->delta = (struct point){0, 0};
+					if (s->state == SLOT_STATE_BEGIN) {
+						s->origin = s->position;
+						s->state = SLOT_STATE_UPDATE;
+					} else if (s->state == SLOT_STATE_END) {
+						s->state = SLOT_STATE_NONE;
+					}
+				}
+
+				if (fmt.have_data) {
+					if (nskipped_lines > 0) {
+						printf("\n");
+						nskipped_lines = 0;
+					}
+					printf("%2" PRIu64 ".%06" PRIu64 " %+5dms %s %s %s\n",
+					       (uint64_t)e->input_event_sec,
+					       (uint64_t)e->input_event_usec,
+					       tdelta,
+					       tool_state,
+					       button_state,
+					       fmt.line);
+				} else if (fmt.filtered) {
+					nskipped_lines++;
+					printf("\r%23s... %u below threshold", "", nskipped_lines);
+					fflush(stdout);
+				}
+			}
+		}
+	}
+
+	rc = rc < 0 ? EXIT_FAILURE : EXIT_SUCCESS;
+out:
+	free(slots);
+	recording_reader_destroy(reader);
+
+	return rc;
+}
@@ -0,0 +1,1034 @@
+/*
+ * Copyright © 2025 Red Hat, Inc.
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a
+ * copy of this software and associated documentation files (the "Software"),
+ * to deal in the Software without restriction, including without limitation
+ * the rights to use, copy, modify, merge, publish, distribute, sublicense,
+ * and/or sell copies of the Software, and to permit persons to whom the
+ * Software is furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice (including the next
+ * paragraph) shall be included in all copies or substantial portions of the
+ * Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT.  IN NO EVENT SHALL
+ * THE AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING
+ * FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER
+ * DEALINGS IN THE SOFTWARE.
+ */
+
+/* Replays a recording through a number of libinput contexts, each with a
+ * different set of configuration options and quirks, and prints what
+ * libinput made of the recording in each of them.
+ *
+ * The events are fed through libinput_path_add_evdev_device() as fast as
+ * possible, no uinput device is created and the contexts run in parallel.
+ */
+
+#include "config.h"
+
+#include <errno.h>
+#include <fcntl.h>
+#include <getopt.h>
+#include <inttypes.h>
+#include <math.h>
+#include <pthread.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <unistd.h>
+
+#include <libevdev/libevdev.h>
+#include <libinput.h>
+
+#include "linux/input.h"
+#include "libinput-private-api.h"
+#include "util-input-event.h"
+#include "util-macros.h"
+#include "util-mem.h"
+#include "util-strings.h"
+#include "util-time.h"
+#include "shared.h"
+
+/* Upper limit for the number of combinations, a typo in a grid should
+ * not keep the machine busy for the rest of the day */
+#define MAX_COMBINATIONS 4096
+
+/* After the last frame, the clock advances at this interval to let the
+ * timers that are still pending fire */
+#define FLUSH_INTERVAL_US ms2us(10)
+#define FLUSH_DURATION_US s2us(2)
+
+/* The time of the first frame, the same for all jobs */
+#define START_TIME_US s2us(1)
+
+#define MAX_DEVICES 64
+
+static bool verbose = false;
+
+struct sweep_setting {
+	int option;		/* one of enum configuration_options, or 0 for a quirk */
+	char *value;		/* the option argument or the quirk line */
+	char *label;
+};
+
+struct sweep_axis {
+	bool quirk;
+	struct sweep_setting *settings;
+	size_t nsettings;
+};
+
+struct sweep_frame {
+	size_t device;
+	size_t first;
+	size_t count;
+	uint64_t time;	/* µs, as in the recording */
+};
+
+struct sweep_result {
+	bool failed;
+	size_t events;
+	size_t taps;
+	size_t clicks;
+	double motion;
+	double scroll[2];	/* vertical, horizontal */
+	size_t gestures;
+};
+
+struct sweep_job {
+	size_t index;
+	struct tools_options options;
+	const char *quirks_file;	/* NULL for the default */
+	char *label;
+	struct sweep_result result;
+};
+
+struct sweep {
+	struct recording_reader *reader;
+	size_t ndevices;
+
+	/* All events of all devices, the frames index into this and are
+	 * sorted by time */
+	struct input_event *events;
+	size_t nevents;
+	size_t events_size;
+	struct sweep_frame *frames;
+	size_t nframes;
+	size_t frames_size;
+	size_t max_frame_size;
+
+	struct sweep_axis axes[32];
+	size_t naxes;
+
+	char *tmpdir;
+	char **quirks_files;
+	size_t nquirks_files;
+
+	struct sweep_job *jobs;
+	size_t njobs;
+
+	pthread_mutex_t lock;
+	size_t next_job;
+};
+
+/* Per-context state while a job runs */
+struct sweep_context {
+	struct sweep *sweep;
+	struct sweep_job *job;
+	struct libinput *li;
+	int fds[MAX_DEVICES];	/* write end of the pipe per device, or -1 */
+	unsigned int buttons_down;	/* physical buttons, all devices */
+	uint64_t now;	/* the clock of the context, see sweep_clock() */
+};
+
+static void
+sweep_destroy(struct sweep *s)
+{
+	for (size_t a = 0; a < s->naxes; a++) {
+		struct sweep_axis *axis = &s->axes[a];
+
+		for (size_t i = 0; i < axis->nsettings; i++) {
+			free(axis->settings[i].value);
+			free(axis->settings[i].label);
+		}
+		free(axis->settings);
+	}
+
+	for (size_t i = 0; i < s->nquirks_files; i++) {
+		unlink(s->quirks_files[i]);
+		free(s->quirks_files[i]);
+	}
+	free(s->quirks_files);
+	if (s->tmpdir) {
+		rmdir(s->tmpdir);
+		free(s->tmpdir);
+	}
+
+	for (size_t i = 0; i < s->njobs; i++)
+		free(s->jobs[i].label);
+	free(s->jobs);
+
+	free(s->events);
+	free(s->frames);
+	recording_reader_destroy(s->reader);
+}
+
+static void
+sweep_add_frame(struct sweep *s, const struct recording_frame *frame)
+{
+	struct sweep_frame *f;
+	size_t first = s->nevents;
+	bool skipped = false;
+
+	for (size_t i = 0; i < frame->nevents; i++) {
+		const struct input_event *e = &frame->events[i];
+
+		/* kernel key repeat and SYN_DROPPED are not replayed */
+		if ((e->type == EV_KEY && e->value == 2) ||
+		    (e->type == EV_SYN && e->code == SYN_DROPPED)) {
+			skipped = true;
+			continue;
+		}
+
+		if (s->nevents == s->events_size) {
+			s->events_size = max(s->events_size * 2, 1024U);
+			s->events = realloc(s->events,
+					    s->events_size * sizeof(*s->events));
+			if (!s->events)
+				abort();
+		}
+		s->events[s->nevents++] = *e;
+	}
+
+	if (s->nevents == first || (s->nevents - first == 1 && skipped)) {
+		s->nevents = first;
+		return;
+	}
+
+	if (s->nframes == s->frames_size) {
+		s->frames_size = max(s->frames_size * 2, 256U);
+		s->frames = realloc(s->frames, s->frames_size * sizeof(*s->frames));
+		if (!s->frames)
+			abort();
+	}
+
+	f = &s->frames[s->nframes++];
+	f->device = frame->device;
+	f->first = first;
+	f->count = s->nevents - first;
+	f->time = input_event_time(&s->events[first]);
+	s->max_frame_size = max(s->max_frame_size, f->count);
+}
+
+static int
+cmp_frames(const void *a, const void *b)
+{
+	const struct sweep_frame *fa = a,
+				 *fb = b;
+
+	if (fa->time != fb->time)
+		return fa->time < fb->time ? -1 : 1;
+	if (fa->device != fb->device)
+		return fa->device < fb->device ? -1 : 1;
+	return fa->first < fb->first ? -1 : 1;
+}
+
+static bool
+sweep_load(struct sweep *s, const char *path)
+{
+	struct recording_frame frame;
+	int rc;
+
+	s->reader = recording_reader_new(path);
+	if (!s->reader)
+		return false;
+
+	while ((rc = recording_reader_next_frame(s->reader, &frame)) > 0)
+		sweep_add_frame(s, &frame);
+
+	if (rc < 0)
+		return false;
+
+	s->ndevices = recording_reader_get_num_devices(s->reader);
+	if (s->ndevices > MAX_DEVICES) {
+		fprintf(stderr, "Too many devices in recording\n");
+		return false;
+	}
+
+	qsort(s->frames, s->nframes, sizeof(*s->frames), cmp_frames);
+
+	return true;
+}
+
+static const struct option *
+find_config_option(const char *name)
+{
+	static const struct option opts[] = {
+		CONFIGURATION_OPTIONS,
+		{ 0, 0, 0, 0 },
+	};
+
+	for (const struct option *o = opts; o->name; o++) {
+		if (streq(o->name, name))
+			return o;
+	}
+
+	return NULL;
+}
+
+static void
+axis_add_setting(struct sweep_axis *axis, int option,
+		 const char *value, char *label)
+{
+	struct sweep_setting *setting;
+
+	axis->settings = realloc(axis->settings,
+				 (axis->nsettings + 1) * sizeof(*axis->settings));
+	if (!axis->settings)
+		abort();
+
+	setting = &axis->settings[axis->nsettings++];
+	setting->option = option;
+	setting->value = value ? safe_strdup(value) : NULL;
+	setting->label = label;
+}
+
+/* Either NAME=V1,V2,... for an option that takes an argument or
+ * NAME1,NAME2,... for options that don't, e.g.
+ * "set-speed=-0.5,0,0.5" or "enable-tap,disable-tap" */
+static bool
+parse_config_axis(struct sweep_axis *axis, const char *spec)
+{
+	const char *eq = strchr(spec, '=');
+
+	if (eq) {
+		_autofree_ char *name = strndup(spec, eq - spec);
+		const struct option *o = find_config_option(name);
+		size_t nvalues;
+		char **values;
+
+		if (!o || o->has_arg == no_argument) {
+			fprintf(stderr, "Invalid configuration option '%s'\n", name);
+			return false;
+		}
+
+		values = strv_from_string(eq + 1, ",", &nvalues);
+		for (size_t i = 0; i < nvalues; i++)
+			axis_add_setting(axis, o->val, values[i],
+					 strdup_printf("%s=%s", name, values[i]));
+		strv_free(values);
+	} else {
+		size_t nnames;
+		char **names = strv_from_string(spec, ",", &nnames);
+
+		for (size_t i = 0; i < nnames; i++) {
+			const struct option *o = find_config_option(names[i]);
+
+			if (!o || o->has_arg == required_argument) {
+				fprintf(stderr,
+					"Invalid configuration option '%s'\n",
+					names[i]);
+				strv_free(names);
+				return false;
+			}
+			axis_add_setting(axis, o->val, NULL, safe_strdup(names[i]));
+		}
+		strv_free(names);
+	}
+
+	return axis->nsettings > 0;
+}
+
+/* AttrFoo=V1,V2,... or ModelFoo=V1,V2,... */
+static bool
+parse_quirk_axis(struct sweep_axis *axis, const char *spec)
+{
+	const char *eq = strchr(spec, '=');
+	_autofree_ char *name = NULL;
+	size_t nvalues;
+	char **values;
+
+	if (!eq || (!strstartswith(spec, "Attr") && !strstartswith(spec, "Model"))) {
+		fprintf(stderr, "Invalid quirk '%s', expected AttrFoo=... or ModelFoo=...\n",
+			spec);
+		return false;
+	}
+
+	name = strndup(spec, eq - spec);
+	values = strv_from_string(eq + 1, ",", &nvalues);
+	for (size_t i = 0; i < nvalues; i++) {
+		char *line = strdup_printf("%s=%s", name, values[i]);
+
+		/* the label takes ownership */
+		axis_add_setting(axis, 0, line, line);
+	}
+	strv_free(values);
+
+	axis->quirk = true;
+
+	return axis->nsettings > 0;
+}
+
+/* The setting index of each axis for the given combination, the last
+ * axis varies fastest */
+static void
+sweep_get_combination(struct sweep *s, size_t index, bool quirks_only,
+		      size_t choice[])
+{
+	for (size_t a = s->naxes; a > 0; a--) {
+		struct sweep_axis *axis = &s->axes[a - 1];
+
+		if (quirks_only && !axis->quirk)
+			continue;
+
+		choice[a - 1] = index % axis->nsettings;
+		index /= axis->nsettings;
+	}
+}
+
+static size_t
+sweep_count_combinations(struct sweep *s, bool quirks_only)
+{
+	size_t count = 1;
+
+	for (size_t a = 0; a < s->naxes; a++) {
+		if (quirks_only && !s->axes[a].quirk)
+			continue;
+		count *= s->axes[a].nsettings;
+		if (count > MAX_COMBINATIONS)
+			return count;
+	}
+
+	return count;
+}
+
+LIBINPUT_ATTRIBUTE_PRINTF(3, 0)
+static void
+quirks_log_handler(struct libinput *this_is_null,
+		   enum libinput_log_priority priority,
+		   const char *format,
+		   va_list args)
+{
+	enum quirks_log_priorities p = (enum quirks_log_priorities)priority;
+
+	if (p != QLOG_PARSER_ERROR && p != QLOG_ERROR)
+		return;
+
+	vfprintf(stderr, format, args);
+}
+
+/* Devices names may contain characters that are special to fnmatch(),
+ * those match any character instead */
+static char *
+quirks_match_name(const char *name)
+{
+	char *match = safe_strdup(name);
+
+	for (char *c = match; *c; c++) {
+		if (strchr("*?[]\\", *c))
+			*c = '?';
+	}
+
+	return match;
+}
+
+static bool
+sweep_write_quirks(struct sweep *s)
+{
+	const char *data_path;
+	size_t nfiles = sweep_count_combinations(s, true);
+	bool have_quirks = false;
+
+	for (size_t a = 0; a < s->naxes; a++)
+		have_quirks |= s->axes[a].quirk;
+
+	if (!have_quirks)
+		return true;
+
+	if (nfiles > MAX_COMBINATIONS) {
+		fprintf(stderr, "Too many combinations, the maximum is %d\n",
+			MAX_COMBINATIONS);
+		return false;
+	}
+
+	s->tmpdir = safe_strdup("/tmp/libinput-sweep-XXXXXX");
+	if (!mkdtemp(s->tmpdir)) {
+		fprintf(stderr, "Failed to create temporary directory: %m\n");
+		free(s->tmpdir);
+		s->tmpdir = NULL;
+		return false;
+	}
+
+	tools_setenv_quirks_dir();
+	data_path = getenv("LIBINPUT_QUIRKS_DIR");
+	if (!data_path)
+		data_path = LIBINPUT_QUIRKS_DIR;
+
+	s->quirks_files = zalloc(nfiles * sizeof(*s->quirks_files));
+	for (size_t i = 0; i < nfiles; i++) {
+		size_t choice[ARRAY_LENGTH(s->axes)] = {0};
+		char *path = strdup_printf("%s/sweep-%zu.quirks", s->tmpdir, i);
+		FILE *fp;
+
+		s->quirks_files[s->nquirks_files++] = path;
+
+		fp = fopen(path, "w");
+		if (!fp) {
+			fprintf(stderr, "Failed to create %s: %m\n", path);
+			return false;
+		}
+
+		/* The same quirks apply to every device in the recording */
+		sweep_get_combination(s, i, true, choice);
+		for (size_t d = 0; d < s->ndevices; d++) {
+			const struct recording_device *dev =
+				recording_reader_get_device(s->reader, d);
+			_autofree_ char *match = quirks_match_name(dev->name ? dev->name : "*");
+
+			fprintf(fp, "[libinput analyze sweep device %zu]\n", d);
+			fprintf(fp, "MatchName=%s\n", match);
+			for (size_t a = 0; a < s->naxes; a++) {
+				if (s->axes[a].quirk)
+					fprintf(fp, "%s\n", s->axes[a].settings[choice[a]].value);
+			}
+			fprintf(fp, "\n");
+		}
+		fclose(fp);
+
+		/* An invalid override file means libinput ignores all
+		 * quirks, check it before we replay anything */
+		_unref_(quirks_context) *ctx = quirks_init_subsystem(data_path,
+								     path,
+								     quirks_log_handler,
+								     NULL,
+								     QLOG_CUSTOM_LOG_PRIORITIES);
+		if (!ctx) {
+			fprintf(stderr, "Failed to load the quirks, check the --quirk values\n");
+			return false;
+		}
+	}
+
+	return true;
+}
+
+static bool
+sweep_create_jobs(struct sweep *s, const struct tools_options *base)
+{
+	size_t njobs = sweep_count_combinations(s, false);
+
+	if (njobs > MAX_COMBINATIONS) {
+		fprintf(stderr, "Too many combinations, the maximum is %d\n",
+			MAX_COMBINATIONS);
+		return false;
+	}
+
+	s->jobs = zalloc(njobs * sizeof(*s->jobs));
+	s->njobs = njobs;
+
+	for (size_t i = 0; i < njobs; i++) {
+		struct sweep_job *job = &s->jobs[i];
+		size_t choice[ARRAY_LENGTH(s->axes)] = {0};
+		size_t quirks_index = 0;
+		char label[1024] = {0};
+
+		job->index = i;
+		job->options = *base;
+
+		sweep_get_combination(s, i, false, choice);
+		for (size_t a = 0; a < s->naxes; a++) {
+			struct sweep_axis *axis = &s->axes[a];
+			struct sweep_setting *setting = &axis->settings[choice[a]];
+
+			if (axis->quirk) {
+				quirks_index = quirks_index * axis->nsettings + choice[a];
+			} else if (tools_parse_option(setting->option,
+						      setting->value,
+						      &job->options) != 0) {
+				fprintf(stderr, "Invalid value for %s\n", setting->label);
+				return false;
+			}
+
+			if (label[0])
+				strncat(label, " ", sizeof(label) - strlen(label) - 1);
+			strncat(label, setting->label, sizeof(label) - strlen(label) - 1);
+		}
+
+		job->label = safe_strdup(label[0] ? label : "default");
+		if (s->quirks_files)
+			job->quirks_file = s->quirks_files[quirks_index];
+	}
+
+	return true;
+}
+
+static int
+open_restricted(const char *path, int flags, void *user_data)
+{
+	int fd = open(path, flags);
+	return fd < 0 ? -errno : fd;
+}
+
+static void
+close_restricted(int fd, void *user_data)
+{
+	close(fd);
+}
+
+static const struct libinput_interface interface = {
+	.open_restricted = open_restricted,
+	.close_restricted = close_restricted,
+};
+
+LIBINPUT_ATTRIBUTE_PRINTF(3, 0)
+static void
+log_handler(struct libinput *li,
+	    enum libinput_log_priority priority,
+	    const char *format,
+	    va_list args)
+{
+	struct sweep_context *ctx = libinput_get_user_data(li);
+	char buf[1024];
+
+	/* The messages of all jobs end up interleaved, they're only
+	 * useful when debugging the tool itself */
+	if (!verbose)
+		return;
+
+	vsnprintf(buf, sizeof(buf), format, args);
+	fprintf(stderr, "%s: %s", ctx->job->label, buf);
+}
+
+static void
+sweep_handle_events(struct sweep_context *ctx)
+{
+	struct sweep_result *result = &ctx->job->result;
+	struct libinput_event *ev;
+
+	libinput_dispatch(ctx->li);
+	while ((ev = libinput_get_event(ctx->li))) {
+		struct libinput_event_pointer *p;
+
+		switch (libinput_event_get_type(ev)) {
+		case LIBINPUT_EVENT_DEVICE_ADDED:
+		case LIBINPUT_EVENT_DEVICE_REMOVED:
+			break;
+		case LIBINPUT_EVENT_POINTER_BUTTON:
+			p = libinput_event_get_pointer_event(ev);
+			if (libinput_event_pointer_get_button_state(p) !=
+			    LIBINPUT_BUTTON_STATE_PRESSED)
+				break;
+			/* A button press without a physical button down is
+			 * a tap (or a software button like it) */
+			if (ctx->buttons_down > 0)
+				result->clicks++;
+			else
+				result->taps++;
+			break;
+		case LIBINPUT_EVENT_POINTER_MOTION:
+			p = libinput_event_get_pointer_event(ev);
+			result->motion += hypot(libinput_event_pointer_get_dx(p),
+						libinput_event_pointer_get_dy(p));
+			break;
+		case LIBINPUT_EVENT_POINTER_SCROLL_WHEEL:
+		case LIBINPUT_EVENT_POINTER_SCROLL_FINGER:
+		case LIBINPUT_EVENT_POINTER_SCROLL_CONTINUOUS:
+			p = libinput_event_get_pointer_event(ev);
+			if (libinput_event_pointer_has_axis(p, LIBINPUT_POINTER_AXIS_SCROLL_VERTICAL))
+				result->scroll[0] += fabs(libinput_event_pointer_get_scroll_value(p,
+									LIBINPUT_POINTER_AXIS_SCROLL_VERTICAL));
+			if (libinput_event_pointer_has_axis(p, LIBINPUT_POINTER_AXIS_SCROLL_HORIZONTAL))
+				result->scroll[1] += fabs(libinput_event_pointer_get_scroll_value(p,
+									LIBINPUT_POINTER_AXIS_SCROLL_HORIZONTAL));
+			break;
+		case LIBINPUT_EVENT_GESTURE_SWIPE_BEGIN:
+		case LIBINPUT_EVENT_GESTURE_PINCH_BEGIN:
+		case LIBINPUT_EVENT_GESTURE_HOLD_BEGIN:
+			result->gestures++;
+			break;
+		default:
+			break;
+		}
+		result->events++;
+
+		libinput_event_destroy(ev);
+	}
+}
+
+static void
+sweep_update_buttons(struct sweep_context *ctx, const struct input_event *e)
+{
+	if (e->type != EV_KEY || e->code < BTN_MOUSE || e->code > BTN_TASK)
+		return;
+
+	if (e->value)
+		ctx->buttons_down++;
+	else if (ctx->buttons_down > 0)
+		ctx->buttons_down--;
+}
+
+static bool
+sweep_write(struct sweep_context *ctx, size_t device,
+	    struct input_event *events, size_t count)
+{
+	if (write(ctx->fds[device], events, count * sizeof(*events)) < 0) {
+		fprintf(stderr, "Failed to write events: %m\n");
+		return false;
+	}
+
+	return true;
+}
+
+/* The context's clock is the time of the last frame written, the replay
+ * runs as fast as possible and the timers still expire at the right
+ * event time */
+static uint64_t
+sweep_clock(struct libinput *li, void *user_data)
+{
+	struct sweep_context *ctx = user_data;
+
+	return ctx->now;
+}
+
+static bool
+sweep_run_job(struct sweep *s, struct sweep_job *job)
+{
+	struct sweep_context ctx = {
+		.sweep = s,
+		.job = job,
+		.now = START_TIME_US,
+	};
+	_autofree_ struct input_event *buf = NULL;
+	uint64_t offset;
+	bool have_device = false;
+	bool rc = false;
+
+	for (size_t i = 0; i < ARRAY_LENGTH(ctx.fds); i++)
+		ctx.fds[i] = -1;
+
+	ctx.li = libinput_path_create_context(&interface, &ctx);
+	if (!ctx.li)
+		return false;
+
+	libinput_log_set_handler(ctx.li, log_handler);
+	libinput_log_set_priority(ctx.li,
+				  verbose ? LIBINPUT_LOG_PRIORITY_DEBUG :
+					    LIBINPUT_LOG_PRIORITY_ERROR);
+
+	if (job->quirks_file &&
+	    libinput_set_quirks_override_file(ctx.li, job->quirks_file) != 0)
+		goto out;
+
+	if (libinput_set_clock(ctx.li, sweep_clock, &ctx) != 0)
+		goto out;
+
+	for (size_t d = 0; d < s->ndevices; d++) {
+		const struct recording_device *dev = recording_reader_get_device(s->reader, d);
+		const char *sysname = strrchr(dev->node, '/');
+		struct libinput_device *device;
+		int fds[2];
+
+		if (pipe2(fds, O_CLOEXEC) == -1)
+			goto out;
+		/* libinput needs a non-blocking read end */
+		if (fcntl(fds[0], F_SETFL, O_NONBLOCK) == -1) {
+			close(fds[0]);
+			close(fds[1]);
+			goto out;
+		}
+
+		device = libinput_path_add_evdev_device(ctx.li,
+							recording_device_create_evdev(dev),
+							fds[0],
+							sysname ? sysname + 1 : dev->node,
+							(const char **)dev->properties);
+		close(fds[0]);
+
+		/* Devices libinput doesn't handle are skipped, their
+		 * events would go nowhere anyway */
+		if (!device) {
+			close(fds[1]);
+			continue;
+		}
+
+		ctx.fds[d] = fds[1];
+		have_device = true;
+		tools_device_apply_config(device, &job->options);
+	}
+
+	if (!have_device)
+		goto out;
+
+	sweep_handle_events(&ctx);
+
+	/* The frames happen at their recorded offsets from the start time,
+	 * the clock jumps from one frame to the next */
+	offset = s->nframes ? s->frames[0].time : 0;
+
+	buf = zalloc(max(s->max_frame_size, 1U) * sizeof(*buf));
+
+	for (size_t i = 0; i < s->nframes; i++) {
+		const struct sweep_frame *f = &s->frames[i];
+
+		if (ctx.fds[f->device] == -1)
+			continue;
+
+		ctx.now = START_TIME_US + f->time - offset;
+		for (size_t e = 0; e < f->count; e++) {
+			buf[e] = s->events[f->first + e];
+			input_event_set_time(&buf[e], ctx.now);
+			sweep_update_buttons(&ctx, &buf[e]);
+		}
+
+		if (!sweep_write(&ctx, f->device, buf, f->count))
+			goto out;
+
+		sweep_handle_events(&ctx);
+	}
+
+	/* Let the timers still pending after the last frame (e.g. a tap
+	 * waiting for its timeout) fire */
+	const uint64_t end = ctx.now + FLUSH_DURATION_US;
+	while (ctx.now < end) {
+		ctx.now += FLUSH_INTERVAL_US;
+		sweep_handle_events(&ctx);
+	}
+
+	rc = true;
+out:
+	for (size_t i = 0; i < ARRAY_LENGTH(ctx.fds); i++) {
+		if (ctx.fds[i] != -1)
+			close(ctx.fds[i]);
+	}
+	libinput_unref(ctx.li);
+
+	return rc;
+}
+
+static void *
+sweep_worker(void *data)
+{
+	struct sweep *s = data;
+
+	while (1) {
+		struct sweep_job *job;
+
+		pthread_mutex_lock(&s->lock);
+		job = s->next_job < s->njobs ? &s->jobs[s->next_job++] : NULL;
+		pthread_mutex_unlock(&s->lock);
+
+		if (!job)
+			break;
+
+		if (!sweep_run_job(s, job))
+			job->result.failed = true;
+	}
+
+	return NULL;
+}
+
+static bool
+sweep_run(struct sweep *s, unsigned int nthreads)
+{
+	pthread_t threads[64];
+	size_t nstarted = 0;
+
+	nthreads = min(nthreads, ARRAY_LENGTH(threads));
+	nthreads = min(nthreads, s->njobs);
+
+	pthread_mutex_init(&s->lock, NULL);
+	for (unsigned int i = 0; i < nthreads; i++) {
+		if (pthread_create(&threads[i], NULL, sweep_worker, s) != 0)
+			break;
+		nstarted++;
+	}
+
+	/* If we couldn't start any threads, do the work ourselves */
+	if (nstarted == 0)
+		sweep_worker(s);
+
+	for (size_t i = 0; i < nstarted; i++)
+		pthread_join(threads[i], NULL);
+	pthread_mutex_destroy(&s->lock);
+
+	for (size_t i = 0; i < s->njobs; i++) {
+		if (s->jobs[i].result.failed)
+			return false;
+	}
+
+	return true;
+}
+
+static void
+sweep_print(struct sweep *s, unsigned int nthreads, uint64_t elapsed)
+{
+	uint64_t duration = 0;
+	int width = strlen("configuration");
+
+	if (s->nframes > 0)
+		duration = s->frames[s->nframes - 1].time - s->frames[0].time;
+
+	printf("# %zu configuration%s, %zu device%s, %zu frames (%.1fs), %u thread%s, %.3fs\n",
+	       s->njobs, s->njobs == 1 ? "" : "s",
+	       s->ndevices, s->ndevices == 1 ? "" : "s",
+	       s->nframes, duration / 1e6,
+	       nthreads, nthreads == 1 ? "" : "s",
+	       elapsed / 1e6);
+
+	for (size_t i = 0; i < s->njobs; i++)
+		width = max(width, (int)strlen(s->jobs[i].label));
+
+	printf("%-*s %8s %8s %10s %10s %10s %8s\n",
+	       width, "configuration",
+	       "taps", "clicks", "motion", "scroll-v", "scroll-h", "gestures");
+
+	for (size_t i = 0; i < s->njobs; i++) {
+		const struct sweep_job *job = &s->jobs[i];
+		const struct sweep_result *r = &job->result;
+
+		printf("%-*s %8zu %8zu %10.1f %10.1f %10.1f %8zu\n",
+		       width, job->label,
+		       r->taps, r->clicks, r->motion,
+		       r->scroll[0], r->scroll[1], r->gestures);
+	}
+}
+
+static void
+usage(struct option *opts)
+{
+	printf("Usage: libinput analyze sweep [options] recording.yml\n");
+
+	if (!opts)
+		return;
+
+	printf("\n"
+	       "Replay a recording with every combination of the given configuration\n"
+	       "options and quirks and print the resulting event counts.\n"
+	       "\n"
+	       "  --config=name=value1,value2,...    Configuration option with the values to try\n"
+	       "  --config=name1,name2,...           Configuration flags to try, e.g.\n"
+	       "                                     --config=enable-tap,disable-tap\n"
+	       "  --quirk=AttrFoo=value1,value2,...  Quirk with the values to try\n"
+	       "  --jobs=N                           Number of threads (default: number of CPUs)\n"
+	       "  --verbose                          Print libinput's log messages\n"
+	       "\n"
+	       "The configuration options below apply to all combinations.\n"
+	       "\n");
+	tools_print_usage_option_list(opts);
+}
+
+int
+main(int argc, char **argv)
+{
+	struct sweep s = {0};
+	struct tools_options options;
+	long ncpus = sysconf(_SC_NPROCESSORS_ONLN);
+	unsigned int nthreads = ncpus > 0 ? ncpus : 1;
+	uint64_t start, end;
+	int rc = EXIT_FAILURE;
+
+	tools_init_options(&options);
+
+	while (1) {
+		int c;
+		int option_index = 0;
+		enum {
+			OPT_CONFIG = 1,
+			OPT_QUIRK,
+			OPT_JOBS,
+			OPT_VERBOSE,
+		};
+		static struct option opts[] = {
+			CONFIGURATION_OPTIONS,
+			{ "help",    no_argument,       0, 'h' },
+			{ "config",  required_argument, 0, OPT_CONFIG },
+			{ "quirk",   required_argument, 0, OPT_QUIRK },
+			{ "jobs",    required_argument, 0, OPT_JOBS },
+			{ "verbose", no_argument,       0, OPT_VERBOSE },
+			{ 0, 0, 0, 0 },
+		};
+		bool valid;
+
+		c = getopt_long(argc, argv, "h", opts, &option_index);
+		if (c == -1)
+			break;
+
+		switch (c) {
+		case '?':
+			rc = EXIT_INVALID_USAGE;
+			goto out;
+		case 'h':
+			usage(opts);
+			rc = EXIT_SUCCESS;
+			goto out;
+		case OPT_CONFIG:
+		case OPT_QUIRK:
+			if (s.naxes == ARRAY_LENGTH(s.axes)) {
+				fprintf(stderr, "Too many --config/--quirk arguments\n");
+				rc = EXIT_INVALID_USAGE;
+				goto out;
+			}
+			if (c == OPT_CONFIG)
+				valid = parse_config_axis(&s.axes[s.naxes], optarg);
+			else
+				valid = parse_quirk_axis(&s.axes[s.naxes], optarg);
+			s.naxes++;
+			if (!valid) {
+				usage(NULL);
+				rc = EXIT_INVALID_USAGE;
+				goto out;
+			}
+			break;
+		case OPT_JOBS:
+			if (!safe_atou(optarg, &nthreads) || nthreads == 0) {
+				usage(NULL);
+				rc = EXIT_INVALID_USAGE;
+				goto out;
+			}
+			break;
+		case OPT_VERBOSE:
+			verbose = true;
+			break;
+		default:
+			if (tools_parse_option(c, optarg, &options) != 0) {
+				usage(NULL);
+				rc = EXIT_INVALID_USAGE;
+				goto out;
+			}
+			break;
+		}
+	}
+
+	if (optind + 1 != argc) {
+		usage(NULL);
+		rc = EXIT_INVALID_USAGE;
+		goto out;
+	}
+
+	if (!sweep_load(&s, argv[optind]))
+		goto out;
+
+	if (!sweep_write_quirks(&s) ||
+	    !sweep_create_jobs(&s, &options))
+		goto out;
+
+	nthreads = min(nthreads, s.njobs);
+
+	now_in_us(&start);
+	if (!sweep_run(&s, nthreads)) {
+		fprintf(stderr, "Failed to replay the recording in at least one configuration\n");
+		goto out;
+	}
+	now_in_us(&end);
+
+	sweep_print(&s, nthreads, end - start);
+	rc = EXIT_SUCCESS;
+
+out:
+	sweep_destroy(&s);
+
+	return rc;
+}
@@ -0,0 +1,286 @@
+/*
+ * Copyright © 2020 Red Hat, Inc.
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a
+ * copy of this software and associated documentation files (the "Software"),
+ * to deal in the Software without restriction, including without limitation
+ * the rights to use, copy, modify, merge, publish, distribute, sublicense,
+ * and/or sell copies of the Software, and to permit persons to whom the
+ * Software is furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice (including the next
+ * paragraph) shall be included in all copies or substantial portions of the
+ * Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT.  IN NO EVENT SHALL
+ * THE AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING
+ * FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER
+ * DEALINGS IN THE SOFTWARE.
+ */
+
+/* Prints the down/up state of each touch slot
+ *
+ * Input is a libinput record yaml file, the output matches the
+ * Python tool this replaces.
+ */
+
+#include "config.h"
+
+#include <getopt.h>
+#include <inttypes.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+#include "linux/input.h"
+#include "util-input-event.h"
+#include "util-macros.h"
+#include "util-mem.h"
+#include "shared.h"
+
+enum slot_state {
+	SLOT_STATE_NONE,
+	SLOT_STATE_BEGIN,
+	SLOT_STATE_UPDATE,
+	SLOT_STATE_END,
+};
+
+struct slot {
+	enum slot_state state;
+	bool used;
+	bool was_active;
+};
+
+static inline void
+slot_set_state(struct slot *s, enum slot_state state)
+{
+	if (state != SLOT_STATE_NONE)
+		s->used = true;
+	s->state = state;
+}
+
+static inline bool
+slot_is_active(const struct slot *s)
+{
+	return s->state == SLOT_STATE_BEGIN || s->state == SLOT_STATE_UPDATE;
+}
+
+static inline void
+slot_sync(struct slot *s)
+{
+	if (s->state == SLOT_STATE_BEGIN)
+		slot_set_state(s, SLOT_STATE_UPDATE);
+	else if (s->state == SLOT_STATE_END)
+		slot_set_state(s, SLOT_STATE_NONE);
+}
+
+static int
+tool_slot(unsigned int code)
+{
+	switch (code) {
+	case BTN_TOOL_FINGER:
+	case BTN_TOOL_PEN:
+		return 0;
+	case BTN_TOOL_DOUBLETAP:
+		return 1;
+	case BTN_TOOL_TRIPLETAP:
+		return 2;
+	case BTN_TOOL_QUADTAP:
+		return 3;
+	case BTN_TOOL_QUINTTAP:
+		return 4;
+	default:
+		return -1;
+	}
+}
+
+static void
+usage(void)
+{
+	printf("Usage: libinput analyze touch-down-state [--help] [--use-st] recording.yml\n"
+	       "\n"
+	       "Print the state of touches over time\n"
+	       "\n"
+	       "Options:\n"
+	       "  --use-st ............ Ignore slots, use the BTN_TOOL bits\n");
+}
+
+int
+main(int argc, char **argv)
+{
+	struct recording_reader *reader;
+	const struct recording_device *device;
+	struct recording_frame frame;
+	struct slot *slots;
+	size_t nslots = 0;
+	size_t slot = 0;
+	bool use_st = false;
+	bool have_last_state = false;
+	uint64_t last_time = 0;
+	bool have_last_time = false;
+	const char *header = "Timestamp | Rel time |     Slots     |";
+	int rc;
+
+	while (1) {
+		int c;
+		int option_index = 0;
+		enum {
+			OPT_USE_ST = 1,
+		};
+		static struct option opts[] = {
+			{ "help",   no_argument, 0, 'h' },
+			{ "use-st", no_argument, 0, OPT_USE_ST },
+			{ 0, 0, 0, 0 },
+		};
+
+		c = getopt_long(argc, argv, "h", opts, &option_index);
+		if (c == -1)
+			break;
+
+		switch (c) {
+		case 'h':
+			usage();
+			return EXIT_SUCCESS;
+		case OPT_USE_ST:
+			use_st = true;
+			break;
+		default:
+			usage();
+			return EXIT_INVALID_USAGE;
+		}
+	}
+
+	if (optind + 1 != argc) {
+		usage();
+		return EXIT_INVALID_USAGE;
+	}
+
+	reader = recording_reader_new(argv[optind]);
+	if (!reader)
+		return EXIT_FAILURE;
+
+	device = recording_reader_get_device(reader, 0);
+	if (recording_device_has_code(device, EV_ABS, ABS_MT_SLOT))
+		nslots = device->absinfo[ABS_MT_SLOT].maximum + 1;
+	else
+		use_st = true;
+
+	if (use_st) {
+		for (unsigned int code = BTN_TOOL_PEN; code <= BTN_TOOL_QUADTAP; code++) {
+			int s = tool_slot(code);
+
+			/* Note: this is the highest tool index, not the
+			 * count, same as the original Python tool so the
+			 * number of columns doesn't change */
+			if (s >= 0 && recording_device_has_code(device, EV_KEY, code))
+				nslots = max(nslots, (size_t)s);
+		}
+	}
+
+	nslots = max(nslots, 1U);
+	slots = zalloc(nslots * sizeof(*slots));
+	/* We claim the first slots are used just to make the formatting
+	 * more consistent */
+	for (size_t i = 0; i < min(nslots, 5U); i++)
+		slots[i].used = true;
+
+	printf("%s\n", header);
+	for (size_t i = 0; i < strlen(header); i++)
+		putchar('-');
+	printf("\n");
+
+	/* Only the first device is analyzed */
+	while ((rc = recording_reader_next_frame(reader, &frame)) > 0 &&
+	       frame.device == 0) {
+		for (size_t i = 0; i < frame.nevents; i++) {
+			const struct input_event *e = &frame.events[i];
+			struct slot *s;
+
+			/* single-touch formatting is simpler than multitouch,
+			 * it'll just show the highest finger down rather than
+			 * the correct output. */
+			if (use_st) {
+				int ts = e->type == EV_KEY ? tool_slot(e->code) : -1;
+
+				if (ts >= 0 && (size_t)ts < nslots) {
+					slot = ts;
+					slot_set_state(&slots[slot],
+						       e->value ? SLOT_STATE_BEGIN : SLOT_STATE_END);
+				}
+			} else if (e->type == EV_ABS && e->code == ABS_MT_SLOT) {
+				if (e->value >= 0 && (size_t)e->value < nslots) {
+					slot = e->value;
+					/* bcm5974 cycles through slot numbers, so let's
+					 * say all below our current slot number was used */
+					for (size_t sl = 0; sl <= slot; sl++)
+						slots[sl].used = true;
+				}
+			} else if (e->type == EV_ABS) {
+				s = &slots[slot];
+				switch (e->code) {
+				case ABS_MT_TRACKING_ID:
+					slot_set_state(s, e->value == -1 ?
+						       SLOT_STATE_END : SLOT_STATE_BEGIN);
+					break;
+				case ABS_MT_POSITION_X:
+				case ABS_MT_POSITION_Y:
+				case ABS_MT_PRESSURE:
+				case ABS_MT_TOUCH_MAJOR:
+				case ABS_MT_TOUCH_MINOR:
+					/* If recording started after touch down */
+					if (s->state == SLOT_STATE_NONE)
+						slot_set_state(s, SLOT_STATE_BEGIN);
+					break;
+				}
+			}
+
+			if (e->type == EV_SYN && e->code == SYN_REPORT) {
+				bool changed = !have_last_state;
+
+				for (size_t sl = 0; sl < nslots; sl++) {
+					bool active = slot_is_active(&slots[sl]);
+
+					if (active != slots[sl].was_active)
+						changed = true;
+					slots[sl].was_active = active;
+				}
+
+				if (changed) {
+					uint64_t t = input_event_time(e);
+					double tdelta = 0.0;
+					const char *sep = "";
+
+					if (have_last_time)
+						tdelta = (int64_t)(t - last_time) / 1000 / 1000.0;
+					last_time = t;
+					have_last_time = true;
+
+					printf("%2" PRIu64 ".%06" PRIu64 " | %+7.3fs | ",
+					       (uint64_t)e->input_event_sec,
+					       (uint64_t)e->input_event_usec,
+					       tdelta);
+					for (size_t sl = 0; sl < nslots; sl++) {
+						if (!slots[sl].used)
+							continue;
+						printf("%s%s", sep,
+						       slot_is_active(&slots[sl]) ? "+" : " ");
+						sep = " | ";
+					}
+					printf("\n");
+					have_last_state = true;
+				}
+
+				for (size_t sl = 0; sl < nslots; sl++)
+					slot_sync(&slots[sl]);
+			}
+		}
+	}
+
+	free(slots);
+	recording_reader_destroy(reader);
+
+	return rc < 0 ? EXIT_FAILURE : EXIT_SUCCESS;
+}
@@ -24,7 +24,9 @@
 #include "config.h"
 
 #include <errno.h>
+#include <fcntl.h>
 #include <inttypes.h>
+#include <limits.h>
 #include <getopt.h>
 #include <poll.h>
 #include <stdio.h>
@@ -39,20 +41,303 @@
 #include <libevdev/libevdev.h>
 
 #include "libinput-version.h"
+#include "util-histogram.h"
 #include "util-strings.h"
 #include "util-macros.h"
+#include "util-mem.h"
+#include "util-time.h"
 #include "util-libinput.h"
 #include "shared.h"
 
 static struct tools_options options;
 static bool show_keycodes;
 static volatile sig_atomic_t stop = 0;
+static volatile sig_atomic_t dump_flight_recorder = 0;
 static bool be_quiet = false;
 static bool compress_motion_events = false;
 static bool is_tty = false;
+static bool show_latency = false;
+static struct libinput_device *latency_devices[64];
+static unsigned int summary_interval_ms = 0;
+
+struct summary_counter {
+	enum libinput_event_type type;
+	uint64_t total;
+	uint64_t interval;
+};
+
+/* Per-device state for --summary, hooked into the device's user_data */
+struct summary_device {
+	struct libinput_device *device;
+	struct summary_counter counters[64];
+	size_t ncounters;
+	uint64_t total;
+	uint64_t interval;
+	struct histogram latency;
+};
+
+static struct summary_device *summary_devices[64];
 
 #define printq(...) ({ if (!be_quiet)  printf(__VA_ARGS__); })
 
+static void
+print_latency_stats(struct libinput_device *device)
+{
+	static const struct {
+		enum libinput_latency_stat which;
+		const char *name;
+	} stats[] = {
+		{ LIBINPUT_LATENCY_STAT_DISPATCH, "dispatch" },
+		{ LIBINPUT_LATENCY_STAT_POST, "post" },
+		{ LIBINPUT_LATENCY_STAT_PLUGINS, "plugins" },
+		{ LIBINPUT_LATENCY_STAT_INTERFACE, "interface" },
+	};
+
+	printf("%-7s - %s: latency in µs\n",
+	       libinput_device_get_sysname(device),
+	       libinput_device_get_name(device));
+	printf("  %-10s %8s %8s %8s %8s %8s\n",
+	       "", "count", "p50", "p90", "p99", "max");
+
+	ARRAY_FOR_EACH(stats, s) {
+		printf("  %-10s %8" PRIu64 " %8" PRIu64 " %8" PRIu64 " %8" PRIu64 " %8" PRIu64 "\n",
+		       s->name,
+		       libinput_device_get_latency_stats_count(device, s->which),
+		       libinput_device_get_latency_stats_percentile(device, s->which, 50),
+		       libinput_device_get_latency_stats_percentile(device, s->which, 90),
+		       libinput_device_get_latency_stats_percentile(device, s->which, 99),
+		       libinput_device_get_latency_stats_percentile(device, s->which, 100));
+	}
+}
+
+static void
+latency_device_added(struct libinput_device *device)
+{
+	ARRAY_FOR_EACH(latency_devices, d) {
+		if (*d == NULL) {
+			*d = libinput_device_ref(device);
+			return;
+		}
+	}
+}
+
+static void
+latency_device_removed(struct libinput_device *device)
+{
+	ARRAY_FOR_EACH(latency_devices, d) {
+		if (*d == device) {
+			print_latency_stats(device);
+			*d = libinput_device_unref(device);
+			return;
+		}
+	}
+}
+
+static void
+summary_device_added(struct libinput_device *device)
+{
+	ARRAY_FOR_EACH(summary_devices, d) {
+		if (*d == NULL) {
+			struct summary_device *sd = zalloc(sizeof(*sd));
+
+			sd->device = libinput_device_ref(device);
+			libinput_device_set_user_data(device, sd);
+			*d = sd;
+			return;
+		}
+	}
+}
+
+static void
+summary_device_removed(struct libinput_device *device)
+{
+	ARRAY_FOR_EACH(summary_devices, d) {
+		if (*d && (*d)->device == device) {
+			libinput_device_set_user_data(device, NULL);
+			libinput_device_unref(device);
+			free(*d);
+			*d = NULL;
+			return;
+		}
+	}
+}
+
+static uint64_t
+summary_event_time_usec(struct libinput_event *ev, enum libinput_event_type type)
+{
+	/* Event types are grouped in blocks of 100 per interface */
+	if (type >= LIBINPUT_EVENT_SWITCH_TOGGLE)
+		return libinput_event_switch_get_time_usec(
+				libinput_event_get_switch_event(ev));
+	if (type >= LIBINPUT_EVENT_GESTURE_SWIPE_BEGIN)
+		return libinput_event_gesture_get_time_usec(
+				libinput_event_get_gesture_event(ev));
+	if (type >= LIBINPUT_EVENT_TABLET_PAD_BUTTON)
+		return libinput_event_tablet_pad_get_time_usec(
+				libinput_event_get_tablet_pad_event(ev));
+	if (type >= LIBINPUT_EVENT_TABLET_TOOL_AXIS)
+		return libinput_event_tablet_tool_get_time_usec(
+				libinput_event_get_tablet_tool_event(ev));
+	if (type >= LIBINPUT_EVENT_TOUCH_DOWN)
+		return libinput_event_touch_get_time_usec(
+				libinput_event_get_touch_event(ev));
+	if (type >= LIBINPUT_EVENT_POINTER_MOTION)
+		return libinput_event_pointer_get_time_usec(
+				libinput_event_get_pointer_event(ev));
+	if (type >= LIBINPUT_EVENT_KEYBOARD_KEY)
+		return libinput_event_keyboard_get_time_usec(
+				libinput_event_get_keyboard_event(ev));
+
+	return 0;
+}
+
+static void
+summary_device_count_event(struct summary_device *sd,
+			   enum libinput_event_type type,
+			   uint64_t time,
+			   uint64_t now)
+{
+	struct summary_counter *c = NULL;
+	size_t idx;
+
+	/* Sorted by type so the output order doesn't jump around, a device
+	 * only ever sends a handful of different types */
+	for (idx = 0; idx < sd->ncounters; idx++) {
+		if (sd->counters[idx].type >= type)
+			break;
+	}
+
+	if (idx < sd->ncounters && sd->counters[idx].type == type) {
+		c = &sd->counters[idx];
+	} else if (sd->ncounters < ARRAY_LENGTH(sd->counters)) {
+		memmove(&sd->counters[idx + 1],
+			&sd->counters[idx],
+			(sd->ncounters - idx) * sizeof(*c));
+		sd->ncounters++;
+		c = &sd->counters[idx];
+		c->type = type;
+		c->total = 0;
+		c->interval = 0;
+	}
+
+	if (c) {
+		c->total++;
+		c->interval++;
+	}
+
+	sd->total++;
+	sd->interval++;
+	histogram_add(&sd->latency, now > time ? now - time : 0);
+}
+
+static void
+print_summary(uint64_t elapsed, uint64_t runtime)
+{
+	double secs = (elapsed ? elapsed : 1) / 1e6;
+
+	/* Redraw in place on a terminal, otherwise append so the output
+	 * can be logged */
+	if (is_tty)
+		printf("\e[H\e[J");
+	printf("%+.3fs: summary over %.3fs, latency in µs\n",
+	       runtime / 1e6, secs);
+
+	ARRAY_FOR_EACH(summary_devices, d) {
+		struct summary_device *sd = *d;
+
+		if (!sd)
+			continue;
+
+		printf("%-7s - %s\n",
+		       libinput_device_get_sysname(sd->device),
+		       libinput_device_get_name(sd->device));
+		printf("  %-28s %10.0f/s %10" PRIu64 "   p50 %" PRIu64 " p90 %" PRIu64 " p99 %" PRIu64 " max %" PRIu64 "\n",
+		       "all events",
+		       sd->interval / secs,
+		       sd->total,
+		       histogram_percentile(&sd->latency, 50),
+		       histogram_percentile(&sd->latency, 90),
+		       histogram_percentile(&sd->latency, 99),
+		       sd->latency.max);
+
+		for (size_t i = 0; i < sd->ncounters; i++) {
+			struct summary_counter *c = &sd->counters[i];
+
+			printf("  %-28s %10.0f/s %10" PRIu64 "\n",
+			       libinput_event_type_to_str(c->type),
+			       c->interval / secs,
+			       c->total);
+			c->interval = 0;
+		}
+
+		sd->interval = 0;
+		histogram_reset(&sd->latency);
+	}
+
+	if (!is_tty)
+		printf("\n");
+	fflush(stdout);
+}
+
+static int
+handle_summary_events(struct libinput *li)
+{
+	int rc = -1;
+	struct libinput_event *ev;
+	uint64_t now;
+
+	tools_dispatch(li);
+
+	/* Everything in the queue came out of the same dispatch, so one
+	 * timestamp per batch is good enough and saves a syscall for every
+	 * event on high-frequency devices */
+	now_in_us(&now);
+
+	while ((ev = libinput_get_event(li))) {
+		struct libinput_device *device = libinput_event_get_device(ev);
+		enum libinput_event_type type = libinput_event_get_type(ev);
+		struct summary_device *sd;
+
+		switch (type) {
+		case LIBINPUT_EVENT_DEVICE_ADDED:
+			tools_device_apply_config(device, &options);
+			summary_device_added(device);
+			if (show_latency)
+				latency_device_added(device);
+			break;
+		case LIBINPUT_EVENT_DEVICE_REMOVED:
+			summary_device_removed(device);
+			if (show_latency)
+				latency_device_removed(device);
+			break;
+		case LIBINPUT_EVENT_POINTER_AXIS:
+			/* duplicate of the scroll events */
+			break;
+		case LIBINPUT_EVENT_TABLET_TOOL_PROXIMITY: {
+			struct libinput_event_tablet_tool *tev =
+				libinput_event_get_tablet_tool_event(ev);
+			struct libinput_tablet_tool *tool =
+				libinput_event_tablet_tool_get_tool(tev);
+			tools_tablet_tool_apply_config(tool, &options);
+		}
+			_fallthrough_;
+		default:
+			sd = libinput_device_get_user_data(device);
+			if (sd)
+				summary_device_count_event(sd,
+							   type,
+							   summary_event_time_usec(ev, type),
+							   now);
+			break;
+		}
+
+		libinput_event_destroy(ev);
+		rc = 0;
+	}
+
+	return rc;
+}
+
 static int
 handle_and_print_events(struct libinput *li, const struct libinput_print_options *opts)
 {
@@ -106,6 +391,12 @@ handle_and_print_events(struct libinput *li, const struct libinput_print_options
 			case LIBINPUT_EVENT_DEVICE_ADDED:
 				tools_device_apply_config(libinput_event_get_device(ev),
 							  &options);
+				if (show_latency)
+					latency_device_added(device);
+				break;
+			case LIBINPUT_EVENT_DEVICE_REMOVED:
+				if (show_latency)
+					latency_device_removed(device);
 				break;
 			case LIBINPUT_EVENT_TABLET_TOOL_PROXIMITY: {
 				struct libinput_event_tablet_tool *tev =
@@ -139,7 +430,92 @@ handle_and_print_events(struct libinput *li, const struct libinput_print_options
 static void
 sighandler(int signal, siginfo_t *siginfo, void *userdata)
 {
-	stop = 1;
+	if (signal == SIGUSR1)
+		dump_flight_recorder = 1;
+	else
+		stop = 1;
+}
+
+static void
+write_flight_recorder(struct libinput *li)
+{
+	char name[64];
+	struct tm tm;
+	time_t t = time(NULL);
+
+	localtime_r(&t, &tm);
+	strftime(name, sizeof(name), "libinput-flight-recorder-%F-%T.yml", &tm);
+
+	int fd = open(name, O_WRONLY|O_CREAT|O_EXCL|O_CLOEXEC, 0644);
+	if (fd < 0) {
+		fprintf(stderr, "Failed to create '%s': %s\n", name, strerror(errno));
+		return;
+	}
+
+	int rc = libinput_flight_recorder_dump(li, fd);
+	close(fd);
+	if (rc < 0)
+		fprintf(stderr, "Failed to write '%s': %s\n", name, strerror(-rc));
+	else
+		fprintf(stderr, "Flight recorder written to '%s'\n", name);
+}
+
+static void
+summary_mainloop(struct libinput *li)
+{
+	struct pollfd fds;
+	uint64_t interval = summary_interval_ms * 1000ULL;
+	uint64_t start, last_refresh, next_refresh, now;
+
+	fds.fd = libinput_get_fd(li);
+	fds.events = POLLIN;
+	fds.revents = 0;
+
+	now_in_us(&start);
+	last_refresh = start;
+	next_refresh = start + interval;
+
+	if (handle_summary_events(li))
+		fprintf(stderr, "Expected device added events on startup but got none. "
+				"Maybe you don't have the right permissions?\n");
+
+	while (!stop) {
+		now_in_us(&now);
+		if (now >= next_refresh) {
+			print_summary(now - last_refresh, now - start);
+			last_refresh = now;
+			/* Fixed rate: a late refresh doesn't shift the ones
+			 * after it, unless we're a whole interval behind */
+			next_refresh += interval;
+			if (next_refresh <= now)
+				next_refresh = now + interval;
+		}
+
+		int timeout = min((next_refresh - now + 999) / 1000, (uint64_t)INT_MAX);
+		if (poll(&fds, 1, timeout) == -1 && errno != EINTR)
+			break;
+
+		if (dump_flight_recorder) {
+			dump_flight_recorder = 0;
+			write_flight_recorder(li);
+		}
+		handle_summary_events(li);
+	}
+
+	now_in_us(&now);
+	print_summary(now - last_refresh, now - start);
+
+	ARRAY_FOR_EACH(summary_devices, d) {
+		if (*d)
+			summary_device_removed((*d)->device);
+	}
+
+	if (show_latency) {
+		ARRAY_FOR_EACH(latency_devices, d) {
+			if (*d)
+				latency_device_removed(*d);
+		}
+	}
 }
 
 static void
@@ -164,17 +540,32 @@ mainloop(struct libinput *li)
 				"Maybe you don't have the right permissions?\n");
 
 	/* time offset starts with our first received event */
-	if (poll(&fds, 1, -1) > -1) {
+	int rc;
+	while ((rc = poll(&fds, 1, -1)) == -1 && errno == EINTR && !stop)
+		;
+
+	if (rc > -1) {
 		struct timespec tp;
 
 		clock_gettime(CLOCK_MONOTONIC, &tp);
 		opts.start_time = tp.tv_sec * 1000 + tp.tv_nsec / 1000000;
 		do {
+			if (dump_flight_recorder) {
+				dump_flight_recorder = 0;
+				write_flight_recorder(li);
+			}
 			handle_and_print_events(li, &opts);
-		} while (!stop && poll(&fds, 1, -1) > -1);
+		} while (!stop && (poll(&fds, 1, -1) > -1 || errno == EINTR));
 	}
 
 	printf("\n");
+
+	if (show_latency) {
+		ARRAY_FOR_EACH(latency_devices, d) {
+			if (*d)
+				latency_device_removed(*d);
+		}
+	}
 }
 
 static void
@@ -194,6 +585,7 @@ main(int argc, char **argv)
 	size_t ndevices = 0;
 	bool grab = false;
 	bool verbose = false;
+	unsigned int flight_recorder = 0;
 	struct sigaction act;
 
 	tools_init_options(&options);
@@ -211,6 +603,9 @@ main(int argc, char **argv)
 			OPT_SHOW_KEYCODES,
 			OPT_QUIET,
 			OPT_COMPRESS_MOTION_EVENTS,
+			OPT_LATENCY,
+			OPT_FLIGHT_RECORDER,
+			OPT_SUMMARY,
 		};
 		static struct option opts[] = {
 			CONFIGURATION_OPTIONS,
@@ -222,6 +617,9 @@ main(int argc, char **argv)
 			{ "verbose",                   no_argument,       0, OPT_VERBOSE },
 			{ "quiet",                     no_argument,       0, OPT_QUIET },
 			{ "compress-motion-events",    no_argument,       0, OPT_COMPRESS_MOTION_EVENTS },
+			{ "latency",                   no_argument,       0, OPT_LATENCY },
+			{ "flight-recorder",           required_argument, 0, OPT_FLIGHT_RECORDER },
+			{ "summary",                   optional_argument, 0, OPT_SUMMARY },
 			{ 0, 0, 0, 0}
 		};
 
@@ -274,6 +672,25 @@ main(int argc, char **argv)
 			/* We compress by using ansi escape sequences */
 			compress_motion_events = is_tty;
 			break;
+		case OPT_LATENCY:
+			show_latency = true;
+			break;
+		case OPT_FLIGHT_RECORDER:
+			if (!safe_atou(optarg, &flight_recorder) ||
+			    flight_recorder == 0) {
+				usage(NULL);
+				return EXIT_INVALID_USAGE;
+			}
+			break;
+		case OPT_SUMMARY:
+			summary_interval_ms = 1000;
+			if (optarg &&
+			    (!safe_atou(optarg, &summary_interval_ms) ||
+			     summary_interval_ms == 0)) {
+				usage(NULL);
+				return EXIT_INVALID_USAGE;
+			}
+			break;
 		default:
 			if (tools_parse_option(c, optarg, &options) != 0) {
 				usage(NULL);
@@ -305,7 +722,8 @@ main(int argc, char **argv)
 	act.sa_sigaction = sighandler;
 	act.sa_flags = SA_SIGINFO;
 
-	if (sigaction(SIGINT, &act, NULL) == -1) {
+	if (sigaction(SIGINT, &act, NULL) == -1 ||
+	    (flight_recorder && sigaction(SIGUSR1, &act, NULL) == -1)) {
 		fprintf(stderr, "Failed to set up signal handling (%s)\n",
 				strerror(errno));
 		return EXIT_FAILURE;
@@ -318,7 +736,20 @@ main(int argc, char **argv)
 	if (!li)
 		return EXIT_FAILURE;
 
-	mainloop(li);
+	if (show_latency)
+		libinput_set_latency_stats_enabled(li, 1);
+
+	if (flight_recorder) {
+		libinput_set_flight_recorder(li, flight_recorder);
+		fprintf(stderr,
+			"Flight recorder enabled, run 'kill -USR1 %d' to write it\n",
+			getpid());
+	}
+
+	if (summary_interval_ms)
+		summary_mainloop(li);
+	else
+		mainloop(li);
 
 	libinput_unref(li);
 
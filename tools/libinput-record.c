@@ -80,6 +80,49 @@ enum indent {
 	I_EVENT = 6,			/* event data */
 };
 
+enum record_format {
+	FORMAT_YAML,
+	FORMAT_BINARY,
+};
+
+/* Binary recording format, see the BINARY FILE FORMAT section in the man
+ * page. All integers are little-endian. */
+#define BINARY_MAGIC "LIRECBIN"
+#define BINARY_CHUNK_MAGIC "CHNK"
+#define BINARY_INDEX_MAGIC "INDX"
+#define BINARY_TRAILER_MAGIC "IEND"
+#define BINARY_MAGIC_LEN 8
+#define BINARY_TAG_LEN 4
+#define BINARY_CHUNK_HEADER_SIZE 24	/* tag, device, nframes, length, time */
+#define BINARY_INDEX_ENTRY_SIZE 20	/* offset, time, device */
+#define BINARY_TRAILER_SIZE 12		/* index offset, tag */
+#define BINARY_EVENT_SIZE 8		/* type, code, value */
+#define BINARY_CHUNK_SIZE (64 * 1024)
+#define BINARY_MAX_FRAME_EVENTS 1024
+#define BINARY_MAX_BLOB_SIZE (16 * 1024 * 1024)
+
+struct binary_chunk {
+	uint8_t data[BINARY_CHUNK_SIZE];
+	size_t len;
+	uint32_t nframes;
+	uint64_t base_time;	/* time of the first frame in us */
+	uint64_t last_time;	/* time of the last frame in us */
+};
+
+struct binary_index_entry {
+	uint64_t offset;	/* file offset of the chunk */
+	uint64_t base_time;
+	uint32_t device;
+};
+
+struct binary_writer {
+	FILE *fp;
+	uint64_t offset;	/* bytes written so far, fp may be a pipe */
+	struct binary_index_entry *index;
+	size_t nindex;
+	size_t index_sz;
+};
+
 struct record_device {
 	struct record_context *ctx;
 	struct list link;
@@ -97,6 +140,10 @@ struct record_device {
 	} touch;
 
 	FILE *fp;
+
+	/* Only used for binary recordings */
+	uint32_t index;
+	struct binary_chunk *chunk;
 };
 
 struct hidraw {
@@ -109,6 +156,8 @@ struct hidraw {
 struct record_context {
 	int timeout;
 	bool show_keycodes;
+	enum record_format format;
+	struct binary_writer binary;
 
 	uint64_t offset;
 
@@ -420,6 +469,288 @@ handle_evdev_frame(struct record_device *d)
 	return true;
 }
 
+static inline void
+put_u16(uint8_t *buf, uint16_t v)
+{
+	buf[0] = v & 0xff;
+	buf[1] = v >> 8;
+}
+
+static inline void
+put_u32(uint8_t *buf, uint32_t v)
+{
+	put_u16(buf, v & 0xffff);
+	put_u16(&buf[2], v >> 16);
+}
+
+static inline void
+put_u64(uint8_t *buf, uint64_t v)
+{
+	put_u32(buf, v & 0xffffffff);
+	put_u32(&buf[4], v >> 32);
+}
+
+static inline uint16_t
+get_u16(const uint8_t *buf)
+{
+	return buf[0] | (buf[1] << 8);
+}
+
+static inline uint32_t
+get_u32(const uint8_t *buf)
+{
+	return get_u16(buf) | ((uint32_t)get_u16(&buf[2]) << 16);
+}
+
+static inline uint64_t
+get_u64(const uint8_t *buf)
+{
+	return get_u32(buf) | ((uint64_t)get_u32(&buf[4]) << 32);
+}
+
+/* LEB128-style variable length integer, at most 10 bytes */
+static size_t
+put_varint(uint8_t *buf, uint64_t v)
+{
+	size_t n = 0;
+
+	do {
+		uint8_t byte = v & 0x7f;
+
+		v >>= 7;
+		buf[n++] = byte | (v ? 0x80 : 0);
+	} while (v);
+
+	return n;
+}
+
+static bool
+get_varint(const uint8_t *buf, size_t len, size_t *pos, uint64_t *v)
+{
+	uint64_t value = 0;
+
+	for (unsigned int shift = 0; shift < 64; shift += 7) {
+		uint8_t byte;
+
+		if (*pos >= len)
+			return false;
+
+		byte = buf[(*pos)++];
+		value |= (uint64_t)(byte & 0x7f) << shift;
+		if ((byte & 0x80) == 0) {
+			*v = value;
+			return true;
+		}
+	}
+
+	return false;
+}
+
+static bool
+binary_write(struct binary_writer *w, const void *data, size_t len)
+{
+	if (len > 0 && fwrite(data, 1, len, w->fp) != len)
+		return false;
+
+	w->offset += len;
+
+	return true;
+}
+
+static bool
+binary_write_blob(struct binary_writer *w, const char *text, size_t len)
+{
+	uint8_t buf[4];
+
+	put_u32(buf, len);
+
+	return binary_write(w, buf, sizeof(buf)) &&
+	       binary_write(w, text, len);
+}
+
+static bool
+binary_write_header(struct binary_writer *w,
+		    uint32_t ndevices,
+		    const char *yaml,
+		    size_t len)
+{
+	uint8_t buf[BINARY_MAGIC_LEN + 8];
+
+	w->offset = 0;
+	w->nindex = 0;
+
+	memcpy(buf, BINARY_MAGIC, BINARY_MAGIC_LEN);
+	put_u32(&buf[BINARY_MAGIC_LEN], FILE_VERSION_NUMBER);
+	put_u32(&buf[BINARY_MAGIC_LEN + 4], ndevices);
+
+	return binary_write(w, buf, sizeof(buf)) &&
+	       binary_write_blob(w, yaml, len);
+}
+
+static bool
+binary_flush_chunk(struct binary_writer *w,
+		   struct binary_chunk *chunk,
+		   uint32_t device)
+{
+	uint8_t header[BINARY_CHUNK_HEADER_SIZE];
+	bool rc;
+
+	if (chunk->nframes == 0)
+		return true;
+
+	if (w->nindex == w->index_sz)
+		resize(w->index, w->index_sz);
+
+	w->index[w->nindex++] = (struct binary_index_entry) {
+		.offset = w->offset,
+		.base_time = chunk->base_time,
+		.device = device,
+	};
+
+	memcpy(header, BINARY_CHUNK_MAGIC, BINARY_TAG_LEN);
+	put_u32(&header[4], device);
+	put_u32(&header[8], chunk->nframes);
+	put_u32(&header[12], chunk->len);
+	put_u64(&header[16], chunk->base_time);
+
+	rc = binary_write(w, header, sizeof(header)) &&
+	     binary_write(w, chunk->data, chunk->len);
+
+	chunk->len = 0;
+	chunk->nframes = 0;
+
+	return rc;
+}
+
+/**
+ * Append one frame to the chunk, flushing the chunk first if the frame
+ * doesn't fit. Timestamps are stored as delta to the previous frame in
+ * the same chunk, so a chunk never spans a backwards jump in time.
+ */
+static bool
+binary_add_frame(struct binary_writer *w,
+		 struct binary_chunk *chunk,
+		 uint32_t device,
+		 uint64_t time,
+		 const struct input_event *events,
+		 size_t nevents)
+{
+	const size_t maxlen = 2 * 10 + nevents * BINARY_EVENT_SIZE;
+	size_t len;
+
+	assert(nevents <= BINARY_MAX_FRAME_EVENTS);
+
+	if (chunk->nframes > 0 &&
+	    (chunk->len + maxlen > sizeof(chunk->data) ||
+	     time < chunk->last_time)) {
+		if (!binary_flush_chunk(w, chunk, device))
+			return false;
+	}
+
+	if (chunk->nframes == 0) {
+		chunk->base_time = time;
+		chunk->last_time = time;
+	}
+
+	len = chunk->len;
+	len += put_varint(&chunk->data[len], time - chunk->last_time);
+	len += put_varint(&chunk->data[len], nevents);
+	for (size_t i = 0; i < nevents; i++) {
+		put_u16(&chunk->data[len], events[i].type);
+		put_u16(&chunk->data[len + 2], events[i].code);
+		put_u32(&chunk->data[len + 4], (uint32_t)events[i].value);
+		len += BINARY_EVENT_SIZE;
+	}
+
+	chunk->len = len;
+	chunk->nframes++;
+	chunk->last_time = time;
+
+	return true;
+}
+
+static bool
+binary_write_index(struct binary_writer *w)
+{
+	uint8_t buf[BINARY_INDEX_ENTRY_SIZE];
+	uint64_t index_offset = w->offset;
+
+	memcpy(buf, BINARY_INDEX_MAGIC, BINARY_TAG_LEN);
+	put_u32(&buf[4], w->nindex);
+	if (!binary_write(w, buf, 8))
+		return false;
+
+	for (size_t i = 0; i < w->nindex; i++) {
+		put_u64(buf, w->index[i].offset);
+		put_u64(&buf[8], w->index[i].base_time);
+		put_u32(&buf[16], w->index[i].device);
+		if (!binary_write(w, buf, BINARY_INDEX_ENTRY_SIZE))
+			return false;
+	}
+
+	put_u64(buf, index_offset);
+	memcpy(&buf[8], BINARY_TRAILER_MAGIC, BINARY_TAG_LEN);
+
+	return binary_write(w, buf, BINARY_TRAILER_SIZE);
+}
+
+static bool
+handle_evdev_frame_binary(struct record_device *d)
+{
+	struct record_context *ctx = d->ctx;
+	struct libevdev *evdev = d->evdev;
+	struct input_event events[BINARY_MAX_FRAME_EVENTS];
+	size_t nevents = 0;
+	struct input_event e;
+	uint64_t time = 0;
+
+	if (libevdev_next_event(evdev, LIBEVDEV_READ_FLAG_NORMAL, &e) !=
+		LIBEVDEV_READ_STATUS_SUCCESS)
+		return false;
+
+	do {
+		if (ctx->offset == 0)
+			ctx->offset = input_event_time(&e);
+
+		if (!ctx->show_keycodes)
+			obfuscate_keycode(&e);
+
+		if (nevents == 0)
+			time = input_event_time(&e) - ctx->offset;
+
+		events[nevents++] = e;
+
+		/* Oversized frames are split, the next call picks up the
+		 * remainder */
+		if ((e.type == EV_SYN && e.code == SYN_REPORT) ||
+		    nevents == ARRAY_LENGTH(events))
+			break;
+	} while (libevdev_next_event(evdev,
+				     LIBEVDEV_READ_FLAG_NORMAL,
+				     &e) == LIBEVDEV_READ_STATUS_SUCCESS);
+
+	if (!binary_add_frame(&ctx->binary, d->chunk, d->index,
+			      time, events, nevents)) {
+		fprintf(stderr, "Error: failed to write recording: %m\n");
+		ctx->stop = true;
+		return false;
+	}
+
+	return true;
+}
+
+static bool
+flush_binary_recording(struct record_context *ctx)
+{
+	struct record_device *d;
+	bool rc = true;
+
+	list_for_each(d, &ctx->devices, link)
+		rc = binary_flush_chunk(&ctx->binary, d->chunk, d->index) && rc;
+
+	return fflush(ctx->binary.fp) == 0 && rc;
+}
+
 static void
 print_device_notify(struct record_device *dev, struct libinput_event *e)
 {
@@ -1316,6 +1647,12 @@ handle_events(struct record_context *ctx, struct record_device *d)
 {
 	bool has_events = true;
 
+	if (ctx->format == FORMAT_BINARY) {
+		while (handle_evdev_frame_binary(d))
+			;
+		return;
+	}
+
 	while (has_events) {
 		has_events = handle_evdev_frame(d);
 
@@ -1876,6 +2213,56 @@ print_device_description(struct record_device *dev)
 	print_libinput_description(dev);
 }
 
+static bool
+print_binary_header(struct record_context *ctx)
+{
+	struct binary_writer *w = &ctx->binary;
+	struct record_device *d;
+	_autofree_ char *header = NULL;
+	size_t len = 0;
+	FILE *fp;
+	uint32_t index = 0;
+
+	/* The YAML header and device descriptions are stored as-is, they
+	 * are small and this way the converter doesn't have to know about
+	 * every key in them */
+	fp = open_memstream(&header, &len);
+	if (!fp)
+		return false;
+	print_header(fp, ctx);
+	iprintf(fp, I_TOPLEVEL, "devices:\n");
+	fclose(fp);
+
+	w->fp = ctx->first_device->fp;
+	if (!binary_write_header(w, ctx->ndevices, header, len))
+		return false;
+
+	list_for_each(d, &ctx->devices, link) {
+		_autofree_ char *description = NULL;
+		FILE *out = d->fp;
+
+		d->fp = open_memstream(&description, &len);
+		if (!d->fp) {
+			d->fp = out;
+			return false;
+		}
+		print_device_description(d);
+		fclose(d->fp);
+		d->fp = out;
+
+		if (!binary_write_blob(w, description, len))
+			return false;
+
+		if (!d->chunk)
+			d->chunk = zalloc(sizeof(*d->chunk));
+		d->chunk->len = 0;
+		d->chunk->nframes = 0;
+		d->index = index++;
+	}
+
+	return fflush(w->fp) == 0;
+}
+
 static int is_event_node(const struct dirent *dir) {
 	return strstartswith(dir->d_name, "event");
 }
@@ -2013,6 +2400,10 @@ open_output_files(struct record_context *ctx, bool is_prefix)
 
 	ctx->first_device->fp = out_file;
 
+	/* Binary recordings write all devices into the same file */
+	if (ctx->format == FORMAT_BINARY)
+		return true;
+
 	list_for_each(d, &ctx->devices, link) {
 		if (d->fp)
 			continue;
@@ -2042,6 +2433,13 @@ print_wall_time(struct record_context *ctx)
 	struct tm tm;
 	struct record_device *d;
 
+	/* No comments in binary recordings but we use the timer to push
+	 * the data out to disk */
+	if (ctx->format == FORMAT_BINARY) {
+		flush_binary_recording(ctx);
+		return;
+	}
+
 	localtime_r(&t, &tm);
 
 	list_for_each(d, &ctx->devices, link) {
@@ -2256,22 +2654,31 @@ mainloop(struct record_context *ctx)
 
 		ctx->had_events = false;
 
-		print_header(ctx->first_device->fp, ctx);
-		if (autorestart)
-			iprintf(ctx->first_device->fp,
-				I_NONE,
-				"# Autorestart timeout: %d\n",
-				ctx->timeout);
+		if (ctx->format == FORMAT_BINARY) {
+			if (!print_binary_header(ctx)) {
+				fprintf(stderr,
+					"Failed to write to '%s'\n",
+					ctx->output_file.name_with_suffix);
+				break;
+			}
+		} else {
+			print_header(ctx->first_device->fp, ctx);
+			if (autorestart)
+				iprintf(ctx->first_device->fp,
+					I_NONE,
+					"# Autorestart timeout: %d\n",
+					ctx->timeout);
 
-		iprintf(ctx->first_device->fp, I_TOPLEVEL, "devices:\n");
+			iprintf(ctx->first_device->fp, I_TOPLEVEL, "devices:\n");
 
-		/* we only print the first device's description, the
-		 * rest is assembled after CTRL+C */
-		list_for_each(d, &ctx->devices, link) {
-			print_device_description(d);
-			iprintf(d->fp, I_DEVICE, "events:\n");
+			/* we only print the first device's description, the
+			 * rest is assembled after CTRL+C */
+			list_for_each(d, &ctx->devices, link) {
+				print_device_description(d);
+				iprintf(d->fp, I_DEVICE, "events:\n");
+			}
+			print_wall_time(ctx);
 		}
-		print_wall_time(ctx);
 
 		if (ctx->libinput) {
 			libinput_dispatch(ctx->libinput);
@@ -2303,7 +2710,16 @@ mainloop(struct record_context *ctx)
 
 		}
 
-		if (autorestart) {
+		if (ctx->format == FORMAT_BINARY) {
+			if (!flush_binary_recording(ctx) ||
+			    !binary_write_index(&ctx->binary) ||
+			    fflush(ctx->binary.fp) != 0)
+				fprintf(stderr,
+					"Failed to write to '%s'\n",
+					ctx->output_file.name_with_suffix);
+		}
+
+		if (autorestart && ctx->format == FORMAT_YAML) {
 			list_for_each(d, &ctx->devices, link) {
 				iprintf(d->fp,
 					I_NONE,
@@ -2318,7 +2734,7 @@ mainloop(struct record_context *ctx)
 			char buf[4096];
 			size_t n;
 
-			if (d == ctx->first_device)
+			if (d == ctx->first_device || d->fp == NULL)
 				continue;
 
 			rewind(d->fp);
@@ -2517,10 +2933,616 @@ init_hidraw(struct record_context *ctx)
 	return true;
 }
 
+struct binary_reader {
+	FILE *fp;
+	uint32_t ndevices;
+	char *header;
+	size_t header_len;
+	struct {
+		char *description;
+		size_t len;
+	} *devices;
+
+	struct binary_index_entry *index;
+	size_t nindex;
+	size_t index_sz;
+};
+
+static bool
+binary_read(FILE *fp, void *data, size_t len)
+{
+	return fread(data, 1, len, fp) == len;
+}
+
+static char *
+binary_read_blob(FILE *fp, size_t *len_out)
+{
+	uint8_t buf[4];
+	size_t len;
+
+	if (!binary_read(fp, buf, sizeof(buf)))
+		return NULL;
+
+	len = get_u32(buf);
+	if (len > BINARY_MAX_BLOB_SIZE)
+		return NULL;
+
+	_autofree_ char *text = zalloc(len + 1);
+	if (!binary_read(fp, text, len))
+		return NULL;
+
+	*len_out = len;
+
+	return steal(&text);
+}
+
+static void
+binary_reader_destroy(struct binary_reader *r)
+{
+	if (r->fp)
+		fclose(r->fp);
+	free(r->header);
+	for (size_t i = 0; r->devices && i < r->ndevices; i++)
+		free(r->devices[i].description);
+	free(r->devices);
+	free(r->index);
+}
+
+static void
+binary_reader_add_chunk(struct binary_reader *r,
+			uint64_t offset,
+			uint64_t base_time,
+			uint32_t device)
+{
+	if (r->nindex == r->index_sz)
+		resize(r->index, r->index_sz);
+
+	r->index[r->nindex++] = (struct binary_index_entry) {
+		.offset = offset,
+		.base_time = base_time,
+		.device = device,
+	};
+}
+
+static bool
+binary_reader_load_index(struct binary_reader *r)
+{
+	uint8_t buf[BINARY_INDEX_ENTRY_SIZE];
+	uint32_t nentries;
+
+	if (fseeko(r->fp, -BINARY_TRAILER_SIZE, SEEK_END) != 0 ||
+	    !binary_read(r->fp, buf, BINARY_TRAILER_SIZE) ||
+	    memcmp(&buf[8], BINARY_TRAILER_MAGIC, BINARY_TAG_LEN) != 0)
+		return false;
+
+	if (fseeko(r->fp, get_u64(buf), SEEK_SET) != 0 ||
+	    !binary_read(r->fp, buf, 8) ||
+	    memcmp(buf, BINARY_INDEX_MAGIC, BINARY_TAG_LEN) != 0)
+		return false;
+
+	nentries = get_u32(&buf[4]);
+	for (uint32_t i = 0; i < nentries; i++) {
+		if (!binary_read(r->fp, buf, BINARY_INDEX_ENTRY_SIZE))
+			return false;
+		binary_reader_add_chunk(r,
+					get_u64(buf),
+					get_u64(&buf[8]),
+					get_u32(&buf[16]));
+	}
+
+	return true;
+}
+
+/* Without an index (e.g. the recording was killed) we walk the chunk
+ * headers instead, stopping at the first incomplete chunk */
+static void
+binary_reader_scan_chunks(struct binary_reader *r, off_t offset)
+{
+	uint8_t header[BINARY_CHUNK_HEADER_SIZE];
+	off_t size;
+
+	r->nindex = 0;
+
+	if (fseeko(r->fp, 0, SEEK_END) != 0)
+		return;
+	size = ftello(r->fp);
+
+	while (fseeko(r->fp, offset, SEEK_SET) == 0 &&
+	       binary_read(r->fp, header, sizeof(header)) &&
+	       memcmp(header, BINARY_CHUNK_MAGIC, BINARY_TAG_LEN) == 0) {
+		uint32_t len = get_u32(&header[12]);
+
+		if (len > BINARY_CHUNK_SIZE ||
+		    offset + (off_t)sizeof(header) + len > size)
+			break;
+
+		binary_reader_add_chunk(r,
+					offset,
+					get_u64(&header[16]),
+					get_u32(&header[4]));
+		offset += sizeof(header) + len;
+	}
+
+	fprintf(stderr,
+		"Warning: recording has no index, found %zu chunks\n",
+		r->nindex);
+}
+
+static bool
+binary_reader_open(struct binary_reader *r, const char *path)
+{
+	uint8_t buf[BINARY_MAGIC_LEN + 8];
+	uint32_t version;
+	off_t data_offset;
+
+	r->fp = fopen(path, "rb");
+	if (!r->fp) {
+		fprintf(stderr, "Failed to open '%s' (%m)\n", path);
+		return false;
+	}
+
+	if (!binary_read(r->fp, buf, sizeof(buf)) ||
+	    memcmp(buf, BINARY_MAGIC, BINARY_MAGIC_LEN) != 0) {
+		fprintf(stderr, "'%s' is not a binary recording\n", path);
+		return false;
+	}
+
+	version = get_u32(&buf[BINARY_MAGIC_LEN]);
+	if (version != (uint32_t)FILE_VERSION_NUMBER) {
+		fprintf(stderr, "Unsupported file version %u\n", version);
+		return false;
+	}
+
+	r->ndevices = get_u32(&buf[BINARY_MAGIC_LEN + 4]);
+	if (r->ndevices == 0 || r->ndevices > 1024) {
+		fprintf(stderr, "Invalid device count %u\n", r->ndevices);
+		return false;
+	}
+
+	r->header = binary_read_blob(r->fp, &r->header_len);
+	if (!r->header)
+		goto truncated;
+
+	r->devices = zalloc(r->ndevices * sizeof(*r->devices));
+	for (uint32_t i = 0; i < r->ndevices; i++) {
+		r->devices[i].description = binary_read_blob(r->fp,
+							     &r->devices[i].len);
+		if (!r->devices[i].description)
+			goto truncated;
+	}
+
+	data_offset = ftello(r->fp);
+	if (!binary_reader_load_index(r))
+		binary_reader_scan_chunks(r, data_offset);
+
+	return true;
+
+truncated:
+	fprintf(stderr, "Recording '%s' is truncated\n", path);
+	return false;
+}
+
+static bool
+binary_reader_read_chunk(struct binary_reader *r,
+			 const struct binary_index_entry *entry,
+			 struct binary_chunk *chunk)
+{
+	uint8_t header[BINARY_CHUNK_HEADER_SIZE];
+
+	if (fseeko(r->fp, entry->offset, SEEK_SET) != 0 ||
+	    !binary_read(r->fp, header, sizeof(header)) ||
+	    memcmp(header, BINARY_CHUNK_MAGIC, BINARY_TAG_LEN) != 0)
+		return false;
+
+	chunk->nframes = get_u32(&header[8]);
+	chunk->len = get_u32(&header[12]);
+	chunk->base_time = get_u64(&header[16]);
+	chunk->last_time = chunk->base_time;
+
+	return chunk->len <= sizeof(chunk->data) &&
+	       binary_read(r->fp, chunk->data, chunk->len);
+}
+
+/**
+ * Set up a libevdev context with the absinfo from a device description,
+ * print_evdev_event() needs it to print the deltas for EV_ABS events.
+ */
+static struct libevdev *
+evdev_from_description(const char *description)
+{
+	struct libevdev *evdev = libevdev_new();
+	struct input_absinfo slot_absinfo = {0};
+	bool in_absinfo = false,
+	     have_slots = false;
+	_autostrvfree_ char **lines = strv_from_string(description, "\n", NULL);
+
+	for (char **line = lines; line && *line; line++) {
+		struct input_absinfo abs = {0};
+		unsigned int code;
+
+		if (!in_absinfo) {
+			in_absinfo = streq(*line, "    absinfo:");
+			continue;
+		}
+
+		if (sscanf(*line, " %u: [%d, %d, %d, %d, %d]",
+			   &code,
+			   &abs.minimum,
+			   &abs.maximum,
+			   &abs.fuzz,
+			   &abs.flat,
+			   &abs.resolution) != 6 ||
+		    code >= ABS_CNT)
+			break;
+
+		/* Enable slots last so all MT axes exist when the slots
+		 * are initialized */
+		if (code == ABS_MT_SLOT) {
+			slot_absinfo = abs;
+			have_slots = true;
+		} else {
+			libevdev_enable_event_code(evdev, EV_ABS, code, &abs);
+		}
+	}
+
+	if (have_slots)
+		libevdev_enable_event_code(evdev, EV_ABS, ABS_MT_SLOT, &slot_absinfo);
+
+	return evdev;
+}
+
+static int
+convert_binary_to_yaml(struct binary_reader *r, FILE *out)
+{
+	struct record_context ctx = {
+		.show_keycodes = true, /* obfuscated during recording */
+	};
+	_autofree_ struct binary_chunk *chunk = zalloc(sizeof(*chunk));
+
+	fwrite(r->header, 1, r->header_len, out);
+
+	for (uint32_t device = 0; device < r->ndevices; device++) {
+		struct record_device d = {
+			.ctx = &ctx,
+			.fp = out,
+			.evdev_prev = evdev_from_description(r->devices[device].description),
+		};
+
+		fwrite(r->devices[device].description, 1, r->devices[device].len, out);
+		iprintf(out, I_DEVICE, "events:\n");
+
+		for (size_t i = 0; i < r->nindex; i++) {
+			size_t pos = 0;
+			uint64_t time;
+
+			if (r->index[i].device != device)
+				continue;
+
+			if (!binary_reader_read_chunk(r, &r->index[i], chunk)) {
+				fprintf(stderr, "Failed to read chunk %zu\n", i);
+				libevdev_free(d.evdev_prev);
+				return EXIT_FAILURE;
+			}
+
+			time = chunk->base_time;
+			for (uint32_t frame = 0; frame < chunk->nframes; frame++) {
+				uint64_t dt, nevents;
+
+				if (!get_varint(chunk->data, chunk->len, &pos, &dt) ||
+				    !get_varint(chunk->data, chunk->len, &pos, &nevents) ||
+				    nevents > (chunk->len - pos) / BINARY_EVENT_SIZE) {
+					fprintf(stderr, "Corrupt chunk %zu\n", i);
+					libevdev_free(d.evdev_prev);
+					return EXIT_FAILURE;
+				}
+
+				time += dt;
+				iprintf(out, I_EVENTTYPE, "- evdev:\n");
+				for (uint64_t n = 0; n < nevents; n++) {
+					const uint8_t *data = &chunk->data[pos];
+					struct input_event e = {
+						.type = get_u16(data),
+						.code = get_u16(&data[2]),
+						.value = (int32_t)get_u32(&data[4]),
+					};
+
+					input_event_set_time(&e, time);
+					print_evdev_event(&d, &e);
+					pos += BINARY_EVENT_SIZE;
+				}
+			}
+		}
+
+		libevdev_free(d.evdev_prev);
+	}
+
+	return fflush(out) == 0 ? EXIT_SUCCESS : EXIT_FAILURE;
+}
+
+static bool
+yaml_is_device_start(const char *line)
+{
+	return strstartswith(line, "- node:");
+}
+
+static int
+convert_yaml_to_binary(FILE *in, FILE *out)
+{
+	enum { HEADER, DEVICES, DESCRIPTION, EVENTS } state = HEADER;
+	struct binary_writer w = { .fp = out };
+	_autofree_ struct binary_chunk *chunk = zalloc(sizeof(*chunk));
+	struct input_event events[BINARY_MAX_FRAME_EVENTS];
+	size_t nevents = 0;
+	_autofree_ char *header = NULL;
+	size_t header_len = 0;
+	_autofree_ char *line = NULL;
+	size_t linesz = 0;
+	FILE *header_fp;
+	int ndevices = 0;
+	int device = -1;
+	int skipped = 0;
+	bool rc = true;
+
+	/* First pass: the header and all device descriptions, they go
+	 * before any event in the binary file */
+	header_fp = open_memstream(&header, &header_len);
+	if (!header_fp)
+		return EXIT_FAILURE;
+
+	while (getline(&line, &linesz, in) != -1) {
+		if (yaml_is_device_start(line)) {
+			ndevices++;
+			state = DESCRIPTION;
+		}
+
+		switch (state) {
+		case HEADER:
+			fputs(line, header_fp);
+			if (streq(line, "devices:\n"))
+				state = DEVICES;
+			break;
+		case DESCRIPTION:
+			if (streq(line, "  events:\n"))
+				state = EVENTS;
+			break;
+		case DEVICES:
+		case EVENTS:
+			break;
+		}
+	}
+	fclose(header_fp);
+
+	if (ndevices == 0) {
+		fprintf(stderr, "No devices found in recording\n");
+		return EXIT_FAILURE;
+	}
+
+	rc = binary_write_header(&w, ndevices, header, header_len);
+
+	rewind(in);
+	state = HEADER;
+	while (rc && getline(&line, &linesz, in) != -1) {
+		_autofree_ char *description = NULL;
+		size_t len = 0;
+		FILE *fp;
+
+		if (!yaml_is_device_start(line))
+			continue;
+
+		fp = open_memstream(&description, &len);
+		if (!fp)
+			return EXIT_FAILURE;
+		do {
+			if (streq(line, "  events:\n"))
+				break;
+			fputs(line, fp);
+		} while (getline(&line, &linesz, in) != -1);
+		fclose(fp);
+
+		rc = binary_write_blob(&w, description, len);
+	}
+
+	/* Second pass: the events, frame by frame */
+	rewind(in);
+	while (rc && getline(&line, &linesz, in) != -1) {
+		const char *l = line + strspn(line, " ");
+		unsigned long sec;
+		unsigned int usec, type, code;
+		int value;
+		uint64_t time;
+
+		if (yaml_is_device_start(line)) {
+			rc = binary_flush_chunk(&w, chunk, device);
+			device++;
+			state = DESCRIPTION;
+			continue;
+		}
+
+		if (state == DESCRIPTION) {
+			if (streq(line, "  events:\n"))
+				state = EVENTS;
+			continue;
+		}
+
+		if (state != EVENTS)
+			continue;
+
+		if (strstartswith(l, "- libinput:") ||
+		    strstartswith(l, "libinput:") ||
+		    strstartswith(l, "- hid:"))
+			skipped++;
+
+		if (sscanf(l, "- [%lu, %u, %u, %u, %d]",
+			   &sec, &usec, &type, &code, &value) != 5)
+			continue;
+
+		events[nevents++] = (struct input_event) {
+			.type = type,
+			.code = code,
+			.value = value,
+		};
+		input_event_set_time(&events[nevents - 1], s2us(sec) + usec);
+
+		if ((type == EV_SYN && code == SYN_REPORT) ||
+		    nevents == ARRAY_LENGTH(events)) {
+			time = input_event_time(&events[0]);
+			rc = binary_add_frame(&w, chunk, device, time, events, nevents);
+			nevents = 0;
+		}
+	}
+
+	/* A truncated recording may end mid-frame */
+	if (rc && nevents > 0)
+		rc = binary_add_frame(&w, chunk, device,
+				      input_event_time(&events[0]),
+				      events, nevents);
+
+	rc = rc &&
+	     binary_flush_chunk(&w, chunk, device) &&
+	     binary_write_index(&w) &&
+	     fflush(out) == 0;
+	free(w.index);
+
+	if (skipped > 0)
+		fprintf(stderr,
+			"Skipped %d libinput and hid event sequences, "
+			"binary recordings only store evdev events\n",
+			skipped);
+
+	if (!rc) {
+		fprintf(stderr, "Failed to write recording: %m\n");
+		return EXIT_FAILURE;
+	}
+
+	return EXIT_SUCCESS;
+}
+
+static void
+usage_convert(void)
+{
+	printf("Usage: %s convert [--help] [--format=yaml|binary] input-file [output-file]\n"
+	       "\n"
+	       "Convert a recording between the YAML and the binary format. By default,\n"
+	       "the recording is converted to the format it is not in.\n"
+	       "If no output file is given, the result is printed to stdout.\n",
+	       program_invocation_short_name);
+}
+
+static bool
+is_binary_recording(FILE *fp)
+{
+	char magic[BINARY_MAGIC_LEN];
+	bool is_binary;
+
+	is_binary = binary_read(fp, magic, sizeof(magic)) &&
+		    memcmp(magic, BINARY_MAGIC, BINARY_MAGIC_LEN) == 0;
+	rewind(fp);
+
+	return is_binary;
+}
+
+static int
+record_convert(int argc, char **argv)
+{
+	enum {
+		OPT_HELP,
+		OPT_FORMAT,
+	};
+	struct option opts[] = {
+		{ "help", no_argument, 0, OPT_HELP },
+		{ "format", required_argument, 0, OPT_FORMAT },
+		{ 0, 0, 0, 0 },
+	};
+	const char *format = NULL;
+	const char *input, *output;
+	_autofclose_ FILE *in = NULL;
+	_autofclose_ FILE *out = NULL;
+	bool input_is_binary, output_is_binary;
+	int rc;
+
+	while (1) {
+		int c;
+		int option_index = 0;
+
+		c = getopt_long(argc, argv, "h", opts, &option_index);
+		if (c == -1)
+			break;
+
+		switch (c) {
+		case 'h':
+		case OPT_HELP:
+			usage_convert();
+			return EXIT_SUCCESS;
+		case OPT_FORMAT:
+			if (!streq(optarg, "yaml") && !streq(optarg, "binary")) {
+				usage_convert();
+				return EXIT_INVALID_USAGE;
+			}
+			format = optarg;
+			break;
+		default:
+			usage_convert();
+			return EXIT_INVALID_USAGE;
+		}
+	}
+
+	if (optind >= argc || argc - optind > 2) {
+		usage_convert();
+		return EXIT_INVALID_USAGE;
+	}
+
+	input = argv[optind];
+	output = optind + 1 < argc ? argv[optind + 1] : NULL;
+
+	in = fopen(input, "rb");
+	if (!in) {
+		fprintf(stderr, "Failed to open '%s' (%m)\n", input);
+		return EXIT_FAILURE;
+	}
+
+	input_is_binary = is_binary_recording(in);
+	output_is_binary = format ? streq(format, "binary") : !input_is_binary;
+	if (input_is_binary == output_is_binary) {
+		fprintf(stderr,
+			"'%s' already is a %s recording\n",
+			input,
+			input_is_binary ? "binary" : "YAML");
+		return EXIT_INVALID_USAGE;
+	}
+
+	if (output) {
+		out = fopen(output, "wb");
+		if (!out) {
+			fprintf(stderr, "Failed to open '%s' (%m)\n", output);
+			return EXIT_FAILURE;
+		}
+	} else if (output_is_binary && isatty(STDOUT_FILENO)) {
+		fprintf(stderr, "Refusing to write a binary recording to a terminal\n");
+		return EXIT_INVALID_USAGE;
+	}
+
+	if (input_is_binary) {
+		struct binary_reader r = {0};
+
+		fclose(in);
+		in = NULL;
+		if (binary_reader_open(&r, input))
+			rc = convert_binary_to_yaml(&r, out ? out : stdout);
+		else
+			rc = EXIT_FAILURE;
+		binary_reader_destroy(&r);
+	} else {
+		rc = convert_yaml_to_binary(in, out ? out : stdout);
+	}
+
+	return rc;
+}
+
 static void
 usage(void)
 {
-	printf("Usage: %s [--help] [--all] [--autorestart=2] [--output-file filename] [/dev/input/event0] [...]\n"
+	printf("Usage: %s [--help] [--all] [--autorestart=2] [--format=yaml|binary] [--output-file filename] [/dev/input/event0] [...]\n"
+	       "       %s convert [--format=yaml|binary] input-file [output-file]\n"
 	       "Common use-cases:\n"
 	       "\n"
 	       " sudo %s -o recording.yml\n"
@@ -2534,11 +3556,18 @@ usage(void)
 	       " sudo %s -o recording.yml /dev/input/event3 /dev/input/event4\n"
 	       "    Records the two devices into the same recordings file.\n"
 	       "\n"
+	       " sudo %s --format=binary -o recording.bin\n"
+	       "    Records into the compact binary format, convert it to YAML with\n"
+	       "    %s convert recording.bin recording.yml\n"
+	       "\n"
 	       "For more information, see the %s(1) man page\n",
 	       program_invocation_short_name,
 	       program_invocation_short_name,
 	       program_invocation_short_name,
 	       program_invocation_short_name,
+	       program_invocation_short_name,
+	       program_invocation_short_name,
+	       program_invocation_short_name,
 	       program_invocation_short_name);
 }
 
@@ -2636,6 +3665,7 @@ enum options {
 	OPT_LIBINPUT,
 	OPT_HIDRAW,
 	OPT_GRAB,
+	OPT_FORMAT,
 };
 
 int
@@ -2655,6 +3685,7 @@ main(int argc, char **argv)
 		{ "with-libinput", no_argument, 0, OPT_LIBINPUT },
 		{ "with-hidraw", no_argument, 0, OPT_HIDRAW },
 		{ "grab", no_argument, 0, OPT_GRAB },
+		{ "format", required_argument, 0, OPT_FORMAT },
 		{ 0, 0, 0, 0 },
 	};
 	struct record_device *d;
@@ -2670,6 +3701,9 @@ main(int argc, char **argv)
 	list_init(&ctx.devices);
 	list_init(&ctx.sources);
 
+	if (argc > 1 && streq(argv[1], "convert"))
+		return record_convert(argc - 1, &argv[1]);
+
 	while (1) {
 		int c;
 		int option_index = 0;
@@ -2715,6 +3749,17 @@ main(int argc, char **argv)
 		case OPT_GRAB:
 			grab = true;
 			break;
+		case OPT_FORMAT:
+			if (streq(optarg, "yaml")) {
+				ctx.format = FORMAT_YAML;
+			} else if (streq(optarg, "binary")) {
+				ctx.format = FORMAT_BINARY;
+			} else {
+				usage();
+				rc = EXIT_INVALID_USAGE;
+				goto out;
+			}
+			break;
 		default:
 			usage();
 			rc = EXIT_INVALID_USAGE;
@@ -2754,6 +3799,22 @@ main(int argc, char **argv)
 		goto out;
 	}
 
+	if (ctx.format == FORMAT_BINARY) {
+		if (with_libinput || with_hidraw) {
+			fprintf(stderr,
+				"Binary recordings only support evdev events\n");
+			rc = EXIT_INVALID_USAGE;
+			goto out;
+		}
+
+		if (output_arg == NULL && isatty(STDOUT_FILENO)) {
+			fprintf(stderr,
+				"Binary recordings require an output file\n");
+			rc = EXIT_INVALID_USAGE;
+			goto out;
+		}
+	}
+
 	ctx.output_file.name = safe_strdup(output_arg);
 
 	if (output_arg == NULL && (all || ndevices > 1)) {
@@ -2803,9 +3864,11 @@ out:
 		if (d->device)
 			libinput_device_unref(d->device);
 		free(d->devnode);
+		free(d->chunk);
 		libevdev_free(d->evdev);
 	}
 
+	free(ctx.binary.index);
 	libinput_unref(ctx.libinput);
 
 	return rc;
@@ -0,0 +1,876 @@
+/*
+ * Copyright © 2025 Red Hat, Inc.
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a
+ * copy of this software and associated documentation files (the "Software"),
+ * to deal in the Software without restriction, including without limitation
+ * the rights to use, copy, modify, merge, publish, distribute, sublicense,
+ * and/or sell copies of the Software, and to permit persons to whom the
+ * Software is furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice (including the next
+ * paragraph) shall be included in all copies or substantial portions of the
+ * Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT.  IN NO EVENT SHALL
+ * THE AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING
+ * FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER
+ * DEALINGS IN THE SOFTWARE.
+ */
+
+#include "config.h"
+
+#include <errno.h>
+#include <fcntl.h>
+#include <getopt.h>
+#include <inttypes.h>
+#include <poll.h>
+#include <signal.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+#include <unistd.h>
+
+#include <libevdev/libevdev.h>
+#include <libevdev/libevdev-uinput.h>
+#include <libinput.h>
+
+#include "linux/input.h"
+#include "libinput-private-api.h"
+#include "util-input-event.h"
+#include "util-libinput.h"
+#include "util-macros.h"
+#include "util-mem.h"
+#include "util-strings.h"
+#include "util-time.h"
+#include "shared.h"
+
+/* Default per-frame scheduling budget, the same error margin the Python
+ * replay tool allows for */
+#define DEFAULT_JITTER_BUDGET_US 150
+
+static volatile sig_atomic_t stop = 0;
+static struct tools_options options;
+
+struct replay_device {
+	const struct recording_device *desc;
+	char *sysname;
+
+	/* All events of this device, the frames index into this */
+	struct input_event *events;
+	size_t nevents;
+	size_t events_size;
+
+	struct libevdev_uinput *uinput;
+	struct libinput_device *device;
+	int fd;			/* write end of the pipe in direct mode */
+};
+
+struct replay_frame {
+	size_t device;
+	size_t first;
+	size_t count;
+	uint64_t time;	/* µs, as in the recording */
+};
+
+struct replay {
+	struct recording_reader *reader;
+
+	struct replay_device *devices;
+	size_t ndevices;
+
+	struct replay_frame *frames;
+	size_t nframes;
+	size_t frames_size;
+};
+
+struct jitter_stats {
+	uint64_t *samples;
+	size_t count;
+	uint64_t budget;
+};
+
+static void
+sighandler(int signal, siginfo_t *siginfo, void *userdata)
+{
+	stop = 1;
+}
+
+static void
+replay_device_destroy(struct replay_device *d)
+{
+	if (d->uinput)
+		libevdev_uinput_destroy(d->uinput);
+	if (d->fd != -1)
+		close(d->fd);
+	free(d->sysname);
+	free(d->events);
+}
+
+static void
+replay_destroy(struct replay *r)
+{
+	for (size_t i = 0; i < r->ndevices; i++)
+		replay_device_destroy(&r->devices[i]);
+	free(r->devices);
+	free(r->frames);
+	recording_reader_destroy(r->reader);
+}
+
+static const char *
+replay_device_get_name(struct replay_device *d)
+{
+	return d->desc->name ? d->desc->name : "unnamed device";
+}
+
+static void
+replay_add_devices(struct replay *r)
+{
+	size_t ndevices = recording_reader_get_num_devices(r->reader);
+
+	if (ndevices <= r->ndevices)
+		return;
+
+	r->devices = realloc(r->devices, ndevices * sizeof(*r->devices));
+	if (!r->devices)
+		abort();
+
+	for (size_t i = r->ndevices; i < ndevices; i++) {
+		struct replay_device *d = &r->devices[i];
+		const char *sysname;
+
+		memset(d, 0, sizeof(*d));
+		d->fd = -1;
+		d->desc = recording_reader_get_device(r->reader, i);
+		sysname = strrchr(d->desc->node, '/');
+		d->sysname = safe_strdup(sysname ? sysname + 1 : d->desc->node);
+	}
+	r->ndevices = ndevices;
+}
+
+static void
+replay_add_frame(struct replay *r, const struct recording_frame *frame)
+{
+	struct replay_device *d = &r->devices[frame->device];
+	struct replay_frame *f;
+	size_t first = d->nevents;
+	bool skipped = false;
+
+	for (size_t i = 0; i < frame->nevents; i++) {
+		const struct input_event *e = &frame->events[i];
+
+		/* kernel key repeat and SYN_DROPPED are not replayed */
+		if ((e->type == EV_KEY && e->value == 2) ||
+		    (e->type == EV_SYN && e->code == SYN_DROPPED)) {
+			skipped = true;
+			continue;
+		}
+
+		if (d->nevents == d->events_size) {
+			d->events_size = max(d->events_size * 2, 256U);
+			d->events = realloc(d->events,
+					    d->events_size * sizeof(*d->events));
+			if (!d->events)
+				abort();
+		}
+		d->events[d->nevents++] = *e;
+	}
+
+	/* If we filtered key repeats and all that's left is the
+	 * SYN_REPORT, drop the frame altogether */
+	if (d->nevents == first || (d->nevents - first == 1 && skipped)) {
+		d->nevents = first;
+		return;
+	}
+
+	if (r->nframes == r->frames_size) {
+		r->frames_size = max(r->frames_size * 2, 64U);
+		r->frames = realloc(r->frames, r->frames_size * sizeof(*r->frames));
+		if (!r->frames)
+			abort();
+	}
+
+	f = &r->frames[r->nframes++];
+	f->device = frame->device;
+	f->first = first;
+	f->count = d->nevents - first;
+	f->time = input_event_time(&d->events[first]);
+}
+
+static int
+cmp_frames(const void *a, const void *b)
+{
+	const struct replay_frame *fa = a,
+				  *fb = b;
+
+	if (fa->time != fb->time)
+		return fa->time < fb->time ? -1 : 1;
+	if (fa->device != fb->device)
+		return fa->device < fb->device ? -1 : 1;
+	return fa->first < fb->first ? -1 : 1;
+}
+
+static bool
+replay_load(struct replay *r, const char *path)
+{
+	struct recording_frame frame;
+	int rc;
+
+	r->reader = recording_reader_new(path);
+	if (!r->reader)
+		return false;
+
+	while ((rc = recording_reader_next_frame(r->reader, &frame)) > 0) {
+		replay_add_devices(r);
+		replay_add_frame(r, &frame);
+	}
+	replay_add_devices(r);
+
+	if (rc < 0)
+		return false;
+
+	/* One timeline for all devices, the recording's timestamps share
+	 * the same clock so sorting merges them in order */
+	qsort(r->frames, r->nframes, sizeof(*r->frames), cmp_frames);
+
+	return true;
+}
+
+static void
+sleep_until(uint64_t target)
+{
+	struct timespec ts = us2ts(target);
+
+	while (clock_nanosleep(CLOCK_MONOTONIC, TIMER_ABSTIME, &ts, NULL) == EINTR &&
+	       !stop)
+		;
+}
+
+static uint64_t
+now_us(void)
+{
+	uint64_t now = 0;
+
+	now_in_us(&now);
+	return now;
+}
+
+static uint64_t
+frame_target(const struct replay *r, const struct replay_frame *f,
+	     uint64_t start, double speed)
+{
+	uint64_t offset = f->time - r->frames[0].time;
+
+	if (speed > 0.0)
+		offset = (uint64_t)(offset / speed);
+
+	return start + offset;
+}
+
+static void
+jitter_add(struct jitter_stats *stats, uint64_t target, uint64_t actual)
+{
+	stats->samples[stats->count++] = actual > target ? actual - target : 0;
+}
+
+static int
+cmp_u64(const void *a, const void *b)
+{
+	const uint64_t *ua = a,
+		       *ub = b;
+
+	if (*ua == *ub)
+		return 0;
+	return *ua < *ub ? -1 : 1;
+}
+
+static void
+jitter_print(struct jitter_stats *stats)
+{
+	uint64_t total = 0;
+	size_t over_budget = 0;
+
+	if (stats->count == 0)
+		return;
+
+	qsort(stats->samples, stats->count, sizeof(*stats->samples), cmp_u64);
+
+	for (size_t i = 0; i < stats->count; i++) {
+		total += stats->samples[i];
+		if (stats->samples[i] > stats->budget)
+			over_budget++;
+	}
+
+	printf("Scheduling jitter in µs\n");
+	printf("  %8s %8s %8s %8s %8s %8s\n",
+	       "frames", "mean", "p50", "p99", "max", ">budget");
+	printf("  %8zu %8" PRIu64 " %8" PRIu64 " %8" PRIu64 " %8" PRIu64 " %8zu\n",
+	       stats->count,
+	       total / stats->count,
+	       stats->samples[stats->count / 2],
+	       stats->samples[stats->count * 99 / 100],
+	       stats->samples[stats->count - 1],
+	       over_budget);
+	if (over_budget > 0)
+		printf("%zu frames (%.1f%%) missed the %" PRIu64 "µs budget\n",
+		       over_budget,
+		       100.0 * over_budget / stats->count,
+		       stats->budget);
+
+	stats->count = 0;
+}
+
+static void
+print_uinput_frame(struct replay_device *d, size_t index,
+		   const struct input_event *events, size_t nevents)
+{
+	for (size_t i = 0; i < nevents; i++) {
+		const struct input_event *e = &events[i];
+
+		printf("%s: %*s%06lu.%06lu %s / %-20s %4d\n",
+		       d->sysname,
+		       (int)index * 8, "",
+		       (unsigned long)e->input_event_sec,
+		       (unsigned long)e->input_event_usec,
+		       libevdev_event_type_get_name(e->type),
+		       libevdev_event_code_get_name(e->type, e->code),
+		       e->value);
+		if (e->type == EV_SYN)
+			printf("%s: ------------------------------------------------\n",
+			       d->sysname);
+	}
+}
+
+static bool
+replay_uinput_create(struct replay *r)
+{
+	for (size_t i = 0; i < r->ndevices; i++) {
+		struct replay_device *d = &r->devices[i];
+		struct libevdev *evdev = recording_device_create_evdev(d->desc);
+		int rc;
+
+		rc = libevdev_uinput_create_from_device(evdev,
+							LIBEVDEV_UINPUT_OPEN_MANAGED,
+							&d->uinput);
+		libevdev_free(evdev);
+		if (rc != 0) {
+			fprintf(stderr,
+				"Failed to create uinput device for %s: %s\n",
+				replay_device_get_name(d),
+				strerror(-rc));
+			return false;
+		}
+
+		printf("%s: %s\n",
+		       libevdev_uinput_get_devnode(d->uinput),
+		       replay_device_get_name(d));
+	}
+
+	return true;
+}
+
+static void
+replay_uinput(struct replay *r, double speed, bool verbose,
+	      struct jitter_stats *stats)
+{
+	uint64_t start = now_us();
+
+	for (size_t i = 0; i < r->nframes && !stop; i++) {
+		const struct replay_frame *f = &r->frames[i];
+		struct replay_device *d = &r->devices[f->device];
+		const struct input_event *events = &d->events[f->first];
+		uint64_t target = frame_target(r, f, start, speed);
+
+		sleep_until(target);
+		jitter_add(stats, target, now_us());
+
+		for (size_t e = 0; e < f->count; e++)
+			libevdev_uinput_write_event(d->uinput,
+						    events[e].type,
+						    events[e].code,
+						    events[e].value);
+
+		if (verbose)
+			print_uinput_frame(d, f->device, events, f->count);
+	}
+}
+
+static int
+open_restricted(const char *path, int flags, void *user_data)
+{
+	int fd = open(path, flags);
+	return fd < 0 ? -errno : fd;
+}
+
+static void
+close_restricted(int fd, void *user_data)
+{
+	close(fd);
+}
+
+static const struct libinput_interface interface = {
+	.open_restricted = open_restricted,
+	.close_restricted = close_restricted,
+};
+
+LIBINPUT_ATTRIBUTE_PRINTF(3, 0)
+static void
+log_handler(struct libinput *li,
+	    enum libinput_log_priority priority,
+	    const char *format,
+	    va_list args)
+{
+	vfprintf(stderr, format, args);
+}
+
+struct event_count {
+	enum libinput_event_type type;
+	size_t count;
+};
+
+struct direct_state {
+	struct libinput *li;
+	struct libinput_print_options opts;
+	struct event_count counts[64];
+	size_t ncounts;
+	size_t nevents;
+	bool verbose;
+	bool full_speed;
+	uint64_t now;	/* the context's clock at full speed */
+};
+
+/* At full speed the context runs on the event time, the timers expire
+ * at the right time relative to the events without waiting for them */
+static uint64_t
+direct_clock(struct libinput *li, void *user_data)
+{
+	struct direct_state *state = user_data;
+
+	return state->now;
+}
+
+static void
+direct_handle_events(struct direct_state *state)
+{
+	struct libinput_event *ev;
+
+	libinput_dispatch(state->li);
+	while ((ev = libinput_get_event(state->li))) {
+		enum libinput_event_type type = libinput_event_get_type(ev);
+		size_t i;
+
+		for (i = 0; i < state->ncounts; i++) {
+			if (state->counts[i].type == type)
+				break;
+		}
+		if (i == state->ncounts && i < ARRAY_LENGTH(state->counts)) {
+			state->counts[i].type = type;
+			state->ncounts++;
+		}
+		if (i < state->ncounts)
+			state->counts[i].count++;
+		state->nevents++;
+
+		if (state->verbose) {
+			_autofree_ char *str = libinput_event_to_str(ev, 0, &state->opts);
+			if (str)
+				printf("%s\n", str);
+		}
+
+		libinput_event_destroy(ev);
+	}
+}
+
+static bool
+replay_direct_create(struct replay *r, struct direct_state *state)
+{
+	libinput_log_set_handler(state->li, log_handler);
+	libinput_log_set_priority(state->li,
+				  state->verbose ? LIBINPUT_LOG_PRIORITY_DEBUG :
+						   LIBINPUT_LOG_PRIORITY_ERROR);
+
+	if (state->full_speed) {
+		state->now = now_us();
+		if (libinput_set_clock(state->li, direct_clock, state) != 0)
+			return false;
+	}
+
+	for (size_t i = 0; i < r->ndevices; i++) {
+		struct replay_device *d = &r->devices[i];
+		struct libevdev *evdev = recording_device_create_evdev(d->desc);
+		int fds[2];
+
+		if (pipe2(fds, O_CLOEXEC) == -1) {
+			fprintf(stderr, "Failed to create pipe: %m\n");
+			libevdev_free(evdev);
+			return false;
+		}
+
+		/* libinput needs a non-blocking read end, the writes may
+		 * block */
+		if (fcntl(fds[0], F_SETFL, O_NONBLOCK) == -1) {
+			fprintf(stderr, "Failed to set up pipe: %m\n");
+			close(fds[0]);
+			close(fds[1]);
+			libevdev_free(evdev);
+			return false;
+		}
+
+		d->device = libinput_path_add_evdev_device(state->li,
+							   evdev,
+							   fds[0],
+							   d->sysname,
+							   (const char **)d->desc->properties);
+		/* libinput has its own copy of the read end */
+		close(fds[0]);
+		d->fd = fds[1];
+
+		if (!d->device) {
+			fprintf(stderr, "Failed to add device %s (%s)\n",
+				d->sysname, replay_device_get_name(d));
+			return false;
+		}
+
+		tools_device_apply_config(d->device, &options);
+	}
+
+	direct_handle_events(state);
+
+	return true;
+}
+
+static void
+replay_direct(struct replay *r, struct direct_state *state, double speed,
+	      struct jitter_stats *stats)
+{
+	uint64_t start = state->full_speed ? state->now : now_us();
+	uint64_t end = start;
+
+	state->opts.start_time = us2ms(start);
+
+	for (size_t i = 0; i < r->nframes && !stop; i++) {
+		const struct replay_frame *f = &r->frames[i];
+		struct replay_device *d = &r->devices[f->device];
+		struct input_event *events = &d->events[f->first];
+		uint64_t target = frame_target(r, f, start, speed);
+
+		/* Frames carry the time they would have had on this system,
+		 * at full speed that time is the context's clock */
+		if (state->full_speed) {
+			state->now = target;
+		} else {
+			sleep_until(target);
+			jitter_add(stats, target, now_us());
+		}
+
+		for (size_t e = 0; e < f->count; e++)
+			input_event_set_time(&events[e], target);
+
+		if (write(d->fd, events, f->count * sizeof(*events)) < 0) {
+			fprintf(stderr, "Failed to write events: %m\n");
+			return;
+		}
+
+		direct_handle_events(state);
+		end = target;
+	}
+
+	end += s2us(1);
+
+	/* Give pending timers a chance to fire */
+	if (state->full_speed) {
+		while (!stop && state->now < end) {
+			state->now += ms2us(10);
+			direct_handle_events(state);
+		}
+		return;
+	}
+
+	while (!stop) {
+		struct pollfd fds = {
+			.fd = libinput_get_fd(state->li),
+			.events = POLLIN,
+		};
+		uint64_t now = now_us();
+
+		if (now >= end)
+			break;
+
+		if (poll(&fds, 1, us2ms(end - now) + 1) > 0)
+			direct_handle_events(state);
+	}
+	direct_handle_events(state);
+}
+
+static void
+print_direct_summary(struct replay *r, struct direct_state *state,
+		     uint64_t elapsed)
+{
+	double secs = elapsed / 1e6;
+
+	printf("Replayed %zu frames from %zu device%s in %.3fs (%.0f frames/s)\n",
+	       r->nframes,
+	       r->ndevices,
+	       r->ndevices == 1 ? "" : "s",
+	       secs,
+	       secs > 0 ? r->nframes / secs : 0.0);
+	printf("  %-36s %8s\n", "event", "count");
+	for (size_t i = 0; i < state->ncounts; i++)
+		printf("  %-36s %8zu\n",
+		       libinput_event_type_to_str(state->counts[i].type),
+		       state->counts[i].count);
+}
+
+static void
+print_plugin_stats(struct libinput_stats *ps, bool with_timers)
+{
+	printf("  %-28s %8s %8s %8s %8s %8s %8s %8s %10s\n",
+	       "", "in", "skipped", "out", "injected", "prepend", "append",
+	       with_timers ? "timers" : "", "µs");
+
+	for (unsigned int i = 0; i < libinput_stats_get_num_plugins(ps); i++) {
+		printf("  %-28s %8" PRIu64 " %8" PRIu64 " %8" PRIu64 " %8" PRIu64 " %8" PRIu64 " %8" PRIu64,
+		       libinput_stats_get_plugin_name(ps, i),
+		       libinput_stats_get_plugin_value(ps, i, LIBINPUT_PLUGIN_STAT_FRAMES_IN),
+		       libinput_stats_get_plugin_value(ps, i, LIBINPUT_PLUGIN_STAT_FRAMES_SKIPPED),
+		       libinput_stats_get_plugin_value(ps, i, LIBINPUT_PLUGIN_STAT_FRAMES_OUT),
+		       libinput_stats_get_plugin_value(ps, i, LIBINPUT_PLUGIN_STAT_FRAMES_INJECTED),
+		       libinput_stats_get_plugin_value(ps, i, LIBINPUT_PLUGIN_STAT_FRAMES_PREPENDED),
+		       libinput_stats_get_plugin_value(ps, i, LIBINPUT_PLUGIN_STAT_FRAMES_APPENDED));
+		if (with_timers)
+			printf(" %8" PRIu64,
+			       libinput_stats_get_plugin_value(ps, i, LIBINPUT_PLUGIN_STAT_TIMER_FIRINGS));
+		else
+			printf(" %8s", "");
+		printf(" %10" PRIu64 "\n",
+		       libinput_stats_get_plugin_value(ps, i, LIBINPUT_PLUGIN_STAT_TIME_NSEC) / 1000);
+	}
+}
+
+static void
+print_all_plugin_stats(struct replay *r, struct direct_state *state)
+{
+	struct libinput_stats *ps;
+
+	for (size_t i = 0; i < r->ndevices; i++) {
+		struct replay_device *d = &r->devices[i];
+
+		printf("%-7s - %s: plugin statistics\n",
+		       d->sysname,
+		       replay_device_get_name(d));
+		ps = libinput_device_get_stats(d->device);
+		print_plugin_stats(ps, false);
+		libinput_stats_unref(ps);
+	}
+
+	printf("all devices: plugin statistics\n");
+	ps = libinput_get_stats(state->li);
+	print_plugin_stats(ps, true);
+	libinput_stats_unref(ps);
+}
+
+static void
+usage(struct option *opts)
+{
+	printf("Usage: libinput replay-native [options] recording.yml\n");
+
+	if (opts)
+		tools_print_usage_option_list(opts);
+}
+
+int
+main(int argc, char **argv)
+{
+	struct replay r = {0};
+	struct jitter_stats stats = {
+		.budget = DEFAULT_JITTER_BUDGET_US,
+	};
+	struct direct_state state = {0};
+	struct sigaction act;
+	bool direct = false;
+	bool once = false;
+	bool verbose = false;
+	bool plugin_stats = false;
+	int replay_after = -1;
+	double speed = 1.0;
+	int rc = EXIT_FAILURE;
+
+	tools_init_options(&options);
+
+	while (1) {
+		int c;
+		int option_index = 0;
+		enum {
+			OPT_DIRECT = 1,
+			OPT_ONCE,
+			OPT_REPLAY_AFTER,
+			OPT_SPEED,
+			OPT_JITTER_BUDGET,
+			OPT_VERBOSE,
+			OPT_PLUGIN_STATS,
+		};
+		static struct option opts[] = {
+			CONFIGURATION_OPTIONS,
+			{ "help",                      no_argument,       0, 'h' },
+			{ "direct",                    no_argument,       0, OPT_DIRECT },
+			{ "once",                      no_argument,       0, OPT_ONCE },
+			{ "replay-after",              required_argument, 0, OPT_REPLAY_AFTER },
+			{ "speed",                     required_argument, 0, OPT_SPEED },
+			{ "jitter-budget",             required_argument, 0, OPT_JITTER_BUDGET },
+			{ "verbose",                   no_argument,       0, OPT_VERBOSE },
+			{ "plugin-stats",              no_argument,       0, OPT_PLUGIN_STATS },
+			{ 0, 0, 0, 0}
+		};
+		unsigned int budget;
+
+		c = getopt_long(argc, argv, "h", opts, &option_index);
+		if (c == -1)
+			break;
+
+		switch(c) {
+		case '?':
+			exit(EXIT_INVALID_USAGE);
+			break;
+		case 'h':
+			usage(opts);
+			exit(EXIT_SUCCESS);
+			break;
+		case OPT_DIRECT:
+			direct = true;
+			break;
+		case OPT_ONCE:
+			once = true;
+			break;
+		case OPT_REPLAY_AFTER:
+			if (!safe_atoi(optarg, &replay_after) || replay_after < 0) {
+				usage(NULL);
+				return EXIT_INVALID_USAGE;
+			}
+			break;
+		case OPT_SPEED:
+			if (!safe_atod(optarg, &speed) || speed < 0.0) {
+				usage(NULL);
+				return EXIT_INVALID_USAGE;
+			}
+			break;
+		case OPT_JITTER_BUDGET:
+			if (!safe_atou(optarg, &budget)) {
+				usage(NULL);
+				return EXIT_INVALID_USAGE;
+			}
+			stats.budget = budget;
+			break;
+		case OPT_VERBOSE:
+			verbose = true;
+			break;
+		case OPT_PLUGIN_STATS:
+			plugin_stats = true;
+			break;
+		default:
+			if (tools_parse_option(c, optarg, &options) != 0) {
+				usage(NULL);
+				return EXIT_INVALID_USAGE;
+			}
+			break;
+		}
+	}
+
+	if (optind + 1 != argc) {
+		usage(NULL);
+		return EXIT_INVALID_USAGE;
+	}
+
+	/* Full speed only makes sense without the kernel in the loop */
+	if (speed == 0.0 && !direct) {
+		fprintf(stderr, "--speed=0 requires --direct\n");
+		return EXIT_INVALID_USAGE;
+	}
+
+	if (plugin_stats && !direct) {
+		fprintf(stderr, "--plugin-stats requires --direct\n");
+		return EXIT_INVALID_USAGE;
+	}
+
+	memset(&act, 0, sizeof(act));
+	act.sa_sigaction = sighandler;
+	act.sa_flags = SA_SIGINFO;
+
+	if (sigaction(SIGINT, &act, NULL) == -1) {
+		fprintf(stderr, "Failed to set up signal handling (%s)\n",
+				strerror(errno));
+		return EXIT_FAILURE;
+	}
+
+	if (!replay_load(&r, argv[optind]))
+		goto out;
+
+	stats.samples = zalloc(max(r.nframes, 1U) * sizeof(*stats.samples));
+
+	if (direct) {
+		uint64_t start;
+
+		state.verbose = verbose;
+		state.full_speed = speed == 0.0;
+		state.li = libinput_path_create_context(&interface, NULL);
+		if (!state.li || !replay_direct_create(&r, &state))
+			goto out;
+
+		if (plugin_stats)
+			libinput_set_latency_stats_enabled(state.li, 1);
+
+		start = now_us();
+		replay_direct(&r, &state, speed, &stats);
+		print_direct_summary(&r, &state, now_us() - start);
+		jitter_print(&stats);
+		if (plugin_stats)
+			print_all_plugin_stats(&r, &state);
+		rc = EXIT_SUCCESS;
+		goto out;
+	}
+
+	if (!replay_uinput_create(&r))
+		goto out;
+
+	if (r.nframes == 0) {
+		printf("No events in recording. Hit enter to quit\n");
+		getchar();
+		rc = EXIT_SUCCESS;
+		goto out;
+	}
+
+	while (!stop) {
+		if (replay_after >= 0) {
+			sleep(replay_after);
+		} else {
+			printf("Hit enter to start replaying\n");
+			if (getchar() == EOF)
+				break;
+		}
+
+		if (stop)
+			break;
+
+		replay_uinput(&r, speed, verbose, &stats);
+		if (stop) {
+			printf("Event replay interrupted\n");
+			printf("Note that the device may not be in a neutral state now.\n");
+		}
+		jitter_print(&stats);
+
+		if (once)
+			break;
+	}
+	rc = EXIT_SUCCESS;
+
+out:
+	if (state.li)
+		libinput_unref(state.li);
+	replay_destroy(&r);
+	free(stats.samples);
+
+	return rc;
+}
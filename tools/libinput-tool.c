@@ -62,6 +62,10 @@ usage(void)
 	       "\n"
 	       "  replay\n"
 	       "	Replay a previously recorded event stream. See the man page for more info\n"
+	       "\n"
+	       "  replay-native\n"
+	       "	Replay a recording through uinput or directly into libinput. Only available\n"
+	       "	in the build directory, see the man page for more info\n"
 	       "\n");
 }
 
@@ -551,7 +551,7 @@ tools_open_device(const char **paths, bool verbose, bool *grab)
 	return steal(&li);
 }
 
-static void
+void
 tools_setenv_quirks_dir(void)
 {
 	if (builddir_lookup(NULL))
@@ -839,6 +839,42 @@ sprintf_event_codes(char *buf, size_t sz, struct quirks *quirks, enum quirk q)
 	}
 }
 
+static void
+sprintf_key_remap(char *buf, size_t sz, struct quirks *quirks, enum quirk q)
+{
+	const struct quirk_tuples *t;
+	size_t off = 0;
+	int printed;
+	const char *name;
+
+	quirks_get_tuples(quirks, q, &t);
+	name = quirk_get_name(q);
+	printed = snprintf(buf, sz, "%s=", name);
+	assert(printed != -1);
+	off += printed;
+
+	for (size_t i = 0; off < sz && i < t->ntuples; i++) {
+		unsigned int from = t->tuples[i].first;
+		unsigned int modifier = t->tuples[i].second;
+		unsigned int to = t->tuples[i].third;
+
+		if (modifier) {
+			printed = snprintf(buf + off, sz - off, "%s+",
+					   libevdev_event_code_get_name(EV_KEY, modifier));
+			assert(printed != -1);
+			off += printed;
+			if (off >= sz)
+				break;
+		}
+
+		printed = snprintf(buf + off, sz - off, "%s:%s;",
+				   libevdev_event_code_get_name(EV_KEY, from),
+				   to == KEY_RESERVED ? "none" : libevdev_event_code_get_name(EV_KEY, to));
+		assert(printed != -1);
+		off += printed;
+	}
+}
+
 static void
 sprintf_input_props(char *buf, size_t sz, struct quirks *quirks, enum quirk q)
 {
@@ -922,6 +958,7 @@ tools_list_device_quirks(struct quirks_context *ctx,
 			case QUIRK_ATTR_PALM_PRESSURE_THRESHOLD:
 			case QUIRK_ATTR_THUMB_PRESSURE_THRESHOLD:
 			case QUIRK_ATTR_THUMB_SIZE_THRESHOLD:
+			case QUIRK_ATTR_MAX_MOTION_EVENT_RATE:
 				quirks_get_uint32(quirks, q, &v);
 				snprintf(buf, sizeof(buf), "%s=%u", name, v);
 				callback(userdata, buf);
@@ -954,6 +991,10 @@ tools_list_device_quirks(struct quirks_context *ctx,
 				sprintf_input_props(buf, sizeof(buf), quirks, q);
 				callback(userdata, buf);
 				break;
+			case QUIRK_ATTR_KEY_REMAP:
+				sprintf_key_remap(buf, sizeof(buf), quirks, q);
+				callback(userdata, buf);
+				break;
 			default:
 				abort();
 				break;
@@ -961,3 +1002,483 @@ tools_list_device_quirks(struct quirks_context *ctx,
 		}
 	} while(++q < _QUIRK_LAST_ATTR_QUIRK_);
 }
+
+/* The libinput record file format version we understand */
+#define RECORDING_FILE_VERSION 1
+
+enum recording_section {
+	SECTION_NONE,
+	SECTION_EVDEV,
+	SECTION_EVDEV_CODES,
+	SECTION_EVDEV_ABSINFO,
+	SECTION_UDEV,
+	SECTION_UDEV_PROPERTIES,
+	SECTION_EVENTS,
+	SECTION_EVENTS_EVDEV,
+	SECTION_OTHER,
+};
+
+struct recording_reader {
+	FILE *fp;
+	char *line;
+	size_t linesize;
+	size_t lineno;
+	bool line_pending;
+
+	enum recording_section section;
+	struct recording_device **devices;
+	size_t ndevices;
+	size_t ndevices_expected;
+
+	/* The frame being assembled, reused for every frame */
+	struct input_event *events;
+	size_t nevents;
+	size_t events_size;
+};
+
+/* Parses "[1, 2, 3]" (anything before the opening bracket is ignored)
+ * into values, returns the number of values or -1 on error */
+static int
+parse_int_list(const char *str, int *values, size_t nvalues)
+{
+	const char *p = strchr(str, '[');
+	size_t count = 0;
+
+	if (!p)
+		return -1;
+	p++;
+
+	while (true) {
+		char *end;
+		long v;
+
+		while (*p == ' ')
+			p++;
+		if (*p == ']')
+			return count;
+
+		errno = 0;
+		v = strtol(p, &end, 0);
+		if (errno != 0 || end == p || v < INT_MIN || v > INT_MAX)
+			return -1;
+		if (count >= nvalues)
+			return -1;
+		values[count++] = (int)v;
+
+		p = end;
+		while (*p == ' ')
+			p++;
+		if (*p == ',')
+			p++;
+		else if (*p != ']')
+			return -1;
+	}
+}
+
+static inline bool
+recording_is_device_start(const char *line)
+{
+	return strstartswith(line, "- node:");
+}
+
+static bool
+recording_read_line(struct recording_reader *reader)
+{
+	ssize_t len;
+
+	if (reader->line_pending) {
+		reader->line_pending = false;
+		return true;
+	}
+
+	len = getline(&reader->line, &reader->linesize, reader->fp);
+	if (len == -1)
+		return false;
+
+	if (len > 0 && reader->line[len - 1] == '\n')
+		reader->line[len - 1] = '\0';
+	reader->lineno++;
+
+	return true;
+}
+
+static void
+recording_add_device(struct recording_reader *reader, const char *node)
+{
+	struct recording_device *d = zalloc(sizeof(*d));
+
+	d->node = strstrip(node, " ");
+	d->properties = zalloc(sizeof(*d->properties));
+
+	reader->devices = realloc(reader->devices,
+				  (reader->ndevices + 1) * sizeof(*reader->devices));
+	if (!reader->devices)
+		abort();
+	reader->devices[reader->ndevices++] = d;
+}
+
+static void
+recording_device_add_property(struct recording_device *d, const char *prop)
+{
+	size_t nprops = 0;
+
+	while (d->properties[nprops])
+		nprops++;
+
+	d->properties = realloc(d->properties,
+				(nprops + 2) * sizeof(*d->properties));
+	if (!d->properties)
+		abort();
+	d->properties[nprops] = safe_strdup(prop);
+	d->properties[nprops + 1] = NULL;
+}
+
+static bool
+recording_add_event(struct recording_reader *reader, const char *line)
+{
+	unsigned long sec;
+	unsigned int usec;
+	int type, code, value;
+	const char *p = strchr(line, '[');
+
+	if (!p ||
+	    sscanf(p, "[%lu, %u, %d, %d, %d]", &sec, &usec, &type, &code, &value) != 5)
+		return false;
+
+	if (reader->nevents == reader->events_size) {
+		reader->events_size = max(reader->events_size * 2, 64U);
+		reader->events = realloc(reader->events,
+					 reader->events_size * sizeof(*reader->events));
+		if (!reader->events)
+			abort();
+	}
+
+	reader->events[reader->nevents++] = (struct input_event) {
+		.input_event_sec = sec,
+		.input_event_usec = usec,
+		.type = type,
+		.code = code,
+		.value = value,
+	};
+
+	return true;
+}
+
+static bool
+recording_parse_key(const char *line, unsigned int *key, unsigned int max)
+{
+	_autofree_ char *str = safe_strdup(line);
+	char *colon = strchr(str, ':');
+
+	if (!colon)
+		return false;
+	*colon = '\0';
+
+	return safe_atou(str, key) && *key < max;
+}
+
+static bool
+recording_parse_line(struct recording_reader *reader)
+{
+	const char *line = reader->line;
+	size_t indent = strspn(line, " ");
+	const char *l = line + indent;
+	struct recording_device *d;
+	enum recording_section *section = &reader->section;
+	int values[KEY_CNT];
+	int n;
+
+	if (*l == '\0' || *l == '#')
+		return true;
+
+	if (indent == 0) {
+		*section = SECTION_NONE;
+		if (recording_is_device_start(l)) {
+			recording_add_device(reader, l + 7);
+		} else if (strstartswith(l, "version:")) {
+			int version;
+			if (!safe_atoi(l + 9, &version) ||
+			    version != RECORDING_FILE_VERSION) {
+				fprintf(stderr,
+					"Invalid file format: %s, expected %d\n",
+					l + 9,
+					RECORDING_FILE_VERSION);
+				return false;
+			}
+		} else if (strstartswith(l, "ndevices:")) {
+			unsigned int ndevices;
+			if (safe_atou(l + 10, &ndevices))
+				reader->ndevices_expected = ndevices;
+		}
+		return true;
+	}
+
+	/* Anything indented before the first device is the header */
+	if (reader->ndevices == 0)
+		return true;
+
+	d = reader->devices[reader->ndevices - 1];
+
+	if (indent == 2) {
+		if (*section == SECTION_EVENTS_EVDEV)
+			*section = SECTION_EVENTS;
+
+		if (streq(l, "evdev:"))
+			*section = SECTION_EVDEV;
+		else if (streq(l, "udev:"))
+			*section = SECTION_UDEV;
+		else if (streq(l, "events:"))
+			*section = SECTION_EVENTS;
+		else if (*section == SECTION_EVENTS) {
+			if (streq(l, "- evdev:"))
+				*section = SECTION_EVENTS_EVDEV;
+		} else
+			*section = SECTION_OTHER;
+		return true;
+	}
+
+	switch (*section) {
+	case SECTION_EVDEV:
+	case SECTION_EVDEV_CODES:
+	case SECTION_EVDEV_ABSINFO:
+		if (indent == 4) {
+			*section = SECTION_EVDEV;
+			if (strstartswith(l, "name:")) {
+				free(d->name);
+				d->name = strstrip(l + 5, " \"");
+			} else if (strstartswith(l, "id:")) {
+				if (parse_int_list(l, d->id, ARRAY_LENGTH(d->id)) != 4)
+					goto error;
+			} else if (streq(l, "codes:")) {
+				*section = SECTION_EVDEV_CODES;
+			} else if (streq(l, "absinfo:")) {
+				*section = SECTION_EVDEV_ABSINFO;
+			} else if (strstartswith(l, "properties:")) {
+				n = parse_int_list(l, values, ARRAY_LENGTH(values));
+				if (n < 0)
+					goto error;
+				for (int i = 0; i < n; i++) {
+					if (values[i] >= 0 && values[i] < INPUT_PROP_CNT)
+						long_set_bit(d->props, values[i]);
+				}
+			}
+		} else if (*section == SECTION_EVDEV_CODES) {
+			unsigned int type;
+
+			if (!recording_parse_key(l, &type, EV_CNT))
+				goto error;
+			n = parse_int_list(l, values, ARRAY_LENGTH(values));
+			if (n < 0)
+				goto error;
+			for (int i = 0; i < n; i++) {
+				if (values[i] >= 0 && values[i] < KEY_CNT)
+					long_set_bit(d->codes[type], values[i]);
+			}
+		} else if (*section == SECTION_EVDEV_ABSINFO) {
+			unsigned int code;
+
+			if (!recording_parse_key(l, &code, ABS_CNT) ||
+			    parse_int_list(l, values, 5) != 5)
+				goto error;
+			d->absinfo[code] = (struct input_absinfo) {
+				.minimum = values[0],
+				.maximum = values[1],
+				.fuzz = values[2],
+				.flat = values[3],
+				.resolution = values[4],
+			};
+		}
+		break;
+	case SECTION_UDEV:
+	case SECTION_UDEV_PROPERTIES:
+		if (streq(l, "properties:"))
+			*section = SECTION_UDEV_PROPERTIES;
+		else if (*section == SECTION_UDEV_PROPERTIES &&
+			 strstartswith(l, "- ") && strchr(l, '='))
+			recording_device_add_property(d, l + 2);
+		else
+			*section = SECTION_UDEV;
+		break;
+	case SECTION_EVENTS_EVDEV:
+		if (strstartswith(l, "- [") &&
+		    !recording_add_event(reader, l))
+			goto error;
+		break;
+	default:
+		break;
+	}
+
+	return true;
+
+error:
+	fprintf(stderr, "Failed to parse line %zu: %s\n", reader->lineno, line);
+	return false;
+}
+
+struct recording_reader *
+recording_reader_new(const char *path)
+{
+	struct recording_reader *reader;
+
+	reader = zalloc(sizeof(*reader));
+	reader->fp = fopen(path, "r");
+	if (!reader->fp) {
+		fprintf(stderr, "Failed to open %s: %m\n", path);
+		goto error;
+	}
+
+	/* Parse the header and the first device's description so the
+	 * caller can look at it before the first frame */
+	while (recording_read_line(reader)) {
+		if (reader->lineno == 1 && strstartswith(reader->line, "LIRECBIN")) {
+			fprintf(stderr,
+				"%s is a binary recording, convert it with "
+				"'libinput record convert' first\n",
+				path);
+			goto error;
+		}
+
+		if (!recording_parse_line(reader))
+			goto error;
+
+		if (reader->section == SECTION_EVENTS)
+			break;
+	}
+
+	if (reader->ndevices == 0) {
+		fprintf(stderr, "No devices found in %s\n", path);
+		goto error;
+	}
+
+	return reader;
+
+error:
+	recording_reader_destroy(reader);
+	return NULL;
+}
+
+void
+recording_reader_destroy(struct recording_reader *reader)
+{
+	if (!reader)
+		return;
+
+	for (size_t i = 0; i < reader->ndevices; i++) {
+		struct recording_device *d = reader->devices[i];
+
+		free(d->node);
+		free(d->name);
+		strv_free(d->properties);
+		free(d);
+	}
+	free(reader->devices);
+	free(reader->events);
+	free(reader->line);
+	if (reader->fp)
+		fclose(reader->fp);
+	free(reader);
+}
+
+int
+recording_reader_next_frame(struct recording_reader *reader,
+			    struct recording_frame *frame)
+{
+	reader->nevents = 0;
+
+	while (recording_read_line(reader)) {
+		/* A frame never spans devices, a truncated last frame
+		 * is handed out as-is */
+		if (recording_is_device_start(reader->line) &&
+		    reader->nevents > 0) {
+			reader->line_pending = true;
+			break;
+		}
+
+		if (!recording_parse_line(reader))
+			return -1;
+
+		if (reader->nevents > 0) {
+			const struct input_event *e = &reader->events[reader->nevents - 1];
+
+			if (e->type == EV_SYN && e->code == SYN_REPORT)
+				break;
+		}
+	}
+
+	if (reader->nevents == 0) {
+		if (reader->ndevices_expected != reader->ndevices) {
+			fprintf(stderr,
+				"WARNING: truncated file, expected %zu devices, got %zu\n",
+				reader->ndevices_expected,
+				reader->ndevices);
+			reader->ndevices_expected = reader->ndevices;
+		}
+		return 0;
+	}
+
+	frame->device = reader->ndevices - 1;
+	frame->events = reader->events;
+	frame->nevents = reader->nevents;
+
+	return 1;
+}
+
+size_t
+recording_reader_get_num_devices(struct recording_reader *reader)
+{
+	return reader->ndevices;
+}
+
+const struct recording_device *
+recording_reader_get_device(struct recording_reader *reader, size_t index)
+{
+	if (index >= reader->ndevices)
+		return NULL;
+
+	return reader->devices[index];
+}
+
+struct libevdev *
+recording_device_create_evdev(const struct recording_device *device)
+{
+	struct libevdev *evdev = libevdev_new();
+	const int rep_delay = 500,
+		  rep_period = 20;
+
+	libevdev_set_name(evdev, device->name ? device->name : "unnamed device");
+	libevdev_set_id_bustype(evdev, device->id[0]);
+	libevdev_set_id_vendor(evdev, device->id[1]);
+	libevdev_set_id_product(evdev, device->id[2]);
+	libevdev_set_id_version(evdev, device->id[3]);
+
+	for (unsigned int prop = 0; prop < INPUT_PROP_CNT; prop++) {
+		if (recording_device_has_property(device, prop))
+			libevdev_enable_property(evdev, prop);
+	}
+
+	for (unsigned int type = 0; type < EV_CNT; type++) {
+		int max = libevdev_event_type_get_max(type);
+
+		for (int code = 0; code <= max; code++) {
+			const void *data = NULL;
+
+			if (!recording_device_has_code(device, type, code))
+				continue;
+
+			switch (type) {
+			case EV_ABS:
+				data = &device->absinfo[code];
+				break;
+			case EV_REP:
+				if (code == REP_DELAY)
+					data = &rep_delay;
+				else if (code == REP_PERIOD)
+					data = &rep_period;
+				break;
+			}
+			libevdev_enable_event_code(evdev, type, code, data);
+		}
+	}
+
+	return evdev;
+}
@@ -33,6 +33,10 @@
 #include <quirks.h>
 #include <libinput.h>
 
+#include "linux/input.h"
+#include "util-bits.h"
+
+struct libevdev;
 #include "util-strings.h"
 
 #define EXIT_INVALID_USAGE 2
@@ -194,6 +198,9 @@ void tools_tablet_tool_apply_config(struct libinput_tablet_tool *tool,
 				    struct tools_options *options);
 int tools_exec_command(const char *prefix, int argc, char **argv);
 
+/* Point LIBINPUT_QUIRKS_DIR at the source tree when run from the builddir */
+void tools_setenv_quirks_dir(void);
+
 bool find_touchpad_device(char *path, size_t path_len);
 bool is_touchpad_device(const char *devnode);
 
@@ -205,4 +212,92 @@ tools_list_device_quirks(struct quirks_context *ctx,
 
 void
 tools_dispatch(struct libinput *libinput);
+
+/**
+ * A device description from a libinput record YAML file.
+ */
+struct recording_device {
+	char *node;
+	char *name;
+	int id[4]; /* bustype, vendor, product, version */
+	unsigned long codes[EV_CNT][NLONGS(KEY_CNT)];
+	struct input_absinfo absinfo[ABS_CNT];
+	unsigned long props[NLONGS(INPUT_PROP_CNT)];
+	char **properties; /* udev properties as KEY=value */
+};
+
+/**
+ * One event frame, up to and including the SYN_REPORT. The events are
+ * only valid until the next call to recording_reader_next_frame().
+ */
+struct recording_frame {
+	size_t device;
+	const struct input_event *events;
+	size_t nevents;
+};
+
+struct recording_reader;
+
+/**
+ * Opens a libinput record YAML file and parses the header and the
+ * description of the first device. Prints an error and returns NULL if
+ * the file cannot be read or has no device.
+ */
+struct recording_reader *
+recording_reader_new(const char *path);
+
+void
+recording_reader_destroy(struct recording_reader *reader);
+
+/**
+ * Reads the next event frame. Only one frame is kept in memory at any
+ * time, the recording is never loaded as a whole.
+ *
+ * @return 1 if a frame was read, 0 at the end of the file or -1 on a
+ * parser error
+ */
+int
+recording_reader_next_frame(struct recording_reader *reader,
+			    struct recording_frame *frame);
+
+/**
+ * @return the number of devices parsed so far
+ */
+size_t
+recording_reader_get_num_devices(struct recording_reader *reader);
+
+/**
+ * The returned device description is valid until the reader is
+ * destroyed.
+ */
+const struct recording_device *
+recording_reader_get_device(struct recording_reader *reader, size_t index);
+
+/**
+ * Create a libevdev context with the name, ids, event codes, absinfo
+ * and properties of the recorded device, e.g. to create a uinput device
+ * or for libinput_path_add_evdev_device(). The caller owns the returned
+ * context.
+ */
+struct libevdev *
+recording_device_create_evdev(const struct recording_device *device);
+
+static inline bool
+recording_device_has_code(const struct recording_device *device,
+			  unsigned int type,
+			  unsigned int code)
+{
+	if (type >= EV_CNT || code >= KEY_CNT)
+		return false;
+	return long_bit_is_set(device->codes[type], code);
+}
+
+static inline bool
+recording_device_has_property(const struct recording_device *device,
+			      unsigned int prop)
+{
+	if (prop >= INPUT_PROP_CNT)
+		return false;
+	return long_bit_is_set(device->props, prop);
+}
 #endif
@@ -163,6 +163,16 @@ def libinput_record():
     return get_tool("record")
 
 
+@pytest.fixture
+def libinput_replay_native():
+    return get_tool("replay-native")
+
+
+@pytest.fixture
+def libinput_analyze():
+    return get_tool("analyze")
+
+
 def test_help(libinput):
     stdout, stderr = libinput.run_command_success(["--help"])
     assert stdout.startswith("Usage:")
@@ -296,6 +306,16 @@ def test_libinput_debug_events_multiple_devices(libinput_debug_events):
     )
 
 
+@pytest.mark.parametrize("arg", ["--summary", "--summary=500"])
+def test_libinput_debug_events_summary(libinput_debug_events, arg):
+    libinput_debug_events.run_command_success([arg])
+
+
+@pytest.mark.parametrize("arg", ["--summary=0", "--summary=-1", "--summary=foo"])
+def test_libinput_debug_events_summary_invalid(libinput_debug_events, arg):
+    libinput_debug_events.run_command_invalid([arg])
+
+
 def test_libinput_debug_events_too_many_devices(libinput_debug_events):
     # Too many arguments just bails with the usage message
     rc, stdout, stderr = libinput_debug_events.run_command(["/dev/input/event0"] * 61)
@@ -364,6 +384,58 @@ def test_libinput_record_autorestart(libinput_record, recording):
     libinput_record.run_command_success(["-o", recording, "--autorestart=2"])
 
 
+def test_libinput_record_format(libinput_record, recording):
+    libinput_record.run_command_invalid(["--format=foo"])
+    libinput_record.run_command_invalid(["--format=binary", "--with-libinput"])
+    libinput_record.run_command_invalid(["--format=binary", "--with-hidraw"])
+    libinput_record.run_command_success(["--format=yaml", "-o", recording])
+    libinput_record.run_command_success(["--format=binary", "-o", recording])
+
+
+def test_libinput_record_convert(libinput_record):
+    libinput_record.run_command_success(["convert", "--help"])
+    libinput_record.run_command_invalid(["convert"])
+    libinput_record.run_command_invalid(["convert", "--format=foo", "in.yml"])
+
+
+def test_libinput_replay_native_args(libinput_replay_native):
+    libinput_replay_native.run_command_success(["--help"])
+    libinput_replay_native.run_command_invalid([])
+    libinput_replay_native.run_command_invalid(["a.yml", "b.yml"])
+    libinput_replay_native.run_command_invalid(["--speed=-1", "a.yml"])
+    libinput_replay_native.run_command_invalid(["--speed=foo", "a.yml"])
+    libinput_replay_native.run_command_invalid(["--speed=0", "a.yml"])
+    libinput_replay_native.run_command_invalid(["--replay-after=-1", "a.yml"])
+    libinput_replay_native.run_command_invalid(["--jitter-budget=foo", "a.yml"])
+    libinput_replay_native.run_command_invalid(["--plugin-stats", "a.yml"])
+
+
+@pytest.mark.parametrize("feature", ["per-slot-delta", "touch-down-state"])
+def test_libinput_analyze_args(libinput_analyze, feature):
+    libinput_analyze.run_command_success([feature, "--help"])
+    libinput_analyze.run_command_invalid([feature])
+    libinput_analyze.run_command_invalid([feature, "a.yml", "b.yml"])
+    libinput_analyze.run_command_unrecognized_option([feature, "--foo", "a.yml"])
+
+
+def test_libinput_analyze_per_slot_delta_args(libinput_analyze):
+    for arg in ["--threshold=foo", "--ignore-below=foo", "--pressure-min=1.5"]:
+        libinput_analyze.run_command_invalid(["per-slot-delta", arg, "a.yml"])
+    libinput_analyze.run_command_missing_arg(["per-slot-delta", "a.yml", "--threshold"])
+
+
+def test_libinput_analyze_sweep_args(libinput_analyze):
+    libinput_analyze.run_command_success(["sweep", "--help"])
+    libinput_analyze.run_command_invalid(["sweep"])
+    libinput_analyze.run_command_invalid(["sweep", "a.yml", "b.yml"])
+    libinput_analyze.run_command_invalid(["sweep", "--jobs=0", "a.yml"])
+    libinput_analyze.run_command_invalid(["sweep", "--config=foo=1,2", "a.yml"])
+    libinput_analyze.run_command_invalid(["sweep", "--config=set-speed", "a.yml"])
+    libinput_analyze.run_command_invalid(["sweep", "--config=enable-tap,foo", "a.yml"])
+    libinput_analyze.run_command_invalid(["sweep", "--quirk=Foo=1", "a.yml"])
+    libinput_analyze.run_command_unrecognized_option(["sweep", "--foo", "a.yml"])
+
+
 def main():
     args = ["-m", "pytest"]
     try: